@@ -0,0 +1,249 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDataStream>
+#include <QDate>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalSocket>
+#include <QTextStream>
+#include <functional>
+#include <memory>
+#include "sqlparser.h"
+#include "xhydbmanager.h"
+#include "xhyexecutor.h"
+#include "xhyprotocol.h"
+
+// 命令行外壳：从文件或标准输入读取 SQL，逐条执行并打印结果与每条语句的耗时
+// 默认在本进程中打开当前工作目录下的数据（与图形界面相同），不做登录与权限检查；
+// 指定 --connect 时改为把语句发给本地服务器（dbms-server）执行，耗时为服务器上的执行时间
+namespace {
+
+struct Outcome {
+    QStringList lines;
+    qint64 nanos = 0;
+};
+
+struct Shell {
+    std::function<Outcome(const QString&)> execute;
+    QTextStream& out;
+    bool timing = true;
+    int statements = 0;
+    qint64 totalNanos = 0;
+
+    void run(const QString& statement) {
+        const Outcome outcome = execute(statement);
+        ++statements;
+        totalNanos += outcome.nanos;
+
+        out << "> " << statement << '\n';
+        for (const QString& line : outcome.lines) out << line << '\n';
+        if (timing) out << QString("(%1 ms)").arg(outcome.nanos / 1e6, 0, 'f', 3) << '\n';
+        out << '\n';
+        out.flush();
+    }
+
+    // 缓冲区以分号结尾时执行其中的全部语句；返回 true 表示缓冲区已消费
+    bool flush(const QString& buffer) {
+        if (!buffer.trimmed().endsWith(';')) return false;
+        const QStringList commands = SQLParser::parseMultiLineSQL(buffer);
+        if (commands.isEmpty()) return false;
+        for (const QString& command : commands) run(command.trimmed());
+        return true;
+    }
+};
+
+// 本地服务器的客户端：每条语句一个 Query 帧，读取 Rows 帧直到 Done；结果行的列值以制表符分隔打印
+class RemoteSession {
+public:
+    bool open(const QString& name, const QString& user, const QString& password, QString* error) {
+        m_socket.connectToServer(name);
+        if (!m_socket.waitForConnected(5000)) {
+            *error = m_socket.errorString();
+            return false;
+        }
+        m_socket.write(xhyprotocol::message(xhyprotocol::Login, user, password));
+        xhyprotocol::FrameType type;
+        QByteArray payload;
+        if (!readFrame(&type, &payload, error)) return false;
+        if (type != xhyprotocol::Ready) {
+            *error = text(payload);
+            return false;
+        }
+        return true;
+    }
+
+    Outcome execute(const QString& statement) {
+        Outcome outcome;
+        m_socket.write(xhyprotocol::message(xhyprotocol::Query, statement));
+        xhyprotocol::FrameType type;
+        QByteArray payload;
+        QString error;
+        bool header = false;
+        while (readFrame(&type, &payload, &error)) {
+            QDataStream stream(payload);
+            stream.setVersion(xhyprotocol::kStreamVersion);
+            if (type == xhyprotocol::Rows) {
+                QStringList columns;
+                QList<QVariantList> rows;
+                stream >> columns >> rows;
+                if (!header) { // 第一帧之前打印表头
+                    const QString line = columns.join('\t');
+                    outcome.lines.append(line);
+                    outcome.lines.append(QString(line.isEmpty() ? 20 : line.size(), '-'));
+                    header = true;
+                }
+                for (const QVariantList& row : rows) {
+                    QStringList cells;
+                    for (const QVariant& value : row) cells.append(cellText(value));
+                    outcome.lines.append(cells.join('\t'));
+                }
+            } else if (type == xhyprotocol::Done) {
+                QString executed;
+                qint64 micros = 0;
+                bool inTransaction = false;
+                QStringList output;
+                stream >> executed >> micros >> inTransaction >> output;
+                outcome.nanos = micros * 1000;
+                outcome.lines += output;
+                return outcome;
+            } else { // Busy / Error：整个请求未执行
+                outcome.lines.append("服务器: " + text(payload));
+                return outcome;
+            }
+        }
+        outcome.lines.append("错误: 与服务器的连接中断: " + error);
+        return outcome;
+    }
+
+private:
+    bool readFrame(xhyprotocol::FrameType* type, QByteArray* payload, QString* error) {
+        for (;;) {
+            const xhyprotocol::Status status = xhyprotocol::takeFrame(m_input, type, payload);
+            if (status == xhyprotocol::Complete) return true;
+            if (status == xhyprotocol::Malformed) {
+                *error = "帧格式错误";
+                return false;
+            }
+            if (m_socket.bytesAvailable() == 0 && !m_socket.waitForReadyRead(-1)) {
+                *error = m_socket.errorString();
+                return false;
+            }
+            m_input += m_socket.readAll();
+        }
+    }
+
+    // 与 xhyrecord::valueAt 的文本一致：NULL 为空，浮点按 QString::number，日期为 ISO 格式，布尔为 1/0
+    static QString cellText(const QVariant& value) {
+        if (!value.isValid() || value.isNull()) return QString();
+        switch (value.userType()) {
+        case QMetaType::Double: return QString::number(value.toDouble());
+        case QMetaType::QDate: return value.toDate().toString(Qt::ISODate);
+        case QMetaType::Bool: return value.toBool() ? QStringLiteral("1") : QStringLiteral("0");
+        default: return value.toString();
+        }
+    }
+
+    static QString text(const QByteArray& payload) {
+        QDataStream stream(payload);
+        stream.setVersion(xhyprotocol::kStreamVersion);
+        QString message;
+        stream >> message;
+        return message;
+    }
+
+    QLocalSocket m_socket;
+    QByteArray m_input;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("dbms-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mini DBMS 命令行：执行文件或标准输入中以分号结尾的 SQL 语句");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "SQL 脚本文件；省略或为 - 时读取标准输入", "[file]");
+    QCommandLineOption databaseOption({"d", "database"}, "执行前切换到的数据库", "name");
+    QCommandLineOption noTimingOption("no-timing", "不打印每条语句的耗时");
+    QCommandLineOption connectOption({"c", "connect"}, "连接本地服务器（dbms-server 的套接字名）", "name");
+    QCommandLineOption userOption({"u", "user"}, "连接服务器时的用户名", "user");
+    QCommandLineOption passwordOption({"p", "password"}, "连接服务器时的密码", "password");
+    parser.addOptions({databaseOption, noTimingOption, connectOption, userOption, passwordOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QFile input;
+    const QStringList positional = parser.positionalArguments();
+    const QString path = positional.isEmpty() ? QString("-") : positional.first();
+    if (path == "-") {
+        if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Text)) {
+            err << "错误: 无法读取标准输入" << Qt::endl;
+            return 1;
+        }
+    } else {
+        input.setFileName(path);
+        if (!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            err << QString("错误: 无法打开文件 '%1': %2").arg(path, input.errorString()) << Qt::endl;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<xhydbmanager> dbManager;
+    std::unique_ptr<xhyexecutor> executor;
+    RemoteSession remote;
+    Shell shell{nullptr, out};
+    if (parser.isSet(connectOption)) {
+        QString error;
+        if (!remote.open(parser.value(connectOption), parser.value(userOption), parser.value(passwordOption), &error)) {
+            err << QString("错误: 无法连接服务器 '%1': %2").arg(parser.value(connectOption), error) << Qt::endl;
+            return 1;
+        }
+        shell.execute = [&remote](const QString& statement) { return remote.execute(statement); };
+    } else {
+        dbManager.reset(new xhydbmanager);
+        executor.reset(new xhyexecutor(*dbManager));
+        shell.execute = [&executor](const QString& statement) {
+            Outcome outcome;
+            QElapsedTimer timer;
+            timer.start();
+            executor->execute_command(statement);
+            outcome.nanos = timer.nsecsElapsed();
+            outcome.lines = executor->takeOutput();
+            return outcome;
+        };
+    }
+    shell.timing = !parser.isSet(noTimingOption);
+
+    if (parser.isSet(databaseOption)) {
+        shell.run(QString("USE %1;").arg(parser.value(databaseOption)));
+    }
+
+    QTextStream in(&input);
+    QString buffer;
+    while (!in.atEnd()) {
+        buffer += in.readLine() + '\n';
+        if (shell.flush(buffer)) buffer.clear();
+    }
+    if (!buffer.trimmed().isEmpty()) {
+        const QStringList commands = SQLParser::parseMultiLineSQL(buffer);
+        for (const QString& command : commands) shell.run(command.trimmed());
+        if (commands.isEmpty()) {
+            err << "错误: 检测到未完成的SQL语句（末尾缺少分号）: " << buffer.trimmed() << Qt::endl;
+        }
+    }
+
+    // 连接服务器时由服务器在断开后回滚未结束的事务
+    if (dbManager && dbManager->isInTransaction()) {
+        dbManager->rollbackTransaction();
+        out << "输入结束时事务仍未提交，已回滚。" << '\n';
+    }
+    if (shell.timing) {
+        out << QString("共 %1 条语句，总耗时 %2 ms").arg(shell.statements).arg(shell.totalNanos / 1e6, 0, 'f', 3) << '\n';
+    }
+    return 0;
+}
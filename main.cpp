@@ -3,6 +3,7 @@
 #include <QDebug> // 用于输出调试信息
 #include <QDir>
 #include <QTCore>
+#include <QElapsedTimer>
 #include "mainwindow.h" // 确保包含了 MainWindow 的头文件
 #include "logindialog.h"    // 确保包含了 LoginDialog 的头文件
 #include "userfilemanager.h" // 确保包含了 UserFileManager 的头文件
@@ -18,8 +19,11 @@ int main(int argc, char *argv[])
         // 登录成功
         QString loggedInUsername = login.getUsername();
         qDebug() << "用户登录成功:" << loggedInUsername;
+        QElapsedTimer startupTimer; // 统计主窗口（含数据库目录加载）就绪耗时
+        startupTimer.start();
         MainWindow w(loggedInUsername,findDataFile());
         w.show();
+        qInfo() << "[STARTUP] 主窗口就绪，用时" << startupTimer.elapsed() << "ms";
 
         return a.exec();
     } else {
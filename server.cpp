@@ -0,0 +1,56 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QThread>
+#include "userfilemanager.h"
+#include "xhydbmanager.h"
+#include "xhyserver.h"
+
+// 本地服务器：同一主机上的多个进程通过本地套接字共用一个数据库实例
+// 数据目录为当前工作目录（与图形界面、命令行相同），用户与权限来自用户文件
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("dbms-server");
+
+    xhyserver::Options options;
+    options.workers = qMax(2, QThread::idealThreadCount() / 2); // 语句内的并行扫描另用全局线程池
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mini DBMS 本地服务器");
+    parser.addHelpOption();
+    QCommandLineOption nameOption({"n", "name"}, "本地套接字名", "name", options.name);
+    QCommandLineOption usersOption({"u", "users"}, "用户文件", "file", "data/default_userdata.dat");
+    QCommandLineOption workersOption({"w", "workers"}, "工作线程数", "count", QString::number(options.workers));
+    QCommandLineOption sessionsOption("max-sessions", "最大连接数", "count", QString::number(options.maxSessions));
+    QCommandLineOption queueOption("max-queue", "排队语句数上限", "count", QString::number(options.maxQueued));
+    QCommandLineOption idleOption("idle-transaction-timeout", "事务空闲超时（秒），0 为不限", "seconds",
+                                  QString::number(options.idleTransactionTimeout));
+    parser.addOptions({nameOption, usersOption, workersOption, sessionsOption, queueOption, idleOption});
+    parser.process(app);
+
+    options.name = parser.value(nameOption);
+    options.workers = parser.value(workersOption).toInt();
+    options.maxSessions = parser.value(sessionsOption).toInt();
+    options.maxQueued = parser.value(queueOption).toInt();
+    bool idleOk = false;
+    options.idleTransactionTimeout = parser.value(idleOption).toInt(&idleOk);
+    if (!idleOk || options.idleTransactionTimeout < 0 || options.idleTransactionTimeout > 24 * 3600) {
+        qCritical() << "错误: 事务空闲超时必须是 0 到 86400 之间的整数（秒）。";
+        return 1;
+    }
+    if (options.workers < 1 || options.maxSessions < 1 || options.maxQueued < 1) {
+        qCritical() << "错误: 工作线程数、最大连接数和排队上限都必须为正整数。";
+        return 1;
+    }
+
+    xhydbmanager dbManager;
+    UserFileManager account(parser.value(usersOption));
+    xhyserver server(dbManager, account, options);
+    QString error;
+    if (!server.listen(&error)) {
+        qCritical() << "错误: 无法监听" << options.name << ":" << error;
+        return 1;
+    }
+    return app.exec();
+}
@@ -0,0 +1,81 @@
+// 表改名：回滚后旧名的文件仍在；提交时先按新名写出，再删除旧名的文件
+#include "xhydbmanager.h"
+#include "xhyexecutor.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstdio>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+static QStringList run(xhyexecutor& executor, const QString& sql) {
+    executor.execute_command(sql);
+    return executor.takeOutput();
+}
+
+static bool tableFilesExist(const QString& table) {
+    const QString base = "DBMS_ROOT/data/renamedb/" + table;
+    return QFile::exists(base + ".tdf") && QFile::exists(base + ".trd");
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    if (!dir.isValid()) return 1;
+    QDir(dir.path()).mkpath("DBMS_ROOT");
+    QDir::setCurrent(dir.path()); // 数据目录取自当前目录
+
+    {
+        xhydbmanager manager;
+        xhyexecutor executor(manager);
+        run(executor, "CREATE DATABASE renamedb;");
+        run(executor, "USE renamedb;");
+        run(executor, "CREATE TABLE t (id INT PRIMARY KEY);");
+        run(executor, "INSERT INTO t VALUES (1);");
+        run(executor, "INSERT INTO t VALUES (2);");
+    }
+
+    // 事务中改名后回滚，然后模拟崩溃：不析构，不做检查点
+    xhydbmanager* crashed = new xhydbmanager; // 有意不释放
+    {
+        xhyexecutor executor(*crashed);
+        run(executor, "USE renamedb;");
+        run(executor, "BEGIN;");
+        run(executor, "ALTER TABLE t RENAME TO u;");
+        check(tableFilesExist("t"), "改名未提交时旧名的文件仍在");
+        run(executor, "ROLLBACK;");
+        check(tableFilesExist("t"), "回滚后旧名的文件仍在");
+    }
+
+    {
+        xhydbmanager manager;
+        xhyexecutor executor(manager);
+        run(executor, "USE renamedb;");
+        const QStringList rows = run(executor, "SELECT id FROM t;");
+        check(rows.contains("1") && rows.contains("2"), "崩溃后按旧名加载表");
+
+        run(executor, "ALTER TABLE t RENAME TO u;");
+        check(tableFilesExist("u"), "提交后按新名写出");
+        check(!QFile::exists("DBMS_ROOT/data/renamedb/t.tdf") && !QFile::exists("DBMS_ROOT/data/renamedb/t.trd"),
+              "提交后删除旧名的文件");
+    }
+
+    {
+        xhydbmanager manager;
+        xhyexecutor executor(manager);
+        run(executor, "USE renamedb;");
+        const QStringList rows = run(executor, "SELECT id FROM u;");
+        check(rows.contains("1") && rows.contains("2"), "重启后按新名加载表");
+    }
+
+    if (failures == 0) std::printf("tst_renametable: OK\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+// 快照读：写会话的事务未结束时，另一个线程上的只读语句读到已提交的数据，不回滚、也不等待该事务
+#include "xhydbmanager.h"
+#include "xhyexecutor.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+#include <cstdio>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+static QStringList run(xhyexecutor& executor, const QString& sql) {
+    executor.execute_command(sql);
+    return executor.takeOutput();
+}
+
+// 与服务器相同：写方先准备好表，只读语句随后在工作线程上执行
+static QStringList sharedRead(xhydbmanager& manager, xhyexecutor& reader, const QString& sql) {
+    manager.prepareReads(reader.currentDatabase());
+    check(manager.readsPrepared(reader.currentDatabase()), "prepareReads 之后可以并发读");
+    return QtConcurrent::run([&reader, sql] {
+        reader.executeSharedRead(sql);
+        return reader.takeOutput();
+    }).result();
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    if (!dir.isValid()) return 1;
+    QDir(dir.path()).mkpath("DBMS_ROOT");
+    QDir::setCurrent(dir.path()); // 数据目录取自当前目录
+
+    {
+        xhydbmanager manager;
+        xhyexecutor writer(manager);
+        xhyexecutor reader(manager);
+        run(writer, "CREATE DATABASE snapdb;");
+        run(writer, "USE snapdb;");
+        run(writer, "CREATE TABLE t (id INT PRIMARY KEY, v INT);");
+        run(writer, "INSERT INTO t VALUES (1, 111);");
+        run(reader, "USE snapdb;");
+        run(writer, "USE snapdb;"); // 管理器的当前数据库切回写会话
+
+        run(writer, "BEGIN;");
+        run(writer, "UPDATE t SET v = 222 WHERE id = 1;");
+        run(writer, "INSERT INTO t VALUES (2, 333);");
+
+        const QStringList during = sharedRead(manager, reader, "SELECT v FROM t;");
+        check(during.contains("111"), "事务进行中读到已提交的旧值");
+        check(!during.contains("222") && !during.contains("333"), "读不到未提交的修改");
+        check(manager.isInTransaction(), "并发读不结束写会话的事务");
+
+        sharedRead(manager, reader, "SELECT v FROM missing;");
+        check(manager.isInTransaction(), "并发读出错时不回滚写会话的事务");
+
+        check(run(writer, "SELECT v FROM t;").contains("222"), "写会话读到本事务的修改");
+        run(writer, "COMMIT;");
+
+        const QStringList after = sharedRead(manager, reader, "SELECT v FROM t;");
+        check(after.contains("222") && after.contains("333") && !after.contains("111"), "提交后读到新值");
+
+        const QStringList rejected = sharedRead(manager, reader, "DELETE FROM t;");
+        check(run(writer, "SELECT v FROM t;").contains("222") && !rejected.isEmpty(), "写语句不能按只读语句执行");
+    }
+
+    if (failures == 0) std::printf("tst_snapshotread: OK\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// 重启后的提交：正常退出时检查点截断了日志，重启后新的提交仍须排在数据文件头的 LSN 之后，崩溃后能从日志重放
+#include "xhydbmanager.h"
+#include "xhyexecutor.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QTemporaryDir>
+#include <cstdio>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+static QStringList run(xhyexecutor& executor, const QString& sql) {
+    executor.execute_command(sql);
+    return executor.takeOutput();
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    if (!dir.isValid()) return 1;
+    QDir(dir.path()).mkpath("DBMS_ROOT");
+    QDir::setCurrent(dir.path()); // 数据目录取自当前目录
+
+    {
+        xhydbmanager manager; // 析构时做检查点并截断日志
+        xhyexecutor executor(manager);
+        run(executor, "CREATE DATABASE waldb;");
+        run(executor, "USE waldb;");
+        run(executor, "CREATE TABLE t (id INT PRIMARY KEY);");
+        run(executor, "INSERT INTO t VALUES (1);");
+        run(executor, "INSERT INTO t VALUES (2);");
+    }
+
+    // 重启后提交，然后模拟崩溃：不析构，不做检查点，新的提交只在日志中
+    xhydbmanager* crashed = new xhydbmanager; // 有意不释放
+    {
+        xhyexecutor executor(*crashed);
+        run(executor, "USE waldb;");
+        run(executor, "INSERT INTO t VALUES (3);");
+    }
+
+    {
+        xhydbmanager manager;
+        xhyexecutor executor(manager);
+        run(executor, "USE waldb;");
+        const QStringList rows = run(executor, "SELECT id FROM t;");
+        check(rows.contains("1") && rows.contains("2"), "检查点之前提交的行仍在");
+        check(rows.contains("3"), "重启后提交、未做检查点的行从日志重放");
+    }
+
+    if (failures == 0) std::printf("tst_walrestart: OK\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -7,6 +7,7 @@
 #include <QStandardPaths>
 #include <QDebug>
 #include <QDir>
+#include <QMutexLocker>
 
 UserFileManager::UserFileManager(const QString& filename)
     : m_filename(filename.isEmpty() ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/userdata.dat" : filename)
@@ -16,6 +17,7 @@ UserFileManager::UserFileManager(const QString& filename)
 
 bool UserFileManager::loadUsers()
 {
+    QMutexLocker locker(&m_mutex);
     QFile file(m_filename);
     if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << "Failed to open user file:" << file.errorString();
@@ -79,6 +81,7 @@ UserFileManager::~UserFileManager(){
 
 bool UserFileManager::saveUsers()
 {
+    QMutexLocker locker(&m_mutex);
     QFile file(m_filename);
     if (!file.open(QIODevice::WriteOnly)) {
         qWarning() << "Failed to save user file:" << file.errorString();
@@ -117,6 +120,7 @@ bool UserFileManager::addUser(const QString& username,
                               uint8_t role,
                               const QVector<QPair<QString, uint8_t>>& databases)
 {
+    QMutexLocker locker(&m_mutex);
     // 参数验证
     if (username.isEmpty() || password.isEmpty()) {
         qWarning() << "Username or password cannot be empty";
@@ -176,6 +180,7 @@ bool UserFileManager::addUser(const QString& username,
 
 bool UserFileManager::deleteUser(const QString& username)
 {
+    QMutexLocker locker(&m_mutex);
     for (int i = 0; i < m_users.size(); ++i) {
         if (QString::fromUtf8(m_users[i].username, strnlen(m_users[i].username, 50)) == username) {
             m_users.removeAt(i);
@@ -188,6 +193,7 @@ bool UserFileManager::deleteUser(const QString& username)
 
 bool UserFileManager::validateUser(const QString& username, const QString& password)
 {
+    QMutexLocker locker(&m_mutex);
     for (const UserRecord& user : m_users) {
         if (QString::fromUtf8(user.username, strnlen(user.username, 50)) == username) {
             QByteArray salt(user.salt, 32); // 从 UserRecord 结构体中取出盐值
@@ -207,6 +213,7 @@ bool UserFileManager::validateUser(const QString& username, const QString& passw
 
 uint8_t UserFileManager::getUserRole(const QString& username) const
 {
+    QMutexLocker locker(&m_mutex);
     // 参数检查
     if (username.isEmpty()) {
         qWarning() << "Username cannot be empty";
@@ -230,6 +237,7 @@ uint8_t UserFileManager::getUserRole(const QString& username) const
 
 bool UserFileManager::setUserRole(const QString& username, uint8_t newRole)
 {
+    QMutexLocker locker(&m_mutex);
     if (newRole > 2) {
         qWarning() << "Invalid role level:" << newRole;
         return false;
@@ -246,6 +254,7 @@ bool UserFileManager::setUserRole(const QString& username, uint8_t newRole)
 
 QVector<UserDatabaseInfo> UserFileManager::getUserDatabaseInfo(const QString& username) const
 {
+    QMutexLocker locker(&m_mutex);
     QVector<UserDatabaseInfo> result;
 
     // 参数检查
@@ -270,6 +279,7 @@ QVector<UserDatabaseInfo> UserFileManager::getUserDatabaseInfo(const QString& us
 
 bool UserFileManager::addDatabaseToUser(const QString& username, const QString& dbName, uint8_t permissions)
 {
+    QMutexLocker locker(&m_mutex);
     for (UserRecord& user : m_users) {
         if (QString::fromUtf8(user.username, strnlen(user.username, 50)) == username) {
             // 检查是否已存在
@@ -296,6 +306,7 @@ bool UserFileManager::addDatabaseToUser(const QString& username, const QString&
 
 bool UserFileManager::removeDatabaseFromUser(const QString& username, const QString& dbName)
 {
+    QMutexLocker locker(&m_mutex);
     for (UserRecord& user : m_users) {
         if (QString::fromUtf8(user.username, strnlen(user.username, 50)) == username) {
             auto& dbs = m_userDatabases[username];
@@ -314,6 +325,7 @@ bool UserFileManager::removeDatabaseFromUser(const QString& username, const QStr
 
 bool UserFileManager::updateDatabasePermissions(const QString& username, const QString& dbName, uint8_t newPermissions)
 {
+    QMutexLocker locker(&m_mutex);
     for (UserRecord& user : m_users) {
         if (QString::fromUtf8(user.username, strnlen(user.username, 50)) == username) {
             auto& dbs = m_userDatabases[username];
@@ -330,6 +342,7 @@ bool UserFileManager::updateDatabasePermissions(const QString& username, const Q
 }
 
 bool UserFileManager::removeAllDatabasesFromUser(const QString& username) {
+    QMutexLocker locker(&m_mutex);
     // 1. 查找用户
     for (UserRecord& user : m_users) {
         if (QString::fromUtf8(user.username, strnlen(user.username, 50)) == username) {
@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QVector>
 #include <QMap>
+#include <QMutex>
 #include <QString>
 
 #pragma pack(push, 1)
@@ -34,6 +35,7 @@ struct UserRecord {
 };
 #pragma pack(pop)
 
+// 各公有接口在内部加锁，服务器的登录与各会话的权限检查可在不同线程中同时调用
 class UserFileManager
 {
 public:
@@ -62,6 +64,7 @@ private:
     QString m_filename;
     QVector<UserRecord> m_users;
     QMap<QString, QVector<DatabasePermission>> m_userDatabases;
+    mutable QRecursiveMutex m_mutex; // 修改接口内部会调用 saveUsers
 
     QByteArray hashPassword(const QString& password, const QByteArray& salt) const;
     QByteArray generateSalt() const;
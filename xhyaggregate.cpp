@@ -0,0 +1,374 @@
+#include "xhyaggregate.h"
+#include "xhysort.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+const int kMaxSpillDepth = 8; // 递归分区的层数上限，超过后不再落盘
+
+// 与 record.value(column).toDouble(&ok) 相同，整数/浮点单元直接取值
+bool numberAt(const xhyrecord& record, int ordinal, double* out) {
+    qint64 i = 0;
+    if (record.intAt(ordinal, &i)) {
+        *out = static_cast<double>(i);
+        return true;
+    }
+    if (record.doubleAt(ordinal, out)) return true;
+    if (record.isNullAt(ordinal)) return false;
+    bool ok = false;
+    *out = record.valueAt(ordinal).toDouble(&ok);
+    return ok;
+}
+
+// COUNT(列)：与 !record.value(column).isEmpty() 相同
+bool nonEmptyAt(const xhyrecord& record, int ordinal) {
+    if (record.isNullAt(ordinal)) return false;
+    QVariant native;
+    if (record.nativeValueAt(ordinal, &native)) return true; // 原生单元的文本不为空
+    return !record.valueAt(ordinal).isEmpty();
+}
+
+bool keyLess(const xhyhashaggregate::Group& a, const xhyhashaggregate::Group& b) {
+    const int c = std::memcmp(a.key.constData(), b.key.constData(), static_cast<size_t>(qMin(a.key.size(), b.key.size())));
+    if (c != 0) return c < 0;
+    return a.key.size() < b.key.size();
+}
+}
+
+bool xhyhashaggregate::functionFromName(const QString& name, Function* out) {
+    const QString upper = name.trimmed().toUpper();
+    if (upper == "COUNT") *out = Count;
+    else if (upper == "SUM") *out = Sum;
+    else if (upper == "AVG") *out = Avg;
+    else if (upper == "MIN") *out = Min;
+    else if (upper == "MAX") *out = Max;
+    else return false;
+    return true;
+}
+
+QString xhyhashaggregate::functionName(Function function) {
+    switch (function) {
+    case Count: return "COUNT";
+    case Sum: return "SUM";
+    case Avg: return "AVG";
+    case Min: return "MIN";
+    case Max: return "MAX";
+    }
+    return QString();
+}
+
+xhyhashaggregate::xhyhashaggregate(const QStringList& groupColumns, const QVector<Aggregate>& aggregates)
+    : m_groupColumns(groupColumns), m_aggregates(aggregates) {}
+
+void xhyhashaggregate::setSpill(const QString& directory, qint64 memoryBudget) {
+    m_spillDirectory = directory;
+    m_memoryBudget = qMax<qint64>(1, memoryBudget);
+}
+
+void xhyhashaggregate::setParallelDegree(int degree) {
+    m_parallelDegree = qMax(0, degree);
+}
+
+void xhyhashaggregate::appendKey(const xhyrecord& record, QVector<xhyhashjoin::ColumnOrdinal>& groupOrdinals, QByteArray& key) const {
+    key.clear();
+    for (xhyhashjoin::ColumnOrdinal& ordinal : groupOrdinals) {
+        xhysorter::Key part;
+        part.kind = xhysorter::Key::Text;
+        part.s = record.valueAt(ordinal.of(record));
+        xhysorter::appendNormalized(key, part, false);
+    }
+}
+
+void xhyhashaggregate::accumulate(const xhyrecord& record, QVector<xhyhashjoin::ColumnOrdinal>& aggregateOrdinals, State* state) const {
+    for (int a = 0; a < m_aggregates.size(); ++a) {
+        const Aggregate& aggregate = m_aggregates.at(a);
+        if (aggregate.function == Count) {
+            if (aggregate.column != "*" && !aggregate.column.isEmpty() && nonEmptyAt(record, aggregateOrdinals[a].of(record))) ++state[a].count;
+            continue;
+        }
+        double v = 0;
+        if (!numberAt(record, aggregateOrdinals[a].of(record), &v)) continue;
+        if (state[a].count == 0) {
+            state[a].min = v;
+            state[a].max = v;
+        } else {
+            state[a].min = qMin(state[a].min, v);
+            state[a].max = qMax(state[a].max, v);
+        }
+        state[a].sum += v;
+        ++state[a].count;
+    }
+}
+
+void xhyhashaggregate::combine(State& into, const State& from) {
+    if (from.count == 0) return;
+    if (into.count == 0) {
+        into.min = from.min;
+        into.max = from.max;
+    } else {
+        into.min = qMin(into.min, from.min);
+        into.max = qMax(into.max, from.max);
+    }
+    into.sum += from.sum;
+    into.count += from.count;
+}
+
+QVariant xhyhashaggregate::finish(const Aggregate& aggregate, const State& state, qint64 rows) const {
+    switch (aggregate.function) {
+    case Count:
+        return QVariant(static_cast<qlonglong>(aggregate.column == "*" || aggregate.column.isEmpty() ? rows : state.count));
+    case Sum:
+        return state.count > 0 ? QVariant(state.sum) : QVariant();
+    case Avg:
+        return state.count > 0 ? QVariant(std::round(state.sum / state.count * 100) / 100) : QVariant(); // 四舍五入到两位小数
+    case Min:
+        return state.count > 0 ? QVariant(state.min) : QVariant();
+    case Max:
+        return state.count > 0 ? QVariant(state.max) : QVariant();
+    }
+    return QVariant();
+}
+
+QVector<xhyhashaggregate::Group> xhyhashaggregate::run(int rowCount, const RowAt& rowAt) {
+    m_stats = Stats();
+    m_stats.rows = rowCount;
+    QVector<Group> groups;
+    const int degree = m_parallelDegree > 0 ? m_parallelDegree : QThread::idealThreadCount();
+    const int workers = rowCount >= kParallelRows ? qMax(1, qMin(degree, (rowCount + kMorselRows - 1) / kMorselRows)) : 1;
+    if (workers <= 1 || !parallelPass(rowCount, rowAt, workers, groups)) {
+        m_stats.workers = 1;
+        m_stats.morsels = 0;
+        groups.clear();
+        pass(nullptr, rowCount, rowAt, 0, groups);
+    }
+    if (m_groupColumns.isEmpty() && groups.isEmpty()) { // 没有行时也有一组（COUNT 为 0，其余为 NULL）
+        Group empty;
+        for (const Aggregate& aggregate : m_aggregates) empty.values.append(finish(aggregate, State(), 0));
+        groups.append(empty);
+    }
+    std::sort(groups.begin(), groups.end(), keyLess);
+    m_stats.groups = groups.size();
+    return groups;
+}
+
+// rows 为空指针时处理 0..rowCount-1，否则处理 rows 中的行
+void xhyhashaggregate::pass(const QVector<int>* rows, int rowCount, const RowAt& rowAt, int depth, QVector<Group>& out) {
+    QVector<xhyhashjoin::ColumnOrdinal> groupOrdinals;
+    for (const QString& column : m_groupColumns) groupOrdinals.append(xhyhashjoin::ColumnOrdinal(column));
+    QVector<xhyhashjoin::ColumnOrdinal> aggregateOrdinals;
+    for (const Aggregate& aggregate : m_aggregates) aggregateOrdinals.append(xhyhashjoin::ColumnOrdinal(aggregate.column));
+    const int aggregateCount = m_aggregates.size();
+    const bool canSpill = !m_spillDirectory.isEmpty() && depth < kMaxSpillDepth;
+
+    QHash<QByteArray, int> groupIndex; // 分组键 -> 组序号
+    QVector<Group> groups;
+    QVector<State> states;        // 每组 aggregateCount 个
+    qint64 usedBytes = 0;
+    std::vector<std::unique_ptr<QTemporaryFile>> partitions(canSpill ? kPartitions : 0);
+    std::vector<std::unique_ptr<QDataStream>> partitionStreams(canSpill ? kPartitions : 0);
+
+    QByteArray key;
+    const int count = rows ? rows->size() : rowCount;
+    for (int n = 0; n < count; ++n) {
+        const int row = rows ? rows->at(n) : n;
+        const xhyrecord& record = rowAt(row);
+        appendKey(record, groupOrdinals, key);
+
+        int slot = groupIndex.value(key, -1);
+        if (slot < 0) {
+            // 分组表已满：新组的行写入分区文件，同一组的行总落在同一分区
+            if (canSpill && !groups.isEmpty() && usedBytes > m_memoryBudget) {
+                const int p = static_cast<int>(qHash(key, static_cast<size_t>(depth) * 0x9e3779b9u + 1) % kPartitions);
+                if (!partitions[p]) {
+                    if (!QDir().mkpath(m_spillDirectory)) {
+                        throw std::runtime_error("无法创建聚合临时目录: " + m_spillDirectory.toStdString());
+                    }
+                    partitions[p].reset(new QTemporaryFile(QDir(m_spillDirectory).filePath("group_XXXXXX.part")));
+                    if (!partitions[p]->open()) {
+                        throw std::runtime_error("无法创建聚合临时文件: " + partitions[p]->errorString().toStdString());
+                    }
+                    partitionStreams[p].reset(new QDataStream(partitions[p].get()));
+                }
+                *partitionStreams[p] << qint32(row);
+                continue;
+            }
+            slot = groups.size();
+            groupIndex.insert(key, slot);
+            Group group;
+            group.key = key;
+            group.firstRow = row;
+            groups.append(group);
+            states.resize(states.size() + aggregateCount);
+            usedBytes += key.size() * 2 + aggregateCount * qint64(sizeof(State)) + 96; // 键在哈希表和组中各一份，另计容器开销
+        }
+
+        ++groups[slot].rows;
+        accumulate(record, aggregateOrdinals, states.data() + qint64(slot) * aggregateCount);
+    }
+
+    for (int slot = 0; slot < groups.size(); ++slot) {
+        Group& group = groups[slot];
+        const State* state = states.constData() + qint64(slot) * aggregateCount;
+        for (int a = 0; a < aggregateCount; ++a) group.values.append(finish(m_aggregates.at(a), state[a], group.rows));
+        out.append(group);
+    }
+    groupIndex.clear();
+    groups.clear();
+    states.clear();
+
+    for (int p = 0; p < static_cast<int>(partitions.size()); ++p) {
+        if (!partitions[p]) continue;
+        QTemporaryFile& file = *partitions[p];
+        if (partitionStreams[p]->status() != QDataStream::Ok || !file.flush() || !file.seek(0)) {
+            throw std::runtime_error("读写聚合临时文件失败: " + file.errorString().toStdString());
+        }
+        ++m_stats.spilledPartitions;
+        m_stats.spilledBytes += file.size();
+        QVector<int> partitionRows;
+        partitionRows.reserve(static_cast<int>(file.size() / sizeof(qint32)));
+        QDataStream in(&file);
+        while (!in.atEnd()) {
+            qint32 row = 0;
+            in >> row;
+            if (in.status() != QDataStream::Ok) throw std::runtime_error("读取聚合临时文件失败");
+            partitionRows.append(row);
+        }
+        partitionStreams[p].reset();
+        partitions[p].reset(); // 删除分区文件
+        qDebug() << "[AGGREGATE] 第" << depth + 1 << "层分区" << p << "共" << partitionRows.size() << "行";
+        pass(&partitionRows, partitionRows.size(), rowAt, depth + 1, out);
+    }
+}
+
+struct xhyhashaggregate::Partial {
+    QHash<QByteArray, int> groupIndex;
+    QVector<Group> groups;            // 只用 key、firstRow、rows
+    QVector<State> states;            // 每组 aggregateCount 个
+    QVector<QVector<int>> partitions; // 合并分区 -> 本线程中属于该分区的组序号
+    qint64 usedBytes = 0;
+};
+
+// 线程各自领取行块做部分聚合，再按分区并行合并；某线程超出内存预算份额时放弃并返回 false
+bool xhyhashaggregate::parallelPass(int rowCount, const RowAt& rowAt, int workers, QVector<Group>& out) {
+    const int aggregateCount = m_aggregates.size();
+    const int morselCount = (rowCount + kMorselRows - 1) / kMorselRows;
+    const int mergePartitions = m_groupColumns.isEmpty() ? 1 : workers;
+    const qint64 workerBudget = qMax<qint64>(1, m_memoryBudget / workers);
+    m_stats.workers = workers;
+    m_stats.morsels = morselCount;
+
+    QVector<Partial> partials(workers);
+    QVector<int> workerIds(workers);
+    for (int w = 0; w < workers; ++w) workerIds[w] = w;
+    std::atomic<int> nextMorsel{0};
+    std::atomic<bool> overBudget{false};
+    QtConcurrent::blockingMap(workerIds, [&](int w) {
+        Partial& partial = partials[w];
+        partial.partitions.resize(mergePartitions);
+        QVector<xhyhashjoin::ColumnOrdinal> groupOrdinals;
+        for (const QString& column : m_groupColumns) groupOrdinals.append(xhyhashjoin::ColumnOrdinal(column));
+        QVector<xhyhashjoin::ColumnOrdinal> aggregateOrdinals;
+        for (const Aggregate& aggregate : m_aggregates) aggregateOrdinals.append(xhyhashjoin::ColumnOrdinal(aggregate.column));
+        QByteArray key;
+        // 块按领取顺序递增，线程内每组的 firstRow 是它在本线程中最早的行
+        for (int morsel = nextMorsel++; morsel < morselCount && !overBudget; morsel = nextMorsel++) {
+            const int end = static_cast<int>(qMin<qint64>(rowCount, qint64(morsel + 1) * kMorselRows));
+            for (int row = morsel * kMorselRows; row < end; ++row) {
+                const xhyrecord& record = rowAt(row);
+                appendKey(record, groupOrdinals, key);
+                int slot = partial.groupIndex.value(key, -1);
+                if (slot < 0) {
+                    slot = partial.groups.size();
+                    partial.groupIndex.insert(key, slot);
+                    Group group;
+                    group.key = key;
+                    group.firstRow = row;
+                    partial.groups.append(group);
+                    partial.states.resize(partial.states.size() + aggregateCount);
+                    partial.partitions[static_cast<int>(qHash(key) % mergePartitions)].append(slot);
+                    partial.usedBytes += key.size() * 2 + aggregateCount * qint64(sizeof(State)) + 96;
+                    if (partial.usedBytes > workerBudget) {
+                        overBudget = true;
+                        return;
+                    }
+                }
+                ++partial.groups[slot].rows;
+                accumulate(record, aggregateOrdinals, partial.states.data() + qint64(slot) * aggregateCount);
+            }
+        }
+        partial.groupIndex.clear();
+    });
+    if (overBudget) {
+        qDebug() << "[AGGREGATE] 并行部分聚合超出内存预算，改为串行聚合";
+        return false;
+    }
+
+    // 合并：同一分组键只会落在一个分区，各分区互不相干
+    QVector<QVector<Group>> merged(mergePartitions);
+    QVector<int> partitionIds(mergePartitions);
+    for (int p = 0; p < mergePartitions; ++p) partitionIds[p] = p;
+    auto mergePartition = [&](int p) {
+        QHash<QByteArray, int> groupIndex;
+        QVector<Group>& groups = merged[p];
+        QVector<State> states;
+        for (const Partial& partial : partials) {
+            for (int from : partial.partitions.at(p)) {
+                const Group& source = partial.groups.at(from);
+                int slot = groupIndex.value(source.key, -1);
+                if (slot < 0) {
+                    slot = groups.size();
+                    groupIndex.insert(source.key, slot);
+                    Group group;
+                    group.key = source.key;
+                    group.firstRow = source.firstRow;
+                    groups.append(group);
+                    states.resize(states.size() + aggregateCount);
+                }
+                Group& group = groups[slot];
+                group.firstRow = qMin(group.firstRow, source.firstRow);
+                group.rows += source.rows;
+                State* state = states.data() + qint64(slot) * aggregateCount;
+                const State* sourceState = partial.states.constData() + qint64(from) * aggregateCount;
+                for (int a = 0; a < aggregateCount; ++a) combine(state[a], sourceState[a]);
+            }
+        }
+        for (int slot = 0; slot < groups.size(); ++slot) {
+            const State* state = states.constData() + qint64(slot) * aggregateCount;
+            for (int a = 0; a < aggregateCount; ++a) groups[slot].values.append(finish(m_aggregates.at(a), state[a], groups[slot].rows));
+        }
+    };
+    if (mergePartitions == 1) {
+        mergePartition(0); // 没有分组列：各线程只有一组，直接合并
+    } else {
+        QtConcurrent::blockingMap(partitionIds, mergePartition);
+    }
+    for (const QVector<Group>& groups : merged) out += groups;
+    return true;
+}
+
+QString xhyhashaggregate::explain() const {
+    QString text = QString("聚合: 哈希聚合 %1 行，%2 组").arg(m_stats.rows).arg(m_stats.groups);
+    if (m_stats.workers > 1) {
+        text += QString("，%1 个线程并行部分聚合 %2 个行块后分区合并").arg(m_stats.workers).arg(m_stats.morsels);
+    }
+    if (m_stats.spilledPartitions > 0) {
+        text += QString("，分组表超出内存预算 %1 MB，写出 %2 个分区共 %3 MB")
+                    .arg(m_memoryBudget / double(1 << 20), 0, 'f', 1)
+                    .arg(m_stats.spilledPartitions)
+                    .arg(m_stats.spilledBytes / double(1 << 20), 0, 'f', 1);
+    }
+    return text;
+}
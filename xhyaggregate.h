@@ -0,0 +1,87 @@
+#ifndef XHYAGGREGATE_H
+#define XHYAGGREGATE_H
+
+#include "xhyhashjoin.h"
+#include "xhyrecord.h"
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <functional>
+
+// GROUP BY 的哈希聚合：逐行流式处理，每组只保存分组键和各聚合的累加状态（计数、和、最小、最大），不复制行
+// 数值按单元的原生类型读取，文本单元才按 toDouble 解析；结果与 calculateAggregate 逐组计算一致
+// 分组表超过内存预算后不再建新组：新组的行号按分组键哈希写入临时分区文件，本轮结束后逐个分区递归聚合
+// 行数达到 kParallelRows 且并行度大于 1 时，各线程按块（kMorselRows 行）领取行，在线程自己的分组表中部分聚合；
+// 之后按分组键哈希分区并行合并（没有分组列时直接合并各线程的状态）。某线程的分组表超出其内存预算份额时改为串行（可落盘）聚合
+class xhyhashaggregate {
+public:
+    enum Function { Count, Sum, Avg, Min, Max };
+    struct Aggregate {
+        Function function = Count;
+        QString column; // 记录中的列名；COUNT(*) 为 "*"
+    };
+    static bool functionFromName(const QString& name, Function* out); // COUNT/SUM/AVG/MIN/MAX（不区分大小写）
+    static QString functionName(Function function);
+
+    struct Group {
+        QByteArray key;           // 分组列文本的规范化编码；按它排序即按 (列1, 列2, ...) 的文本升序
+        int firstRow = -1;        // 组内第一行，分组列的值从这里取
+        qint64 rows = 0;
+        QVector<QVariant> values; // 各聚合的结果，NULL 为无效 QVariant
+    };
+    using RowAt = std::function<const xhyrecord&(int row)>;
+
+    static const qint64 kDefaultMemoryBudget = qint64(64) << 20;
+    static const int kPartitions = 16;
+    static const int kParallelRows = 1 << 16;
+    static const int kMorselRows = 1 << 14;
+
+    struct Stats {
+        int rows = 0;
+        int groups = 0;
+        int spilledPartitions = 0; // 写出的分区文件个数（含递归）
+        qint64 spilledBytes = 0;
+        int workers = 1;           // 部分聚合的线程数
+        int morsels = 0;
+    };
+
+    xhyhashaggregate(const QStringList& groupColumns, const QVector<Aggregate>& aggregates);
+    // 分区文件目录和分组表的内存预算；目录为空时不落盘
+    void setSpill(const QString& directory, qint64 memoryBudget = kDefaultMemoryBudget);
+    // 并行度：0 为 CPU 核数，1 为串行
+    void setParallelDegree(int degree);
+
+    // 对 0..rowCount-1 行聚合，返回按分组键升序的各组；没有分组列时总是返回一组（可能为 0 行）
+    // 分区文件无法读写时抛出 std::runtime_error
+    QVector<Group> run(int rowCount, const RowAt& rowAt);
+    const Stats& stats() const { return m_stats; }
+    QString explain() const;
+
+private:
+    struct State {
+        qint64 count = 0;
+        double sum = 0;
+        double min = 0;
+        double max = 0;
+    };
+
+    struct Partial; // 一个线程的部分聚合结果
+
+    void pass(const QVector<int>* rows, int rowCount, const RowAt& rowAt, int depth, QVector<Group>& out);
+    bool parallelPass(int rowCount, const RowAt& rowAt, int workers, QVector<Group>& out);
+    void appendKey(const xhyrecord& record, QVector<xhyhashjoin::ColumnOrdinal>& groupOrdinals, QByteArray& key) const;
+    void accumulate(const xhyrecord& record, QVector<xhyhashjoin::ColumnOrdinal>& aggregateOrdinals, State* state) const;
+    static void combine(State& into, const State& from);
+    QVariant finish(const Aggregate& aggregate, const State& state, qint64 rows) const;
+
+    QStringList m_groupColumns;
+    QVector<Aggregate> m_aggregates;
+    QString m_spillDirectory;
+    qint64 m_memoryBudget = kDefaultMemoryBudget;
+    int m_parallelDegree = 0;
+    Stats m_stats;
+};
+
+#endif // XHYAGGREGATE_H
@@ -0,0 +1,285 @@
+#include "xhybtree.h"
+#include <QDate>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+const int kMaxEntries = 64; // 节点容量，超过时分裂
+const int kBuildFill = 48;  // 批量装载时每个节点的填充数，给之后的插入留出空间
+
+int compareKeys(const xhybtree::Key& a, const xhybtree::Key& b) {
+    const int n = qMin(a.size(), b.size());
+    for (int k = 0; k < n; ++k) {
+        const int c = a.at(k).compare(b.at(k));
+        if (c != 0) return c;
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+bool entryLess(const xhybtree::Entry& a, const xhybtree::Entry& b) {
+    const int c = compareKeys(a.key, b.key);
+    return c != 0 ? c < 0 : a.rowId < b.rowId;
+}
+}
+
+int xhybtree::KeyPart::compare(const KeyPart& other) const {
+    if (kind != other.kind) return kind < other.kind ? -1 : 1;
+    switch (kind) {
+    case Null:
+        return 0;
+    case Double:
+        return d < other.d ? -1 : (d > other.d ? 1 : 0);
+    case Text: {
+        const int c = s.compare(other.s); // 与 compareQVariants 的字符串比较一致（区分大小写）
+        return c < 0 ? -1 : (c > 0 ? 1 : 0);
+    }
+    default:
+        return i < other.i ? -1 : (i > other.i ? 1 : 0);
+    }
+}
+
+xhybtree::xhybtree() : d(new Data) {}
+
+xhybtree::xhybtree(const xhyindex& definition) : d(new Data), m_definition(definition) {}
+
+int xhybtree::height() const {
+    int levels = 0;
+    for (int node = d->root; node >= 0; node = d->nodes.at(node).leaf ? -1 : d->nodes.at(node).children.first()) {
+        ++levels;
+    }
+    return levels;
+}
+
+xhybtree::KeyPart xhybtree::keyPartOf(const xhyrecord& record, int ordinal) {
+    KeyPart part;
+    if (record.isNullAt(ordinal)) return part;
+    QVariant native;
+    if (record.intAt(ordinal, &part.i)) {
+        part.kind = KeyPart::Int;
+    } else if (record.doubleAt(ordinal, &part.d)) {
+        part.kind = KeyPart::Double;
+    } else if (record.nativeValueAt(ordinal, &native)) {
+        if (native.typeId() == QMetaType::QDate) {
+            part.kind = KeyPart::Date;
+            part.i = native.toDate().toJulianDay();
+        } else {
+            part.kind = KeyPart::Bool;
+            part.i = native.toBool() ? 1 : 0;
+        }
+    } else {
+        part.kind = KeyPart::Text;
+        part.s = record.valueAt(ordinal);
+    }
+    return part;
+}
+
+xhybtree::Key xhybtree::keyOf(const xhyrecord& record) const {
+    const QStringList columns = m_definition.columns();
+    Key key;
+    key.reserve(columns.size());
+    for (const QString& column : columns) key.append(keyPartOf(record, record.layout().indexOf(column)));
+    return key;
+}
+
+void xhybtree::build(const QList<xhyrecord>& rows) {
+    QVector<Entry> entries;
+    entries.reserve(rows.size());
+    for (const xhyrecord& record : rows) entries.append({keyOf(record), record.rowId()});
+    std::sort(entries.begin(), entries.end(), entryLess);
+    load(entries);
+    qDebug() << "[INDEX] 建立索引" << m_definition.name() << "共" << entries.size() << "项，高度" << height();
+}
+
+void xhybtree::load(QVector<Entry> entries) {
+    if (!std::is_sorted(entries.begin(), entries.end(), entryLess)) {
+        std::sort(entries.begin(), entries.end(), entryLess);
+    }
+    Data* data = d.data();
+    data->nodes.clear();
+    data->count = entries.size();
+    data->built = true;
+
+    // 自底向上：叶子按序填充并串成链表，每层节点记下子树最小项作为上一层的分隔键
+    QVector<int> level;
+    QVector<Entry> lowest;
+    for (int start = 0; start < entries.size() || level.isEmpty(); start += kBuildFill) {
+        Node leaf;
+        leaf.entries = entries.mid(start, kBuildFill);
+        if (!level.isEmpty()) data->nodes[level.last()].next = data->nodes.size();
+        lowest.append(leaf.entries.isEmpty() ? Entry() : leaf.entries.first());
+        level.append(data->nodes.size());
+        data->nodes.append(leaf);
+    }
+    while (level.size() > 1) {
+        QVector<int> parents;
+        QVector<Entry> parentLowest;
+        for (int start = 0; start < level.size(); start += kBuildFill + 1) {
+            Node node;
+            node.leaf = false;
+            const int end = qMin(start + kBuildFill + 1, level.size());
+            for (int k = start; k < end; ++k) {
+                if (k > start) node.entries.append(lowest.at(k));
+                node.children.append(level.at(k));
+            }
+            parentLowest.append(lowest.at(start));
+            parents.append(data->nodes.size());
+            data->nodes.append(node);
+        }
+        level = parents;
+        lowest = parentLowest;
+    }
+    data->root = level.first();
+}
+
+void xhybtree::invalidate() {
+    d = QSharedDataPointer<Data>(new Data);
+}
+
+void xhybtree::insert(const xhyrecord& record) {
+    if (!isBuilt()) return;
+    const Entry entry{keyOf(record), record.rowId()};
+    Data* data = d.data();
+    Entry separator;
+    const int split = insertInto(*data, data->root, entry, &separator);
+    if (split >= 0) {
+        Node root;
+        root.leaf = false;
+        root.entries.append(separator);
+        root.children << data->root << split;
+        data->nodes.append(root);
+        data->root = data->nodes.size() - 1;
+    }
+    ++data->count;
+}
+
+// 删除不合并节点（多数数据库的 B+ 树也这样做），空叶子在扫描时直接跳过，重建时整体压实
+void xhybtree::remove(const xhyrecord& record) {
+    if (!isBuilt()) return;
+    const Entry entry{keyOf(record), record.rowId()};
+    Data* data = d.data();
+    int nodeIndex = data->root;
+    while (!data->nodes.at(nodeIndex).leaf) {
+        nodeIndex = data->nodes.at(nodeIndex).children.at(childSlot(data->nodes.at(nodeIndex), entry));
+    }
+    QVector<Entry>& entries = data->nodes[nodeIndex].entries;
+    auto it = std::lower_bound(entries.begin(), entries.end(), entry, entryLess);
+    if (it != entries.end() && !entryLess(entry, *it)) {
+        entries.erase(it);
+        --data->count;
+    }
+}
+
+void xhybtree::scan(const KeyPart& from, bool fromInclusive, const std::function<bool(const Entry&)>& visit) const {
+    if (!isBuilt()) return;
+    const Data& data = *d;
+    auto before = [&from, fromInclusive](const Entry& entry) {
+        const int c = entry.key.isEmpty() ? -1 : entry.key.first().compare(from);
+        return fromInclusive ? c < 0 : c <= 0;
+    };
+    // 分隔键在 from 之前的子树整体在 from 之前
+    int nodeIndex = data.root;
+    while (!data.nodes.at(nodeIndex).leaf) {
+        const Node& node = data.nodes.at(nodeIndex);
+        const int slot = std::partition_point(node.entries.begin(), node.entries.end(), before) - node.entries.begin();
+        nodeIndex = node.children.at(slot);
+    }
+    for (; nodeIndex >= 0; nodeIndex = data.nodes.at(nodeIndex).next) {
+        for (const Entry& entry : data.nodes.at(nodeIndex).entries) {
+            if (before(entry)) continue;
+            if (!visit(entry)) return;
+        }
+    }
+}
+
+QVector<xhybtree::Entry> xhybtree::entries() const {
+    QVector<Entry> result;
+    if (!isBuilt()) return result;
+    result.reserve(d->count);
+    int nodeIndex = d->root;
+    while (!d->nodes.at(nodeIndex).leaf) nodeIndex = d->nodes.at(nodeIndex).children.first();
+    for (; nodeIndex >= 0; nodeIndex = d->nodes.at(nodeIndex).next) result += d->nodes.at(nodeIndex).entries;
+    return result;
+}
+
+int xhybtree::childSlot(const Node& node, const Entry& entry) {
+    return std::upper_bound(node.entries.begin(), node.entries.end(), entry, entryLess) - node.entries.begin();
+}
+
+// 把 entry 插入以 nodeIndex 为根的子树；节点分裂时返回新右兄弟的下标，*separator 为右兄弟子树的下界
+int xhybtree::insertInto(Data& data, int nodeIndex, const Entry& entry, Entry* separator) {
+    if (data.nodes.at(nodeIndex).leaf) {
+        Node& leaf = data.nodes[nodeIndex];
+        leaf.entries.insert(std::upper_bound(leaf.entries.begin(), leaf.entries.end(), entry, entryLess), entry);
+        if (leaf.entries.size() <= kMaxEntries) return -1;
+        Node right;
+        right.entries = leaf.entries.mid(leaf.entries.size() / 2);
+        right.next = leaf.next;
+        leaf.entries.resize(leaf.entries.size() / 2);
+        *separator = right.entries.first();
+        data.nodes.append(right); // 之后 leaf 引用失效
+        data.nodes[nodeIndex].next = data.nodes.size() - 1;
+        return data.nodes.size() - 1;
+    }
+
+    const int slot = childSlot(data.nodes.at(nodeIndex), entry);
+    Entry childSeparator;
+    const int split = insertInto(data, data.nodes.at(nodeIndex).children.at(slot), entry, &childSeparator);
+    if (split < 0) return -1;
+    Node& node = data.nodes[nodeIndex];
+    node.entries.insert(slot, childSeparator);
+    node.children.insert(slot + 1, split);
+    if (node.entries.size() <= kMaxEntries) return -1;
+    const int mid = node.entries.size() / 2;
+    Node right;
+    right.leaf = false;
+    right.entries = node.entries.mid(mid + 1);
+    right.children = node.children.mid(mid + 1);
+    *separator = node.entries.at(mid);
+    node.entries.resize(mid);
+    node.children.resize(mid + 1);
+    data.nodes.append(right);
+    return data.nodes.size() - 1;
+}
+
+QDataStream& operator<<(QDataStream& out, const xhybtree::KeyPart& part) {
+    out << static_cast<quint8>(part.kind);
+    switch (part.kind) {
+    case xhybtree::KeyPart::Null:
+        break;
+    case xhybtree::KeyPart::Double:
+        out << part.d;
+        break;
+    case xhybtree::KeyPart::Text:
+        out << part.s;
+        break;
+    default:
+        out << part.i;
+        break;
+    }
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, xhybtree::KeyPart& part) {
+    quint8 kind = 0;
+    in >> kind;
+    if (kind >= xhybtree::KeyPart::KindCount) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+    part = xhybtree::KeyPart();
+    part.kind = static_cast<xhybtree::KeyPart::Kind>(kind);
+    switch (part.kind) {
+    case xhybtree::KeyPart::Null:
+        break;
+    case xhybtree::KeyPart::Double:
+        in >> part.d;
+        break;
+    case xhybtree::KeyPart::Text:
+        in >> part.s;
+        break;
+    default:
+        in >> part.i;
+        break;
+    }
+    return in;
+}
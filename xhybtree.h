@@ -0,0 +1,79 @@
+#ifndef XHYBTREE_H
+#define XHYBTREE_H
+
+#include "xhyindex.h"
+#include "xhyrecord.h"
+#include <QDataStream>
+#include <QList>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QVector>
+#include <functional>
+
+// CREATE INDEX 建立的 B+ 树二级索引：键为索引列的类型化值，叶子项为 (键, 行号)
+// 同键的多行按行号排列，删除时按 (键, 行号) 精确定位；树数据隐式共享，事务快照只复制指针
+class xhybtree {
+public:
+    // 键的一列：按单元的原生类型取值，无法按列类型存放的文本单元归入 Text
+    struct KeyPart {
+        enum Kind : quint8 { Null = 0, Int, Double, Date, Bool, Text, KindCount };
+        Kind kind = Null;
+        qint64 i = 0; // Int / Date(儒略日) / Bool
+        double d = 0; // Double
+        QString s;    // Text
+        int compare(const KeyPart& other) const; // 先比类型再比值
+    };
+    using Key = QVector<KeyPart>;
+    struct Entry {
+        Key key;
+        quint64 rowId = 0;
+    };
+
+    xhybtree();
+    explicit xhybtree(const xhyindex& definition);
+
+    const xhyindex& definition() const { return m_definition; }
+    void setDefinition(const xhyindex& definition) { m_definition = definition; }
+    bool isBuilt() const { return d->built; }
+    int size() const { return d->count; }
+    int height() const;
+
+    static KeyPart keyPartOf(const xhyrecord& record, int ordinal);
+    Key keyOf(const xhyrecord& record) const; // 按列名取索引列
+
+    void build(const QList<xhyrecord>& rows);   // 按记录整体重建（排序后批量装载）
+    void load(QVector<Entry> entries);          // 从 .ix 恢复
+    void invalidate();                          // 丢弃内容，下次使用前须重新 build
+    // 未建立时忽略，之后的 build 会包含全部记录
+    void insert(const xhyrecord& record);
+    void remove(const xhyrecord& record);
+
+    // 从首列 >= from（fromInclusive 为 false 时 > from）的第一项起按序访问，visit 返回 false 时停止
+    void scan(const KeyPart& from, bool fromInclusive, const std::function<bool(const Entry&)>& visit) const;
+    QVector<Entry> entries() const; // 按序导出全部项
+
+private:
+    struct Node {
+        bool leaf = true;
+        QVector<Entry> entries; // 叶子：数据项；内部节点：entries[k] 为 children[k + 1] 子树的下界
+        QVector<int> children;
+        int next = -1;          // 右侧叶子
+    };
+    struct Data : QSharedData {
+        QVector<Node> nodes;
+        int root = -1;
+        int count = 0;
+        bool built = false;
+    };
+
+    static int childSlot(const Node& node, const Entry& entry);
+    static int insertInto(Data& data, int nodeIndex, const Entry& entry, Entry* separator);
+
+    QSharedDataPointer<Data> d;
+    xhyindex m_definition;
+};
+
+QDataStream& operator<<(QDataStream& out, const xhybtree::KeyPart& part);
+QDataStream& operator>>(QDataStream& in, xhybtree::KeyPart& part);
+
+#endif // XHYBTREE_H
@@ -0,0 +1,169 @@
+#include "xhybufferpool.h"
+#include "xhypagefile.h"
+#include <QDebug>
+
+namespace {
+const int kMinFrames = 8;
+}
+
+xhybufferpool::xhybufferpool(qint64 capacityBytes)
+    : m_maxFrames(qMax<qint64>(kMinFrames, capacityBytes / xhypagefile::PageSize)) {}
+
+xhybufferpool::~xhybufferpool() {
+    QMutexLocker lock(&m_mutex);
+    for (Frame& frame : m_frames) {
+        if (frame.file && frame.dirty) writeBack(frame);
+    }
+}
+
+void xhybufferpool::setCapacity(qint64 bytes) {
+    QMutexLocker lock(&m_mutex);
+    m_maxFrames = qMax<qint64>(kMinFrames, bytes / xhypagefile::PageSize);
+    if (m_frames.size() <= m_maxFrames) return;
+
+    // 缩小：写回并移除多出的未固定页框，然后重建页表
+    QVector<Frame> kept;
+    kept.reserve(m_maxFrames);
+    for (Frame& frame : m_frames) {
+        if (frame.pins > 0 || kept.size() < m_maxFrames) {
+            kept.append(std::move(frame));
+        } else {
+            if (frame.dirty) writeBack(frame);
+            ++m_evictions;
+        }
+    }
+    m_frames.swap(kept);
+    m_pageTable.clear();
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_frames[i].file) m_pageTable.insert(qMakePair(m_frames[i].file, m_frames[i].pageNo), i);
+    }
+    m_clockHand = 0;
+}
+
+qint64 xhybufferpool::capacity() const {
+    QMutexLocker lock(&m_mutex);
+    return qint64(m_maxFrames) * xhypagefile::PageSize;
+}
+
+char* xhybufferpool::pin(xhypagefile* file, quint32 pageNo, bool isNew) {
+    QMutexLocker lock(&m_mutex);
+    const PageKey key = qMakePair(file, pageNo);
+    auto it = m_pageTable.constFind(key);
+    if (it != m_pageTable.constEnd()) {
+        Frame& frame = m_frames[it.value()];
+        ++frame.pins;
+        frame.referenced = true;
+        if (isNew) frame.data.fill('\0');
+        ++m_hits;
+        return frame.data.data();
+    }
+
+    ++m_misses;
+    int index = -1;
+    if (m_frames.size() < m_maxFrames) {
+        m_frames.append(Frame());
+        index = m_frames.size() - 1;
+        m_frames[index].data = QByteArray(xhypagefile::PageSize, '\0');
+    } else {
+        index = findVictim();
+        if (index < 0) {
+            // 所有页框都被固定，临时超出上限
+            qWarning() << "[BUFFER_POOL] 所有页框均被固定，临时超出内存上限。";
+            m_frames.append(Frame());
+            index = m_frames.size() - 1;
+            m_frames[index].data = QByteArray(xhypagefile::PageSize, '\0');
+        } else {
+            Frame& victim = m_frames[index];
+            if (victim.dirty && !writeBack(victim)) return nullptr;
+            m_pageTable.remove(qMakePair(victim.file, victim.pageNo));
+            ++m_evictions;
+        }
+    }
+
+    Frame& frame = m_frames[index];
+    frame.file = file;
+    frame.pageNo = pageNo;
+    frame.pins = 1;
+    frame.dirty = false;
+    frame.referenced = true;
+    if (isNew) {
+        frame.data.fill('\0');
+    } else if (!file->readPage(pageNo, frame.data.data())) {
+        frame.file = nullptr;
+        frame.pins = 0;
+        return nullptr;
+    }
+    m_pageTable.insert(key, index);
+    return frame.data.data();
+}
+
+void xhybufferpool::unpin(xhypagefile* file, quint32 pageNo, bool dirty) {
+    QMutexLocker lock(&m_mutex);
+    auto it = m_pageTable.constFind(qMakePair(file, pageNo));
+    if (it == m_pageTable.constEnd()) return;
+    Frame& frame = m_frames[it.value()];
+    if (frame.pins > 0) --frame.pins;
+    if (dirty) frame.dirty = true;
+}
+
+bool xhybufferpool::flush(xhypagefile* file) {
+    QMutexLocker lock(&m_mutex);
+    bool ok = true;
+    for (Frame& frame : m_frames) {
+        if (frame.file == file && frame.dirty) ok = writeBack(frame) && ok;
+    }
+    return ok;
+}
+
+void xhybufferpool::discard(xhypagefile* file) {
+    QMutexLocker lock(&m_mutex);
+    for (Frame& frame : m_frames) {
+        if (frame.file != file) continue;
+        m_pageTable.remove(qMakePair(frame.file, frame.pageNo));
+        frame.file = nullptr;
+        frame.pins = 0;
+        frame.dirty = false;
+        frame.referenced = false;
+    }
+}
+
+quint64 xhybufferpool::hits() const {
+    QMutexLocker lock(&m_mutex);
+    return m_hits;
+}
+
+quint64 xhybufferpool::misses() const {
+    QMutexLocker lock(&m_mutex);
+    return m_misses;
+}
+
+quint64 xhybufferpool::evictions() const {
+    QMutexLocker lock(&m_mutex);
+    return m_evictions;
+}
+
+int xhybufferpool::findVictim() {
+    // 最多转两圈：第一圈清引用位，第二圈必能找到未固定的页框
+    for (int step = 0; step < m_frames.size() * 2; ++step) {
+        const int index = m_clockHand;
+        m_clockHand = (m_clockHand + 1) % m_frames.size();
+        Frame& frame = m_frames[index];
+        if (!frame.file) return index;
+        if (frame.pins > 0) continue;
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+        return index;
+    }
+    return -1;
+}
+
+bool xhybufferpool::writeBack(Frame& frame) {
+    if (!frame.file->writePage(frame.pageNo, frame.data.data())) {
+        qWarning() << "[BUFFER_POOL] 写回页失败:" << frame.pageNo;
+        return false;
+    }
+    frame.dirty = false;
+    return true;
+}
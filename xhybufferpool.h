@@ -0,0 +1,56 @@
+#ifndef XHYBUFFERPOOL_H
+#define XHYBUFFERPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+
+class xhypagefile;
+
+// 页缓冲池：所有分页记录文件共享，按 CLOCK 算法淘汰，脏页在淘汰或 flush 时写回
+class xhybufferpool {
+public:
+    explicit xhybufferpool(qint64 capacityBytes = 64 * 1024 * 1024);
+    ~xhybufferpool();
+
+    void setCapacity(qint64 bytes); // 内存上限，至少保留 8 个页框
+    qint64 capacity() const;
+
+    // 固定一页并返回其内存；isNew 为真时不读盘直接清零。用完必须 unpin
+    char* pin(xhypagefile* file, quint32 pageNo, bool isNew = false);
+    void unpin(xhypagefile* file, quint32 pageNo, bool dirty);
+
+    bool flush(xhypagefile* file);   // 写回该文件的所有脏页
+    void discard(xhypagefile* file); // 丢弃该文件的所有页框（不写回）
+
+    quint64 hits() const;
+    quint64 misses() const;
+    quint64 evictions() const;
+
+private:
+    struct Frame {
+        xhypagefile* file = nullptr;
+        quint32 pageNo = 0;
+        QByteArray data;
+        int pins = 0;
+        bool dirty = false;
+        bool referenced = false;
+    };
+    using PageKey = QPair<xhypagefile*, quint32>;
+
+    int findVictim();         // CLOCK：跳过被固定的页框，清除引用位直到找到可淘汰的
+    bool writeBack(Frame& frame);
+
+    mutable QMutex m_mutex;
+    QVector<Frame> m_frames;
+    QHash<PageKey, int> m_pageTable;
+    int m_maxFrames;
+    int m_clockHand = 0;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+    quint64 m_evictions = 0;
+};
+
+#endif // XHYBUFFERPOOL_H
@@ -0,0 +1,542 @@
+#include "xhycheck.h"
+#include "xhypredicate.h"
+#include <QDate>
+#include <QDateTime>
+#include <QHash>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+struct Token {
+    enum Type { Identifier, Number, String, Symbol, Keyword, End };
+    Type type = End;
+    QString text; // Keyword 为大写
+};
+
+const QStringList kKeywords = {"AND", "OR", "NOT", "IS", "NULL", "LIKE", "IN", "BETWEEN", "TRUE", "FALSE"};
+
+QVector<Token> tokenize(const QString& text) {
+    QVector<Token> tokens;
+    int i = 0;
+    const int n = text.size();
+    while (i < n) {
+        const QChar c = text.at(i);
+        if (c.isSpace()) { ++i; continue; }
+        Token token;
+        if (c == '\'' || c == '"') { // 字符串；两个连续引号表示一个引号
+            token.type = Token::String;
+            ++i;
+            bool closed = false;
+            while (i < n) {
+                if (text.at(i) == c) {
+                    if (i + 1 < n && text.at(i + 1) == c) { token.text += c; i += 2; continue; }
+                    ++i;
+                    closed = true;
+                    break;
+                }
+                token.text += text.at(i++);
+            }
+            if (!closed) throw std::runtime_error("字符串缺少结束引号");
+        } else if (c == '`' || c == '[') { // 加引号的列名
+            const QChar close = c == '`' ? QChar('`') : QChar(']');
+            const int end = text.indexOf(close, i + 1);
+            if (end < 0) throw std::runtime_error("列名缺少结束符号");
+            token.type = Token::Identifier;
+            token.text = text.mid(i + 1, end - i - 1);
+            i = end + 1;
+        } else if (c.isDigit() || (c == '.' && i + 1 < n && text.at(i + 1).isDigit())) {
+            int end = i;
+            while (end < n && (text.at(end).isDigit() || text.at(end) == '.')) ++end;
+            if (end < n && (text.at(end) == 'e' || text.at(end) == 'E')) {
+                int exp = end + 1;
+                if (exp < n && (text.at(exp) == '+' || text.at(exp) == '-')) ++exp;
+                if (exp < n && text.at(exp).isDigit()) {
+                    end = exp;
+                    while (end < n && text.at(end).isDigit()) ++end;
+                }
+            }
+            token.type = Token::Number;
+            token.text = text.mid(i, end - i);
+            i = end;
+        } else if (c.isLetter() || c == '_') {
+            int end = i;
+            while (end < n && (text.at(end).isLetterOrNumber() || text.at(end) == '_' || text.at(end) == '.')) ++end;
+            token.text = text.mid(i, end - i);
+            token.type = kKeywords.contains(token.text.toUpper()) ? Token::Keyword : Token::Identifier;
+            if (token.type == Token::Keyword) token.text = token.text.toUpper();
+            i = end;
+        } else {
+            static const QStringList twoCharSymbols = {"<=", ">=", "<>", "!=", "=="};
+            token.type = Token::Symbol;
+            const QString two = text.mid(i, 2);
+            if (twoCharSymbols.contains(two)) {
+                token.text = two;
+                i += 2;
+            } else if (QString("()+-*/%,=<>").contains(c)) {
+                token.text = c;
+                ++i;
+            } else {
+                throw std::runtime_error(QString("无法识别的字符 '%1'").arg(c).toStdString());
+            }
+        }
+        tokens.append(token);
+    }
+    tokens.append(Token());
+    return tokens;
+}
+}
+
+// 递归下降：or > and > not > 谓词（比较/IS/LIKE/IN/BETWEEN）> 加减 > 乘除 > 一元负号 > 基本项
+class xhycheck::Parser {
+public:
+    Parser(const QString& text, const QList<xhyfield>& fields, QVector<Node>& nodes)
+        : m_tokens(tokenize(text)), m_fields(fields), m_nodes(nodes) {}
+
+    void parse() {
+        parseOr();
+        if (peek().type != Token::End) throw std::runtime_error(QString("多余的内容 '%1'").arg(peek().text).toStdString());
+    }
+
+private:
+    const Token& peek(int ahead = 0) const { return m_tokens.at(qMin(m_pos + ahead, static_cast<int>(m_tokens.size()) - 1)); }
+    bool isKeyword(const char* word, int ahead = 0) const { return peek(ahead).type == Token::Keyword && peek(ahead).text == QLatin1String(word); }
+    bool isSymbol(const char* symbol) const { return peek().type == Token::Symbol && peek().text == QLatin1String(symbol); }
+    void expectKeyword(const char* word) {
+        if (!isKeyword(word)) throw std::runtime_error(QString("此处应为 %1").arg(word).toStdString());
+        ++m_pos;
+    }
+    void expectSymbol(const char* symbol) {
+        if (!isSymbol(symbol)) throw std::runtime_error(QString("此处应为 '%1'").arg(symbol).toStdString());
+        ++m_pos;
+    }
+
+    int add(const Node& node) {
+        m_nodes.append(node);
+        return static_cast<int>(m_nodes.size()) - 1;
+    }
+    int binary(Kind kind, int left, int right) {
+        Node node;
+        node.kind = kind;
+        node.children = {left, right};
+        return add(node);
+    }
+
+    int parseOr() {
+        int left = parseAnd();
+        while (isKeyword("OR")) {
+            ++m_pos;
+            left = binary(Or, left, parseAnd());
+        }
+        return left;
+    }
+
+    int parseAnd() {
+        int left = parseNot();
+        while (isKeyword("AND")) {
+            ++m_pos;
+            left = binary(And, left, parseNot());
+        }
+        return left;
+    }
+
+    int parseNot() {
+        if (isKeyword("NOT")) {
+            ++m_pos;
+            Node node;
+            node.kind = Not;
+            node.children = {parseNot()};
+            return add(node);
+        }
+        return parsePredicate();
+    }
+
+    int parsePredicate() {
+        const int left = parseAdditive();
+        if (peek().type == Token::Symbol) {
+            static const QHash<QString, CompareOp> ops = {{"=", Eq}, {"==", Eq}, {"<>", Ne}, {"!=", Ne},
+                                                          {"<", Lt}, {"<=", Le}, {">", Gt}, {">=", Ge}};
+            const auto op = ops.constFind(peek().text);
+            if (op != ops.constEnd()) {
+                ++m_pos;
+                Node node;
+                node.kind = Compare;
+                node.compareOp = op.value();
+                node.children = {left, parseAdditive()};
+                return add(node);
+            }
+            return left;
+        }
+        if (isKeyword("IS")) {
+            ++m_pos;
+            Node node;
+            node.kind = IsNull;
+            if (isKeyword("NOT")) { node.negated = true; ++m_pos; }
+            expectKeyword("NULL");
+            node.children = {left};
+            return add(node);
+        }
+        Node node;
+        if (isKeyword("NOT") && (isKeyword("LIKE", 1) || isKeyword("IN", 1) || isKeyword("BETWEEN", 1))) {
+            node.negated = true;
+            ++m_pos;
+        }
+        if (isKeyword("LIKE")) {
+            ++m_pos;
+            if (peek().type != Token::String) throw std::runtime_error("LIKE 的模式必须是字符串");
+            node.kind = Like;
+            node.pattern = QRegularExpression(sqlLikeToRegex(peek().text), QRegularExpression::CaseInsensitiveOption);
+            ++m_pos;
+            node.children = {left};
+            return add(node);
+        }
+        if (isKeyword("IN")) {
+            ++m_pos;
+            expectSymbol("(");
+            node.kind = In;
+            while (!isSymbol(")")) {
+                if (!node.list.isEmpty()) expectSymbol(",");
+                node.list.append(parseLiteral());
+            }
+            ++m_pos;
+            node.children = {left};
+            return add(node);
+        }
+        if (isKeyword("BETWEEN")) {
+            ++m_pos;
+            node.kind = Between;
+            const int low = parseAdditive();
+            expectKeyword("AND");
+            node.children = {left, low, parseAdditive()};
+            return add(node);
+        }
+        if (node.negated) throw std::runtime_error("NOT 之后应为 LIKE、IN 或 BETWEEN");
+        return left;
+    }
+
+    int parseAdditive() {
+        int left = parseMultiplicative();
+        while (isSymbol("+") || isSymbol("-")) {
+            Node node;
+            node.kind = Arithmetic;
+            node.op = peek().text.at(0);
+            ++m_pos;
+            node.children = {left, parseMultiplicative()};
+            left = add(node);
+        }
+        return left;
+    }
+
+    int parseMultiplicative() {
+        int left = parseUnary();
+        while (isSymbol("*") || isSymbol("/") || isSymbol("%")) {
+            Node node;
+            node.kind = Arithmetic;
+            node.op = peek().text.at(0);
+            ++m_pos;
+            node.children = {left, parseUnary()};
+            left = add(node);
+        }
+        return left;
+    }
+
+    int parseUnary() {
+        if (isSymbol("-") || isSymbol("+")) {
+            const bool negate = isSymbol("-");
+            ++m_pos;
+            const int operand = parseUnary();
+            if (!negate) return operand;
+            Node node;
+            node.kind = Negate;
+            node.children = {operand};
+            return add(node);
+        }
+        return parsePrimary();
+    }
+
+    int parsePrimary() {
+        if (isSymbol("(")) {
+            ++m_pos;
+            const int inner = parseOr();
+            expectSymbol(")");
+            return inner;
+        }
+        if (peek().type == Token::Identifier) {
+            QString name = peek().text;
+            const int dot = name.lastIndexOf('.');
+            if (dot >= 0) name = name.mid(dot + 1); // 表名.列名
+            ++m_pos;
+            Node node;
+            node.kind = Column;
+            for (int i = 0; i < m_fields.size(); ++i) {
+                if (m_fields.at(i).name().compare(name, Qt::CaseInsensitive) == 0) { node.ordinal = i; break; }
+            }
+            if (node.ordinal < 0) throw std::runtime_error(QString("列 '%1' 不存在").arg(name).toStdString());
+            return add(node);
+        }
+        Node node;
+        node.kind = Literal;
+        node.value = parseLiteral();
+        return add(node);
+    }
+
+    Value parseLiteral() {
+        Value value;
+        const Token token = peek();
+        bool negative = false;
+        if (token.type == Token::Symbol && (token.text == "-" || token.text == "+") && peek(1).type == Token::Number) {
+            negative = token.text == "-";
+            ++m_pos;
+        }
+        const Token& literal = peek();
+        if (literal.type == Token::Number) {
+            bool ok = false;
+            value.type = Value::Number;
+            value.d = literal.text.toDouble(&ok);
+            if (!ok) throw std::runtime_error(QString("无效的数值 '%1'").arg(literal.text).toStdString());
+            if (negative) value.d = -value.d;
+        } else if (literal.type == Token::String) {
+            value.type = Value::Text;
+            value.s = literal.text;
+        } else if (isKeyword("TRUE") || isKeyword("FALSE")) {
+            value.type = Value::Bool;
+            value.b = isKeyword("TRUE");
+        } else if (isKeyword("NULL")) {
+            value.type = Value::Null;
+        } else {
+            if (literal.type == Token::End) throw std::runtime_error("表达式不完整");
+            throw std::runtime_error(QString("此处不应出现 '%1'").arg(literal.text).toStdString());
+        }
+        ++m_pos;
+        return value;
+    }
+
+    QVector<Token> m_tokens;
+    int m_pos = 0;
+    const QList<xhyfield>& m_fields;
+    QVector<Node>& m_nodes;
+};
+
+xhycheck xhycheck::compile(const QString& expression, const QList<xhyfield>& fields) {
+    xhycheck check;
+    try {
+        Parser(expression, fields, check.m_nodes).parse();
+    } catch (const std::runtime_error& e) {
+        check.m_nodes.clear();
+        check.m_error = QString::fromStdString(e.what());
+    }
+    return check;
+}
+
+bool xhycheck::passes(const QVector<QVariant>& values) const {
+    if (!isValid()) return false;
+    const Value result = evaluate(static_cast<int>(m_nodes.size()) - 1, values);
+    switch (result.type) {
+    case Value::Null: return true; // UNKNOWN 视为满足
+    case Value::Bool: return result.b;
+    case Value::Number: return result.d != 0;
+    case Value::Text: return !result.s.isEmpty();
+    }
+    return false;
+}
+
+xhycheck::Value xhycheck::fromVariant(const QVariant& value) {
+    Value out;
+    if (!value.isValid() || value.isNull()) return out;
+    switch (value.userType()) {
+    case QMetaType::Bool:
+        out.type = Value::Bool;
+        out.b = value.toBool();
+        break;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double:
+        out.type = Value::Number;
+        out.d = value.toDouble();
+        break;
+    case QMetaType::QDate:
+        out.type = Value::Text;
+        out.s = value.toDate().toString(Qt::ISODate);
+        break;
+    case QMetaType::QDateTime:
+        out.type = Value::Text;
+        out.s = value.toDateTime().toString(Qt::ISODateWithMs);
+        break;
+    default:
+        out.s = value.toString();
+        if (out.s.compare("NULL", Qt::CaseInsensitive) != 0) out.type = Value::Text;
+        break;
+    }
+    return out;
+}
+
+QString xhycheck::toText(const Value& value) {
+    switch (value.type) {
+    case Value::Bool: return value.b ? "true" : "false";
+    case Value::Number: return QString::number(value.d, 'g', 15);
+    case Value::Text: return value.s;
+    case Value::Null: break;
+    }
+    return QString();
+}
+
+bool xhycheck::toNumber(const Value& value, double* out) {
+    switch (value.type) {
+    case Value::Bool: *out = value.b ? 1 : 0; return true;
+    case Value::Number: *out = value.d; return true;
+    case Value::Text: {
+        bool ok = false;
+        *out = value.s.trimmed().toDouble(&ok);
+        return ok;
+    }
+    case Value::Null: break;
+    }
+    return false;
+}
+
+xhycheck::Value xhycheck::compare(const Value& left, const Value& right, CompareOp op) {
+    Value result;
+    if (left.type == Value::Null || right.type == Value::Null) return result;
+    result.type = Value::Bool;
+    int c = 0;
+    double l = 0, r = 0;
+    if (left.type == Value::Text && right.type == Value::Text) {
+        c = left.s.compare(right.s);
+    } else if (toNumber(left, &l) && toNumber(right, &r)) {
+        c = l < r ? -1 : (l > r ? 1 : 0);
+    } else { // 文本不能转为数值：按文本比较
+        c = toText(left).compare(toText(right));
+    }
+    switch (op) {
+    case Eq: result.b = c == 0; break;
+    case Ne: result.b = c != 0; break;
+    case Lt: result.b = c < 0; break;
+    case Le: result.b = c <= 0; break;
+    case Gt: result.b = c > 0; break;
+    case Ge: result.b = c >= 0; break;
+    }
+    return result;
+}
+
+xhycheck::Value xhycheck::evaluate(int index, const QVector<QVariant>& values) const {
+    const Node& node = m_nodes.at(index);
+    Value result;
+    switch (node.kind) {
+    case Literal:
+        return node.value;
+    case Column:
+        return node.ordinal < values.size() ? fromVariant(values.at(node.ordinal)) : result;
+    case Negate: {
+        double v = 0;
+        if (!toNumber(evaluate(node.children.at(0), values), &v)) return result;
+        result.type = Value::Number;
+        result.d = -v;
+        return result;
+    }
+    case Arithmetic: {
+        const Value left = evaluate(node.children.at(0), values);
+        const Value right = evaluate(node.children.at(1), values);
+        if (left.type == Value::Null || right.type == Value::Null) return result;
+        double l = 0, r = 0;
+        if (!toNumber(left, &l) || !toNumber(right, &r)) {
+            if (node.op == '+') { // 非数值文本相加为拼接
+                result.type = Value::Text;
+                result.s = toText(left) + toText(right);
+            }
+            return result;
+        }
+        result.type = Value::Number;
+        switch (node.op.unicode()) {
+        case '+': result.d = l + r; break;
+        case '-': result.d = l - r; break;
+        case '*': result.d = l * r; break;
+        case '/':
+            if (r == 0) return Value(); // 除以 0 为 NULL
+            result.d = l / r;
+            break;
+        default:
+            if (r == 0) return Value();
+            result.d = std::fmod(l, r);
+            break;
+        }
+        return result;
+    }
+    case Compare:
+        return compare(evaluate(node.children.at(0), values), evaluate(node.children.at(1), values), node.compareOp);
+    case And:
+    case Or: {
+        // 三值逻辑：AND 有假即假，OR 有真即真，否则有 UNKNOWN 即 UNKNOWN
+        const bool decisive = node.kind == Or;
+        bool unknown = false;
+        for (int child : node.children) {
+            const Value v = evaluate(child, values);
+            if (v.type == Value::Null) { unknown = true; continue; }
+            double number = 0;
+            const bool truth = v.type == Value::Bool ? v.b : (v.type == Value::Text ? !v.s.isEmpty() : (toNumber(v, &number) && number != 0));
+            if (truth == decisive) {
+                result.type = Value::Bool;
+                result.b = decisive;
+                return result;
+            }
+        }
+        if (unknown) return result;
+        result.type = Value::Bool;
+        result.b = !decisive;
+        return result;
+    }
+    case Not: {
+        const Value v = evaluate(node.children.at(0), values);
+        if (v.type == Value::Null) return result;
+        double number = 0;
+        result.type = Value::Bool;
+        result.b = !(v.type == Value::Bool ? v.b : (v.type == Value::Text ? !v.s.isEmpty() : (toNumber(v, &number) && number != 0)));
+        return result;
+    }
+    case IsNull:
+        result.type = Value::Bool;
+        result.b = (evaluate(node.children.at(0), values).type == Value::Null) != node.negated;
+        return result;
+    case Like: {
+        const Value v = evaluate(node.children.at(0), values);
+        if (v.type == Value::Null) return result;
+        result.type = Value::Bool;
+        result.b = node.pattern.match(toText(v)).hasMatch() != node.negated;
+        return result;
+    }
+    case In: {
+        const Value v = evaluate(node.children.at(0), values);
+        if (v.type == Value::Null) return result;
+        bool unknown = false;
+        for (const Value& item : node.list) {
+            const Value equal = compare(v, item, Eq);
+            if (equal.type == Value::Null) { unknown = true; continue; }
+            if (equal.b) {
+                result.type = Value::Bool;
+                result.b = !node.negated;
+                return result;
+            }
+        }
+        if (unknown) return result;
+        result.type = Value::Bool;
+        result.b = node.negated;
+        return result;
+    }
+    case Between: {
+        const Value v = evaluate(node.children.at(0), values);
+        const Value low = compare(v, evaluate(node.children.at(1), values), Ge);
+        const Value high = compare(v, evaluate(node.children.at(2), values), Le);
+        if ((low.type == Value::Bool && !low.b) || (high.type == Value::Bool && !high.b)) {
+            result.type = Value::Bool;
+            result.b = node.negated;
+            return result;
+        }
+        if (low.type == Value::Null || high.type == Value::Null) return result;
+        result.type = Value::Bool;
+        result.b = !node.negated;
+        return result;
+    }
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef XHYCHECK_H
+#define XHYCHECK_H
+
+#include "xhyfield.h"
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+// CHECK 约束：添加约束（以及表结构变化）时把表达式解析一次成按字段序号的表达式树，逐行求值不经过脚本引擎
+// 支持 AND/OR/NOT、比较（= == <> != < <= > >=）、+ - * / %、IS [NOT] NULL、[NOT] LIKE、[NOT] IN (...)、[NOT] BETWEEN ... AND ...
+// 按 SQL 三值逻辑求值：含 NULL 的比较为 UNKNOWN，结果为 UNKNOWN 时约束通过
+// 数值与文本比较时文本能转为数值则按数值比较，否则按文本（区分大小写）比较；LIKE 不区分大小写
+class xhycheck {
+public:
+    xhycheck() = default;
+    // 列名不区分大小写地按 fields 解析；解析失败时 isValid() 为 false，error() 为原因
+    static xhycheck compile(const QString& expression, const QList<xhyfield>& fields);
+
+    bool isValid() const { return m_error.isEmpty() && !m_nodes.isEmpty(); }
+    const QString& error() const { return m_error; }
+    // values 与 fields 按序号对应（xhytable::convertToTypedValue 的结果，无效 QVariant 为 NULL）；无效的表达式总是不通过
+    bool passes(const QVector<QVariant>& values) const;
+
+private:
+    enum Kind : quint8 { Literal, Column, Negate, Arithmetic, Compare, And, Or, Not, IsNull, Like, In, Between };
+    enum CompareOp : quint8 { Eq, Ne, Lt, Le, Gt, Ge };
+
+    struct Value {
+        enum Type : quint8 { Null, Bool, Number, Text };
+        Type type = Null;
+        bool b = false;
+        double d = 0;
+        QString s;
+    };
+
+    struct Node {
+        Kind kind = Literal;
+        bool negated = false;      // IS NOT NULL / NOT LIKE / NOT IN / NOT BETWEEN
+        QChar op;                  // Arithmetic：+ - * / %
+        CompareOp compareOp = Eq;  // Compare
+        int ordinal = -1;          // Column
+        QVector<int> children;
+        Value value;               // Literal
+        QVector<Value> list;       // In
+        QRegularExpression pattern; // Like
+    };
+
+    class Parser;
+
+    Value evaluate(int index, const QVector<QVariant>& values) const;
+    static Value fromVariant(const QVariant& value);
+    static QString toText(const Value& value);
+    static bool toNumber(const Value& value, double* out);
+    static Value compare(const Value& left, const Value& right, CompareOp op);
+
+    QVector<Node> m_nodes; // 根为最后一个节点
+    QString m_error;
+};
+
+#endif // XHYCHECK_H
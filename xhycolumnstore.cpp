@@ -0,0 +1,85 @@
+#include "xhycolumnstore.h"
+#include <QDebug>
+
+void xhycolumnstore::clear() {
+    m_layout = QSharedDataPointer<xhyrecordlayout>();
+    m_columns.clear();
+    m_rowCount = 0;
+}
+
+void xhycolumnstore::rebuild(const QList<xhyrecord>& rows, const QSharedDataPointer<xhyrecordlayout>& layout) {
+    m_layout = layout;
+    m_rowCount = rows.size();
+    m_columns = QVector<Column>(layout.constData()->size());
+    for (int ordinal = 0; ordinal < m_columns.size(); ++ordinal) {
+        Column& column = m_columns[ordinal];
+        column.type = layout.constData()->type(ordinal);
+        column.flags.resize(m_rowCount);
+        column.numbers.resize(m_rowCount);
+        if (column.type == xhyrecordlayout::IntColumn) column.ints.resize(m_rowCount);
+        for (int i = 0; i < m_rowCount; ++i) {
+            const Cell c = cell(rows.at(i), ordinal);
+            column.flags[i] = c.flags;
+            column.numbers[i] = c.number;
+            if (column.type == xhyrecordlayout::IntColumn) column.ints[i] = c.integer;
+        }
+    }
+    qDebug() << "[COLUMN_STORE] 构建" << m_columns.size() << "列，共" << m_rowCount << "行";
+}
+
+void xhycolumnstore::insert(int position, const xhyrecord& record) {
+    for (int ordinal = 0; ordinal < m_columns.size(); ++ordinal) {
+        Column& column = m_columns[ordinal];
+        const Cell c = cell(record, ordinal);
+        column.flags.insert(position, c.flags);
+        column.numbers.insert(position, c.number);
+        if (column.type == xhyrecordlayout::IntColumn) column.ints.insert(position, c.integer);
+    }
+    ++m_rowCount;
+}
+
+void xhycolumnstore::replace(int position, const xhyrecord& record) {
+    for (int ordinal = 0; ordinal < m_columns.size(); ++ordinal) {
+        Column& column = m_columns[ordinal];
+        const Cell c = cell(record, ordinal);
+        column.flags[position] = c.flags;
+        column.numbers[position] = c.number;
+        if (column.type == xhyrecordlayout::IntColumn) column.ints[position] = c.integer;
+    }
+}
+
+void xhycolumnstore::remove(int position) {
+    for (Column& column : m_columns) {
+        column.flags.removeAt(position);
+        column.numbers.removeAt(position);
+        if (column.type == xhyrecordlayout::IntColumn) column.ints.removeAt(position);
+    }
+    --m_rowCount;
+}
+
+xhycolumnstore::Cell xhycolumnstore::cell(const xhyrecord& record, int ordinal) const {
+    const xhyrecordlayout::StorageType type = m_columns.at(ordinal).type;
+    // 表内记录通常共享表的布局；个别记录布局不同时按列名定位
+    const int ord = record.sharesLayout(m_layout) ? ordinal : record.layout().indexOf(m_layout.constData()->name(ordinal));
+    Cell c;
+    double dv = 0;
+    if (record.isNullAt(ord)) {
+        c.flags = Column::IsNull;
+    } else if (record.intAt(ord, &c.integer)) {
+        c.number = static_cast<double>(c.integer);
+        c.flags = Column::HasText | Column::IsNumber | (type == xhyrecordlayout::IntColumn ? Column::IsNative : 0);
+    } else if (record.doubleAt(ord, &dv)) {
+        c.number = dv;
+        c.flags = Column::HasText | Column::IsNumber | (type == xhyrecordlayout::DoubleColumn ? Column::IsNative : 0);
+    } else {
+        const QString text = record.valueAt(ord);
+        bool ok = false;
+        const double parsed = text.toDouble(&ok);
+        c.flags = text.isEmpty() ? 0 : Column::HasText;
+        if (ok) {
+            c.number = parsed;
+            c.flags |= Column::IsNumber;
+        }
+    }
+    return c;
+}
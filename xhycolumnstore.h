@@ -0,0 +1,52 @@
+#ifndef XHYCOLUMNSTORE_H
+#define XHYCOLUMNSTORE_H
+
+#include "xhyrecord.h"
+#include <QVector>
+
+// 列存表（CREATE TABLE ... WITH (storage=column)）的列向量
+// 每列是连续的类型化数组，与表的记录列表按下标一一对应；表在每次插入、修改、删除（以及回滚、重做）时同步更新，
+// 查询只读不写。记录列表仍然保留（逐行的算子、约束与持久化都使用它），所以列存表比行存表多占用每单元约 9-17 字节
+// 列向量隐式共享：复制表（事务快照、检查点、只读视图）不复制数据
+class xhycolumnstore {
+public:
+    struct Column {
+        enum Flag : quint8 {
+            IsNull = 1,   // SQL NULL 或未赋值
+            HasText = 2,  // 文本表示非空（COUNT 计数）
+            IsNumber = 4, // 文本可转为 double（SUM/AVG/MIN/MAX 参与计算）
+            IsNative = 8  // 单元按列类型原生存放，可直接按 ints/numbers 比较
+        };
+        xhyrecordlayout::StorageType type = xhyrecordlayout::TextColumn;
+        QVector<quint8> flags;
+        QVector<double> numbers; // 与 value().toDouble() 一致；非数值为 0
+        QVector<qint64> ints;    // 仅整数列
+    };
+
+    void clear();
+    // 按表的布局整体构建（开启列存、加载、表结构变化后）
+    void rebuild(const QList<xhyrecord>& rows, const QSharedDataPointer<xhyrecordlayout>& layout);
+    void insert(int position, const xhyrecord& record);
+    void replace(int position, const xhyrecord& record);
+    void remove(int position);
+
+    // 按 layout 构建且行数为 rowCount 时列向量可用
+    bool isCurrent(const QSharedDataPointer<xhyrecordlayout>& layout, int rowCount) const {
+        return m_layout.constData() == layout.constData() && m_rowCount == rowCount;
+    }
+    const Column& column(int ordinal) const { return m_columns.at(ordinal); }
+
+private:
+    struct Cell {
+        quint8 flags = 0;
+        double number = 0;
+        qint64 integer = 0;
+    };
+    Cell cell(const xhyrecord& record, int ordinal) const;
+
+    QSharedDataPointer<xhyrecordlayout> m_layout;
+    QVector<Column> m_columns; // 按布局中的列序号
+    int m_rowCount = 0;
+};
+
+#endif // XHYCOLUMNSTORE_H
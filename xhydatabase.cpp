@@ -2,7 +2,8 @@
 #include <QDebug>
 #include <stdexcept> // For std::runtime_error
 
-xhydatabase::xhydatabase(const QString& name) : m_name(name), m_inTransaction(false) {}
+xhydatabase::xhydatabase(const QString& name)
+    : m_name(name), m_inTransaction(false), m_mvcc(QSharedPointer<xhymvcc>::create()) {}
 
 QString xhydatabase::name() const {
     return m_name;
@@ -43,6 +44,16 @@ bool xhydatabase::has_table(const QString& table_name) const {
     return false;
 }
 
+QList<xhytable*> xhydatabase::dirtyTables() {
+    QList<xhytable*> result;
+    for (auto& table : m_tables) {
+        if (table.isDirty()) {
+            result.append(&table);
+        }
+    }
+    return result;
+}
+
 bool xhydatabase::createtable(const xhytable& table_data_const) {
     if (has_table(table_data_const.name())) {
         qWarning() << "创建表失败：表 '" << table_data_const.name() << "' 在数据库 '" << m_name << "' 中已存在。";
@@ -58,6 +69,8 @@ bool xhydatabase::createtable(const xhytable& table_data_const) {
     }
     // newTable.setParentDb(this); // 另一种设置方式，如果在构造函数中未设置
 
+    snapshotBeforeSchemaChange();
+    if (m_inTransaction) newTable.beginTransaction();
     m_tables.append(newTable);
     qDebug() << "表 '" << newTable.name() << "' 已成功创建在数据库 '" << m_name << "' 并设置了父数据库引用。";
     return true;
@@ -69,6 +82,8 @@ void xhydatabase::addTable(xhytable& table) { // 修改为接收引用
         return;
     }
     table.setParentDb(this); // 关键：设置表的父数据库指针
+    snapshotBeforeSchemaChange();
+    if (m_inTransaction) table.beginTransaction();
     m_tables.append(table);
     qDebug() << "表 '" << table.name() << "' 已添加到数据库 '" << m_name << "' 并设置了父数据库引用。";
 }
@@ -76,9 +91,9 @@ void xhydatabase::addTable(xhytable& table) { // 修改为接收引用
 bool xhydatabase::droptable(const QString& tablename) {
     for (auto it = m_tables.begin(); it != m_tables.end(); ++it) {
         if (it->name().compare(tablename, Qt::CaseInsensitive) == 0) {
+            snapshotBeforeSchemaChange();
             it = m_tables.erase(it);
             qDebug() << "表 '" << tablename << "' 已从数据库 '" << m_name << "' 中删除。";
-            m_indexes.removeIf([&](const xhyindex& idx){ return idx.tableName().compare(tablename, Qt::CaseInsensitive) == 0; });
             return true;
         }
     }
@@ -91,10 +106,14 @@ void xhydatabase::beginTransaction() {
         qWarning() << "数据库 '" << m_name << "' 已处于事务中，无法重复开始事务。";
         return;
     }
-    m_transactionCache = m_tables;
+    // 只置标记，不复制表和记录
     for(xhytable& table : m_tables) {
         table.beginTransaction();
     }
+    m_transactionCache.clear();
+    m_hasSchemaSnapshot = false;
+    m_schemaChanges = 0;
+    m_savepoints.clear();
     m_inTransaction = true;
     qDebug() << "数据库 '" << m_name << "' 事务开始。";
 }
@@ -104,10 +123,16 @@ void xhydatabase::commit() {
         qWarning() << "数据库 '" << m_name << "' 不在事务中，无法提交。";
         return;
     }
+    // 新版本全部盖上提交时间戳后才发布，之后打开的快照才能看到它们；随后回收已无快照需要的旧版本
+    const quint64 commitTimestamp = m_mvcc->reserveCommit();
     for(xhytable& table : m_tables) {
-        table.commit();
+        table.commit(commitTimestamp);
     }
+    m_mvcc->publish(commitTimestamp);
+    collectVersions();
     m_transactionCache.clear();
+    m_hasSchemaSnapshot = false;
+    m_savepoints.clear();
     m_inTransaction = false;
     qDebug() << "数据库 '" << m_name << "' 事务提交。";
     // 实际持久化由 xhydbmanager 在其 commitTransaction 中统一处理
@@ -118,23 +143,106 @@ void xhydatabase::rollback() {
         qWarning() << "数据库 '" << m_name << "' 不在事务中，无需回滚。";
         return;
     }
-    m_tables = m_transactionCache; // 从快照恢复表列表
-    // 对于 m_tables 中的每个表，它们在 beginTransaction 时其 m_tempRecords 被 m_records 初始化。
-    // 它们自己的 rollback 会清空 m_tempRecords 并将 m_inTransaction 设置为 false。
-    // 由于 m_tables 列表本身被恢复了，所以内部的表对象也是事务开始时的状态。
-    // 我们仍然需要调用每个表的 rollback，以确保它们内部的 m_inTransaction 标志被正确重置。
-    for(xhytable& table : m_tables) { // 这里的 m_tables 已经是回滚后的列表
-        table.rollback();
+    if (m_hasSchemaSnapshot) {
+        // 改过表结构：恢复快照中的表，它们的撤销日志只含快照之前的行修改。
+        // 结构变化可能已写入文件，与当前表不同的表标记为结构已修改，下次提交或检查点时整体写出
+        QHash<QString, quint64> liveVersions;
+        for (const xhytable& table : m_tables) liveVersions.insert(table.name().toLower(), table.version());
+        m_tables = m_transactionCache;
+        for (xhytable& table : m_tables) {
+            const QString key = table.name().toLower();
+            if (!liveVersions.contains(key) || liveVersions.value(key) != table.version()) table.markSchemaDirty();
+        }
+    }
+    for(xhytable& table : m_tables) {
+        table.rollback(); // 按撤销日志逆序恢复行
     }
     m_transactionCache.clear();
+    m_hasSchemaSnapshot = false;
+    m_savepoints.clear();
     m_inTransaction = false;
     qDebug() << "数据库 '" << m_name << "' 事务回滚。";
 }
 
+void xhydatabase::snapshotBeforeSchemaChange() {
+    if (!m_inTransaction) return;
+    ++m_schemaChanges;
+    if (m_hasSchemaSnapshot) return;
+    // 表对象正在被原地修改，快照必须持有独立的副本；记录等成员仍是隐式共享的，复制开销与表的个数成正比
+    m_transactionCache = m_tables;
+    m_transactionCache.detach();
+    m_hasSchemaSnapshot = true;
+    qDebug() << "数据库 '" << m_name << "' 事务中修改表结构，已保存表列表快照。";
+}
+
+xhysnapshot xhydatabase::openSnapshot() const {
+    return m_mvcc->openSnapshot();
+}
+
+void xhydatabase::collectVersions() {
+    const quint64 horizon = m_mvcc->horizon();
+    for (xhytable& table : m_tables) table.collectVersions(horizon);
+}
+
+void xhydatabase::prepareReads() {
+    for (xhytable& table : m_tables) table.prepareReads();
+}
+
+bool xhydatabase::readsPrepared() const {
+    for (const xhytable& table : m_tables) {
+        if (!table.readsPrepared()) return false;
+    }
+    return true;
+}
+
+int xhydatabase::findSavepoint(const QString& name) const {
+    for (int i = m_savepoints.size() - 1; i >= 0; --i) {
+        if (m_savepoints.at(i).name.compare(name, Qt::CaseInsensitive) == 0) return i;
+    }
+    return -1;
+}
+
+void xhydatabase::savepoint(const QString& name) {
+    if (!m_inTransaction) {
+        throw std::runtime_error("SAVEPOINT 只能在事务中使用。");
+    }
+    Savepoint point;
+    point.name = name;
+    point.schemaChanges = m_schemaChanges;
+    for (const xhytable& table : m_tables) {
+        if (table.undoLogSize() > 0) point.undoLogSizes.insert(table.name().toLower(), table.undoLogSize());
+    }
+    m_savepoints.append(point);
+    qDebug() << "数据库 '" << m_name << "' 设置保存点" << name;
+}
+
+void xhydatabase::rollbackToSavepoint(const QString& name) {
+    const int index = m_inTransaction ? findSavepoint(name) : -1;
+    if (index < 0) {
+        throw std::runtime_error(("保存点 '" + name + "' 不存在。").toStdString());
+    }
+    const Savepoint& point = m_savepoints.at(index);
+    if (point.schemaChanges != m_schemaChanges) {
+        throw std::runtime_error(("保存点 '" + name + "' 之后修改过表结构，只能回滚整个事务。").toStdString());
+    }
+    for (xhytable& table : m_tables) {
+        table.rollbackTo(point.undoLogSizes.value(table.name().toLower(), 0));
+    }
+    m_savepoints.erase(m_savepoints.begin() + index + 1, m_savepoints.end()); // 保存点本身保留，可再次回滚到它
+    qDebug() << "数据库 '" << m_name << "' 回滚到保存点" << name;
+}
+
+void xhydatabase::releaseSavepoint(const QString& name) {
+    const int index = m_inTransaction ? findSavepoint(name) : -1;
+    if (index < 0) {
+        throw std::runtime_error(("保存点 '" + name + "' 不存在。").toStdString());
+    }
+    m_savepoints.erase(m_savepoints.begin() + index, m_savepoints.end());
+}
+
 // *** 添加 clearTables 的实现 ***
 void xhydatabase::clearTables() {
     m_tables.clear();
-    m_indexes.clear(); // 如果表被清空，相关的索引也应该清空
     qDebug() << "数据库 '" << m_name << "' 中的所有表和索引已被清除 (内存中)。";
 }
 
@@ -143,7 +251,9 @@ void xhydatabase::addTable(const xhytable& table) {
         qWarning() << "尝试添加已存在的表 '" << table.name() << "' 到数据库 '" << m_name << "'";
         return;
     }
+    snapshotBeforeSchemaChange();
     m_tables.append(table);
+    if (m_inTransaction) m_tables.last().beginTransaction();
 }
 
 
@@ -185,33 +295,33 @@ bool xhydatabase::selectData(const QString& tablename,
 }
 
 bool xhydatabase::createIndex(const xhyindex& idx) {
-    for (const auto& existing_idx : m_indexes) {
-        if (existing_idx.name().compare(idx.name(), Qt::CaseInsensitive) == 0) {
-            qWarning() << "创建索引失败：索引 '" << idx.name() << "' 已存在于数据库 '" << m_name << "'";
-            return false;
-        }
+    if (findIndexByName(idx.name())) {
+        qWarning() << "创建索引失败：索引 '" << idx.name() << "' 已存在于数据库 '" << m_name << "'";
+        return false;
     }
-    const xhytable* table = find_table(idx.tableName());
+    xhytable* table = find_table(idx.tableName());
     if (!table) {
         qWarning() << "创建索引失败：表 '" << idx.tableName() << "' 不存在于数据库 '" << m_name << "'";
         return false;
     }
+    QStringList columns; // 统一为表定义中的列名，记录按列名取值时区分大小写
     for(const QString& colName : idx.columns()) {
-        if (!table->has_field(colName)) {
+        const xhyfield* field = table->get_field(colName);
+        if (!field) {
             qWarning() << "创建索引失败：列 '" << colName << "' 不存在于表 '" << idx.tableName() << "'";
             return false;
         }
+        columns.append(field->name());
     }
-    m_indexes.append(idx);
+    if (!table->addIndex(xhyindex(idx.name(), table->name(), columns, idx.isUnique()))) return false;
     qDebug() << "索引 '" << idx.name() << "' 已在表 '" << idx.tableName() << "' 上创建。";
     return true;
 }
 
 bool xhydatabase::dropIndex(const QString& indexName) {
-    for (auto it = m_indexes.begin(); it != m_indexes.end(); ++it) {
-        if (it->name().compare(indexName, Qt::CaseInsensitive) == 0) {
-            qDebug() << "索引 '" << it->name() << "' 已从数据库 '" << m_name << "' 中删除。";
-            m_indexes.erase(it);
+    for (xhytable& table : m_tables) {
+        if (table.dropIndex(indexName)) {
+            qDebug() << "索引 '" << indexName << "' 已从数据库 '" << m_name << "' 中删除。";
             return true;
         }
     }
@@ -220,22 +330,30 @@ bool xhydatabase::dropIndex(const QString& indexName) {
 }
 
 const xhyindex* xhydatabase::findIndex(const QString& columnName) const {
-    for (const auto& index : m_indexes) {
-        if (index.columns().contains(columnName, Qt::CaseInsensitive)) {
-            return &index;
+    for (const xhytable& table : m_tables) {
+        for (const xhybtree& index : table.indexes()) {
+            if (index.definition().columns().contains(columnName, Qt::CaseInsensitive)) {
+                return &index.definition();
+            }
         }
     }
     return nullptr;
 }
 const xhyindex* xhydatabase::findIndexByName(const QString& indexName) const {
-    for (const auto& index : m_indexes) {
-        if (index.name().compare(indexName, Qt::CaseInsensitive) == 0) {
-            return &index;
+    for (const xhytable& table : m_tables) {
+        for (const xhybtree& index : table.indexes()) {
+            if (index.definition().name().compare(indexName, Qt::CaseInsensitive) == 0) {
+                return &index.definition();
+            }
         }
     }
     return nullptr;
 }
 
 QList<xhyindex> xhydatabase::allIndexes() const {
-    return m_indexes;
+    QList<xhyindex> indexes;
+    for (const xhytable& table : m_tables) {
+        for (const xhybtree& index : table.indexes()) indexes.append(index.definition());
+    }
+    return indexes;
 }
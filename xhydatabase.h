@@ -8,6 +8,7 @@
 #include "xhyindex.h"    // 确保 xhyindex.h 被包含
 #include <QVector>       // 确保 QVector 被包含 (用于 selectData)
 #include <QMap>          // 确保 QMap 被包含 (用于 insertData/updateData)
+#include <QHash>
 
 
 class xhydatabase {
@@ -21,16 +22,33 @@ public:
     xhytable* find_table(const QString& tablename);
     const xhytable* find_table(const QString& tablename) const; // const 版本
     bool has_table(const QString& table_name) const;
+    QList<xhytable*> dirtyTables(); // 自上次持久化后被修改过的表
 
     // 表操作
     bool createtable(const xhytable& table);
     bool droptable(const QString& tablename);
 
-    // 事务管理
+    // 事务管理：开始事务不复制表，行修改由各表的撤销日志回滚
+    // 事务中第一次修改表结构（建表、删表、改字段、约束、索引等）前才保存一份表列表快照，回滚时整体恢复
     void beginTransaction();
     void commit();
     void rollback();
     bool isInTransaction() const { return m_inTransaction; }
+    void snapshotBeforeSchemaChange();
+    // 保存点：按名称记录各表撤销日志的位置；同名时以最近的为准
+    // 回滚到保存点时撤销其后的行修改并丢弃其后的保存点；其后修改过表结构时抛出 std::runtime_error
+    void savepoint(const QString& name);
+    void rollbackToSavepoint(const QString& name);
+    void releaseSavepoint(const QString& name); // 同时释放其后的保存点
+
+    // 多版本读：快照只看到打开时已提交的数据，不等待写事务、也不复制表；打开快照不修改表，
+    // 旧版本由写方在提交后回收（collectVersions），读方可以与其它读方并发打开快照
+    const QSharedPointer<xhymvcc>& mvcc() const { return m_mvcc; }
+    xhysnapshot openSnapshot() const;
+    void collectVersions();
+    // 并发读之前由写方调用：加载各表延迟加载的记录、建立按需建立的索引，之后 const 的查询接口不再修改表
+    void prepareReads();
+    bool readsPrepared() const;
     void clearTables(); // 添加 clearTables 声明
     void addTable(const xhytable& table); // 添加表到当前数据库实例
 
@@ -46,7 +64,7 @@ public:
                     const ConditionNode &conditions,
                     QVector<xhyrecord>& results) const; // 改为 const
     void addTable(xhytable& table);
-    // 索引操作
+    // 索引操作：索引结构由所属的表维护，随表一起保存、删除和回滚
     bool createIndex(const xhyindex& idx);
     bool dropIndex(const QString& indexName);
     const xhyindex* findIndex(const QString& columnName) const; // 根据列名查找（可能需要调整为更合适的查找方式）
@@ -57,9 +75,19 @@ public:
 private:
     QString m_name;
     QList<xhytable> m_tables;
-    QList<xhytable> m_transactionCache; // 用于事务回滚的表快照
+    struct Savepoint {
+        QString name;
+        QHash<QString, int> undoLogSizes; // 小写表名 -> 撤销日志长度，未列出的表为 0
+        int schemaChanges = 0;
+    };
+    int findSavepoint(const QString& name) const;
+
+    QList<xhytable> m_transactionCache; // 事务中第一次改表结构前的表快照
+    bool m_hasSchemaSnapshot = false;
+    int m_schemaChanges = 0;            // 本事务中表结构修改的次数
+    QList<Savepoint> m_savepoints;
     bool m_inTransaction = false;
-    QList<xhyindex> m_indexes; // 索引列表
+    QSharedPointer<xhymvcc> m_mvcc; // 本库的提交时间戳与活动快照，数据库对象的副本共享同一份
 };
 
 #endif // XHYDATABASE_H
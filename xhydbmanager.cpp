@@ -5,8 +5,259 @@
 #include <QFile>
 #include <QDebug>
 #include <QDir>
+#include <QSaveFile>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+const quint32 TRD_LSN_HEADER = 0xFFFFFFFFu; // 旧格式 .trd 文件头标记，后跟 quint64 检查点 LSN
+const quint32 INDEX_FILE_MAGIC = 0x58485849u; // "XHXI"，.ix 文件头
+const quint32 INDEX_FILE_VERSION = 1;
+
+// 把一行按字段定义编码为 .trd 行数据（每个字段: quint8 NULL 标记 + 类型化值）
+QByteArray encode_record(const xhytable& table, const xhyrecord& record) {
+    QByteArray recordDataBuffer; // Buffer for a single record's fields
+    QDataStream record_field_stream(&recordDataBuffer, QIODevice::WriteOnly);
+    record_field_stream.setVersion(QDataStream::Qt_5_15);
+
+    for (const auto& field : table.fields()) {
+        QString str_value_from_record = record.value(field.name());
+
+        if (str_value_from_record.isNull()) { // Check for genuinely null QString (SQL NULL)
+            record_field_stream << static_cast<quint8>(1); // Marker: 1 for NULL
+        } else {
+            record_field_stream << static_cast<quint8>(0); // Marker: 0 for NOT NULL
+            bool conversion_ok = true; // Assume conversion will be ok
+
+            switch (field.type()) {
+            case xhyfield::TINYINT:
+                record_field_stream << static_cast<qint8>(str_value_from_record.toShort(&conversion_ok));
+                if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for TINYINT field '" << field.name() << "', value: '" << str_value_from_record << "'";
+                break;
+            case xhyfield::SMALLINT:
+                record_field_stream << static_cast<qint16>(str_value_from_record.toShort(&conversion_ok));
+                if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for SMALLINT field '" << field.name() << "', value: '" << str_value_from_record << "'";
+                break;
+            case xhyfield::INT:
+                record_field_stream << str_value_from_record.toInt(&conversion_ok);
+                if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for INT field '" << field.name() << "', value: '" << str_value_from_record << "'";
+                break;
+            case xhyfield::BIGINT:
+                record_field_stream << str_value_from_record.toLongLong(&conversion_ok);
+                if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for BIGINT field '" << field.name() << "', value: '" << str_value_from_record << "'";
+                break;
+            case xhyfield::FLOAT:
+                record_field_stream << str_value_from_record.toFloat(&conversion_ok);
+                if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for FLOAT field '" << field.name() << "', value: '" << str_value_from_record << "'";
+                break;
+            case xhyfield::DOUBLE:
+                record_field_stream << str_value_from_record.toDouble(&conversion_ok);
+                if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for DOUBLE field '" << field.name() << "', value: '" << str_value_from_record << "'";
+                break;
+            case xhyfield::DECIMAL: // Store DECIMAL as string to preserve precision
+            case xhyfield::CHAR:
+            case xhyfield::VARCHAR:
+            case xhyfield::TEXT:
+            case xhyfield::ENUM: { // Store ENUM as its string value
+                QByteArray strBytes = str_value_from_record.toUtf8();
+                record_field_stream << strBytes; // QDataStream handles length-prefix for QByteArray
+                break;
+            }
+            case xhyfield::DATE: {
+                QDate date = QDate::fromString(str_value_from_record, "yyyy-MM-dd");
+                if (!date.isValid() && !str_value_from_record.isEmpty()) { // If original string was non-empty but invalid
+                    qWarning() << "[SAVE_TRD] Invalid date string '" << str_value_from_record << "' for field " << field.name() << ". Saving as invalid QDate.";
+                }
+                record_field_stream << date;
+                break;
+            }
+            case xhyfield::DATETIME:
+            case xhyfield::TIMESTAMP: { // Treat TIMESTAMP like DATETIME for serialization
+                QDateTime datetime = QDateTime::fromString(str_value_from_record, "yyyy-MM-dd HH:mm:ss");
+                if (!datetime.isValid() && !str_value_from_record.isEmpty()) {
+                    qWarning() << "[SAVE_TRD] Invalid datetime string '" << str_value_from_record << "' for field " << field.name() << ". Saving as invalid QDateTime.";
+                }
+                record_field_stream << datetime;
+                break;
+            }
+            case xhyfield::BOOL:
+                record_field_stream << (str_value_from_record.compare("true", Qt::CaseInsensitive) == 0 || str_value_from_record == "1");
+                break;
+            default:
+                qWarning() << "[SAVE_TRD] Unsupported data type for field '" << field.name() << "' (Type ID: " << static_cast<int>(field.type()) << "). Saving as raw UTF-8 string.";
+                QByteArray strBytes = str_value_from_record.toUtf8();
+                record_field_stream << strBytes; // Fallback
+                break;
+            }
+        }
+    } // end for fields in record
+    return recordDataBuffer;
+}
+
+// 快速解码：不构造 QDataStream，直接按 QDataStream(Qt_5_15) 的大端布局读取，按字段序号写入原生值
+// record 须使用 table.rowLayout()；遇到 DATETIME/TIMESTAMP 等不在此处理的类型或数据不完整时返回 false，由 decode_record 处理
+bool decode_record_fast(const QList<xhyfield>& fields, const char* data, int size, xhyrecord& record) {
+    int pos = 0;
+    auto readDouble = [&]() {
+        const quint64 bits = qFromBigEndian<quint64>(data + pos);
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        pos += 8;
+        return d;
+    };
+    for (int i = 0; i < fields.size(); ++i) {
+        if (pos + 1 > size) return false;
+        if (data[pos++] != 0) { // SQL NULL
+            record.setNullAt(i);
+            continue;
+        }
+        switch (fields.at(i).type()) {
+        case xhyfield::TINYINT:
+            if (pos + 1 > size) return false;
+            record.setIntAt(i, static_cast<qint8>(data[pos]));
+            pos += 1;
+            break;
+        case xhyfield::SMALLINT:
+            if (pos + 2 > size) return false;
+            record.setIntAt(i, qFromBigEndian<qint16>(data + pos));
+            pos += 2;
+            break;
+        case xhyfield::INT:
+            if (pos + 4 > size) return false;
+            record.setIntAt(i, qFromBigEndian<qint32>(data + pos));
+            pos += 4;
+            break;
+        case xhyfield::BIGINT:
+            if (pos + 8 > size) return false;
+            record.setIntAt(i, qFromBigEndian<qint64>(data + pos));
+            pos += 8;
+            break;
+        case xhyfield::FLOAT: // QDataStream 默认双精度写出 float
+            if (pos + 8 > size) return false;
+            record.setDoubleAt(i, static_cast<float>(readDouble()));
+            break;
+        case xhyfield::DOUBLE:
+            if (pos + 8 > size) return false;
+            record.setDoubleAt(i, readDouble());
+            break;
+        case xhyfield::DECIMAL:
+        case xhyfield::CHAR:
+        case xhyfield::VARCHAR:
+        case xhyfield::TEXT:
+        case xhyfield::ENUM: {
+            if (pos + 4 > size) return false;
+            const quint32 len = qFromBigEndian<quint32>(data + pos);
+            pos += 4;
+            if (len == 0xFFFFFFFFu) { // 空 QByteArray
+                record.setNullAt(i);
+                break;
+            }
+            if (pos + qint64(len) > size) return false;
+            record.setValueAt(i, QString::fromUtf8(data + pos, len));
+            pos += len;
+            break;
+        }
+        case xhyfield::DATE:
+            if (pos + 8 > size) return false;
+            record.setDateAt(i, qFromBigEndian<qint64>(data + pos));
+            pos += 8;
+            break;
+        case xhyfield::BOOL:
+            if (pos + 1 > size) return false;
+            record.setBoolAt(i, data[pos] != 0);
+            pos += 1;
+            break;
+        default:
+            return false;
+        }
+    }
+    return pos == size;
+}
+
+// encode_record 的逆过程；字段读取出错时返回 false
+bool decode_record(const xhytable& table, const QByteArray& record_data_buffer, xhyrecord& new_loaded_record) {
+    QDataStream field_parse_stream(record_data_buffer);
+    field_parse_stream.setVersion(QDataStream::Qt_5_15);
+    bool current_record_field_read_error = false;
+
+    for (const auto& field_def : table.fields()) {
+        if (field_parse_stream.atEnd()) {
+            qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '" << table.name() << "' 记录数据在预期字段 '" << field_def.name() << "' 之前意外结束。";
+            current_record_field_read_error = true; break;
+        }
+        QString value_to_insert_in_record;
+        quint8 is_null_marker;
+
+        field_parse_stream >> is_null_marker;
+        if (field_parse_stream.status()!= QDataStream::Ok) {
+            qWarning() << "      [LOAD_DB_TRD_ERROR] 读取字段 '" << field_def.name() << "' 的NULL标记时流错误。";
+            current_record_field_read_error = true; break;
+        }
+
+        if (is_null_marker == 0) { // Not NULL
+            switch (field_def.type()) {
+            case xhyfield::TINYINT:  { qint8 val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
+            case xhyfield::SMALLINT: { qint16 val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
+            case xhyfield::INT:      { qint32 val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
+            case xhyfield::BIGINT:   { qlonglong val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
+            case xhyfield::FLOAT:    { float val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
+            case xhyfield::DOUBLE:   { double val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
+            case xhyfield::DECIMAL:
+            case xhyfield::CHAR:
+            case xhyfield::VARCHAR:
+            case xhyfield::TEXT:
+            case xhyfield::ENUM:     { QByteArray strBytes; field_parse_stream >> strBytes; value_to_insert_in_record = QString::fromUtf8(strBytes); break; }
+            case xhyfield::DATE:     { QDate date; field_parse_stream >> date; value_to_insert_in_record = date.isValid() ? date.toString(Qt::ISODate) : QString(); break; }
+            case xhyfield::DATETIME:
+            case xhyfield::TIMESTAMP:{ QDateTime dt; field_parse_stream >> dt; value_to_insert_in_record = dt.isValid() ? dt.toString(Qt::ISODateWithMs) : QString(); break; } // Using ISODateWithMs for more precision if needed
+            case xhyfield::BOOL:     { bool bVal; field_parse_stream >> bVal; value_to_insert_in_record = bVal ? "1" : "0"; break; }
+            default:                 {
+                qWarning() << "      [LOAD_DB_TRD_WARNING] 未知数据类型 '" << field_def.typestring() << "' 用于字段 '" << field_def.name() << "'。尝试作为字符串读取。";
+                QByteArray unkData; if(!field_parse_stream.atEnd()) field_parse_stream >> unkData; value_to_insert_in_record = QString::fromUtf8(unkData); break;
+            }
+            }
+            if (field_parse_stream.status() != QDataStream::Ok) {
+                qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '" << table.name() << "' 字段 '" << field_def.name() << "' 读取非NULL值后流状态错误。值设为NULL。";
+                value_to_insert_in_record = QString(); // SQL NULL
+                current_record_field_read_error = true; // Mark as error for this record
+            }
+        } else { // is_null_marker == 1 (SQL NULL)
+            value_to_insert_in_record = QString(); // Represents SQL NULL
+        }
+        if(current_record_field_read_error) break; // Stop processing fields for this record
+        new_loaded_record.insert(field_def.name(), value_to_insert_in_record);
+    }
+
+    if (!current_record_field_read_error && !field_parse_stream.atEnd() && field_parse_stream.status() == QDataStream::Ok) {
+        qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '" << table.name() << "' 的一条记录在所有字段读取完毕后仍有尾随数据。";
+    }
+    return !current_record_field_read_error;
+}
+}
+
+xhydbmanager::FileTime xhydbmanager::FileTime::now() {
+    const QDateTime current = QDateTime::currentDateTimeUtc();
+    const QDate date = current.date();
+    const QTime time = current.time();
+    FileTime result;
+    result.year = quint16(date.year());
+    result.month = quint16(date.month());
+    result.dayOfWeek = quint16(date.dayOfWeek() % 7); // Qt 的星期日为 7，SYSTEMTIME 为 0
+    result.day = quint16(date.day());
+    result.hour = quint16(time.hour());
+    result.minute = quint16(time.minute());
+    result.second = quint16(time.second());
+    result.milliseconds = quint16(time.msec());
+    return result;
+}
 
 xhydbmanager::xhydbmanager() {
+    m_checkpointPool.setMaxThreadCount(1);
     QDir().mkdir(m_dataDir+"/data"); // 确保 data 目录存在
     load_databases_from_files();
 
@@ -20,6 +271,18 @@ xhydbmanager::xhydbmanager() {
     }
 }
 
+xhydbmanager::~xhydbmanager() {
+    // 退出前做一次同步检查点，使数据文件与日志一致
+    wait_prewarm();
+    m_checkpointPool.waitForDone();
+    if (!m_inTransaction) {
+        for (const auto& db : m_databases) {
+            if (m_wals.contains(db.name().toLower())) checkpoint(db.name(), true);
+        }
+    }
+    for (auto& wal : m_wals) wal->close();
+}
+
 bool xhydbmanager::createdatabase(const QString& dbname) {
     // 1. 检查数据库是否已存在
     for (const auto& db : m_databases) {
@@ -47,7 +310,7 @@ bool xhydbmanager::createdatabase(const QString& dbname) {
         qstrncpy(dbBlock.name, dbname.toUtf8().constData(), 128);
         dbBlock.type = false; // 用户数据库
         qstrncpy(dbBlock.filename, db_dir.path().toUtf8().constData(), 256);
-        GetSystemTime(&dbBlock.crtime);
+        dbBlock.crtime = FileTime::now();
 
         out.writeRawData(reinterpret_cast<const char*>(&dbBlock), sizeof(DatabaseBlock));
         ruankoDB.close();
@@ -75,6 +338,10 @@ bool xhydbmanager::dropdatabase(const QString& dbname) {
         if (it->name().compare(dbname, Qt::CaseInsensitive) == 0) { // 使用 compare 进行不区分大小写的比较
             // 删除数据库目录
             QString dbPath = QString("%1/data/%2").arg(m_dataDir, dbname); // m_dataDir 是您的根数据目录
+            wait_prewarm();
+            m_checkpointPool.waitForDone();
+            if (auto wal = m_wals.take(dbname.toLower())) wal->close();
+            close_page_files_under(dbPath);
             QDir db_dir(dbPath);
             if (db_dir.exists()) {
                 if (!db_dir.removeRecursively()) { // 检查删除是否成功
@@ -156,16 +423,11 @@ bool xhydbmanager::commitTransaction() {
         if (db) {
             db->commit(); // <--- 新增：让数据库对象也提交事务
 
-            // 持久化已提交的数据
-            for (const xhytable& table : db->tables()) { // db->tables() 现在返回的是已提交状态的表
-                // save_table_to_file 应该只在最外层事务成功提交后执行
-                // 如果 db->commit() 内部有复杂逻辑可能失败，需要更细致的错误处理
-            }
-            // 实际的文件保存应该在所有内存操作成功后进行
+            // 事务中的变更写入日志（结构变化时直接写出被修改过的表）
             if (success) { // 假设 db->commit() 总是成功，或者能指示成功
-                for (const xhytable& table : db->tables()) {
-                    save_table_to_file(current_database, table.name(), &table);
-                }
+                qint64 bytesWritten = commit_changes(*db);
+                m_lastCommitBytesWritten = bytesWritten;
+                qDebug() << "[COMMIT] 本次提交写入" << bytesWritten << "字节，累计" << totalBytesWritten() << "字节。";
             }
 
         } else {
@@ -205,12 +467,51 @@ void xhydbmanager::rollbackTransaction() {
         // m_tempTables 是为管理器层面的 DDL 事务准备的，例如 CREATE TABLE 后 ROLLBACK
         // 如果您的事务模型支持这种混合操作，清空它是合理的。
         m_tempTables.clear();
+        m_renamedTables.remove(current_database.toLower()); // 表名已恢复，旧文件仍有效
 
 
         m_inTransaction = false;
         qDebug() << "Transaction rolled back for database:" << current_database;
     }
 }
+
+xhysnapshot xhydbmanager::readSnapshot(const QString& dbname) {
+    if (m_inTransaction && dbname.compare(current_database, Qt::CaseInsensitive) == 0) return xhysnapshot();
+    return committedSnapshot(dbname);
+}
+
+xhysnapshot xhydbmanager::committedSnapshot(const QString& dbname) const {
+    const xhydatabase* db = find_database(dbname);
+    return db ? db->openSnapshot() : xhysnapshot();
+}
+
+void xhydbmanager::prepareReads(const QString& dbname) {
+    xhydatabase* db = find_database(dbname);
+    if (db) db->prepareReads();
+}
+
+bool xhydbmanager::readsPrepared(const QString& dbname) const {
+    const xhydatabase* db = find_database(dbname);
+    return !db || db->readsPrepared();
+}
+
+void xhydbmanager::savepoint(const QString& name) {
+    xhydatabase* db = m_inTransaction ? find_database(current_database) : nullptr;
+    if (!db) throw std::runtime_error("SAVEPOINT 只能在事务中使用。");
+    db->savepoint(name);
+}
+
+void xhydbmanager::rollbackToSavepoint(const QString& name) {
+    xhydatabase* db = m_inTransaction ? find_database(current_database) : nullptr;
+    if (!db) throw std::runtime_error("ROLLBACK TO SAVEPOINT 只能在事务中使用。");
+    db->rollbackToSavepoint(name);
+}
+
+void xhydbmanager::releaseSavepoint(const QString& name) {
+    xhydatabase* db = m_inTransaction ? find_database(current_database) : nullptr;
+    if (!db) throw std::runtime_error("RELEASE SAVEPOINT 只能在事务中使用。");
+    db->releaseSavepoint(name);
+}
 bool xhydbmanager::add_column(const QString& database_name, const QString& table_name, const xhyfield& field) {
     xhydatabase* db = find_database(database_name);
     if (!db) return false;
@@ -253,9 +554,9 @@ bool xhydbmanager::rename_table(const QString& database_name, const QString& old
         return false; // 新名称已存在
     }
 
-    // 重命名表
+    // 重命名表；新文件在提交时按脏标记整体写出，写出之后才删除旧文件（回滚时旧文件保持原样）
     table->rename(new_name);
-    // 保存更改到文件或其他存储中
+    m_renamedTables[database_name.toLower()].append(old_name);
     return true;
 }
 // 解析数据类型字符串转换为枚举值
@@ -393,14 +694,19 @@ bool xhydbmanager::update_table(const QString& database_name, const xhytable& ta
     xhytable* existing_table = db->find_table(table.name());
     if (!existing_table) return false;
 
+    // table 可能就是表列表中的元素，删除前先复制
+    const xhytable replacement = table;
+
     // 删除旧表
     db->droptable(existing_table->name());
 
     // 创建新表
-    db->createtable(table);
+    db->createtable(replacement);
 
     // 保存更新后的新表到文件
-    save_table_to_file(database_name, table.name(), &table);
+    xhytable* new_table_ptr = db->find_table(replacement.name());
+    save_table_to_file(database_name, replacement.name(), new_table_ptr ? new_table_ptr : &replacement);
+    if (new_table_ptr) new_table_ptr->clearDirty();
 
     return true; // 返回更新成功
 }
@@ -423,9 +729,10 @@ bool xhydbmanager::createtable(const QString& dbname, const xhytable& table) {
     // 并将 xhydatabase 自身的 'this' 指针作为父数据库传递给 xhytable 的构造函数。
     if (db->createtable(table)) {
         // 持久化新创建的表
-        const xhytable* new_table_ptr = db->find_table(table.name());
+        xhytable* new_table_ptr = db->find_table(table.name());
         if (new_table_ptr) {
             save_table_to_file(dbname, new_table_ptr->name(), new_table_ptr);
+            new_table_ptr->clearDirty();
             qDebug() << "表 '" << new_table_ptr->name() << "' 在数据库 '" << dbname << "' 中创建并已保存。";
             return true;
         } else {
@@ -444,15 +751,7 @@ bool xhydbmanager::droptable(const QString& dbname, const QString& tablename) {
     for (auto& db : m_databases) {
         if (db.name().toLower() == dbname.toLower()) {
             if (db.droptable(tablename)) {
-                // 删除表相关文件
-                QString basePath = QString("%1/data/%2/%3").arg(m_dataDir,dbname, tablename);
-                QFile::remove(basePath + ".tdf"); // 表定义文件
-                QFile::remove(basePath + ".trd"); // 记录文件
-                QFile::remove(basePath + ".tic"); // 完整性约束文件
-                QFile::remove(basePath + ".tid"); // 索引描述文件
-
-                // 更新表描述文件（从数据库名.tb中移除该表信息）
-                update_table_description_file(dbname, tablename, nullptr);
+                remove_table_files(dbname, tablename);
                 return true;
             }
         }
@@ -460,13 +759,39 @@ bool xhydbmanager::droptable(const QString& dbname, const QString& tablename) {
     return false;
 }
 
+void xhydbmanager::remove_table_files(const QString& dbname, const QString& tablename) {
+    m_checkpointPool.waitForDone();
+    QString basePath = QString("%1/data/%2/%3").arg(m_dataDir,dbname, tablename);
+    QFile::remove(basePath + ".tdf"); // 表定义文件
+    wait_prewarm(basePath + ".trd");
+    close_page_file(basePath + ".trd");
+    QFile::remove(basePath + ".trd"); // 记录文件
+    QFile::remove(xhypagefile::doubleWritePath(basePath + ".trd"));
+    QFile::remove(basePath + ".tic"); // 完整性约束文件
+    QFile::remove(basePath + ".tid"); // 索引描述文件
+    for (const QString& ixFile : QDir(QFileInfo(basePath).path()).entryList(QStringList() << tablename + ".*.ix", QDir::Files)) {
+        QFile::remove(QFileInfo(basePath).path() + "/" + ixFile); // 二级索引文件
+    }
+
+    // 更新表描述文件（从数据库名.tb中移除该表信息）
+    update_table_description_file(dbname, tablename, nullptr);
+}
+
+// 旧名在事务中又被使用（改回原名或新建同名表）时文件属于现在的表，不删除
+void xhydbmanager::remove_renamed_table_files(xhydatabase& db) {
+    const QStringList oldNames = m_renamedTables.take(db.name().toLower());
+    for (const QString& oldName : oldNames) {
+        if (!db.has_table(oldName)) remove_table_files(db.name(), oldName);
+    }
+}
+
 bool xhydbmanager::insertData(const QString& dbname, const QString& tablename, const QMap<QString, QString>& fieldValues) {
     for (auto& db : m_databases) {
         if (db.name() == dbname) {
             if (db.insertData(tablename, fieldValues)) {
                 // 仅在非事务模式下立即保存
                 if (!m_inTransaction || dbname != current_database) {
-                    save_table_to_file(dbname, tablename, db.find_table(tablename));
+                    m_lastCommitBytesWritten = commit_changes(db);
                 }
                 return true;
             }
@@ -482,7 +807,7 @@ int xhydbmanager::updateData(const QString& dbname, const QString& tablename, co
             if (affected > 0) {
                 // 仅在非事务模式下立即保存
                 if (!m_inTransaction || dbname != current_database) {
-                    save_table_to_file(dbname, tablename, db.find_table(tablename));
+                    m_lastCommitBytesWritten = commit_changes(db);
                 }
             }
             return affected;
@@ -498,7 +823,7 @@ int xhydbmanager::deleteData(const QString& dbname, const QString& tablename, co
             if (affected > 0) {
                 // 仅在非事务模式下立即保存
                 if (!m_inTransaction || dbname != current_database) {
-                    save_table_to_file(dbname, tablename, db.find_table(tablename));
+                    m_lastCommitBytesWritten = commit_changes(db);
                 }
             }
             return affected;
@@ -516,6 +841,25 @@ bool xhydbmanager::selectData(const QString& dbname, const QString& tablename,co
     return false;
 }
 
+bool xhydbmanager::createIndex(const QString& dbname, const xhyindex& index) {
+    xhydatabase* db = find_database(dbname);
+    if (!db || !db->createIndex(index)) return false;
+    // 仅在非事务模式下立即保存
+    if (!m_inTransaction || dbname != current_database) {
+        m_lastCommitBytesWritten = commit_changes(*db);
+    }
+    return true;
+}
+
+bool xhydbmanager::dropIndex(const QString& dbname, const QString& indexName) {
+    xhydatabase* db = find_database(dbname);
+    if (!db || !db->dropIndex(indexName)) return false;
+    if (!m_inTransaction || dbname != current_database) {
+        m_lastCommitBytesWritten = commit_changes(*db);
+    }
+    return true;
+}
+
 void xhydbmanager::save_database_to_file(const QString& dbname) {
     QDir db_dir(QString("%1/data").arg(m_dataDir, dbname));
     if (!db_dir.exists()) {
@@ -535,7 +879,14 @@ void xhydbmanager::load_databases_from_files() {
         qDebug() << "[LOAD_DB] 已创建数据目录 " << data_dir.absolutePath();
     }
 
+    QElapsedTimer load_timer;
+    load_timer.start();
+    int eager_tables = 0, deferred_tables = 0;
+
+    wait_prewarm();
+    m_checkpointPool.waitForDone();
     m_databases.clear(); // 清空内存中的数据库列表
+    m_renamedTables.clear();
     QStringList db_dirs = data_dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
     qInfo() << "[LOAD_DB] 开始从目录加载数据库和表定义: " << data_dir.path();
 
@@ -546,6 +897,19 @@ void xhydbmanager::load_databases_from_files() {
         xhydatabase* currentDbPtr = &m_databases.last(); // 获取指向刚添加的数据库对象的指针
 
         QDir db_dir_path(data_dir.filePath(dbname));
+
+        // 先读日志：检查点之后有已提交变更的表必须立即加载并重做
+        QSharedPointer<xhywal> wal = wal_for(dbname);
+        const QList<xhywal::Entry> wal_entries = wal ? wal->readCommitted() : QList<xhywal::Entry>();
+        QHash<QString, quint64> wal_max_lsn; // 小写表名 -> 日志中的最大 LSN
+        for (const xhywal::Entry& entry : wal_entries) {
+            quint64& maxLsn = wal_max_lsn[entry.tableName.toLower()];
+            maxLsn = qMax(maxLsn, entry.lsn);
+        }
+
+        quint64 header_max_lsn = 0; // 各 .trd 文件头中的最大 LSN，新的提交必须排在它之后
+        QStringList eager_paged_tables;
+        QString db_load_error; // 记录文件损坏：整个数据库不注册，文件保持原样，检查点不会覆盖它
         QStringList tdf_files = db_dir_path.entryList(QStringList() << "*.tdf", QDir::Files);
         qDebug() << "  [LOAD_DB] 在数据库 '" << dbname << "' 中找到 " << tdf_files.count() << " 个TDF文件。";
 
@@ -847,6 +1211,23 @@ void xhydbmanager::load_databases_from_files() {
                 qDebug() << "    [LOAD_DB_TDF] 文件在CHECK约束信息后已结束（可能无表级UNIQUE约束）。";
             }
             qDebug() << "    [LOAD_DB_TDF] 表级 UNIQUE 约束定义加载完毕。当前文件位置: " << tdfFile.pos();
+
+            // --- 6. 加载表选项 (WITH (...))，旧文件没有这一节 ---
+            if (tdf_load_overall_successful && static_cast<qint64>(tdfFile.size() - tdfFile.pos()) >= static_cast<qint64>(sizeof(quint32))) {
+                quint32 numOptions = 0;
+                tdf_in_stream >> numOptions;
+                for (quint32 i = 0; i < numOptions && tdf_in_stream.status() == QDataStream::Ok; ++i) {
+                    QString optionKey, optionValue;
+                    tdf_in_stream >> optionKey >> optionValue;
+                    if (tdf_in_stream.status() == QDataStream::Ok) table.m_options.insert(optionKey, optionValue);
+                }
+                if (tdf_in_stream.status() != QDataStream::Ok) {
+                    qWarning() << "    [LOAD_DB_TDF_WARNING] 读取表选项失败，按默认选项加载。";
+                    table.m_options.clear();
+                } else if (numOptions > 0) {
+                    qDebug() << "    [LOAD_DB_TDF] 表选项: " << table.m_options;
+                }
+            }
             if (!tdf_load_overall_successful) {
                 qWarning() << "  [LOAD_DB_ERROR] 表 '" << current_table_name << "' 的TDF文件加载过程中发生错误，跳过TRD加载。";
                 // No need to remove from m_databases.last().tables() yet, as it's not added until the end.
@@ -864,115 +1245,32 @@ void xhydbmanager::load_databases_from_files() {
             }
 
             // --- 加载记录数据 (.trd) ---
-            QString trdFilePath = db_dir_path.filePath(current_table_name + ".trd");
-            QFile trdFile(trdFilePath);
-            if (trdFile.exists()) {
-                if (!trdFile.open(QIODevice::ReadOnly)) {
-                    qWarning() << "    [LOAD_DB_TRD_ERROR] 打开TRD文件进行读取失败: " << trdFilePath << " 错误: " << trdFile.errorString();
-                } else {
-                    qDebug() << "    [LOAD_DB_TRD] 开始为表 '" << current_table_name << "' 从 '" << trdFilePath << "' 加载记录。";
-                    QDataStream record_file_stream(&trdFile);
-                    record_file_stream.setVersion(QDataStream::Qt_5_15);
-                    bool trd_processing_error_occurred = false;
-
-                    while (!record_file_stream.atEnd() && !trd_processing_error_occurred) {
-                        quint32 record_total_size_from_file;
-                        if(record_file_stream.status() != QDataStream::Ok) {trd_processing_error_occurred = true; break; }
-                        record_file_stream >> record_total_size_from_file;
-                        if (record_file_stream.status() != QDataStream::Ok) {
-                            if (!record_file_stream.atEnd()) { qWarning() << "    [LOAD_DB_TRD_ERROR] 读取记录大小时流错误。"; }
-                            else { qDebug() << "    [LOAD_DB_TRD] 正常到达TRD文件尾部（在读取记录大小处）。"; }
-                            break;
-                        }
-                        if (record_total_size_from_file == 0) { qDebug() << "    [LOAD_DB_TRD] 读到记录大小为0 (可能为空记录标记或文件结束)。"; continue; }
-
-                        if (static_cast<qint64>(trdFile.size() - trdFile.pos()) < static_cast<qint64>(record_total_size_from_file)) {
-                            qWarning() << "    [LOAD_DB_TRD_ERROR] 文件剩余字节不足以读取声明的记录大小: " << record_total_size_from_file;
-                            trd_processing_error_occurred = true; break;
-                        }
-
-                        QByteArray record_data_buffer(record_total_size_from_file, Qt::Uninitialized);
-                        int bytes_actually_read = record_file_stream.readRawData(record_data_buffer.data(), record_total_size_from_file);
-
-                        if (bytes_actually_read < static_cast<int>(record_total_size_from_file)) {
-                            qWarning() << "    [LOAD_DB_TRD_ERROR] 读取记录数据块错误。期望 " << record_total_size_from_file << " 字节，实际读取 " << bytes_actually_read;
-                            trd_processing_error_occurred = true; break;
-                        }
-
-                        QDataStream field_parse_stream(record_data_buffer);
-                        field_parse_stream.setVersion(QDataStream::Qt_5_15);
-                        xhyrecord new_loaded_record;
-                        bool current_record_field_read_error = false;
-
-                        for (const auto& field_def : table.fields()) {
-                            if (field_parse_stream.atEnd()) {
-                                qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '" << current_table_name << "' 记录数据在预期字段 '" << field_def.name() << "' 之前意外结束。";
-                                current_record_field_read_error = true; break;
-                            }
-                            QString value_to_insert_in_record;
-                            quint8 is_null_marker;
-
-                            field_parse_stream >> is_null_marker;
-                            if (field_parse_stream.status()!= QDataStream::Ok) {
-                                qWarning() << "      [LOAD_DB_TRD_ERROR] 读取字段 '" << field_def.name() << "' 的NULL标记时流错误。";
-                                current_record_field_read_error = true; break;
-                            }
-
-                            if (is_null_marker == 0) { // Not NULL
-                                switch (field_def.type()) {
-                                case xhyfield::TINYINT:  { qint8 val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
-                                case xhyfield::SMALLINT: { qint16 val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
-                                case xhyfield::INT:      { qint32 val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
-                                case xhyfield::BIGINT:   { qlonglong val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
-                                case xhyfield::FLOAT:    { float val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
-                                case xhyfield::DOUBLE:   { double val; field_parse_stream >> val; value_to_insert_in_record = QString::number(val); break; }
-                                case xhyfield::DECIMAL:
-                                case xhyfield::CHAR:
-                                case xhyfield::VARCHAR:
-                                case xhyfield::TEXT:
-                                case xhyfield::ENUM:     { QByteArray strBytes; field_parse_stream >> strBytes; value_to_insert_in_record = QString::fromUtf8(strBytes); break; }
-                                case xhyfield::DATE:     { QDate date; field_parse_stream >> date; value_to_insert_in_record = date.isValid() ? date.toString(Qt::ISODate) : QString(); break; }
-                                case xhyfield::DATETIME:
-                                case xhyfield::TIMESTAMP:{ QDateTime dt; field_parse_stream >> dt; value_to_insert_in_record = dt.isValid() ? dt.toString(Qt::ISODateWithMs) : QString(); break; } // Using ISODateWithMs for more precision if needed
-                                case xhyfield::BOOL:     { bool bVal; field_parse_stream >> bVal; value_to_insert_in_record = bVal ? "1" : "0"; break; }
-                                default:                 {
-                                    qWarning() << "      [LOAD_DB_TRD_WARNING] 未知数据类型 '" << field_def.typestring() << "' 用于字段 '" << field_def.name() << "'。尝试作为字符串读取。";
-                                    QByteArray unkData; if(!field_parse_stream.atEnd()) field_parse_stream >> unkData; value_to_insert_in_record = QString::fromUtf8(unkData); break;
-                                }
-                                }
-                                if (field_parse_stream.status() != QDataStream::Ok) {
-                                    qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '" << current_table_name << "' 字段 '" << field_def.name() << "' 读取非NULL值后流状态错误。值设为NULL。";
-                                    value_to_insert_in_record = QString(); // SQL NULL
-                                    current_record_field_read_error = true; // Mark as error for this record
-                                }
-                            } else { // is_null_marker == 1 (SQL NULL)
-                                value_to_insert_in_record = QString(); // Represents SQL NULL
-                            }
-                            if(current_record_field_read_error) break; // Stop processing fields for this record
-                            new_loaded_record.insert(field_def.name(), value_to_insert_in_record);
-                        }
-
-                        if (current_record_field_read_error) {
-                            qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '"<< current_table_name <<"' 的一条记录因字段读取错误而被跳过。";
-                            // trd_processing_error_occurred = true; // Optional: make it a fatal error for the whole file
-                            continue; // Skip to next record
-                        }
-
-                        if (!field_parse_stream.atEnd() && field_parse_stream.status() == QDataStream::Ok){
-                            qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '"<< current_table_name <<"' 的一条记录在所有字段读取完毕后仍有尾随数据。";
-                        }
-                        table.addrecord(new_loaded_record); // Add record to the table object
-                    }
-                    trdFile.close();
-                    qDebug() << "    [LOAD_DB_TRD] 表 '" << current_table_name << "' 的记录加载完毕。";
-                }
+            // 分页文件且无需重做时只记下加载方式，第一次访问记录时再解码
+            const QString trd_path = db_dir_path.filePath(current_table_name + ".trd");
+            if (!xhypagefile::recoverTornPages(trd_path)) { // 上次写页时崩溃，先用双写文件修复
+                db_load_error = QString("表 %1 的双写文件无法写回").arg(current_table_name);
+                break;
+            }
+            xhypagefile::HeaderInfo trd_header;
+            const bool paged = xhypagefile::readHeaderInfo(trd_path, &trd_header);
+            header_max_lsn = qMax(header_max_lsn, trd_header.walLsn);
+            const bool needs_redo = wal_max_lsn.value(current_table_name.toLower()) > trd_header.walLsn;
+            if (m_lazyLoading && paged && !needs_redo) {
+                table.setWalLsn(trd_header.walLsn);
+                table.setRowLoader([this, trd_path](xhytable& t) { load_deferred_rows(trd_path, t); });
+                ++deferred_tables;
+            } else if (paged) {
+                eager_paged_tables.append(current_table_name); // 本库的表定义全部读完后并行解码
+                ++eager_tables;
             } else {
-                qDebug() << "    [LOAD_DB_TRD] TRD文件未找到 (对于新表或空表是正常的): " << trdFilePath;
+                load_table_records(trd_path, table); // 旧格式，读入后转换
+                ++eager_tables;
             }
 
             // Add the fully loaded table to the database object
             // Only add if TDF loading was successful and the table is valid (e.g., has fields or is a special temp table)
             if (tdf_load_overall_successful && (!table.fields().isEmpty() || current_table_name.contains("_temp_"))) {
+                table.clearDirty(); // 刚从文件加载，与磁盘一致
                 currentDbPtr->addTable(table);
                 qInfo() << "  [LOAD_DB] 表 '" << current_table_name << "' 已成功加载并添加到数据库 '" << dbname << "'。";
             } else {
@@ -985,8 +1283,40 @@ void xhydbmanager::load_databases_from_files() {
                 }
             }
         } // TDF files loop ends
+
+        QList<QPair<xhytable*, QString>> decode_targets;
+        for (const QString& name : eager_paged_tables) {
+            if (xhytable* loaded = currentDbPtr->find_table(name)) {
+                decode_targets.append(qMakePair(loaded, db_dir_path.filePath(name + ".trd")));
+            }
+        }
+        if (db_load_error.isEmpty() && !decode_targets.isEmpty()) {
+            try {
+                decode_tables_parallel(decode_targets);
+            } catch (const std::runtime_error& e) {
+                db_load_error = QString::fromUtf8(e.what());
+            }
+        }
+        if (!db_load_error.isEmpty()) {
+            qCritical() << "[LOAD_DB] 数据库" << dbname << "的记录文件损坏，未加载（文件保持原样）:" << db_load_error;
+            m_databases.removeLast();
+            continue;
+        }
+
+        // 索引在重放之前装载，重放的变更随之维护
+        for (xhytable& loaded : currentDbPtr->tables()) {
+            load_table_indexes(db_dir_path.filePath(loaded.name()), loaded);
+        }
+
+        // 重放检查点之后已提交的日志
+        replay_wal(*currentDbPtr, wal_entries);
+        if (wal) wal->advanceLsn(header_max_lsn); // 截断前的旧日志可能已为空，LSN 不能从 1 重新开始
     } // Database directories loop ends
-    qInfo() << "[LOAD_DB] 所有数据库和表的加载过程完成。";
+
+    m_lastLoadMs = load_timer.elapsed();
+    qInfo() << "[LOAD_DB] 所有数据库和表的加载过程完成：" << m_databases.size() << "个数据库，"
+            << eager_tables << "个表已加载记录，" << deferred_tables << "个表延迟加载，用时" << m_lastLoadMs << "ms。";
+    prewarm_from_config();
 }
 
 
@@ -999,6 +1329,13 @@ xhydatabase* xhydbmanager::find_database(const QString& dbname) {
     return nullptr;
 }
 
+const xhydatabase* xhydbmanager::find_database(const QString& dbname) const {
+    for (const xhydatabase& db : m_databases) {
+        if (db.name().compare(dbname, Qt::CaseInsensitive) == 0) return &db;
+    }
+    return nullptr;
+}
+
 bool xhydbmanager::isInTransaction() const {
     return m_inTransaction; // 返回当前事务状态
 }
@@ -1006,15 +1343,15 @@ bool xhydbmanager::isInTransaction() const {
 
 
 // 1. 保存表定义文件
-void xhydbmanager::save_table_definition_file(const QString& filePath, const xhytable* table) {
+qint64 xhydbmanager::save_table_definition_file(const QString& filePath, const xhytable* table) {
     if (!table) {
         qWarning() << "[SAVE_TDF] Error: Table pointer is null for path " << filePath;
-        return;
+        return 0;
     }
     QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         qWarning() << "[SAVE_TDF] Error: Failed to open TDF file for writing: " << filePath;
-        return;
+        return 0;
     }
 
     QDataStream out(&file);
@@ -1072,7 +1409,7 @@ void xhydbmanager::save_table_definition_file(const QString& filePath, const xhy
         if (constraints.contains("UNIQUE", Qt::CaseInsensitive)) fb.integrities |= 0x04;
 
 
-        GetSystemTime(&fb.mtime); // Windows specific
+        fb.mtime = FileTime::now();
         out.writeRawData(reinterpret_cast<const char*>(&fb), sizeof(FieldBlock));
     }
 
@@ -1142,129 +1479,94 @@ void xhydbmanager::save_table_definition_file(const QString& filePath, const xhy
         }
         qDebug() << "    [SAVE_TDF_UNIQUE_TABLE] 已保存表级 UNIQUE 约束:" << it.key() << " ON (" << columns.join(", ") << ")";
     }
-     file.close();
-
+    // 表选项
+    const QMap<QString, QString>& options = table->options();
+    out << static_cast<quint32>(options.size());
+    for (auto it = options.constBegin(); it != options.constEnd(); ++it) {
+        out << it.key() << it.value();
+    }
+    qint64 written = file.pos();
+    file.close();
+    return written;
 }
 
 // 2. 保存记录文件
-void xhydbmanager::save_table_records_file(const QString& filePath, const xhytable* table) {
+qint64 xhydbmanager::save_table_records_file(const QString& filePath, const xhytable* table, quint64 walLsn) {
     if (!table) {
         qWarning() << "[SAVE_TRD] Error: Table pointer is null for path " << filePath;
-        return;
+        return 0;
     }
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) { // Truncate to overwrite
-        qWarning() << "[SAVE_TRD] Error: Failed to open TRD file for writing:" << filePath;
-        return;
+    const QList<xhyrecord>& committed = table->getCommittedRecords();
+    qDebug() << "[SAVE_TRD] Saving TRD for table:" << table->name() << "to" << filePath << "with" << committed.count() << "records.";
+
+    // 整体重写为分页格式（原子替换），已打开的页文件随之作废
+    QList<QPair<quint64, QByteArray>> rows;
+    rows.reserve(committed.size());
+    for (const auto& record : committed) {
+        rows.append(qMakePair(record.rowId(), encode_record(*table, record)));
     }
+    close_page_file(filePath);
+    qint64 written = xhypagefile::build(filePath, rows, table->nextRowId(), walLsn);
+    if (written <= 0) {
+        qWarning() << "[SAVE_TRD] Error: Failed to write TRD file:" << filePath;
+        return 0;
+    }
+    qDebug() << "[SAVE_TRD] Finished saving TRD for table:" << table->name() << "(" << written << "bytes)";
+    return written;
+}
 
-    QDataStream out(&file);
-    out.setVersion(QDataStream::Qt_5_15);
-    qDebug() << "[SAVE_TRD] Saving TRD for table:" << table->name() << "to" << filePath << "with" << table->records().count() << "records.";
-
-    for (const auto& record : table->records()) { // records() should provide committed records
-        QByteArray recordDataBuffer; // Buffer for a single record's fields
-        QDataStream record_field_stream(&recordDataBuffer, QIODevice::WriteOnly);
-        record_field_stream.setVersion(QDataStream::Qt_5_15);
-
-        for (const auto& field : table->fields()) {
-            QString str_value_from_record = record.value(field.name());
-
-            if (str_value_from_record.isNull()) { // Check for genuinely null QString (SQL NULL)
-                record_field_stream << static_cast<quint8>(1); // Marker: 1 for NULL
-            } else {
-                record_field_stream << static_cast<quint8>(0); // Marker: 0 for NOT NULL
-                bool conversion_ok = true; // Assume conversion will be ok
-
-                switch (field.type()) {
-                case xhyfield::TINYINT:
-                    record_field_stream << static_cast<qint8>(str_value_from_record.toShort(&conversion_ok));
-                    if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for TINYINT field '" << field.name() << "', value: '" << str_value_from_record << "'";
-                    break;
-                case xhyfield::SMALLINT:
-                    record_field_stream << static_cast<qint16>(str_value_from_record.toShort(&conversion_ok));
-                    if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for SMALLINT field '" << field.name() << "', value: '" << str_value_from_record << "'";
-                    break;
-                case xhyfield::INT:
-                    record_field_stream << str_value_from_record.toInt(&conversion_ok);
-                    if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for INT field '" << field.name() << "', value: '" << str_value_from_record << "'";
-                    break;
-                case xhyfield::BIGINT:
-                    record_field_stream << str_value_from_record.toLongLong(&conversion_ok);
-                    if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for BIGINT field '" << field.name() << "', value: '" << str_value_from_record << "'";
-                    break;
-                case xhyfield::FLOAT:
-                    record_field_stream << str_value_from_record.toFloat(&conversion_ok);
-                    if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for FLOAT field '" << field.name() << "', value: '" << str_value_from_record << "'";
-                    break;
-                case xhyfield::DOUBLE:
-                    record_field_stream << str_value_from_record.toDouble(&conversion_ok);
-                    if (!conversion_ok) qWarning() << "[SAVE_TRD] Conversion warning for DOUBLE field '" << field.name() << "', value: '" << str_value_from_record << "'";
-                    break;
-                case xhyfield::DECIMAL: // Store DECIMAL as string to preserve precision
-                case xhyfield::CHAR:
-                case xhyfield::VARCHAR:
-                case xhyfield::TEXT:
-                case xhyfield::ENUM: { // Store ENUM as its string value
-                    QByteArray strBytes = str_value_from_record.toUtf8();
-                    record_field_stream << strBytes; // QDataStream handles length-prefix for QByteArray
-                    break;
-                }
-                case xhyfield::DATE: {
-                    QDate date = QDate::fromString(str_value_from_record, "yyyy-MM-dd");
-                    if (!date.isValid() && !str_value_from_record.isEmpty()) { // If original string was non-empty but invalid
-                        qWarning() << "[SAVE_TRD] Invalid date string '" << str_value_from_record << "' for field " << field.name() << ". Saving as invalid QDate.";
-                    }
-                    record_field_stream << date;
-                    break;
-                }
-                case xhyfield::DATETIME:
-                case xhyfield::TIMESTAMP: { // Treat TIMESTAMP like DATETIME for serialization
-                    QDateTime datetime = QDateTime::fromString(str_value_from_record, "yyyy-MM-dd HH:mm:ss");
-                    if (!datetime.isValid() && !str_value_from_record.isEmpty()) {
-                        qWarning() << "[SAVE_TRD] Invalid datetime string '" << str_value_from_record << "' for field " << field.name() << ". Saving as invalid QDateTime.";
-                    }
-                    record_field_stream << datetime;
-                    break;
-                }
-                case xhyfield::BOOL:
-                    record_field_stream << (str_value_from_record.compare("true", Qt::CaseInsensitive) == 0 || str_value_from_record == "1");
-                    break;
-                default:
-                    qWarning() << "[SAVE_TRD] Unsupported data type for field '" << field.name() << "' (Type ID: " << static_cast<int>(field.type()) << "). Saving as raw UTF-8 string.";
-                    QByteArray strBytes = str_value_from_record.toUtf8();
-                    record_field_stream << strBytes; // Fallback
-                    break;
-                }
-            }
-        } // end for fields in record
-
-        // Write the size of the record's data block, then the data block itself
-        out << static_cast<quint32>(recordDataBuffer.size());
-        out.writeRawData(recordDataBuffer.constData(), recordDataBuffer.size());
-    } // end for records in table
-    file.close();
-    qDebug() << "[SAVE_TRD] Finished saving TRD for table:" << table->name();
+// 增量写出：只把新增/修改/删除的行应用到页文件，写回被弄脏的页
+qint64 xhydbmanager::write_dirty_pages(const QString& filePath, const xhytable* table, quint64 walLsn) {
+    QSharedPointer<xhypagefile> pageFile = page_file_for(filePath);
+    if (!pageFile) return save_table_records_file(filePath, table, walLsn);
+
+    const qint64 before = pageFile->bytesWritten();
+    const QSet<quint64>& changed = table->changedRowIds();
+    bool ok = true;
+    for (quint64 rowId : table->deletedRowIds()) ok = pageFile->remove(rowId) && ok;
+    // 只访问本次变化的行；新插入的行也在 changed 中，回滚删除恢复的行可能已不在页文件里
+    for (quint64 rowId : changed) {
+        const xhyrecord* record = table->committedRecord(rowId);
+        if (!record) continue;
+        if (table->insertedRowIds().contains(rowId) && !pageFile->contains(rowId)) {
+            ok = pageFile->insert(rowId, encode_record(*table, *record)) && ok;
+        } else {
+            ok = pageFile->update(rowId, encode_record(*table, *record)) && ok;
+        }
+    }
+    pageFile->setNextRowId(table->nextRowId());
+    pageFile->setWalLsn(walLsn);
+    if (!ok || !pageFile->flush()) {
+        qWarning() << "[SAVE_TRD] 增量写出失败，改为整体重写:" << filePath;
+        return save_table_records_file(filePath, table, walLsn);
+    }
+    const qint64 written = pageFile->bytesWritten() - before;
+    qDebug() << "[SAVE_TRD] 表" << table->name() << "增量写出" << changed.size() << "行修改、"
+             << table->deletedRowIds().size() << "行删除，写入" << written << "字节。";
+    return written;
 }
 
 // 3. 保存完整性约束文件
-void xhydbmanager::save_table_integrity_file(const QString& filePath, const xhytable* table) {
+qint64 xhydbmanager::save_table_integrity_file(const QString& filePath, const xhytable* table) {
+    Q_UNUSED(table);
     QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly)) {
         qWarning() << "Failed to open TIC file:" << filePath;
-        return;
+        return 0;
     }
 
     // 实现约束写入逻辑
+    qint64 written = file.pos();
     file.close();
+    return written;
 }
 
 // 4. 保存索引描述文件
-void xhydbmanager::save_table_index_file(const QString& filePath, const xhytable* table) {
+qint64 xhydbmanager::save_table_index_file(const QString& filePath, const xhytable* table) {
     QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly)) {
         qWarning() << "Failed to open TID file:" << filePath;
-        return;
+        return 0;
     }
 
     QDataStream out(&file);
@@ -1282,14 +1584,16 @@ void xhydbmanager::save_table_index_file(const QString& filePath, const xhytable
         out.writeRawData(reinterpret_cast<const char*>(&ib), sizeof(IndexBlock));
     }
 
+    qint64 written = file.pos();
     file.close();
+    return written;
 }
 
 // 5. 更新表描述文件
-void xhydbmanager::update_table_description_file(const QString& dbname, const QString& tablename, const xhytable* table) {
+qint64 xhydbmanager::update_table_description_file(const QString& dbname, const QString& tablename, const xhytable* table) {
     QString tbFilePath = QString("%1/data/%2/%3.tb").arg(m_dataDir,dbname, dbname);
     QFile file(tbFilePath);
-    if (!file.open(QIODevice::ReadWrite)) return;
+    if (!file.open(QIODevice::ReadWrite)) return 0;
 
     // 读取现有表信息
     QByteArray data = file.readAll();
@@ -1297,6 +1601,13 @@ void xhydbmanager::update_table_description_file(const QString& dbname, const QS
     QJsonObject root = doc.object();
     QJsonArray tables = root["tables"].toArray();
 
+    // 先移除同名旧条目，避免每次保存都重复追加
+    for (int i = tables.size() - 1; i >= 0; --i) {
+        if (tables[i].toObject()["name"].toString() == tablename) {
+            tables.removeAt(i);
+        }
+    }
+
     if (table) {
         // 添加或更新表信息
         QJsonObject tableObj;
@@ -1305,58 +1616,613 @@ void xhydbmanager::update_table_description_file(const QString& dbname, const QS
 
 
         tables.append(tableObj);
-    } else {
-        // 删除表信息
-        for (int i = 0; i < tables.size(); ++i) {
-            if (tables[i].toObject()["name"].toString() == tablename) {
-                tables.removeAt(i);
-                break;
-            }
-        }
     }
 
     // 写回文件
     root["tables"] = tables;
     file.resize(0);
-    file.write(QJsonDocument(root).toJson());
+    qint64 written = file.write(QJsonDocument(root).toJson());
     file.close();
+    return written;
 }
-void xhydbmanager::save_index_file(const QString& dbname, const QString& indexname, const QVector<QPair<QString, quint64>>& indexData) {
-    QString indexPath = QString("%1/%2/%3.ix").arg(m_dataDir, dbname, indexname);
-    QFile file(indexPath);
-    if (file.open(QIODevice::WriteOnly)) {
-        QDataStream out(&file);
-        out.setVersion(QDataStream::Qt_5_15);
-        for (const auto& entry : indexData) {
-            out << entry.first;   // 索引键
-            out << entry.second;  // 记录位置
+qint64 xhydbmanager::save_index_file(const QString& filePath, const xhybtree& index, quint64 walLsn) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open IX file:" << filePath;
+        return 0;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    const xhyindex& definition = index.definition();
+    out << INDEX_FILE_MAGIC << INDEX_FILE_VERSION;
+    out << definition.name() << definition.tableName() << definition.columns() << definition.isUnique() << walLsn;
+    if (!index.isBuilt()) {
+        out << qint32(-1); // 只有定义，加载后第一次使用时按记录建立
+    } else {
+        const QVector<xhybtree::Entry> entries = index.entries();
+        out << qint32(entries.size());
+        for (const xhybtree::Entry& entry : entries) {
+            for (const xhybtree::KeyPart& part : entry.key) out << part;
+            out << entry.rowId;
         }
-        file.close();
+    }
+    const qint64 written = file.pos();
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "[SAVE_IX] 写出索引文件失败:" << filePath;
+        return 0;
+    }
+    return written;
+}
+
+bool xhydbmanager::load_index_file(const QString& filePath, xhybtree* index, quint64* walLsn) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != INDEX_FILE_MAGIC || version != INDEX_FILE_VERSION) return false;
+    QString name, tableName;
+    QStringList columns;
+    bool unique = false;
+    qint32 count = 0;
+    in >> name >> tableName >> columns >> unique >> *walLsn >> count;
+    if (in.status() != QDataStream::Ok || name.isEmpty() || columns.isEmpty()) return false;
+    *index = xhybtree(xhyindex(name, tableName, columns, unique));
+    if (count < 0) return true;
+
+    QVector<xhybtree::Entry> entries;
+    entries.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        xhybtree::Entry entry;
+        entry.key.resize(columns.size());
+        for (xhybtree::KeyPart& part : entry.key) in >> part;
+        in >> entry.rowId;
+        entries.append(entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "[LOAD_IX] 索引文件" << filePath << "已损坏，改为按记录重建。";
+        return true; // 定义仍可用
+    }
+    index->load(entries);
+    return true;
+}
+
+qint64 xhydbmanager::save_table_indexes(const QString& basePath, const xhytable* table, quint64 walLsn) {
+    const QFileInfo base(basePath);
+    QDir dir(base.path());
+    const QString prefix = base.fileName() + ".";
+    QSet<QString> current;
+    qint64 written = 0;
+    for (const xhybtree& index : table->indexes()) {
+        const QString fileName = prefix + index.definition().name() + ".ix";
+        current.insert(fileName.toLower());
+        written += save_index_file(dir.filePath(fileName), index, walLsn);
+    }
+    // 表名和索引名都不含 '.'，<表名>.*.ix 只匹配本表的索引文件
+    for (const QString& fileName : dir.entryList(QStringList() << prefix + "*.ix", QDir::Files)) {
+        if (!current.contains(fileName.toLower())) QFile::remove(dir.filePath(fileName));
+    }
+    return written;
+}
+
+// .ix 与 .trd 在同一检查点写出（LSN 相同）时直接装载，否则只保留定义，第一次使用时按记录重建
+void xhydbmanager::load_table_indexes(const QString& basePath, xhytable& table) {
+    const QFileInfo base(basePath);
+    QDir dir(base.path());
+    for (const QString& fileName : dir.entryList(QStringList() << base.fileName() + ".*.ix", QDir::Files)) {
+        xhybtree index;
+        quint64 indexLsn = 0;
+        if (!load_index_file(dir.filePath(fileName), &index, &indexLsn)) {
+            qWarning() << "[LOAD_IX] 无法读取索引文件" << fileName << "，已忽略。";
+            continue;
+        }
+        bool columnsExist = true;
+        for (const QString& column : index.definition().columns()) columnsExist = columnsExist && table.has_field(column);
+        if (!columnsExist) {
+            qWarning() << "[LOAD_IX] 索引" << index.definition().name() << "引用的列已不存在，已忽略。";
+            continue;
+        }
+        if (index.isBuilt() && indexLsn != table.walLsn()) index.invalidate();
+        table.attachIndex(index);
+        qDebug() << "[LOAD_IX] 表" << table.name() << "加载索引" << index.definition().name()
+                 << (index.isBuilt() ? QString("共 %1 项").arg(index.size()) : QString("（待重建）"));
     }
 }
 // 修改save_table_to_file函数，添加索引文件保存
-void xhydbmanager::save_table_to_file(const QString& dbname, const QString& tablename, const xhytable* table) {
-    if (!table) return;
+qint64 xhydbmanager::save_table_to_file(const QString& dbname, const QString& tablename, const xhytable* table) {
+    if (!table) return 0;
 
     QString basePath = QString("%1/data/%2/%3").arg(m_dataDir, dbname, tablename);
     QDir().mkpath(QFileInfo(basePath).path());
+    qint64 written = 0;
 
     // 保存表定义文件(.tdf)
-    save_table_definition_file(basePath + ".tdf", table);
+    written += save_table_definition_file(basePath + ".tdf", table);
 
     // 保存记录文件(.trd)
-    save_table_records_file(basePath + ".trd", table);
+    written += save_table_records_file(basePath + ".trd", table, current_wal_lsn(dbname));
 
     // 保存完整性约束文件(.tic)
-    save_table_integrity_file(basePath + ".tic", table);
+    written += save_table_integrity_file(basePath + ".tic", table);
 
     // 保存索引描述文件(.tid)
-    save_table_index_file(basePath + ".tid", table);
+    written += save_table_index_file(basePath + ".tid", table);
+
+    // 保存二级索引文件(<表名>.<索引名>.ix)
+    written += save_table_indexes(basePath, table, current_wal_lsn(dbname));
 
     // 更新表描述文件([数据库名].tb)
-    update_table_description_file(dbname, tablename, table);
+    written += update_table_description_file(dbname, tablename, table);
+
+    m_totalBytesWritten += written;
+    qDebug() << "表" << tablename << "已成功保存到文件，写入" << written << "字节";
+    return written;
+}
+
+// 按脏标记持久化单个表：结构变化时整体重写（.trd 布局依赖字段定义），仅数据变化时只写 .trd
+qint64 xhydbmanager::persist_dirty_table(const QString& dbname, xhytable* table) {
+    if (!table || !table->isDirty()) return 0;
+
+    qint64 written = 0;
+    if (table->isSchemaDirty()) {
+        written = save_table_to_file(dbname, table->name(), table);
+    } else {
+        QString basePath = QString("%1/data/%2/%3").arg(m_dataDir, dbname, table->name());
+        QDir().mkpath(QFileInfo(basePath).path());
+        written = write_dirty_pages(basePath + ".trd", table, current_wal_lsn(dbname));
+        if (!table->indexes().isEmpty()) written += save_table_indexes(basePath, table, current_wal_lsn(dbname));
+        m_totalBytesWritten += written;
+    }
+    table->clearDirty();
+    return written;
+}
+
+qint64 xhydbmanager::persist_dirty_tables(xhydatabase& db) {
+    qint64 written = 0;
+    const QList<xhytable*> dirty = db.dirtyTables();
+    for (xhytable* table : dirty) {
+        written += persist_dirty_table(db.name(), table);
+    }
+    qDebug() << "[PERSIST] 数据库" << db.name() << ":" << dirty.size() << "/" << db.tables().size()
+             << "个表被修改并写出，共" << written << "字节。";
+    return written;
+}
+
+QSharedPointer<xhywal> xhydbmanager::wal_for(const QString& dbname) {
+    const QString key = dbname.toLower();
+    auto it = m_wals.find(key);
+    if (it != m_wals.end()) return it.value();
+
+    QSharedPointer<xhywal> wal(new xhywal(QString("%1/data/%2/%2.log").arg(m_dataDir, dbname)));
+    if (!wal->open()) {
+        qWarning() << "[WAL] 数据库" << dbname << "的日志无法打开，提交将直接写数据文件。";
+        return {};
+    }
+    m_wals.insert(key, wal);
+    return wal;
+}
+
+quint64 xhydbmanager::current_wal_lsn(const QString& dbname) {
+    auto it = m_wals.constFind(dbname.toLower());
+    return it != m_wals.constEnd() ? it.value()->lastLsn() : 0;
+}
+
+// 提交：收集各表尚未记录的变更写入日志并等待落盘
+qint64 xhydbmanager::commit_changes(xhydatabase& db) {
+    db.collectVersions(); // 旧版本在写方提交时回收，读方打开快照不修改表
+    bool schemaChanged = false;
+    QList<QPair<QString, RowChange>> changes;
+    for (xhytable& table : db.tables()) {
+        if (table.isSchemaDirty()) schemaChanged = true;
+        const QList<RowChange> tableChanges = table.takePendingChanges();
+        for (const RowChange& change : tableChanges) changes.append(qMakePair(table.name(), change));
+        if (!tableChanges.isEmpty()) table.markDataDirty(); // 期间若有检查点清掉了标记，这里补回
+    }
+
+    QSharedPointer<xhywal> wal = m_walEnabled ? wal_for(db.name()) : QSharedPointer<xhywal>();
+    if (!wal || schemaChanged) {
+        // 结构变化时 .trd 布局随之改变，直接写出所有脏表，之前的日志随之作废
+        m_checkpointPool.waitForDone();
+        qint64 written = persist_dirty_tables(db);
+        remove_renamed_table_files(db);
+        if (wal) wal->truncateUpTo(wal->lastLsn());
+        return written;
+    }
+    if (changes.isEmpty()) return 0;
+
+    qint64 walBytes = 0;
+    quint64 lsn = wal->appendCommit(changes, &walBytes);
+    if (!wal->sync(lsn)) {
+        qWarning() << "[WAL] 日志写盘失败，改为直接写出数据文件。";
+        m_checkpointPool.waitForDone();
+        return persist_dirty_tables(db);
+    }
+    m_totalBytesWritten += walBytes;
+
+    if (wal->size() >= m_checkpointThreshold && !m_inTransaction) {
+        checkpoint(db.name(), false);
+    }
+    return walBytes;
+}
+
+// 检查点：把脏表写成新的 .trd（文件头记录检查点 LSN），成功后截断日志
+bool xhydbmanager::checkpoint(const QString& dbname, bool wait) {
+    if (m_inTransaction) {
+        qDebug() << "[CHECKPOINT] 事务进行中，跳过检查点。";
+        return false;
+    }
+    xhydatabase* db = find_database(dbname);
+    if (!db) return false;
+    QSharedPointer<xhywal> wal = wal_for(db->name());
+    if (!wal) return persist_dirty_tables(*db) >= 0;
+
+    m_checkpointPool.waitForDone(); // 上一个检查点完成后才开始新的
+    const bool writeAll = m_checkpointFailed.exchange(false);
+    QList<xhytable> snapshots; // 记录列表隐式共享，复制开销很小
+    for (xhytable& table : db->tables()) {
+        if (table.isSchemaDirty()) {
+            persist_dirty_table(db->name(), &table); // 结构变化需整体写出
+        } else if (table.isDataDirty() || (writeAll && table.rowsLoaded())) {
+            snapshots.append(table);
+            table.clearDirty();
+        }
+    }
+    const quint64 ckptLsn = wal->lastLsn();
+    const QString dbPath = QString("%1/data/%2").arg(m_dataDir, db->name());
+
+    auto job = [this, wal, snapshots, ckptLsn, dbPath, writeAll]() {
+        bool ok = true;
+        qint64 written = 0;
+        for (const xhytable& table : snapshots) {
+            const QString trdPath = dbPath + "/" + table.name() + ".trd";
+            qint64 n = writeAll ? save_table_records_file(trdPath, &table, ckptLsn)
+                                : write_dirty_pages(trdPath, &table, ckptLsn);
+            if (n <= 0) ok = false;
+            written += n;
+            if (!table.indexes().isEmpty()) written += save_table_indexes(dbPath + "/" + table.name(), &table, ckptLsn);
+        }
+        m_totalBytesWritten += written;
+        if (ok) {
+            wal->truncateUpTo(ckptLsn);
+        } else {
+            m_checkpointFailed = true;
+            qWarning() << "[CHECKPOINT] 写出数据文件失败，保留日志，下次检查点重写全部表。";
+        }
+        qDebug() << "[CHECKPOINT]" << dbPath << ":" << snapshots.size() << "个表，写入" << written << "字节，LSN" << ckptLsn;
+    };
+    if (wait) {
+        job();
+    } else {
+        m_checkpointPool.start(job);
+    }
+    return true;
+}
+
+// 启动时重放：只应用 LSN 大于表文件头 LSN 的已提交变更（延迟加载的表没有这样的变更）
+void xhydbmanager::replay_wal(xhydatabase& db, const QList<xhywal::Entry>& entries) {
+    int applied = 0, skipped = 0, failed = 0;
+    // 各表互不影响，按表分组后每张表的变更仍保持日志顺序
+    QList<xhytable*> order;
+    QHash<xhytable*, QList<RowChange>> changes;
+    for (const xhywal::Entry& entry : entries) {
+        xhytable* table = db.find_table(entry.tableName);
+        if (!table || entry.lsn <= table->walLsn()) { ++skipped; continue; }
+        if (!changes.contains(table)) order.append(table);
+        changes[table].append(entry.change);
+    }
+    for (xhytable* table : order) {
+        const QList<RowChange>& tableChanges = changes.value(table);
+        const int tableFailed = table->redoChanges(tableChanges);
+        applied += tableChanges.size() - tableFailed;
+        failed += tableFailed;
+    }
+    if (!entries.isEmpty()) {
+        qInfo() << "[WAL] 数据库" << db.name() << "重放日志：应用" << applied << "条，跳过" << skipped << "条，失败" << failed << "条。";
+    }
+}
+
+QSharedPointer<xhypagefile> xhydbmanager::page_file_for(const QString& filePath) {
+    const QString key = QDir::cleanPath(filePath).toLower();
+    QMutexLocker lock(&m_pageFilesMutex);
+    auto it = m_pageFiles.find(key);
+    if (it != m_pageFiles.end()) return it.value();
+
+    if (QFileInfo::exists(filePath) && QFileInfo(filePath).size() > 0 && !xhypagefile::isPageFile(filePath)) {
+        return {}; // 旧格式，需要先整体重写
+    }
+    QSharedPointer<xhypagefile> pageFile(new xhypagefile(filePath, &m_bufferPool));
+    if (!pageFile->open()) return {};
+    m_pageFiles.insert(key, pageFile);
+    return pageFile;
+}
+
+void xhydbmanager::close_page_file(const QString& filePath) {
+    QMutexLocker lock(&m_pageFilesMutex);
+    if (auto pageFile = m_pageFiles.take(QDir::cleanPath(filePath).toLower())) pageFile->close();
+}
+
+void xhydbmanager::close_page_files_under(const QString& dirPath) {
+    const QString prefix = QDir::cleanPath(dirPath).toLower() + "/";
+    QMutexLocker lock(&m_pageFilesMutex);
+    for (auto it = m_pageFiles.begin(); it != m_pageFiles.end();) {
+        if (it.key().startsWith(prefix)) {
+            it.value()->close();
+            it = m_pageFiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// 加载 .trd：分页格式按页扫描；旧的长度前缀格式读完后就地转换为分页格式
+void xhydbmanager::load_table_records(const QString& trd_path, xhytable& table) {
+    if (!QFileInfo::exists(trd_path)) {
+        qDebug() << "    [LOAD_DB_TRD] TRD文件未找到 (对于新表或空表是正常的): " << trd_path;
+        return;
+    }
+
+    if (xhypagefile::isPageFile(trd_path)) {
+        decode_tables_parallel({qMakePair(&table, trd_path)});
+        return;
+    }
+
+    QFile trdFile(trd_path);
+    if (!trdFile.open(QIODevice::ReadOnly)) {
+        qWarning() << "    [LOAD_DB_TRD_ERROR] 打开TRD文件进行读取失败: " << trd_path << " 错误: " << trdFile.errorString();
+        return;
+    }
+    qDebug() << "    [LOAD_DB_TRD] 开始为表 '" << table.name() << "' 从旧格式文件 '" << trd_path << "' 加载记录。";
+    QDataStream record_file_stream(&trdFile);
+    record_file_stream.setVersion(QDataStream::Qt_5_15);
+
+    while (!record_file_stream.atEnd()) {
+        quint32 record_total_size_from_file;
+        record_file_stream >> record_total_size_from_file;
+        if (record_file_stream.status() != QDataStream::Ok) {
+            qWarning() << "    [LOAD_DB_TRD_ERROR] 读取记录大小时流错误。";
+            break;
+        }
+        if (record_total_size_from_file == TRD_LSN_HEADER) {
+            quint64 trd_wal_lsn = 0;
+            record_file_stream >> trd_wal_lsn;
+            table.setWalLsn(trd_wal_lsn);
+            continue;
+        }
+        if (record_total_size_from_file == 0) { qDebug() << "    [LOAD_DB_TRD] 读到记录大小为0 (可能为空记录标记或文件结束)。"; continue; }
+
+        if (static_cast<qint64>(trdFile.size() - trdFile.pos()) < static_cast<qint64>(record_total_size_from_file)) {
+            qWarning() << "    [LOAD_DB_TRD_ERROR] 文件剩余字节不足以读取声明的记录大小: " << record_total_size_from_file;
+            break;
+        }
+
+        QByteArray record_data_buffer(record_total_size_from_file, Qt::Uninitialized);
+        int bytes_actually_read = record_file_stream.readRawData(record_data_buffer.data(), record_total_size_from_file);
+        if (bytes_actually_read < static_cast<int>(record_total_size_from_file)) {
+            qWarning() << "    [LOAD_DB_TRD_ERROR] 读取记录数据块错误。期望 " << record_total_size_from_file << " 字节，实际读取 " << bytes_actually_read;
+            break;
+        }
+
+        xhyrecord new_loaded_record(table.rowLayout());
+        if (!decode_record(table, record_data_buffer, new_loaded_record)) {
+            qWarning() << "      [LOAD_DB_TRD_WARNING] 表 '"<< table.name() <<"' 的一条记录因字段读取错误而被跳过。";
+            continue;
+        }
+        table.addrecord(new_loaded_record); // 分配行号
+    }
+    trdFile.close();
+
+    // 转换为分页格式（经 QSaveFile 原子替换，失败时旧文件保持不变）
+    if (save_table_records_file(trd_path, &table, table.walLsn()) > 0) {
+        qInfo() << "    [LOAD_DB_TRD] 表 '" << table.name() << "' 的旧格式 .trd 已转换为分页格式。";
+    }
+}
+
+bool xhydbmanager::convert_trd_to_paged(const QString& dbname, const QString& tablename) {
+    xhydatabase* db = find_database(dbname);
+    xhytable* table = db ? db->find_table(tablename) : nullptr;
+    if (!table) return false;
+    m_checkpointPool.waitForDone();
+    const QString trdPath = QString("%1/data/%2/%3.trd").arg(m_dataDir, db->name(), table->name());
+    if (xhypagefile::isPageFile(trdPath)) return true;
+    return save_table_records_file(trdPath, table, current_wal_lsn(db->name())) > 0;
+}
+
+// 延迟加载的表第一次被访问时调用；已在后台预热的直接取结果
+void xhydbmanager::load_deferred_rows(const QString& trdPath, xhytable& table) {
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<xhytable> prewarm = m_prewarmJobs.take(QDir::cleanPath(trdPath).toLower());
+    if (prewarm.isValid()) {
+        xhytable loaded(table.name(), nullptr);
+        try {
+            loaded = prewarm.result(); // 预热尚未完成时在此等待
+        } catch (...) { // 预热时读盘失败：在这里重新加载，错误随之抛给调用者
+            prewarm = QFuture<xhytable>();
+        }
+        if (prewarm.isValid()) {
+            for (const xhyrecord& record : loaded.getCommittedRecords()) table.addrecord(record);
+            table.setNextRowId(loaded.nextRowId());
+        }
+    }
+    if (!prewarm.isValid()) {
+        load_table_records(trdPath, table);
+    }
+    qDebug() << "[LOAD_DB] 表" << table.name() << "首次访问，加载" << table.getCommittedRecords().size()
+             << "条记录用时" << timer.elapsed() << "ms" << (prewarm.isValid() ? "(已预热)" : "");
+}
+
+int xhydbmanager::prewarm_tables(const QString& dbname, const QStringList& tablenames) {
+    xhydatabase* db = find_database(dbname);
+    if (!db) return 0;
+    int started = 0;
+    for (const xhytable& table : db->tables()) {
+        if (table.rowsLoaded()) continue;
+        if (!tablenames.isEmpty() && !tablenames.contains(table.name(), Qt::CaseInsensitive)) continue;
+        const QString trdPath = QString("%1/data/%2/%3.trd").arg(m_dataDir, db->name(), table.name());
+        const QString key = QDir::cleanPath(trdPath).toLower();
+        if (m_prewarmJobs.contains(key)) continue;
+
+        xhytable shell = table; // 只带表定义，在后台线程解码记录
+        shell.setRowLoader(nullptr);
+        m_prewarmJobs.insert(key, QtConcurrent::run([this, shell, trdPath]() mutable {
+            load_table_records(trdPath, shell);
+            return shell;
+        }));
+        ++started;
+    }
+    qInfo() << "[PREWARM] 数据库" << db->name() << "启动" << started << "个预热任务。";
+    return started;
+}
+
+// DBMS_ROOT/prewarm.txt：每行 "数据库.表" 或 "数据库.*"，# 开头为注释
+void xhydbmanager::prewarm_from_config() {
+    QFile config(m_dataDir + "/prewarm.txt");
+    if (!config.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+    QMap<QString, QStringList> requested;
+    QTextStream in(&config);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        const int dot = line.indexOf('.');
+        if (dot <= 0) continue;
+        const QString tablename = line.mid(dot + 1).trimmed();
+        QStringList& tables = requested[line.left(dot).trimmed()];
+        if (tablename != "*") tables.append(tablename);
+        else tables.append(QString()); // 标记为全部
+    }
+    for (auto it = requested.constBegin(); it != requested.constEnd(); ++it) {
+        const bool all = it.value().contains(QString());
+        prewarm_tables(it.key(), all ? QStringList() : it.value());
+    }
+}
+
+void xhydbmanager::wait_prewarm(const QString& trdPath) {
+    if (trdPath.isEmpty()) {
+        for (auto& job : m_prewarmJobs) {
+            try { job.waitForFinished(); } catch (...) {} // 失败的预热在第一次访问该表时重新报告
+        }
+        m_prewarmJobs.clear();
+    } else if (QFuture<xhytable> job = m_prewarmJobs.take(QDir::cleanPath(trdPath).toLower()); job.isValid()) {
+        try { job.waitForFinished(); } catch (...) {}
+    }
+}
+
+void xhydbmanager::setLazyLoading(bool enabled) {
+    m_lazyLoading = enabled;
+}
+
+bool xhydbmanager::isLazyLoading() const {
+    return m_lazyLoading;
+}
+
+qint64 xhydbmanager::lastLoadMs() const {
+    return m_lastLoadMs;
+}
+
+void xhydbmanager::decode_tables_parallel(const QList<QPair<xhytable*, QString>>& targets) {
+    struct Chunk {
+        int target = 0;
+        quint32 firstPage = 0;
+        quint32 endPage = 0;
+        QList<xhyrecord> rows;
+        int skipped = 0;
+        bool failed = false; // 页校验和不匹配
+    };
+    const quint32 pagesPerChunk = 256; // 每块 2 MB
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<xhypagefile::HeaderInfo> headers(targets.size());
+    QList<Chunk> chunks;
+    for (int i = 0; i < targets.size(); ++i) {
+        {
+            // 直接读盘前先写回缓冲池中该文件的脏页；页文件未打开时由双写文件修复上次崩溃时撕裂的页
+            QMutexLocker lock(&m_pageFilesMutex);
+            if (auto pageFile = m_pageFiles.value(QDir::cleanPath(targets.at(i).second).toLower())) pageFile->flush();
+            else if (!xhypagefile::recoverTornPages(targets.at(i).second)) {
+                throw std::runtime_error(QString("双写文件无法写回: %1").arg(targets.at(i).second).toStdString());
+            }
+        }
+        if (!xhypagefile::readHeaderInfo(targets.at(i).second, &headers[i])) {
+            throw std::runtime_error(QString("读取分页记录文件头失败: %1").arg(targets.at(i).second).toStdString());
+        }
+        for (quint32 first = 1; first < headers[i].pageCount; first += pagesPerChunk) {
+            Chunk chunk;
+            chunk.target = i;
+            chunk.firstPage = first;
+            chunk.endPage = qMin(headers[i].pageCount, first + pagesPerChunk);
+            chunks.append(chunk);
+        }
+    }
+
+    // 每个块只写自己的结果，解码期间不需要任何锁
+    QtConcurrent::blockingMap(chunks, [&targets](Chunk& chunk) {
+        const xhytable& table = *targets.at(chunk.target).first;
+        const QList<xhyfield>& fields = table.fields();
+        chunk.failed = !xhypagefile::scanRange(targets.at(chunk.target).second, chunk.firstPage, chunk.endPage,
+                               [&](quint64 rowId, const char* data, int size) {
+            xhyrecord record(table.rowLayout());
+            if (!decode_record_fast(fields, data, size, record)) {
+                record.clear();
+                if (!decode_record(table, QByteArray::fromRawData(data, size), record)) {
+                    ++chunk.skipped;
+                    return true;
+                }
+            }
+            record.setRowId(rowId);
+            chunk.rows.append(record);
+            return true;
+        });
+    });
+
+    // 日志已截断到检查点，损坏的页无法重做，不能跳过后当作正常加载
+    for (const Chunk& chunk : chunks) {
+        if (chunk.failed) {
+            throw std::runtime_error(QString("记录文件 %1 的第 %2-%3 页校验失败")
+                .arg(targets.at(chunk.target).second).arg(chunk.firstPage).arg(chunk.endPage - 1).toStdString());
+        }
+    }
+
+    // 按块顺序合并，保持文件中的物理顺序
+    qint64 rowCount = 0;
+    int skipped = 0;
+    for (const Chunk& chunk : chunks) {
+        xhytable* table = targets.at(chunk.target).first;
+        for (const xhyrecord& record : chunk.rows) table->addrecord(record);
+        rowCount += chunk.rows.size();
+        skipped += chunk.skipped;
+    }
+    for (int i = 0; i < targets.size(); ++i) {
+        targets.at(i).first->setWalLsn(headers.at(i).walLsn);
+        targets.at(i).first->setNextRowId(headers.at(i).nextRowId);
+    }
+    qDebug() << "    [LOAD_DB_TRD]" << targets.size() << "个表分" << chunks.size() << "块并行解码"
+             << rowCount << "条记录，跳过" << skipped << "条，用时" << timer.elapsed() << "ms。";
+}
+
+void xhydbmanager::setBufferPoolCapacity(qint64 bytes) {
+    m_bufferPool.setCapacity(bytes);
+}
+
+void xhydbmanager::setWalEnabled(bool enabled) {
+    m_walEnabled = enabled;
+}
+
+bool xhydbmanager::isWalEnabled() const {
+    return m_walEnabled;
+}
+
+void xhydbmanager::setCheckpointThreshold(qint64 bytes) {
+    m_checkpointThreshold = bytes;
+}
+
+qint64 xhydbmanager::lastCommitBytesWritten() const {
+    return m_lastCommitBytesWritten;
+}
 
-    qDebug() << "表" << tablename << "已成功保存到文件";
+qint64 xhydbmanager::totalBytesWritten() const {
+    return m_totalBytesWritten;
 }
 void xhydbmanager::addTable(const xhytable& table) {
     if (m_inTransaction) {
@@ -8,22 +8,46 @@
 #include "xhytable.h"
 #include "xhyfield.h"
 #include "xhyrecord.h"
-#include<windows.h>
 #include <QDir>
 #include"ConditionNode.h"
+#include "xhywal.h"
+#include "xhybufferpool.h"
+#include "xhypagefile.h"
+#include <QMutex>
+#include <QFuture>
+#include <QHash>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <atomic>
 class xhydbmanager {
 
 public:
     xhydbmanager();
+    ~xhydbmanager();
 
 //描述性文件模块
 // 定义结构体
 #pragma pack(push, 1)
+    // 描述文件中的时间：与 Windows SYSTEMTIME 布局相同（8 个 16 位字段，UTC），原有描述文件可直接读取
+    struct FileTime {
+        quint16 year;
+        quint16 month;
+        quint16 dayOfWeek; // 0 为星期日
+        quint16 day;
+        quint16 hour;
+        quint16 minute;
+        quint16 second;
+        quint16 milliseconds;
+
+        static FileTime now();
+    };
+    static_assert(sizeof(FileTime) == 16, "FileTime 必须与 SYSTEMTIME 大小一致");
+
     struct DatabaseBlock {
         char name[128];
         bool type;
         char filename[256];
-        SYSTEMTIME crtime;
+        FileTime crtime;
     };
 
     struct TableBlock {
@@ -34,7 +58,7 @@ public:
         char tic[256];
         char trd[256];
         char tid[256];
-        SYSTEMTIME crtime;
+        FileTime crtime;
         int mtime;
     };
 
@@ -44,7 +68,7 @@ public:
         int type;       // 存储 xhyfield::datatype 枚举值
         int param;      // 应该用于存储 VARCHAR/CHAR 的长度 N，或者 DECIMAL 的精度 P
         int size;       // 应该用于存储 DECIMAL 的小数位数 S (或者其他需要第二个参数的类型)
-        SYSTEMTIME mtime;
+        FileTime mtime;
         int integrities; // 存储 PRIMARY_KEY, NOT_NULL, UNIQUE 的位标记
          char enum_values_str[1024];
     };
@@ -65,6 +89,7 @@ public:
     bool dropdatabase(const QString& dbname);
     bool use_database(const QString& dbname);
     QString get_current_database() const;
+    void clear_current_database() { current_database.clear(); }
     QList<xhydatabase> databases() const;
 
     // 表操作
@@ -79,6 +104,18 @@ public:
     bool commitTransaction();
     void rollbackTransaction();
     bool isInTransaction() const;
+    // 保存点：只能在事务中使用；不在事务中、保存点不存在等错误抛出 std::runtime_error
+    void savepoint(const QString& name);
+    void rollbackToSavepoint(const QString& name);
+    void releaseSavepoint(const QString& name);
+    // 查询用的读快照：事务中的库返回空快照（读本事务看到的当前记录），否则打开该库已提交数据的快照
+    xhysnapshot readSnapshot(const QString& dbname);
+    // 已提交数据的快照，不论是否在事务中；不修改管理器与表，可在多个线程中同时调用
+    xhysnapshot committedSnapshot(const QString& dbname) const;
+    // 并发读：写方先调用 prepareReads 加载该库延迟加载的记录、建立按需建立的索引，
+    // readsPrepared 为 true 期间只读查询不修改表，多个读方可同时执行（由调用者保证期间没有写方）
+    void prepareReads(const QString& dbname);
+    bool readsPrepared(const QString& dbname) const;
     void addTable(const xhytable& table);
 
     // 数据操作
@@ -87,10 +124,29 @@ public:
     bool selectData(const QString& dbname, const QString& tablename,  const ConditionNode &conditions, QVector<xhyrecord>& results);
 
     // 辅助函数
-    void save_table_to_file(const QString& dbname, const QString& tablename, const xhytable* table);
+    qint64 save_table_to_file(const QString& dbname, const QString& tablename, const xhytable* table);
+    qint64 persist_dirty_tables(xhydatabase& db); // 只写出被修改过的表，返回写入字节数
+    qint64 lastCommitBytesWritten() const; // 最近一次提交写入的字节数
+    qint64 totalBytesWritten() const;
+    QString temp_dir() const { return m_dataDir + "/tmp"; } // 外部排序等的临时文件目录
+    // 预写日志：提交只追加日志并组提交 fsync，数据文件由检查点写出
+    bool checkpoint(const QString& dbname, bool wait = true);
+    void setWalEnabled(bool enabled);
+    bool isWalEnabled() const;
+    void setCheckpointThreshold(qint64 bytes); // 日志超过该大小时在后台触发检查点
+    // 分页记录文件共享的缓冲池
+    void setBufferPoolCapacity(qint64 bytes);
+    xhybufferpool& bufferPool() { return m_bufferPool; }
+    bool convert_trd_to_paged(const QString& dbname, const QString& tablename); // 把旧格式 .trd 转换为分页格式
+    // 延迟加载：启动时只读表定义，记录在第一次访问时解码；可在后台预热指定的表
+    void setLazyLoading(bool enabled);
+    bool isLazyLoading() const;
+    int prewarm_tables(const QString& dbname, const QStringList& tablenames = QStringList()); // 为空表示全部，返回启动的任务数
+    qint64 lastLoadMs() const; // 最近一次 load_databases_from_files 的耗时
     void save_database_to_file(const QString& dbname);
     void load_databases_from_files();
     xhydatabase* find_database(const QString& dbname);
+    const xhydatabase* find_database(const QString& dbname) const; // 不分离数据库列表，供并发的读方使用
 
       bool update_table(const QString& database_name, const xhytable& table);
     bool add_constraint(const QString& database_name, const QString& table_name, const QString& field_name, const QString& constraint);
@@ -100,22 +156,59 @@ public:
 
     void commit();
     void rollback();
-    void save_index_file(const QString &dbname, const QString &indexname, const QVector<QPair<QString, quint64> > &indexData);
+    // 二级索引：建立/删除后随表写出 .ix（事务中等提交时写出）
+    bool createIndex(const QString& dbname, const xhyindex& index);
+    bool dropIndex(const QString& dbname, const QString& indexName);
     int deleteData(const QString &dbname, const QString &tablename,  const ConditionNode &conditions);
     void load_table_records(const QString &trd_path, xhytable &table);
     void load_table_definition(const QString &tdf_path, xhytable &table);
 private:
-    void save_table_definition_file(const QString& filePath, const xhytable* table);
-    void save_table_records_file(const QString& filePath, const xhytable* table);
-    void save_table_integrity_file(const QString& filePath, const xhytable* table);
-    void save_table_index_file(const QString& filePath, const xhytable* table);
-    void update_table_description_file(const QString& dbname, const QString& tablename, const xhytable* table);
+    qint64 save_table_definition_file(const QString& filePath, const xhytable* table);
+    qint64 save_table_records_file(const QString& filePath, const xhytable* table, quint64 walLsn);
+    qint64 save_table_integrity_file(const QString& filePath, const xhytable* table);
+    qint64 save_table_index_file(const QString& filePath, const xhytable* table);
+    // .ix 文件：索引定义 + 写出时的检查点 LSN + 按序的 (键, 行号)；LSN 与 .trd 一致时加载直接使用
+    qint64 save_index_file(const QString& filePath, const xhybtree& index, quint64 walLsn);
+    bool load_index_file(const QString& filePath, xhybtree* index, quint64* walLsn);
+    qint64 save_table_indexes(const QString& basePath, const xhytable* table, quint64 walLsn); // 同时删除已不存在的索引文件
+    void load_table_indexes(const QString& basePath, xhytable& table);
+    qint64 update_table_description_file(const QString& dbname, const QString& tablename, const xhytable* table);
+    qint64 persist_dirty_table(const QString& dbname, xhytable* table);
+    void remove_table_files(const QString& dbname, const QString& tablename); // 表的所有文件及 .tb 中的描述
+    void remove_renamed_table_files(xhydatabase& db); // 改名后的表已写出，删除旧名的文件
+    qint64 write_dirty_pages(const QString& filePath, const xhytable* table, quint64 walLsn);
+    QSharedPointer<xhypagefile> page_file_for(const QString& filePath);
+    void close_page_file(const QString& filePath);
+    void close_page_files_under(const QString& dirPath);
+    QSharedPointer<xhywal> wal_for(const QString& dbname);
+    quint64 current_wal_lsn(const QString& dbname);
+    qint64 commit_changes(xhydatabase& db);
+    void replay_wal(xhydatabase& db, const QList<xhywal::Entry>& entries);
+    void load_deferred_rows(const QString& trdPath, xhytable& table);
+    // 并行解码分页表：大表按页区间切块，各块结果互不共享，最后按块顺序合并到表中
+    void decode_tables_parallel(const QList<QPair<xhytable*, QString>>& targets);
+    void wait_prewarm(const QString& trdPath = QString()); // 等待（指定或全部）预热任务结束
+    void prewarm_from_config();
     QString m_dataDir = QDir::currentPath()
                         + QDir::separator() + "DBMS_ROOT";
     QList<xhydatabase> m_databases;
     QString current_database;
     bool m_inTransaction = false;
     QList<xhytable> m_tempTables;
+    QHash<QString, QStringList> m_renamedTables; // 小写数据库名 -> 已改名、旧名的文件待提交写出新表后删除的表名
+    qint64 m_lastCommitBytesWritten = 0;
+    std::atomic<qint64> m_totalBytesWritten{0};
+    xhybufferpool m_bufferPool;
+    QHash<QString, QSharedPointer<xhypagefile>> m_pageFiles; // 以 .trd 路径为键
+    QMutex m_pageFilesMutex;
+    bool m_lazyLoading = true;
+    QHash<QString, QFuture<xhytable>> m_prewarmJobs; // 以 .trd 路径为键，只在主线程访问
+    qint64 m_lastLoadMs = 0;
+    QHash<QString, QSharedPointer<xhywal>> m_wals; // 以小写数据库名为键
+    bool m_walEnabled = true;
+    qint64 m_checkpointThreshold = 4 * 1024 * 1024;
+    QThreadPool m_checkpointPool;                 // 单线程，检查点串行执行
+    std::atomic<bool> m_checkpointFailed{false};  // 上次检查点失败时下次写出全部表
 };
 
 #endif // XHYDBMANAGER_H
@@ -0,0 +1,161 @@
+#ifndef XHYEXECUTOR_H
+#define XHYEXECUTOR_H
+
+#include "sqlparser.h"
+#include "xhydbmanager.h"
+#include "xhypredicate.h"
+#include "ConditionNode.h"
+#include "userfilemanager.h"
+#include <QHash>
+#include <QPair>
+#include <QSharedDataPointer>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVariant>
+#include <functional>
+
+// SQL 执行器：解析并执行单条语句，结果以文本行追加到输出缓冲；只依赖 Qt Core，图形界面与命令行共用
+// account 为空时不做权限检查（本地命令行按管理员执行）
+class xhyexecutor {
+public:
+    // DROP DATABASE、DROP TABLE 与不带 WHERE 的 DELETE 执行前的确认；返回 false 时取消。未设置时直接执行
+    using ConfirmHandler = std::function<bool(const QString& title, const QString& text)>;
+    // 查询结果行：columns 为结果列名（同一条语句的各行相同），values 为各列的值，
+    // NULL 为无效 QVariant，整数/浮点/日期/布尔列为原生类型，其余为文本
+    using RowSink = std::function<void(const QStringList& columns, const QVariantList& values)>;
+
+    explicit xhyexecutor(xhydbmanager& dbManager, UserFileManager* account = nullptr, const QString& username = QString());
+
+    void setConfirmHandler(ConfirmHandler handler) { m_confirm = std::move(handler); }
+    // 设置后 SELECT 的结果行逐行交给 sink，输出缓冲中只留下消息和行数；传入空函数恢复为文本行输出
+    void setRowSink(RowSink sink) { m_rowSink = std::move(sink); }
+
+    void execute_command(const QString& command); // 一条以分号结尾的语句
+    void executeScript(const QString& text);      // 按分号拆分后逐条执行，回显每条语句
+    QStringList takeOutput();                     // 取出并清空输出缓冲
+    QString currentDatabase() const { return current_db; }
+    int parallelDegree() const { return m_parallelDegree; }
+    // 多个执行器共用一个 xhydbmanager 时（服务器的各会话），执行前把管理器的当前数据库切回本执行器的；已被删除时清空
+    void restoreCurrentDatabase();
+    // 可与其它执行器并发的只读语句：SELECT、SHOW DATABASES、SHOW TABLES
+    static bool isSharedRead(const QString& command);
+    // 并发执行只读语句：读本执行器当前数据库已提交数据的快照，不切换管理器的当前数据库，出错时也不回滚管理器的事务。
+    // 调用者保证期间没有写语句，且该库已由 xhydbmanager::prepareReads 准备好（服务器在引擎读锁下调用）
+    void executeSharedRead(const QString& command);
+
+    bool parseWhereClause(const QString &whereStr, ConditionNode &rootNode);
+
+    void handleCreateDatabase(const QString &command);
+    void handleUseDatabase(const QString &command);
+    void handleDropDatabase(const QString &command);
+    void handleCreateTable( QString &command); // 注意：如果这里确实需要修改command，则不能是const
+    void handleDropTable(const QString &command);
+    void handleDescribe(const QString &command);
+    void handleInsert(const QString &command);
+    void handleUpdate(const QString &command);
+    void handleDelete(const QString &command);
+    void handleSelect(const QString &command);
+    void handleAlterTable(const QString &command);
+    void handleExplainSelect(const QString& command);
+    void handleExplainAnalyze(const QString& command);
+    void handleSetParallelDegree(const QString& command);
+    void handleSavepoint(const QString& command);
+    void handleCreateIndex(const QString& command);
+    void handleDropIndex(const QString& command);
+    void handleShowIndexes(const QString& command);
+
+    QStringList parseSqlValues(const QString &input);
+    xhyfield::datatype parseDataType(const QString& type_str, int* size = nullptr);
+    QStringList parseConstraints(const QString& constraints_str_input); // 参数名修改
+    void handleTableConstraint(const QString &constraint_str, xhytable &table);
+    // JOIN 中的一张表，display 为别名（无别名时为表名）
+    struct JoinTable {
+        const xhytable* table = nullptr;
+        QString name;
+        QString display;
+    };
+    bool handleJoinSelect(const QString& command, bool explainOnly);
+
+    // 新增的辅助函数，用于从合并记录中获取字段的原始类型
+    xhyfield::datatype getFieldTypeFromJoinedRecord(
+        const QString& columnNameOrAlias, // WHERE 或 ORDER BY 中使用的列名/别名
+        const QList<JoinTable>& tables    // FROM 中的各表，按出现顺序
+        );
+
+    // JOIN 后记录的 WHERE 条件：按合并记录的布局编译一次，逐行求值
+    xhypredicate compileJoinedPredicate(
+        const ConditionNode& condition,   // 条件节点
+        const QSharedDataPointer<xhyrecordlayout>& joinedLayout, // 合并记录共用的布局
+        const QList<JoinTable>& tables,   // FROM 中的各表 (用于确定列类型)
+        // 非空时改为在连接前对单表记录求值（WHERE 下推）：rowColumns 把合并记录的键映射为表中的列名
+        const QSharedDataPointer<xhyrecordlayout>& rowLayout = QSharedDataPointer<xhyrecordlayout>(),
+        const QHash<QString, QString>& rowColumns = QHash<QString, QString>()
+        );
+    QPair<int, QString> findLowestPrecedenceOperator(const QString &expr, const QStringList &operatorsInPrecedenceOrder);
+
+    QPair<QString, QString> parseQualifiedColumn(const QString &qualifiedName);
+
+private:
+    void show_databases();
+    void show_tables(const QString& db_name);
+    void show_schema(const QString& db_name, const QString& table_name);
+
+    //获取数据库权限；没有账户时按管理员处理
+    int getDatabaseRole(QString dbname);
+    int userRole() const;
+    bool confirm(const QString& title, const QString& text) const;
+    // 只读语句使用的当前数据库与读快照：并发读时取本执行器的，否则取管理器的
+    QString readDatabaseName() const;
+    xhysnapshot readSnapshot(const QString& dbname) const;
+    static QVariant resultValue(const xhyrecord& record, const QString& column); // 见 RowSink
+
+    xhydbmanager& db_manager;
+    UserFileManager* m_account;
+    QString username;
+    QString current_db;
+    ConfirmHandler m_confirm;
+    RowSink m_rowSink;
+    int m_parallelDegree = 0; // SET PARALLEL_DEGREE：本会话的扫描、排序和聚合线程数，0 为 CPU 核数
+    bool m_sharedRead = false; // executeSharedRead 期间为 true
+
+    QVariant parseLiteralValue(const QString& valueStr);
+    int findBalancedOperatorPos(const QString& text, const QStringList& operatorsToFind, int startPos = 0);
+    ConditionNode parseSubExpression(QStringView expressionView);
+    ComparisonDetails parseComparisonDetails(const QString& field, const QString& op, const QString& valuePart);
+    //check 条件括号匹配
+    bool validateCheckExpression(const QString& expression);
+    QString cleanIdentifier(QString id) const; // 如果已添加，确保为 const
+
+    QString sqlLikeToRegex(const QString& likePattern, QChar customEscapeChar = QChar::Null) const; // 保持 const
+
+    // 新增 visualLength 的声明
+    int visualLength(const QString& str) const;
+
+    QStringList textBuffer;
+    // EXPLAIN ANALYZE：执行期间由各算子追加统计（连接计划、排序方式等）
+    bool m_analyzing = false;
+    QStringList m_analyzeLines;
+    int m_analyzeRows = -1; // 查询成功时返回的行数
+
+    xhyfield::datatype parseDataTypeAndParams(
+        const QString& type_str_input,
+        QStringList& auto_generated_constraints,
+        QString& out_error_message
+        );
+    bool extractParenthesizedParams(
+        const QString& params_str_with_parens,
+        int& p_val,
+        int& s_val,
+        bool& s_specified
+        );
+
+    // 由zyh新增，用于聚组函数
+    QVariant calculateAggregate(const QString& function, const QString& column, const QVector<xhyrecord>& records);
+    bool isNumeric(const QString& str) const;
+
+    // 由zyh新增，用于解决函数里无法使用表别名的情况
+    QString removeTableAlias(const QString& col, const QString& table_alias, const QString& table_name);
+};
+
+#endif // XHYEXECUTOR_H
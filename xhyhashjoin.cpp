@@ -0,0 +1,90 @@
+#include "xhyhashjoin.h"
+#include <QDebug>
+
+namespace {
+bool isCanonicalInt(const QString& text, qint64* out) {
+    if (text.isEmpty()) return false;
+    const QChar first = text.at(0);
+    if (!first.isDigit() && first != QLatin1Char('-')) return false;
+    bool ok = false;
+    const qint64 v = text.toLongLong(&ok);
+    if (!ok || QString::number(v) != text) return false;
+    *out = v;
+    return true;
+}
+}
+
+xhyhashjoin::xhyhashjoin(int batchRows) : m_batchRows(qMax(1, batchRows)) {}
+
+bool xhyhashjoin::keyOf(const xhyrecord& record, int ordinal, Key* key) {
+    if (record.isNullAt(ordinal)) return false;
+    if (record.intAt(ordinal, &key->i)) {
+        key->kind = Key::Int;
+        key->s.clear();
+        return true;
+    }
+    const QString text = record.valueAt(ordinal);
+    if (isCanonicalInt(text, &key->i)) {
+        key->kind = Key::Int;
+        key->s.clear();
+    } else {
+        key->kind = Key::Text;
+        key->s = text;
+    }
+    return true;
+}
+
+xhyhashjoin::Side xhyhashjoin::chooseBuildSide(int leftRows, int rightRows) {
+    return leftRows < rightRows ? Left : Right;
+}
+
+int xhyhashjoin::batchCount(int buildRows) const {
+    return buildRows <= 0 ? 0 : (buildRows + m_batchRows - 1) / m_batchRows;
+}
+
+void xhyhashjoin::run(const Source& left, const QString& leftColumn, const Source& right, const QString& rightColumn,
+                      const MatchSink& sink) {
+    m_buildSide = chooseBuildSide(left.rows, right.rows);
+    const bool buildLeft = m_buildSide == Left;
+    const Source& build = buildLeft ? left : right;
+    const Source& probe = buildLeft ? right : left;
+    ColumnOrdinal buildOrdinal(buildLeft ? leftColumn : rightColumn);
+    ColumnOrdinal probeOrdinal(buildLeft ? rightColumn : leftColumn);
+    m_batches = batchCount(build.rows);
+    m_matches = 0;
+
+    QHash<Key, int> heads; // 键 -> 本批中该键的第一行
+    QVector<int> next;     // 同键的下一行（本批内偏移），-1 结束
+    Key key;
+    for (int start = 0; start < build.rows; start += m_batchRows) {
+        const int end = qMin(start + m_batchRows, build.rows);
+        heads.clear();
+        heads.reserve(end - start);
+        next.fill(-1, end - start);
+        // 倒序插入，链表按行下标升序
+        for (int b = end - 1; b >= start; --b) {
+            const xhyrecord& record = build.at(b);
+            if (!keyOf(record, buildOrdinal.of(record), &key)) continue;
+            auto it = heads.find(key);
+            if (it == heads.end()) {
+                heads.insert(key, b);
+            } else {
+                next[b - start] = it.value();
+                it.value() = b;
+            }
+        }
+        for (int p = 0; p < probe.rows; ++p) {
+            const xhyrecord& record = probe.at(p);
+            if (!keyOf(record, probeOrdinal.of(record), &key)) continue;
+            auto it = heads.constFind(key);
+            if (it == heads.constEnd()) continue;
+            for (int b = it.value(); b >= 0; b = next.at(b - start)) {
+                if (buildLeft) sink(b, p);
+                else sink(p, b);
+                ++m_matches;
+            }
+        }
+    }
+    qDebug() << "[HASH_JOIN] 构建侧" << (buildLeft ? "左表" : "右表") << build.rows << "行，探测侧"
+             << probe.rows << "行，" << m_batches << "批，匹配" << m_matches << "对";
+}
@@ -0,0 +1,88 @@
+#ifndef XHYHASHJOIN_H
+#define XHYHASHJOIN_H
+
+#include "xhyrecord.h"
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+// 两表等值连接（JOIN ... ON a = b）的哈希连接：在行数较少的一侧按连接列建哈希表，另一侧逐行探测
+// 两侧都是行源（行数 + 按下标取行），不要求调用者把记录复制到连续的数组中
+// 构建侧超过 batchRows 行时分批建表，每批探测一遍；匹配在探测时直接交给回调，不在内部累积，内存只与批大小有关
+// 连接列任一侧为 NULL 的行不参与连接；其余按文本相等判定，与原来逐行比较 value() 的结果一致
+class xhyhashjoin {
+public:
+    enum Side { Left, Right };
+
+    // 连接键：文本为规范整数（与 QString::number 的结果相同）时按整数存放，其余按文本
+    // 两个键相等当且仅当两个单元的文本相等，整数列与文本列之间的连接也不受影响
+    struct Key {
+        enum Kind : quint8 { Int, Text };
+        Kind kind = Text;
+        qint64 i = 0;
+        QString s;
+        bool operator==(const Key& other) const {
+            return kind == other.kind && (kind == Int ? i == other.i : s == other.s);
+        }
+        bool operator<(const Key& other) const { // 整数在前，各自按值排序（归并连接用）
+            if (kind != other.kind) return kind < other.kind;
+            return kind == Int ? i < other.i : s < other.s;
+        }
+    };
+
+    // 按列名取序号；同一批记录通常共享布局，只在布局变化时重新查找
+    class ColumnOrdinal {
+    public:
+        explicit ColumnOrdinal(const QString& column) : m_column(column) {}
+        int of(const xhyrecord& record) {
+            if (&record.layout() != m_layout) {
+                m_layout = &record.layout();
+                m_ordinal = m_layout->indexOf(m_column);
+            }
+            return m_ordinal;
+        }
+
+    private:
+        QString m_column;
+        const xhyrecordlayout* m_layout = nullptr;
+        int m_ordinal = -1;
+    };
+
+    static const int kDefaultBatchRows = 1 << 18;
+
+    struct Source {
+        int rows = 0;
+        std::function<const xhyrecord&(int)> at; // 返回的引用在下一次调用前有效
+    };
+    using MatchSink = std::function<void(int leftRow, int rightRow)>;
+
+    explicit xhyhashjoin(int batchRows = kDefaultBatchRows);
+
+    static bool keyOf(const xhyrecord& record, int ordinal, Key* key); // NULL 返回 false
+    // 行数较少的一侧作为构建侧；相同时取右侧，按左侧顺序探测即得到嵌套循环的输出顺序
+    static Side chooseBuildSide(int leftRows, int rightRows);
+    int batchCount(int buildRows) const;
+
+    // 对满足 left.leftColumn = right.rightColumn 的每一对行调用 sink(左行下标, 右行下标)
+    // 一批之内按探测侧下标升序、同键的构建侧行按下标升序输出；批与批之间没有整体顺序，需要嵌套循环顺序时由调用者排序
+    void run(const Source& left, const QString& leftColumn, const Source& right, const QString& rightColumn,
+             const MatchSink& sink);
+    qint64 matches() const { return m_matches; }
+
+    Side buildSide() const { return m_buildSide; }
+    int batches() const { return m_batches; }
+
+private:
+    int m_batchRows;
+    Side m_buildSide = Right;
+    int m_batches = 0;
+    qint64 m_matches = 0;
+};
+
+inline size_t qHash(const xhyhashjoin::Key& key, size_t seed = 0) {
+    return key.kind == xhyhashjoin::Key::Int ? qHash(key.i, seed) : qHash(key.s, seed);
+}
+
+#endif // XHYHASHJOIN_H
@@ -0,0 +1,327 @@
+#include "xhyjoinplanner.h"
+#include "xhyhashjoin.h"
+#include "xhytable.h"
+#include <QDebug>
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+xhyjoinplanner::xhyjoinplanner(const QVector<Input>& inputs, const QVector<Edge>& edges)
+    : m_inputs(inputs), m_edges(edges) {}
+
+QString xhyjoinplanner::methodName(Method method) {
+    switch (method) {
+    case HashJoin: return "哈希连接";
+    case IndexNestedLoop: return "索引嵌套循环连接";
+    case MergeJoin: return "归并连接";
+    default: return "扫描";
+    }
+}
+
+// 采样估计；样本中几乎没有重复时按样本比例放大，否则认为样本已经见到了大部分取值
+double xhyjoinplanner::distinct(int input, const QString& column) const {
+    const QString cacheKey = QString("%1:%2").arg(input).arg(column);
+    auto cached = m_distinct.constFind(cacheKey);
+    if (cached != m_distinct.constEnd()) return cached.value();
+
+    const QVector<xhyrecord>& rows = m_inputs.at(input).rows;
+    const xhytable* table = m_inputs.at(input).table;
+    const int n = rows.size();
+    double estimate = 1;
+    if (table && table->primaryKeys().size() == 1 && table->primaryKeys().first().compare(column, Qt::CaseInsensitive) == 0) {
+        estimate = qMax(1, n);
+    } else if (n > 0) {
+        const int sample = qMin(n, kStatsSample);
+        QSet<xhyhashjoin::Key> seen;
+        xhyhashjoin::ColumnOrdinal ordinal(column);
+        xhyhashjoin::Key key;
+        int nonNull = 0;
+        for (int k = 0; k < sample; ++k) {
+            const xhyrecord& record = rows.at(static_cast<int>(static_cast<qint64>(k) * n / sample));
+            if (!xhyhashjoin::keyOf(record, ordinal.of(record), &key)) continue;
+            ++nonNull;
+            seen.insert(key);
+        }
+        if (sample == n || seen.size() < nonNull * 0.9) {
+            estimate = qMax(1, static_cast<int>(seen.size()));
+        } else {
+            estimate = qMax(1.0, static_cast<double>(seen.size()) * n / sample);
+        }
+    }
+    m_distinct.insert(cacheKey, estimate);
+    return estimate;
+}
+
+bool xhyjoinplanner::sortedOn(int input, const QString& column) const {
+    const QString cacheKey = QString("%1:%2").arg(input).arg(column);
+    auto cached = m_sorted.constFind(cacheKey);
+    if (cached != m_sorted.constEnd()) return cached.value();
+
+    bool sorted = true;
+    bool havePrevious = false;
+    xhyhashjoin::Key previous, key;
+    xhyhashjoin::ColumnOrdinal ordinal(column);
+    for (const xhyrecord& record : m_inputs.at(input).rows) {
+        if (!xhyhashjoin::keyOf(record, ordinal.of(record), &key)) continue;
+        if (havePrevious && key < previous) {
+            sorted = false;
+            break;
+        }
+        previous = key;
+        havePrevious = true;
+    }
+    m_sorted.insert(cacheKey, sorted);
+    return sorted;
+}
+
+QBitArray xhyjoinplanner::maskBits(quint32 mask, int n) {
+    QBitArray bits(n);
+    for (int i = 0; i < n; ++i) bits.setBit(i, mask & (1u << i));
+    return bits;
+}
+
+bool xhyjoinplanner::bestStep(const QBitArray& joined, double outerRows, int inner, Step* step) const {
+    QVector<int> connecting;
+    for (int e = 0; e < m_edges.size(); ++e) {
+        const Edge& edge = m_edges.at(e);
+        if ((edge.left == inner && joined.testBit(edge.right)) || (edge.right == inner && joined.testBit(edge.left))) {
+            connecting.append(e);
+        }
+    }
+    if (connecting.isEmpty()) return false;
+
+    const Input& in = m_inputs.at(inner);
+    const double innerRows = in.rows.size();
+    // 各条件相互独立：|A ⋈ B| = |A| * |B| / max(不同值个数)
+    double rows = outerRows * innerRows;
+    for (int e : connecting) {
+        const Edge& edge = m_edges.at(e);
+        const int outer = otherSide(edge, inner);
+        const double outerDistinct = qMin(distinct(outer, columnOf(edge, outer)), qMax(1.0, outerRows));
+        rows /= qMax(1.0, qMax(outerDistinct, distinct(inner, columnOf(edge, inner))));
+    }
+
+    const bool singleOuter = joined.count(true) == 1;
+    step->input = inner;
+    step->rows = rows;
+    step->cost = -1;
+    for (int e : connecting) {
+        const Edge& edge = m_edges.at(e);
+        const int outer = otherSide(edge, inner);
+        auto consider = [&](Method method, double cost) {
+            if (step->cost >= 0 && cost >= step->cost) return;
+            step->method = method;
+            step->edge = e;
+            step->cost = cost;
+        };
+        // 建哈希表的开销按较小一侧再计一遍
+        consider(HashJoin, outerRows + innerRows + qMin(outerRows, innerRows) + rows);
+        // 被连接的表未经过滤时可以直接用它的索引逐行探测，不必扫描
+        if (!in.filtered && in.table && in.table->hasEqualityIndex(columnOf(edge, inner))) {
+            consider(IndexNestedLoop, outerRows * (1 + std::log2(innerRows + 1)) + rows);
+        }
+        // 已有结果只有一张表且两侧都已按连接列有序时，一遍归并即可
+        if (singleOuter && sortedOn(outer, columnOf(edge, outer)) && sortedOn(inner, columnOf(edge, inner))) {
+            consider(MergeJoin, outerRows + innerRows + rows);
+        }
+    }
+    for (int e : connecting) {
+        if (e != step->edge) step->residualEdges.append(e);
+    }
+    step->buildInner = xhyhashjoin::chooseBuildSide(qRound64(outerRows), in.rows.size()) == xhyhashjoin::Right;
+    return true;
+}
+
+xhyjoinplanner::Plan xhyjoinplanner::plan() const {
+    const int n = m_inputs.size();
+    if (n == 0) return Plan();
+    auto start = [this](int input) {
+        Step step;
+        step.input = input;
+        step.rows = m_inputs.at(input).rows.size();
+        step.cost = step.rows;
+        return step;
+    };
+
+    Plan best;
+    if (n <= kMaxExhaustiveInputs) {
+        // 动态规划：每个输入子集只保留代价最低的左深计划
+        const quint32 full = (1u << n) - 1;
+        QVector<Plan> plans(full + 1);
+        for (int i = 0; i < n; ++i) plans[1u << i] = Plan{start(i)};
+        for (quint32 mask = 1; mask <= full; ++mask) {
+            const Plan& current = plans.at(mask);
+            if (current.isEmpty()) continue;
+            for (int inner = 0; inner < n; ++inner) {
+                if (mask & (1u << inner)) continue;
+                Step step;
+                if (!bestStep(maskBits(mask, n), current.last().rows, inner, &step)) continue;
+                step.cost += current.last().cost;
+                Plan& target = plans[mask | (1u << inner)];
+                if (target.isEmpty() || step.cost < target.last().cost) {
+                    target = current;
+                    target.append(step);
+                }
+            }
+        }
+        best = plans.at(full);
+    } else {
+        // 输入过多时从最小的表开始，每次加入代价最低的一张
+        int first = 0;
+        for (int i = 1; i < n; ++i) {
+            if (m_inputs.at(i).rows.size() < m_inputs.at(first).rows.size()) first = i;
+        }
+        best.append(start(first));
+        QBitArray joined(n);
+        joined.setBit(first);
+        while (best.size() < n) {
+            Step chosen;
+            for (int inner = 0; inner < n; ++inner) {
+                Step step;
+                if (joined.testBit(inner) || !bestStep(joined, best.last().rows, inner, &step)) continue;
+                if (chosen.input < 0 || step.cost < chosen.cost) chosen = step;
+            }
+            if (chosen.input < 0) break;
+            chosen.cost += best.last().cost;
+            best.append(chosen);
+            joined.setBit(chosen.input);
+        }
+    }
+    if (best.size() != n) throw std::runtime_error("JOIN 的 ON 条件不能把所有表连接在一起（不支持笛卡尔积）。");
+    return best;
+}
+
+QVector<int> xhyjoinplanner::execute(const Plan& plan) const {
+    const int width = m_inputs.size();
+    QVector<int> tuples;
+    if (plan.isEmpty()) return tuples;
+
+    const int first = plan.first().input;
+    tuples.fill(-1, m_inputs.at(first).rows.size() * width);
+    for (int r = 0; r < m_inputs.at(first).rows.size(); ++r) tuples[r * width + first] = r;
+
+    for (int s = 1; s < plan.size(); ++s) {
+        const Step& step = plan.at(s);
+        const Input& inner = m_inputs.at(step.input);
+        const Edge& keyEdge = m_edges.at(step.edge);
+        const int outer = otherSide(keyEdge, step.input);
+        const QString outerColumn = columnOf(keyEdge, outer);
+        const QString innerColumn = columnOf(keyEdge, step.input);
+        const QVector<xhyrecord>& outerRows = m_inputs.at(outer).rows;
+        const int count = tuples.size() / width;
+        auto outerRecord = [&](int t) -> const xhyrecord& { return outerRows.at(tuples.at(t * width + outer)); };
+
+        // 其余连到已连接输入的条件：两侧键都非 NULL 且相等
+        auto residualHolds = [&](int t, int r) {
+            for (int e : step.residualEdges) {
+                const Edge& edge = m_edges.at(e);
+                const int other = otherSide(edge, step.input);
+                const xhyrecord& a = m_inputs.at(other).rows.at(tuples.at(t * width + other));
+                const xhyrecord& b = inner.rows.at(r);
+                xhyhashjoin::Key ka, kb;
+                if (!xhyhashjoin::keyOf(a, a.layout().indexOf(columnOf(edge, other)), &ka)
+                    || !xhyhashjoin::keyOf(b, b.layout().indexOf(columnOf(edge, step.input)), &kb) || !(ka == kb)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        // 每个匹配 (已有元组, 新输入的行) 直接扩展为下一步的元组，不另存匹配列表；最后统一排序
+        QVector<int> next;
+        auto emitMatch = [&](int t, int r) {
+            if (!residualHolds(t, r)) return;
+            const int base = next.size();
+            next.append(tuples.mid(t * width, width));
+            next[base + step.input] = r;
+        };
+
+        if (step.method == IndexNestedLoop) {
+            xhyhashjoin::ColumnOrdinal ordinal(outerColumn);
+            QVector<int> found;
+            for (int t = 0; t < count; ++t) {
+                const xhyrecord& record = outerRecord(t);
+                const int ord = ordinal.of(record);
+                if (record.isNullAt(ord)) continue;
+                inner.table->lookupEqual(innerColumn, record.valueAt(ord), found);
+                for (int r : found) emitMatch(t, r);
+            }
+        } else if (step.method == MergeJoin) {
+            // 两侧都已按键有序，同键的一段与另一侧同键的一段两两配对
+            QVector<QPair<xhyhashjoin::Key, int>> left, right;
+            xhyhashjoin::Key key;
+            xhyhashjoin::ColumnOrdinal leftOrdinal(outerColumn), rightOrdinal(innerColumn);
+            for (int t = 0; t < count; ++t) {
+                if (xhyhashjoin::keyOf(outerRecord(t), leftOrdinal.of(outerRecord(t)), &key)) left.append(qMakePair(key, t));
+            }
+            for (int r = 0; r < inner.rows.size(); ++r) {
+                if (xhyhashjoin::keyOf(inner.rows.at(r), rightOrdinal.of(inner.rows.at(r)), &key)) right.append(qMakePair(key, r));
+            }
+            int i = 0, j = 0;
+            while (i < left.size() && j < right.size()) {
+                if (left.at(i).first < right.at(j).first) { ++i; continue; }
+                if (right.at(j).first < left.at(i).first) { ++j; continue; }
+                int iEnd = i, jEnd = j;
+                while (iEnd < left.size() && left.at(iEnd).first == left.at(i).first) ++iEnd;
+                while (jEnd < right.size() && right.at(jEnd).first == right.at(j).first) ++jEnd;
+                for (int a = i; a < iEnd; ++a) {
+                    for (int b = j; b < jEnd; ++b) emitMatch(left.at(a).second, right.at(b).second);
+                }
+                i = iEnd;
+                j = jEnd;
+            }
+        } else {
+            // 已连接的结果按元组下标直接取外侧记录，不复制
+            const xhyhashjoin::Source outerSource{count, outerRecord};
+            const xhyhashjoin::Source innerSource{int(inner.rows.size()),
+                                                  [&inner](int r) -> const xhyrecord& { return inner.rows.at(r); }};
+            xhyhashjoin hashJoin;
+            hashJoin.run(outerSource, outerColumn, innerSource, innerColumn, emitMatch);
+        }
+        tuples = next;
+        qDebug() << "[JOIN_PLAN]" << methodName(step.method) << inner.display << "后" << tuples.size() / width
+                 << "行（估计" << qRound64(step.rows) << "行）";
+    }
+
+    // 恢复按 FROM 中表的顺序逐层嵌套的输出顺序
+    const int count = tuples.size() / width;
+    QVector<int> order(count);
+    for (int t = 0; t < count; ++t) order[t] = t;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        for (int k = 0; k < width; ++k) {
+            const int x = tuples.at(a * width + k), y = tuples.at(b * width + k);
+            if (x != y) return x < y;
+        }
+        return false;
+    });
+    QVector<int> sorted;
+    sorted.reserve(tuples.size());
+    for (int t : order) sorted.append(tuples.mid(t * width, width));
+    return sorted;
+}
+
+QString xhyjoinplanner::edgeText(int edge) const {
+    const Edge& e = m_edges.at(edge);
+    return QString("%1.%2 = %3.%4").arg(m_inputs.at(e.left).display, e.leftColumn, m_inputs.at(e.right).display, e.rightColumn);
+}
+
+QStringList xhyjoinplanner::explain(const Plan& plan) const {
+    QStringList lines;
+    for (int s = 0; s < plan.size(); ++s) {
+        const Step& step = plan.at(s);
+        const Input& in = m_inputs.at(step.input);
+        QString line;
+        if (s == 0) {
+            line = QString("%1. 扫描表 '%2' (%3 行)").arg(s + 1).arg(in.display).arg(in.rows.size());
+        } else {
+            line = QString("%1. %2 表 '%3' (%4 行) ON %5").arg(s + 1).arg(methodName(step.method), in.display)
+                       .arg(in.rows.size()).arg(edgeText(step.edge));
+            if (step.method == HashJoin) line += step.buildInner ? "，在该表上建哈希表" : "，在已连接结果上建哈希表";
+            for (int e : step.residualEdges) line += QString("，并检查 %1").arg(edgeText(e));
+        }
+        if (in.filtered) line += "（已按下推的 WHERE 条件过滤）";
+        line += QString(" -> 估计 %1 行，累计代价 %2").arg(qRound64(step.rows)).arg(qRound64(step.cost));
+        lines.append(line);
+    }
+    return lines;
+}
@@ -0,0 +1,74 @@
+#ifndef XHYJOINPLANNER_H
+#define XHYJOINPLANNER_H
+
+#include "xhyrecord.h"
+#include <QBitArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class xhytable;
+
+// 多表等值连接：按各表（下推过滤后）的行数和连接列的不同值个数估计中间结果，枚举左深连接顺序，
+// 每一步在哈希连接、索引嵌套循环和归并连接中选代价最低的一种
+// 执行结果为各输入的行下标元组，按 (输入 0 的行, 输入 1 的行, ...) 升序排列，与逐表嵌套循环的输出顺序相同
+class xhyjoinplanner {
+public:
+    enum Method { Scan, HashJoin, IndexNestedLoop, MergeJoin };
+
+    struct Input {
+        QString display;          // 别名，无别名时为表名
+        const xhytable* table = nullptr;
+        QVector<xhyrecord> rows;  // 下推条件过滤后的记录
+        bool filtered = false;    // 为 false 时 rows 就是 table->records()，可以直接用表上的索引探测
+    };
+    // 等值条件 inputs[left].leftColumn = inputs[right].rightColumn（列名与表字段名一致）
+    struct Edge {
+        int left = -1;
+        QString leftColumn;
+        int right = -1;
+        QString rightColumn;
+    };
+    struct Step {
+        int input = -1;              // 本步加入的输入
+        Method method = Scan;
+        int edge = -1;               // 作为连接键的条件
+        QVector<int> residualEdges;  // 本步同时连到已连接输入的其他条件，连接后逐行检查
+        bool buildInner = true;      // 哈希连接：在新加入的输入上建哈希表
+        double rows = 0;             // 本步之后的估计行数
+        double cost = 0;             // 到本步为止的累计代价
+    };
+    using Plan = QVector<Step>;
+
+    xhyjoinplanner(const QVector<Input>& inputs, const QVector<Edge>& edges);
+
+    // 连接条件不能把所有输入连在一起（笛卡尔积）时抛出 std::runtime_error
+    Plan plan() const;
+    // 展平的结果元组：每 inputs.size() 个下标为一行，第 k 个是输入 k 的行下标
+    QVector<int> execute(const Plan& plan) const;
+    QStringList explain(const Plan& plan) const;
+
+    static QString methodName(Method method);
+
+private:
+    static const int kMaxExhaustiveInputs = 10; // 超过时改用贪心（每次加入代价最低的一张表）
+    static const int kStatsSample = 4096;       // 估计不同值个数时的采样行数
+
+    QString columnOf(const Edge& edge, int input) const { return edge.left == input ? edge.leftColumn : edge.rightColumn; }
+    int otherSide(const Edge& edge, int input) const { return edge.left == input ? edge.right : edge.left; }
+    double distinct(int input, const QString& column) const;
+    bool sortedOn(int input, const QString& column) const;
+    // 在已连接的输入集合 joined（第 k 位为输入 k，估计 outerRows 行）上加入 inner；没有连接条件时返回 false
+    // 用 QBitArray 而不是整数位掩码：贪心路径的输入个数没有上限
+    bool bestStep(const QBitArray& joined, double outerRows, int inner, Step* step) const;
+    static QBitArray maskBits(quint32 mask, int n); // 动态规划的子集位掩码（n <= kMaxExhaustiveInputs）
+    QString edgeText(int edge) const;
+
+    QVector<Input> m_inputs;
+    QVector<Edge> m_edges;
+    mutable QHash<QString, double> m_distinct; // "输入:列" -> 不同值个数估计
+    mutable QHash<QString, bool> m_sorted;     // "输入:列" -> 非 NULL 键是否已按序排列
+};
+
+#endif // XHYJOINPLANNER_H
@@ -0,0 +1,52 @@
+#include "xhykeyindex.h"
+
+xhykeyindex::xhykeyindex(const QString& name, const QStringList& columns, bool skipNulls)
+    : m_name(name), m_columns(columns), m_skipNulls(skipNulls) {}
+
+QString xhykeyindex::keyOf(const QStringList& values) {
+    QString key;
+    for (const QString& value : values) {
+        key += QString::number(value.size());
+        key += QLatin1Char(':');
+        key += value;
+    }
+    return key;
+}
+
+bool xhykeyindex::keyOf(const xhyrecord& record, QString* key) const {
+    QStringList values;
+    values.reserve(m_columns.size());
+    for (const QString& column : m_columns) {
+        const QString value = record.value(column);
+        if (m_skipNulls && (value.isNull() || value.compare("NULL", Qt::CaseInsensitive) == 0)) return false;
+        values.append(value);
+    }
+    *key = keyOf(values);
+    return true;
+}
+
+void xhykeyindex::build(const QList<xhyrecord>& rows) {
+    m_rows.clear();
+    m_rows.reserve(rows.size());
+    QString key;
+    for (const xhyrecord& record : rows) {
+        if (keyOf(record, &key)) m_rows.insert(key, record.rowId());
+    }
+}
+
+void xhykeyindex::insert(const xhyrecord& record) {
+    QString key;
+    if (keyOf(record, &key)) m_rows.insert(key, record.rowId());
+}
+
+void xhykeyindex::remove(const xhyrecord& record) {
+    QString key;
+    if (keyOf(record, &key)) m_rows.remove(key, record.rowId());
+}
+
+bool xhykeyindex::contains(const QString& key, quint64 exceptRowId) const {
+    for (auto it = m_rows.constFind(key); it != m_rows.constEnd() && it.key() == key; ++it) {
+        if (it.value() != exceptRowId) return true;
+    }
+    return false;
+}
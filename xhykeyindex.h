@@ -0,0 +1,40 @@
+#ifndef XHYKEYINDEX_H
+#define XHYKEYINDEX_H
+
+#include "xhyrecord.h"
+#include <QList>
+#include <QMultiHash>
+#include <QString>
+#include <QStringList>
+
+// 主键 / UNIQUE 约束的哈希索引：键为各列文本（区分大小写，与逐行比较一致），值为行号
+// 只做等值探测（约束检查、外键查找），随表当前可见的记录（事务中为临时记录）维护
+class xhykeyindex {
+public:
+    xhykeyindex() = default;
+    // skipNulls 为 true 时（UNIQUE）含 NULL 的行不进入索引，SQL 允许多个 NULL
+    xhykeyindex(const QString& name, const QStringList& columns, bool skipNulls);
+
+    const QString& name() const { return m_name; }
+    const QStringList& columns() const { return m_columns; }
+    bool skipsNulls() const { return m_skipNulls; }
+    int size() const { return m_rows.size(); }
+
+    static QString keyOf(const QStringList& values); // 各值按长度前缀拼接，任意文本都不会混淆
+    bool keyOf(const xhyrecord& record, QString* key) const; // 含 NULL 且 skipNulls 时返回 false
+
+    void build(const QList<xhyrecord>& rows);
+    void insert(const xhyrecord& record);
+    void remove(const xhyrecord& record);
+    // 键已被 exceptRowId 以外的行占用（行号从 1 开始，0 表示不排除）
+    bool contains(const QString& key, quint64 exceptRowId = 0) const;
+    QList<quint64> rowIds(const QString& key) const { return m_rows.values(key); }
+
+private:
+    QString m_name;
+    QStringList m_columns;
+    bool m_skipNulls = false;
+    QMultiHash<QString, quint64> m_rows;
+};
+
+#endif // XHYKEYINDEX_H
@@ -0,0 +1,60 @@
+#include "xhymvcc.h"
+#include <QMutexLocker>
+
+struct xhysnapshot::Registration {
+    QSharedPointer<xhymvcc> owner;
+    quint64 timestamp = 0;
+    ~Registration() { owner->release(timestamp); }
+};
+
+quint64 xhysnapshot::timestamp() const {
+    return m_registration ? m_registration->timestamp : xhymvcc::kUncommitted;
+}
+
+quint64 xhymvcc::lastCommitted() const {
+    QMutexLocker locker(&m_mutex);
+    return m_published;
+}
+
+quint64 xhymvcc::reserveCommit() {
+    QMutexLocker locker(&m_mutex);
+    m_reserved = qMax(m_reserved, m_published) + 1;
+    return m_reserved;
+}
+
+void xhymvcc::publish(quint64 timestamp) {
+    QMutexLocker locker(&m_mutex);
+    m_published = qMax(m_published, timestamp);
+}
+
+xhysnapshot xhymvcc::openSnapshot() {
+    QSharedPointer<xhysnapshot::Registration> registration(new xhysnapshot::Registration);
+    registration->owner = sharedFromThis();
+    {
+        QMutexLocker locker(&m_mutex);
+        registration->timestamp = m_published;
+        ++m_active[m_published];
+    }
+    xhysnapshot snapshot;
+    snapshot.m_registration = registration;
+    return snapshot;
+}
+
+quint64 xhymvcc::horizon() const {
+    QMutexLocker locker(&m_mutex);
+    return m_active.isEmpty() ? m_published : m_active.firstKey();
+}
+
+int xhymvcc::activeSnapshots() const {
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (int registrations : m_active) count += registrations;
+    return count;
+}
+
+void xhymvcc::release(quint64 timestamp) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_active.find(timestamp);
+    if (it == m_active.end()) return;
+    if (--it.value() == 0) m_active.erase(it);
+}
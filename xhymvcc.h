@@ -0,0 +1,51 @@
+#ifndef XHYMVCC_H
+#define XHYMVCC_H
+
+#include <QEnableSharedFromThis>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+
+// 多版本并发控制的时间戳：每次提交分配一个递增的提交时间戳，行的当前版本记录创建它的提交时间戳（xhyrecord::beginTs）
+// 被更新或删除的已提交版本连同结束时间戳保存在表的版本链中（xhytable），读快照按时间戳选出各行可见的版本
+// 仍在登记中的最早快照是回收水位：结束时间戳不超过它的旧版本不再被任何快照需要
+class xhymvcc;
+
+// 读快照：复制只增加引用计数，最后一个副本析构时注销
+// 默认构造的空快照表示读当前记录（包括本事务未提交的修改），与不使用快照时相同
+class xhysnapshot {
+public:
+    xhysnapshot() = default;
+    bool isValid() const { return !m_registration.isNull(); }
+    quint64 timestamp() const; // 可见：开始时间戳 <= timestamp < 结束时间戳
+
+private:
+    friend class xhymvcc;
+    struct Registration;
+    QSharedPointer<Registration> m_registration;
+};
+
+class xhymvcc : public QEnableSharedFromThis<xhymvcc> {
+public:
+    static constexpr quint64 kUncommitted = ~quint64(0); // 未提交版本的开始时间戳；尚未结束的版本的结束时间戳
+
+    quint64 lastCommitted() const;
+    // 提交分两步：先分配时间戳给本事务的版本盖章，publish 之后新开的快照才能看到它们（同一时刻只有一个写事务）
+    quint64 reserveCommit();
+    void publish(quint64 timestamp);
+
+    xhysnapshot openSnapshot(); // 以 lastCommitted 为时间戳登记一个读快照
+    quint64 horizon() const;    // 最早的活动快照；没有活动快照时为 lastCommitted
+    int activeSnapshots() const;
+
+private:
+    friend class xhysnapshot;
+    void release(quint64 timestamp);
+
+    mutable QMutex m_mutex;
+    quint64 m_reserved = 0;
+    quint64 m_published = 0;
+    QMap<quint64, int> m_active; // 快照时间戳 -> 登记数
+};
+
+#endif // XHYMVCC_H
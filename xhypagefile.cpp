@@ -0,0 +1,668 @@
+#include "xhypagefile.h"
+#include "xhybufferpool.h"
+#include "xhywal.h"
+#include <QDebug>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+const quint32 kMagic = 0x50594858u; // "XHYP"
+const quint16 kVersion = 1;
+const int kTupleHeader = 9;          // quint64 行号 + quint8 标志
+const quint8 kTupleInline = 0;
+const quint8 kTupleOverflow = 1;
+const int kOverflowPayload = xhypagefile::PageSize - xhypagefile::PageHeaderSize;
+
+// 页头: 0 校验和(quint32) | 4 类型 | 6 槽数(溢出页为数据长度) | 8 freeStart | 10 freeEnd | 12 下一溢出页
+inline quint16 get16(const char* p, int off) { return qFromLittleEndian<quint16>(p + off); }
+inline quint32 get32(const char* p, int off) { return qFromLittleEndian<quint32>(p + off); }
+inline quint64 get64(const char* p, int off) { return qFromLittleEndian<quint64>(p + off); }
+inline void put16(char* p, int off, quint16 v) { qToLittleEndian<quint16>(v, p + off); }
+inline void put32(char* p, int off, quint32 v) { qToLittleEndian<quint32>(v, p + off); }
+inline void put64(char* p, int off, quint64 v) { qToLittleEndian<quint64>(v, p + off); }
+
+inline quint8 pageType(const char* page) { return static_cast<quint8>(page[4]); }
+inline quint16 slotCount(const char* page) { return get16(page, 6); }
+inline quint16 freeStart(const char* page) { return get16(page, 8); }
+inline quint16 freeEnd(const char* page) { return get16(page, 10); }
+inline quint16 slotOffset(const char* page, int slot) { return get16(page, xhypagefile::PageHeaderSize + slot * xhypagefile::SlotSize); }
+inline quint16 slotLength(const char* page, int slot) { return get16(page, xhypagefile::PageHeaderSize + slot * xhypagefile::SlotSize + 2); }
+inline void setSlot(char* page, int slot, quint16 offset, quint16 length) {
+    put16(page, xhypagefile::PageHeaderSize + slot * xhypagefile::SlotSize, offset);
+    put16(page, xhypagefile::PageHeaderSize + slot * xhypagefile::SlotSize + 2, length);
+}
+inline void setSlotCount(char* page, quint16 count) {
+    put16(page, 6, count);
+    put16(page, 8, xhypagefile::PageHeaderSize + count * xhypagefile::SlotSize);
+}
+
+quint32 pageChecksum(const char* page) {
+    return xhywal::checksum(page + 4, xhypagefile::PageSize - 4);
+}
+
+void sealPage(char* page) {
+    put32(page, 0, pageChecksum(page));
+}
+
+void fillHeaderPage(char* page, quint32 pageCount, quint64 walLsn, quint64 nextRowId, quint64 rowCount) {
+    memset(page, 0, xhypagefile::PageSize);
+    page[4] = static_cast<char>(xhypagefile::HeaderPage);
+    int off = xhypagefile::PageHeaderSize;
+    put32(page, off, kMagic); off += 4;
+    put16(page, off, kVersion); off += 2;
+    put16(page, off, xhypagefile::PageSize); off += 2;
+    put32(page, off, pageCount); off += 4;
+    put64(page, off, walLsn); off += 8;
+    put64(page, off, nextRowId); off += 8;
+    put64(page, off, rowCount);
+    sealPage(page);
+}
+}
+
+xhypagefile::xhypagefile(const QString& filePath, xhybufferpool* pool)
+    : m_filePath(filePath), m_pool(pool) {}
+
+xhypagefile::~xhypagefile() {
+    close();
+}
+
+bool xhypagefile::isPageFile(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QByteArray head = file.read(PageHeaderSize + 4);
+    return head.size() == PageHeaderSize + 4
+           && static_cast<quint8>(head.at(4)) == HeaderPage
+           && get32(head.constData(), PageHeaderSize) == kMagic;
+}
+
+bool xhypagefile::readHeaderInfo(const QString& filePath, HeaderInfo* info) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QByteArray page = file.read(PageSize);
+    const char* p = page.constData();
+    if (page.size() != PageSize || get32(p, 0) != pageChecksum(p)
+        || pageType(p) != HeaderPage || get32(p, PageHeaderSize) != kMagic) {
+        return false;
+    }
+    int off = PageHeaderSize + 8; // 魔数、版本、页大小之后
+    info->pageCount = qMax<quint32>(1, get32(p, off)); off += 4;
+    info->walLsn = get64(p, off); off += 8;
+    info->nextRowId = get64(p, off); off += 8;
+    info->rowCount = get64(p, off);
+    return true;
+}
+
+bool xhypagefile::scanRange(const QString& filePath, quint32 firstPage, quint32 endPage,
+                            const std::function<bool(quint64 rowId, const char* data, int size)>& visitor) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    endPage = qMin<qint64>(endPage, file.size() / PageSize);
+    if (firstPage >= endPage || !file.seek(qint64(firstPage) * PageSize)) return true;
+
+    // 一次读入整段，避免逐页系统调用
+    const QByteArray range = file.read(qint64(endPage - firstPage) * PageSize);
+    const quint32 pages = range.size() / PageSize;
+    QByteArray overflowPage(PageSize, '\0');
+    QByteArray blob;
+    for (quint32 i = 0; i < pages; ++i) {
+        const char* page = range.constData() + qint64(i) * PageSize;
+        if (get32(page, 0) != pageChecksum(page)) {
+            qCritical() << "[PAGE_FILE] 页校验和不匹配:" << filePath << "页" << firstPage + i;
+            return false;
+        }
+        if (pageType(page) != DataPage) continue;
+        for (int slot = 0; slot < slotCount(page); ++slot) {
+            const quint16 off = slotOffset(page, slot);
+            const quint16 len = slotLength(page, slot);
+            if (len < kTupleHeader || off + len > PageSize) continue;
+            const quint64 rowId = get64(page, off);
+            if (static_cast<quint8>(page[off + 8]) != kTupleOverflow) {
+                if (!visitor(rowId, page + off + kTupleHeader, len - kTupleHeader)) return true;
+                continue;
+            }
+            // 溢出行：沿页链随机读取
+            const quint32 total = get32(page, off + kTupleHeader + 4);
+            quint32 next = get32(page, off + kTupleHeader);
+            blob.clear();
+            while (next != 0 && quint32(blob.size()) < total) {
+                if (!file.seek(qint64(next) * PageSize) || file.read(overflowPage.data(), PageSize) != PageSize
+                    || get32(overflowPage.constData(), 0) != pageChecksum(overflowPage.constData())
+                    || pageType(overflowPage.constData()) != OverflowPage) break;
+                blob.append(overflowPage.constData() + PageHeaderSize, get16(overflowPage.constData(), 6));
+                next = get32(overflowPage.constData(), 12);
+            }
+            if (quint32(blob.size()) != total) {
+                qCritical() << "[PAGE_FILE] 溢出页链不完整或已损坏:" << filePath << "行" << rowId;
+                return false;
+            }
+            if (!visitor(rowId, blob.constData(), blob.size())) return true;
+        }
+    }
+    return true;
+}
+
+bool xhypagefile::recoverTornPages(const QString& filePath) {
+    QFile dwb(doubleWritePath(filePath));
+    if (!dwb.exists() || dwb.size() == 0) return true; // 上次 flush 已完成
+    if (!dwb.open(QIODevice::ReadOnly)) {
+        qCritical() << "[PAGE_FILE] 无法读取双写文件:" << dwb.fileName() << dwb.errorString();
+        return false;
+    }
+    const QByteArray data = dwb.readAll();
+    dwb.close();
+
+    // 条目: quint32 页号 + 整页；尾部不完整或校验和不对的条目是写双写文件时崩溃留下的，对应的原地写入还没有开始
+    const int entrySize = 4 + PageSize;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qCritical() << "[PAGE_FILE] 无法打开记录文件修复撕裂页:" << filePath << file.errorString();
+        return false;
+    }
+    int restored = 0;
+    for (qint64 off = 0; off + entrySize <= data.size(); off += entrySize) {
+        const char* page = data.constData() + off + 4;
+        if (get32(page, 0) != pageChecksum(page)) break;
+        const quint32 pageNo = get32(data.constData(), int(off));
+        if (!file.seek(qint64(pageNo) * PageSize) || file.write(page, PageSize) != PageSize) {
+            qCritical() << "[PAGE_FILE] 修复撕裂页失败:" << filePath << "页" << pageNo << file.errorString();
+            return false;
+        }
+        ++restored;
+    }
+    if (!xhywal::syncFile(file)) return false;
+    file.close();
+    if (!QFile::remove(dwb.fileName())) {
+        qCritical() << "[PAGE_FILE] 无法删除双写文件:" << dwb.fileName();
+        return false;
+    }
+    if (restored > 0) qInfo() << "[PAGE_FILE] 已从双写文件写回" << restored << "页:" << filePath;
+    return true;
+}
+
+bool xhypagefile::open() {
+    if (!recoverTornPages(m_filePath)) return false;
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "[PAGE_FILE] 无法打开记录文件:" << m_filePath << m_file.errorString();
+        return false;
+    }
+    m_directory.clear();
+    m_freePages.clear();
+    m_pageCount = 1;
+    m_freeSpace = QVector<quint16>(1, 0);
+    if (m_file.size() == 0) return true; // 新文件，flush 时写文件头
+    if (!readHeader()) {
+        m_file.close();
+        return false;
+    }
+
+    // 扫描一遍，建立行号目录、空闲空间表和空页列表
+    m_freeSpace = QVector<quint16>(m_pageCount, 0);
+    for (quint32 pageNo = 1; pageNo < m_pageCount; ++pageNo) {
+        const char* page = m_pool->pin(this, pageNo);
+        if (!page) {
+            qCritical() << "[PAGE_FILE] 第" << pageNo << "页损坏:" << m_filePath;
+            m_pool->discard(this);
+            m_file.close();
+            return false;
+        }
+        if (pageType(page) == DataPage) {
+            for (int slot = 0; slot < slotCount(page); ++slot) {
+                if (slotLength(page, slot) == 0) continue;
+                m_directory.insert(get64(page, slotOffset(page, slot)), Location{pageNo, static_cast<quint16>(slot)});
+            }
+            m_freeSpace[pageNo] = pageFreeSpace(page);
+        } else if (pageType(page) == FreePage) {
+            m_freePages.append(pageNo);
+        }
+        m_pool->unpin(this, pageNo, false);
+    }
+    return true;
+}
+
+void xhypagefile::close() {
+    if (m_pool) m_pool->discard(this);
+    if (m_file.isOpen()) m_file.close();
+    if (m_doubleWrite.isOpen()) m_doubleWrite.close();
+}
+
+bool xhypagefile::readHeader() {
+    QByteArray page(PageSize, '\0');
+    if (!m_file.seek(0) || m_file.read(page.data(), PageSize) != PageSize) {
+        qWarning() << "[PAGE_FILE] 读取文件头失败:" << m_filePath;
+        return false;
+    }
+    const char* p = page.constData();
+    if (get32(p, 0) != pageChecksum(p) || pageType(p) != HeaderPage || get32(p, PageHeaderSize) != kMagic) {
+        qWarning() << "[PAGE_FILE] 文件头无效或已损坏:" << m_filePath;
+        return false;
+    }
+    int off = PageHeaderSize + 4;
+    const quint16 version = get16(p, off); off += 2;
+    const quint16 pageSize = get16(p, off); off += 2;
+    if (version != kVersion || pageSize != PageSize) {
+        qWarning() << "[PAGE_FILE] 不支持的文件版本或页大小:" << version << pageSize;
+        return false;
+    }
+    m_pageCount = qMax<quint32>(1, get32(p, off)); off += 4;
+    m_walLsn = get64(p, off); off += 8;
+    m_nextRowId = get64(p, off);
+    return true;
+}
+
+QByteArray xhypagefile::headerImage() const {
+    QByteArray page(PageSize, '\0');
+    fillHeaderPage(page.data(), m_pageCount, m_walLsn, m_nextRowId, m_directory.size());
+    return page;
+}
+
+bool xhypagefile::writeThrough(const QList<QPair<quint32, QByteArray>>& pages) {
+    if (pages.isEmpty()) return true;
+    if (!m_doubleWrite.isOpen()) {
+        m_doubleWrite.setFileName(doubleWritePath(m_filePath));
+        if (!m_doubleWrite.open(QIODevice::ReadWrite | QIODevice::Append)) {
+            qWarning() << "[PAGE_FILE] 无法打开双写文件:" << m_doubleWrite.fileName() << m_doubleWrite.errorString();
+            return false;
+        }
+    }
+    QByteArray batch;
+    batch.reserve(pages.size() * (4 + PageSize));
+    for (const auto& page : pages) {
+        char no[4];
+        put32(no, 0, page.first);
+        batch.append(no, 4);
+        batch.append(page.second);
+    }
+    if (m_doubleWrite.write(batch) != batch.size() || !xhywal::syncFile(m_doubleWrite)) {
+        qWarning() << "[PAGE_FILE] 写双写文件失败:" << m_doubleWrite.errorString();
+        return false;
+    }
+    for (const auto& page : pages) {
+        if (!m_file.seek(qint64(page.first) * PageSize) || m_file.write(page.second) != PageSize) {
+            qWarning() << "[PAGE_FILE] 写页失败:" << page.first << m_file.errorString();
+            return false;
+        }
+        m_bytesWritten += PageSize;
+    }
+    return true;
+}
+
+// 记录文件 fsync 之后双写文件中的页都已完整落盘；清空后也要 fsync，旧条目不能在崩溃后被当成新页写回
+bool xhypagefile::resetDoubleWrite() {
+    if (!m_doubleWrite.isOpen()) return true;
+    return m_doubleWrite.resize(0) && xhywal::syncFile(m_doubleWrite);
+}
+
+bool xhypagefile::readPage(quint32 pageNo, char* buf) {
+    const qint64 offset = qint64(pageNo) * PageSize;
+    if (offset + PageSize > m_file.size()) {
+        memset(buf, 0, PageSize); // 尚未写出的新页
+        return true;
+    }
+    if (!m_file.seek(offset) || m_file.read(buf, PageSize) != PageSize) {
+        qWarning() << "[PAGE_FILE] 读取页失败:" << pageNo << m_file.errorString();
+        return false;
+    }
+    if (get32(buf, 0) != pageChecksum(buf)) {
+        qWarning() << "[PAGE_FILE] 页校验和不匹配:" << m_filePath << "页" << pageNo;
+        return false;
+    }
+    return true;
+}
+
+bool xhypagefile::writePage(quint32 pageNo, char* buf) {
+    sealPage(buf);
+    if (m_deferWrites) {
+        m_deferred.append({pageNo, QByteArray(buf, PageSize)});
+        return true;
+    }
+    return writeThrough({{pageNo, QByteArray(buf, PageSize)}}); // 缓冲池淘汰脏页
+}
+
+bool xhypagefile::flush() {
+    // 数据页与文件头作为一批写入双写文件：原地写入中途崩溃时整批可修复，文件头中的 LSN 不会超前于数据
+    m_deferWrites = true;
+    const bool collected = m_pool->flush(this);
+    m_deferWrites = false;
+    QList<QPair<quint32, QByteArray>> pages;
+    pages.swap(m_deferred);
+    if (!collected) return false;
+    pages.append({0, headerImage()});
+    return writeThrough(pages) && xhywal::syncFile(m_file) && resetDoubleWrite();
+}
+
+quint16 xhypagefile::pageFreeSpace(const char* page) {
+    int used = PageHeaderSize + slotCount(page) * SlotSize;
+    for (int slot = 0; slot < slotCount(page); ++slot) used += slotLength(page, slot);
+    return static_cast<quint16>(PageSize - used);
+}
+
+void xhypagefile::initDataPage(char* page) {
+    memset(page, 0, PageSize);
+    page[4] = static_cast<char>(DataPage);
+    setSlotCount(page, 0);
+    put16(page, 10, PageSize);
+}
+
+// 整理页内碎片：把存活的行紧凑地挪到页尾
+void xhypagefile::compactPage(char* page) {
+    QByteArray copy(page, PageSize);
+    quint16 end = PageSize;
+    for (int slot = 0; slot < slotCount(page); ++slot) {
+        const quint16 len = slotLength(copy.constData(), slot);
+        if (len == 0) continue;
+        end -= len;
+        memcpy(page + end, copy.constData() + slotOffset(copy.constData(), slot), len);
+        setSlot(page, slot, end, len);
+    }
+    put16(page, 10, end);
+}
+
+QByteArray xhypagefile::makeInlineTuple(quint64 rowId, const QByteArray& blob) {
+    QByteArray tuple(kTupleHeader, '\0');
+    put64(tuple.data(), 0, rowId);
+    tuple[8] = static_cast<char>(kTupleInline);
+    tuple.append(blob);
+    return tuple;
+}
+
+bool xhypagefile::tupleForBlob(quint64 rowId, const QByteArray& blob, QByteArray* tuple) {
+    if (blob.size() <= InlineLimit) {
+        *tuple = makeInlineTuple(rowId, blob);
+        return true;
+    }
+    quint32 firstPage = 0;
+    if (!writeOverflow(blob, &firstPage)) return false;
+    *tuple = QByteArray(kTupleHeader + 8, '\0');
+    put64(tuple->data(), 0, rowId);
+    (*tuple)[8] = static_cast<char>(kTupleOverflow);
+    put32(tuple->data(), kTupleHeader, firstPage);
+    put32(tuple->data(), kTupleHeader + 4, static_cast<quint32>(blob.size()));
+    return true;
+}
+
+quint32 xhypagefile::allocatePage() {
+    if (!m_freePages.isEmpty()) return m_freePages.takeFirst();
+    m_freeSpace.append(0);
+    return m_pageCount++;
+}
+
+bool xhypagefile::writeOverflow(const QByteArray& blob, quint32* firstPage) {
+    const int chunks = (blob.size() + kOverflowPayload - 1) / kOverflowPayload;
+    QVector<quint32> pages(chunks);
+    for (int i = 0; i < chunks; ++i) pages[i] = allocatePage();
+
+    for (int i = 0; i < chunks; ++i) {
+        char* page = m_pool->pin(this, pages[i], true);
+        if (!page) return false;
+        const int len = qMin(kOverflowPayload, int(blob.size()) - i * kOverflowPayload);
+        page[4] = static_cast<char>(OverflowPage);
+        put16(page, 6, static_cast<quint16>(len));
+        put32(page, 12, i + 1 < chunks ? pages[i + 1] : 0);
+        memcpy(page + PageHeaderSize, blob.constData() + i * kOverflowPayload, len);
+        m_freeSpace[pages[i]] = 0;
+        m_pool->unpin(this, pages[i], true);
+    }
+    *firstPage = pages.first();
+    return true;
+}
+
+bool xhypagefile::readOverflow(quint32 firstPage, quint32 totalLength, QByteArray* blob) {
+    blob->clear();
+    blob->reserve(totalLength);
+    quint32 pageNo = firstPage;
+    while (pageNo != 0 && quint32(blob->size()) < totalLength) {
+        const char* page = m_pool->pin(this, pageNo);
+        if (!page) return false;
+        const bool valid = pageType(page) == OverflowPage;
+        if (valid) blob->append(page + PageHeaderSize, get16(page, 6));
+        const quint32 next = get32(page, 12);
+        m_pool->unpin(this, pageNo, false);
+        if (!valid) return false;
+        pageNo = next;
+    }
+    return quint32(blob->size()) == totalLength;
+}
+
+void xhypagefile::freeOverflow(quint32 firstPage) {
+    quint32 pageNo = firstPage;
+    while (pageNo != 0) {
+        char* page = m_pool->pin(this, pageNo);
+        if (!page) return;
+        const quint32 next = get32(page, 12);
+        memset(page, 0, PageSize);
+        page[4] = static_cast<char>(FreePage);
+        m_pool->unpin(this, pageNo, true);
+        m_freePages.append(pageNo);
+        pageNo = next;
+    }
+}
+
+void xhypagefile::releaseTuple(const char* page, quint16 slot) {
+    const quint16 off = slotOffset(page, slot);
+    if (slotLength(page, slot) >= kTupleHeader + 8 && static_cast<quint8>(page[off + 8]) == kTupleOverflow) {
+        freeOverflow(get32(page, off + kTupleHeader));
+    }
+}
+
+bool xhypagefile::decodeTuple(const char* page, quint16 slot, quint64* rowId, QByteArray* blob) {
+    const quint16 off = slotOffset(page, slot);
+    const quint16 len = slotLength(page, slot);
+    if (len < kTupleHeader || off + len > PageSize) return false;
+    *rowId = get64(page, off);
+    if (static_cast<quint8>(page[off + 8]) == kTupleOverflow) {
+        return readOverflow(get32(page, off + kTupleHeader), get32(page, off + kTupleHeader + 4), blob);
+    }
+    *blob = QByteArray(page + off + kTupleHeader, len - kTupleHeader);
+    return true;
+}
+
+bool xhypagefile::placeTuple(quint64 rowId, const QByteArray& tuple, quint32 skipPage) {
+    const int need = tuple.size() + SlotSize;
+    quint32 target = 0;
+    // 从上次插入的页开始查空闲空间表
+    for (quint32 i = 0; i + 1 < m_pageCount && target == 0; ++i) {
+        const quint32 pageNo = 1 + (m_insertHint - 1 + i) % (m_pageCount - 1);
+        if (pageNo != skipPage && m_freeSpace.value(pageNo) >= need) target = pageNo;
+    }
+    const bool fresh = target == 0;
+    if (fresh) target = allocatePage();
+
+    char* page = m_pool->pin(this, target, fresh);
+    if (!page) return false;
+    if (fresh || pageType(page) != DataPage) initDataPage(page);
+
+    int slot = 0;
+    while (slot < slotCount(page) && slotLength(page, slot) != 0) ++slot;
+    const bool newSlot = slot == slotCount(page);
+    const int contiguousNeed = tuple.size() + (newSlot ? SlotSize : 0);
+    if (freeEnd(page) - freeStart(page) < contiguousNeed) compactPage(page);
+    if (newSlot) setSlotCount(page, slotCount(page) + 1);
+
+    const quint16 offset = freeEnd(page) - tuple.size();
+    memcpy(page + offset, tuple.constData(), tuple.size());
+    put16(page, 10, offset);
+    setSlot(page, slot, offset, static_cast<quint16>(tuple.size()));
+    m_freeSpace[target] = pageFreeSpace(page);
+    m_pool->unpin(this, target, true);
+
+    m_directory.insert(rowId, Location{target, static_cast<quint16>(slot)});
+    m_insertHint = target;
+    return true;
+}
+
+bool xhypagefile::read(quint64 rowId, QByteArray* blob) {
+    auto it = m_directory.constFind(rowId);
+    if (it == m_directory.constEnd()) return false;
+    const char* page = m_pool->pin(this, it->page);
+    if (!page) return false;
+    quint64 storedId = 0;
+    const bool ok = decodeTuple(page, it->slot, &storedId, blob) && storedId == rowId;
+    m_pool->unpin(this, it->page, false);
+    return ok;
+}
+
+bool xhypagefile::insert(quint64 rowId, const QByteArray& blob) {
+    if (m_directory.contains(rowId)) return update(rowId, blob);
+    QByteArray tuple;
+    if (!tupleForBlob(rowId, blob, &tuple)) return false;
+    if (rowId >= m_nextRowId) m_nextRowId = rowId + 1;
+    return placeTuple(rowId, tuple, 0);
+}
+
+bool xhypagefile::update(quint64 rowId, const QByteArray& blob) {
+    auto it = m_directory.find(rowId);
+    if (it == m_directory.end()) return insert(rowId, blob);
+    const Location loc = it.value();
+
+    QByteArray tuple;
+    if (!tupleForBlob(rowId, blob, &tuple)) return false;
+    char* page = m_pool->pin(this, loc.page);
+    if (!page) return false;
+    releaseTuple(page, loc.slot);
+    setSlot(page, loc.slot, 0, 0);
+
+    if (tuple.size() <= pageFreeSpace(page)) {
+        // 原地更新：页内空间够就保持行的位置不变
+        if (freeEnd(page) - freeStart(page) < tuple.size()) compactPage(page);
+        const quint16 offset = freeEnd(page) - tuple.size();
+        memcpy(page + offset, tuple.constData(), tuple.size());
+        put16(page, 10, offset);
+        setSlot(page, loc.slot, offset, static_cast<quint16>(tuple.size()));
+        m_freeSpace[loc.page] = pageFreeSpace(page);
+        m_pool->unpin(this, loc.page, true);
+        return true;
+    }
+    m_freeSpace[loc.page] = pageFreeSpace(page);
+    m_pool->unpin(this, loc.page, true);
+    m_directory.erase(it);
+    return placeTuple(rowId, tuple, loc.page);
+}
+
+bool xhypagefile::remove(quint64 rowId) {
+    auto it = m_directory.find(rowId);
+    if (it == m_directory.end()) return true;
+    const Location loc = it.value();
+    char* page = m_pool->pin(this, loc.page);
+    if (!page) return false;
+    releaseTuple(page, loc.slot);
+    setSlot(page, loc.slot, 0, 0);
+    // 去掉尾部的空槽
+    quint16 count = slotCount(page);
+    while (count > 0 && slotLength(page, count - 1) == 0) --count;
+    setSlotCount(page, count);
+    m_freeSpace[loc.page] = pageFreeSpace(page);
+    m_pool->unpin(this, loc.page, true);
+    m_directory.erase(it);
+    return true;
+}
+
+bool xhypagefile::scan(const std::function<bool(quint64 rowId, const QByteArray& blob)>& visitor) {
+    for (quint32 pageNo = 1; pageNo < m_pageCount; ++pageNo) {
+        const char* page = m_pool->pin(this, pageNo);
+        if (!page) return false;
+        bool keepGoing = true;
+        if (pageType(page) == DataPage) {
+            for (int slot = 0; slot < slotCount(page) && keepGoing; ++slot) {
+                if (slotLength(page, slot) == 0) continue;
+                quint64 rowId = 0;
+                QByteArray blob;
+                if (!decodeTuple(page, slot, &rowId, &blob)) {
+                    qWarning() << "[PAGE_FILE] 页" << pageNo << "槽" << slot << "的数据无法解析，已跳过。";
+                    continue;
+                }
+                keepGoing = visitor(rowId, blob);
+            }
+        }
+        m_pool->unpin(this, pageNo, false);
+        if (!keepGoing) break;
+    }
+    return true;
+}
+
+qint64 xhypagefile::build(const QString& filePath, const QList<QPair<quint64, QByteArray>>& rows,
+                          quint64 nextRowId, quint64 walLsn) {
+    QSaveFile out(filePath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qWarning() << "[PAGE_FILE] 无法写入记录文件:" << filePath << out.errorString();
+        return 0;
+    }
+
+    QByteArray header(PageSize, '\0');
+    out.write(header); // 占位，最后回填
+
+    quint32 nextPageNo = 1;
+    QByteArray dataPage(PageSize, '\0');
+    QList<QByteArray> overflowPages; // 跟在当前数据页之后写出，保证顺序写
+    bool pageOpen = false;
+    auto flushDataPage = [&]() {
+        if (!pageOpen) return;
+        sealPage(dataPage.data());
+        out.write(dataPage);
+        for (QByteArray& ov : overflowPages) {
+            sealPage(ov.data());
+            out.write(ov);
+        }
+        overflowPages.clear();
+        pageOpen = false;
+    };
+
+    for (const auto& row : rows) {
+        QByteArray tuple;
+        if (row.second.size() <= InlineLimit) {
+            tuple = makeInlineTuple(row.first, row.second);
+        } else {
+            tuple = QByteArray(kTupleHeader + 8, '\0');
+            put64(tuple.data(), 0, row.first);
+            tuple[8] = static_cast<char>(kTupleOverflow);
+            put32(tuple.data(), kTupleHeader + 4, static_cast<quint32>(row.second.size()));
+        }
+        if (pageOpen && freeEnd(dataPage.constData()) - freeStart(dataPage.constData()) < tuple.size() + SlotSize) {
+            flushDataPage();
+        }
+        if (!pageOpen) {
+            initDataPage(dataPage.data());
+            ++nextPageNo;
+            pageOpen = true;
+        }
+        if (static_cast<quint8>(tuple.at(8)) == kTupleOverflow) {
+            const QByteArray& blob = row.second;
+            const int chunks = (blob.size() + kOverflowPayload - 1) / kOverflowPayload;
+            put32(tuple.data(), kTupleHeader, nextPageNo);
+            for (int i = 0; i < chunks; ++i) {
+                QByteArray ov(PageSize, '\0');
+                const int len = qMin(kOverflowPayload, int(blob.size()) - i * kOverflowPayload);
+                ov[4] = static_cast<char>(OverflowPage);
+                put16(ov.data(), 6, static_cast<quint16>(len));
+                put32(ov.data(), 12, i + 1 < chunks ? nextPageNo + 1 : 0);
+                memcpy(ov.data() + PageHeaderSize, blob.constData() + i * kOverflowPayload, len);
+                overflowPages.append(ov);
+                ++nextPageNo;
+            }
+        }
+        char* page = dataPage.data();
+        const int slot = slotCount(page);
+        setSlotCount(page, slot + 1);
+        const quint16 offset = freeEnd(page) - tuple.size();
+        memcpy(page + offset, tuple.constData(), tuple.size());
+        put16(page, 10, offset);
+        setSlot(page, slot, offset, static_cast<quint16>(tuple.size()));
+    }
+    flushDataPage();
+
+    fillHeaderPage(header.data(), nextPageNo, walLsn, nextRowId, rows.size());
+    const qint64 written = out.pos();
+    // 双写文件中的页属于被替换的旧文件，不能在之后写回到新文件
+    const QString dwbPath = doubleWritePath(filePath);
+    if (QFile::exists(dwbPath) && !QFile::remove(dwbPath)) {
+        qWarning() << "[PAGE_FILE] 无法删除双写文件:" << dwbPath;
+        out.cancelWriting();
+        return 0;
+    }
+    if (!out.seek(0) || out.write(header) != PageSize || !xhywal::syncFile(out) || !out.commit()) {
+        qWarning() << "[PAGE_FILE] 提交记录文件失败:" << filePath << out.errorString();
+        return 0;
+    }
+    return written;
+}
@@ -0,0 +1,119 @@
+#ifndef XHYPAGEFILE_H
+#define XHYPAGEFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class xhybufferpool;
+
+// 分页记录文件（.trd）：定长页 + 槽目录 + 空闲空间表
+// 第 0 页为文件头（魔数、页数、检查点 LSN、下一个行号、行数）
+// 数据页: 页头 | 槽目录(offset,length) 向后增长 | ... 空闲 ... | 行数据从页尾向前增长
+// 每行数据前带 quint64 行号；超过 InlineLimit 的行存入溢出页链
+// 双写文件（.trd.dwb）：页先追加到双写文件并 fsync，再原地写入；原地写入时崩溃（页撕裂）由 recoverTornPages 用双写文件中的完整页修复
+class xhypagefile {
+public:
+    static const int PageSize = 8192;
+    static const int PageHeaderSize = 16;
+    static const int SlotSize = 4;
+    static const int InlineLimit = PageSize / 4;
+
+    enum PageType : quint8 { DataPage = 0, OverflowPage = 1, FreePage = 2, HeaderPage = 3 };
+
+    xhypagefile(const QString& filePath, xhybufferpool* pool);
+    ~xhypagefile();
+
+    bool open();  // 读文件头并扫描一遍页，建立行号目录和空闲空间表
+    void close(); // 丢弃缓冲池中的页（调用前应先 flush）
+    bool isOpen() const { return m_file.isOpen(); }
+    QString filePath() const { return m_filePath; }
+
+    bool contains(quint64 rowId) const { return m_directory.contains(rowId); }
+    bool read(quint64 rowId, QByteArray* blob);
+    bool insert(quint64 rowId, const QByteArray& blob);
+    bool update(quint64 rowId, const QByteArray& blob); // 放得下则原地更新，否则迁移到别的页
+    bool remove(quint64 rowId);
+    // 按物理顺序遍历所有行，visitor 返回 false 时停止
+    bool scan(const std::function<bool(quint64 rowId, const QByteArray& blob)>& visitor);
+    bool flush(); // 脏页与文件头一起经双写文件写回、fsync，再清空双写文件
+
+    quint64 walLsn() const { return m_walLsn; }
+    void setWalLsn(quint64 lsn) { m_walLsn = lsn; }
+    quint64 nextRowId() const { return m_nextRowId; }
+    void setNextRowId(quint64 rowId) { m_nextRowId = rowId; }
+    quint64 rowCount() const { return m_directory.size(); }
+    quint32 pageCount() const { return m_pageCount; }
+    qint64 bytesWritten() const { return m_bytesWritten; }
+
+    // 缓冲池回调
+    bool readPage(quint32 pageNo, char* buf);
+    bool writePage(quint32 pageNo, char* buf);
+
+    static bool isPageFile(const QString& filePath);
+    static QString doubleWritePath(const QString& filePath) { return filePath + ".dwb"; }
+    // 把双写文件中完整的页写回记录文件并删除双写文件；打开或扫描记录文件之前调用。没有双写文件时直接返回 true
+    static bool recoverTornPages(const QString& filePath);
+    struct HeaderInfo {
+        quint32 pageCount = 1;
+        quint64 walLsn = 0;
+        quint64 nextRowId = 1;
+        quint64 rowCount = 0;
+    };
+    // 只读文件头（不扫描数据页），用于启动时判断是否需要重放日志、规划并行解码
+    static bool readHeaderInfo(const QString& filePath, HeaderInfo* info);
+    // 不经缓冲池、用独立的文件句柄顺序读取 [firstPage, endPage) 中的行，可在多个线程中并发调用
+    // visitor 收到的指针只在回调期间有效；页校验和不匹配时返回 false（日志已截断，不能跳过损坏的页）
+    static bool scanRange(const QString& filePath, quint32 firstPage, quint32 endPage,
+                          const std::function<bool(quint64 rowId, const char* data, int size)>& visitor);
+    // 整体重写：按行号顺序紧凑装页，经 QSaveFile 原子替换；返回写入字节数，失败返回 0
+    static qint64 build(const QString& filePath, const QList<QPair<quint64, QByteArray>>& rows,
+                        quint64 nextRowId, quint64 walLsn);
+
+private:
+    struct Location {
+        quint32 page = 0;
+        quint16 slot = 0;
+    };
+
+    static quint16 pageFreeSpace(const char* page);
+    static void compactPage(char* page);
+    static void initDataPage(char* page);
+    static QByteArray makeInlineTuple(quint64 rowId, const QByteArray& blob);
+
+    bool readHeader();
+    QByteArray headerImage() const;
+    // 先把页追加到双写文件并 fsync，再原地写入（不 fsync 记录文件）
+    bool writeThrough(const QList<QPair<quint32, QByteArray>>& pages);
+    bool resetDoubleWrite();
+    quint32 allocatePage();
+    bool writeOverflow(const QByteArray& blob, quint32* firstPage);
+    bool readOverflow(quint32 firstPage, quint32 totalLength, QByteArray* blob);
+    void freeOverflow(quint32 firstPage);
+    bool placeTuple(quint64 rowId, const QByteArray& tuple, quint32 skipPage);
+    bool tupleForBlob(quint64 rowId, const QByteArray& blob, QByteArray* tuple);
+    void releaseTuple(const char* page, quint16 slot);
+    bool decodeTuple(const char* page, quint16 slot, quint64* rowId, QByteArray* blob);
+
+    QString m_filePath;
+    xhybufferpool* m_pool;
+    QFile m_file;
+    QFile m_doubleWrite;
+    bool m_deferWrites = false;                      // flush 期间缓冲池写回的页先收集起来，与文件头一起双写
+    QList<QPair<quint32, QByteArray>> m_deferred;
+    quint32 m_pageCount = 1;
+    quint64 m_walLsn = 0;
+    quint64 m_nextRowId = 1;
+    QHash<quint64, Location> m_directory; // 行号 -> (页, 槽)
+    QVector<quint16> m_freeSpace;          // 空闲空间表：每个数据页可用字节（含可整理的碎片）
+    QList<quint32> m_freePages;            // 可复用的空页
+    quint32 m_insertHint = 1;
+    qint64 m_bytesWritten = 0;
+};
+
+#endif // XHYPAGEFILE_H
@@ -0,0 +1,481 @@
+#include "xhypredicate.h"
+#include "xhytable.h"
+#include <QDate>
+#include <QDateTime>
+#include <QDebug>
+#include <stdexcept>
+
+namespace {
+const double kEpsilon = 0.000001; // 与 compareQVariants 的浮点容差一致
+
+bool isIntegerType(int typeId) {
+    return typeId == QMetaType::Int || typeId == QMetaType::LongLong || typeId == QMetaType::ULongLong;
+}
+
+template <typename T>
+bool ordered(const T& l, const T& r, xhypredicate::Op op) {
+    switch (op) {
+    case xhypredicate::Eq: return l == r;
+    case xhypredicate::Ne: return l != r;
+    case xhypredicate::Lt: return l < r;
+    case xhypredicate::Le: return l <= r;
+    case xhypredicate::Gt: return l > r;
+    case xhypredicate::Ge: return l >= r;
+    default: return false;
+    }
+}
+
+bool approximately(double l, double r, xhypredicate::Op op) {
+    const bool equal = qAbs(l - r) < kEpsilon;
+    switch (op) {
+    case xhypredicate::Eq: return equal;
+    case xhypredicate::Ne: return !equal;
+    case xhypredicate::Lt: return l < r && !equal;
+    case xhypredicate::Le: return l < r || equal;
+    case xhypredicate::Gt: return l > r && !equal;
+    case xhypredicate::Ge: return l > r || equal;
+    default: return false;
+    }
+}
+
+bool textOrdered(const QString& l, const QString& r, xhypredicate::Op op) {
+    const int c = l.compare(r, Qt::CaseSensitive);
+    return ordered(c, 0, op);
+}
+}
+
+xhypredicate::xhypredicate() {
+    m_nodes.append(Node()); // True
+}
+
+xhypredicate xhypredicate::compile(const ConditionNode& condition, const QSharedDataPointer<xhyrecordlayout>& layout,
+                                   const Resolver& resolve, Mode mode) {
+    xhypredicate predicate;
+    predicate.m_nodes.clear();
+    predicate.m_layout = layout;
+    predicate.m_mode = mode;
+    predicate.add(condition, resolve);
+    return predicate;
+}
+
+QList<ConditionNode> xhypredicate::conjuncts(const ConditionNode& condition) {
+    QList<ConditionNode> result;
+    if (condition.type == ConditionNode::EMPTY) return result;
+    if (condition.type == ConditionNode::LOGIC_OP && condition.logicOp.compare("AND", Qt::CaseInsensitive) == 0) {
+        for (const ConditionNode& child : condition.children) result += conjuncts(child);
+        return result;
+    }
+    result.append(condition);
+    return result;
+}
+
+ConditionNode xhypredicate::conjunction(const QList<ConditionNode>& conditions) {
+    if (conditions.isEmpty()) return ConditionNode();
+    if (conditions.size() == 1) return conditions.first();
+    ConditionNode node(ConditionNode::LOGIC_OP, "AND");
+    node.children = conditions;
+    return node;
+}
+
+QStringList xhypredicate::referencedFields(const ConditionNode& condition) {
+    QStringList fields;
+    if (condition.type == ConditionNode::COMPARISON_OP) fields.append(condition.comparison.fieldName);
+    for (const ConditionNode& child : condition.children) fields += referencedFields(child);
+    return fields;
+}
+
+xhypredicate::Op xhypredicate::opFromString(const QString& op) {
+    if (op == "=") return Eq;
+    if (op == "!=" || op == "<>") return Ne;
+    if (op == "<") return Lt;
+    if (op == "<=") return Le;
+    if (op == ">") return Gt;
+    if (op == ">=") return Ge;
+    return NoOp;
+}
+
+// 按前序追加节点，返回节点下标；错误只记录在 Fail 节点里，求值到它时才抛出（与逐行解释时的时机一致）
+int xhypredicate::add(const ConditionNode& condition, const Resolver& resolve) {
+    const int index = m_nodes.size();
+    m_nodes.append(Node());
+    Node node;
+    switch (condition.type) {
+    case ConditionNode::EMPTY:
+        node.kind = True;
+        break;
+    case ConditionNode::LOGIC_OP: {
+        const bool isAnd = condition.logicOp.compare("AND", Qt::CaseInsensitive) == 0;
+        if (condition.children.isEmpty()) {
+            node.kind = isAnd ? True : False;
+        } else if (isAnd || condition.logicOp.compare("OR", Qt::CaseInsensitive) == 0) {
+            node.kind = isAnd ? And : Or;
+            for (const ConditionNode& child : condition.children) node.children.append(add(child, resolve));
+        } else {
+            node.kind = Fail;
+            node.error = (m_mode == JoinedRows ? "未知的逻辑运算符: " : "未知逻辑运算符: ") + condition.logicOp;
+        }
+        break;
+    }
+    case ConditionNode::NEGATION_OP:
+        if (condition.children.isEmpty()) {
+            node.kind = Fail;
+            node.error = "NOT 操作符后缺少条件";
+        } else {
+            node.kind = Not;
+            node.children.append(add(condition.children.first(), resolve));
+        }
+        break;
+    case ConditionNode::COMPARISON_OP: {
+        const ComparisonDetails& cd = condition.comparison;
+        const Column column = resolve(cd.fieldName);
+        if (!column.found) {
+            node.kind = Fail;
+            node.error = column.error;
+            break;
+        }
+        node.name = column.name;
+        node.type = column.type;
+        node.storage = xhytable::storageTypeFor(column.type);
+        node.ordinal = m_layout.constData() ? m_layout.constData()->indexOf(column.name) : -1;
+        node.nativeType = node.ordinal >= 0 && m_layout.constData()->type(node.ordinal) == node.storage;
+
+        const QString& op = cd.operation;
+        if (op.compare("IS NULL", Qt::CaseInsensitive) == 0) {
+            node.kind = IsNull;
+        } else if (op.compare("IS NOT NULL", Qt::CaseInsensitive) == 0) {
+            node.kind = IsNotNull;
+        } else if (op.compare("IN", Qt::CaseInsensitive) == 0 || op.compare("NOT IN", Qt::CaseInsensitive) == 0) {
+            node.kind = In;
+            node.negated = op.compare("NOT IN", Qt::CaseInsensitive) == 0;
+            bool allInts = !cd.valueList.isEmpty(), allTexts = !cd.valueList.isEmpty();
+            for (const QVariant& item : cd.valueList) {
+                const Value value = fromVariant(item);
+                node.list.append(value);
+                allInts = allInts && value.type == Value::Int;
+                allTexts = allTexts && value.type == Value::Text && value.numeric == 0;
+            }
+            if (allInts) {
+                for (const Value& value : node.list) node.intSet.insert(value.i);
+                node.intsHashed = true;
+            } else if (allTexts) {
+                for (const Value& value : node.list) node.textSet.insert(value.s);
+                node.textsHashed = true;
+            }
+        } else if (op.compare("BETWEEN", Qt::CaseInsensitive) == 0 || op.compare("NOT BETWEEN", Qt::CaseInsensitive) == 0) {
+            node.kind = Between;
+            node.negated = op.compare("NOT BETWEEN", Qt::CaseInsensitive) == 0;
+            node.value = fromVariant(cd.value);
+            node.value2 = fromVariant(cd.value2);
+        } else if (op.compare("LIKE", Qt::CaseInsensitive) == 0 || op.compare("NOT LIKE", Qt::CaseInsensitive) == 0) {
+            node.kind = Like;
+            node.negated = op.compare("NOT LIKE", Qt::CaseInsensitive) == 0;
+            if (cd.value.typeId() != QMetaType::QString && !cd.value.canConvert<QString>()) {
+                node.error = m_mode == JoinedRows ? "LIKE 操作符的模式必须是字符串。"
+                                                  : "LIKE 操作符的模式必须是字符串或可转换为字符串。";
+            } else {
+                node.pattern = QRegularExpression(sqlLikeToRegex(cd.value.toString()), QRegularExpression::CaseInsensitiveOption);
+                node.pattern.optimize();
+            }
+        } else {
+            node.kind = Compare;
+            node.op = opFromString(op);
+            node.value = fromVariant(cd.value);
+            if (node.op == NoOp) qWarning() << "[xhypredicate] 不支持的比较运算符 '" << op << "'，条件恒为假。";
+        }
+        break;
+    }
+    default:
+        node.kind = Fail;
+        node.error = "未知的条件节点类型";
+        break;
+    }
+    m_nodes[index] = node;
+    return index;
+}
+
+bool xhypredicate::evaluate(const xhyrecord& record, int index) const {
+    const Node& node = m_nodes.at(index);
+    switch (node.kind) {
+    case True:
+        return true;
+    case False:
+        return false;
+    case Fail:
+        throw std::runtime_error(node.error.toStdString());
+    case And:
+        for (int child : node.children) {
+            if (!evaluate(record, child)) return false;
+        }
+        return true;
+    case Or:
+        for (int child : node.children) {
+            if (evaluate(record, child)) return true;
+        }
+        return false;
+    case Not:
+        return !evaluate(record, node.children.first());
+    default:
+        return evaluateLeaf(record, node);
+    }
+}
+
+bool xhypredicate::evaluateLeaf(const xhyrecord& record, const Node& node) const {
+    bool present = true;
+    const Value value = rowValue(record, node, &present);
+    if (m_mode == JoinedRows) {
+        if (!present) return node.kind == IsNull; // 合并记录中没有该列：IS NULL 为真，其余为假
+        if (value.type == Value::Null && node.kind != IsNull && node.kind != IsNotNull) return false;
+    }
+
+    switch (node.kind) {
+    case IsNull:
+        return value.type == Value::Null;
+    case IsNotNull:
+        return value.type != Value::Null;
+    case Compare:
+        return compare(value, node.value, node.op);
+    case Between: {
+        const bool between = compare(value, node.value, Ge) && compare(value, node.value2, Le);
+        return node.negated ? !between : between;
+    }
+    case In: {
+        bool found = false;
+        if (value.type == Value::Null) {
+            found = false;
+        } else if (node.intsHashed && value.type == Value::Int) {
+            found = node.intSet.contains(value.i);
+        } else if (node.textsHashed && value.type == Value::Text) {
+            found = node.textSet.contains(value.s);
+        } else {
+            for (const Value& item : node.list) {
+                if (compare(value, item, Eq)) { found = true; break; }
+            }
+        }
+        return node.negated ? !found : found;
+    }
+    case Like: {
+        if (!node.error.isEmpty()) throw std::runtime_error(node.error.toStdString());
+        const bool matches = node.pattern.match(toString(value)).hasMatch();
+        return node.negated ? !matches : matches;
+    }
+    default:
+        return false;
+    }
+}
+
+// 与 matchConditions 取行值的方式相同：按列类型原生存放的单元直接取值，其余单元按文本解析
+xhypredicate::Value xhypredicate::rowValue(const xhyrecord& record, const Node& node, bool* present) const {
+    int ordinal = node.ordinal;
+    bool nativeType = node.nativeType;
+    if (!record.sharesLayout(m_layout)) {
+        ordinal = record.layout().indexOf(node.name);
+        nativeType = ordinal >= 0 && record.layout().type(ordinal) == node.storage;
+    }
+    *present = record.containsAt(ordinal);
+    if (ordinal >= 0 && nativeType) {
+        Value value;
+        if (record.isNullAt(ordinal)) return value;
+        if (record.intAt(ordinal, &value.i)) {
+            value.type = Value::Int;
+            return value;
+        }
+        if (record.doubleAt(ordinal, &value.d)) {
+            value.type = Value::Double;
+            return value;
+        }
+        QVariant native;
+        if (record.nativeValueAt(ordinal, &native)) {
+            if (native.typeId() == QMetaType::QDate) {
+                value.type = Value::Date;
+                value.i = native.toDate().toJulianDay();
+            } else {
+                value.type = Value::Bool;
+                value.i = native.toBool() ? 1 : 0;
+            }
+            return value;
+        }
+    }
+    return fromText(record.valueAt(ordinal), node.type);
+}
+
+// 与 xhytable::convertToTypedValue 相同的解析规则
+xhypredicate::Value xhypredicate::fromText(const QString& text, xhyfield::datatype type) {
+    Value value;
+    if (text.isNull() || text.compare("NULL", Qt::CaseInsensitive) == 0) return value;
+    bool ok = false;
+    switch (type) {
+    case xhyfield::INT:
+    case xhyfield::TINYINT:
+    case xhyfield::SMALLINT:
+    case xhyfield::BIGINT:
+        value.i = text.toLongLong(&ok);
+        if (ok) {
+            value.type = Value::Int;
+            return value;
+        }
+        break;
+    case xhyfield::FLOAT:
+    case xhyfield::DOUBLE:
+    case xhyfield::DECIMAL:
+        value.d = text.toDouble(&ok);
+        if (ok) {
+            value.type = Value::Double;
+            return value;
+        }
+        break;
+    case xhyfield::BOOL:
+        if (text.compare("true", Qt::CaseInsensitive) == 0 || text == "1") {
+            value.type = Value::Bool;
+            value.i = 1;
+            return value;
+        }
+        if (text.compare("false", Qt::CaseInsensitive) == 0 || text == "0") {
+            value.type = Value::Bool;
+            value.i = 0;
+            return value;
+        }
+        break;
+    case xhyfield::DATE: {
+        QDate date = QDate::fromString(text, "yyyy-MM-dd");
+        if (!date.isValid()) date = QDate::fromString(text, Qt::ISODate);
+        if (date.isValid()) {
+            value.type = Value::Date;
+            value.i = date.toJulianDay();
+            return value;
+        }
+        break;
+    }
+    case xhyfield::DATETIME:
+    case xhyfield::TIMESTAMP: {
+        QDateTime dt = QDateTime::fromString(text, "yyyy-MM-dd HH:mm:ss");
+        if (!dt.isValid()) dt = QDateTime::fromString(text, Qt::ISODate);
+        if (dt.isValid()) {
+            value.type = Value::Variant;
+            value.v = QVariant(dt);
+            return value;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    value = Value();
+    value.type = Value::Text;
+    value.s = text;
+    return value;
+}
+
+// 常量只分类一次；文本常量同时记下能否转为数值
+xhypredicate::Value xhypredicate::fromVariant(const QVariant& constant) {
+    Value value;
+    if (!constant.isValid() || constant.isNull()) return value;
+    const int typeId = constant.typeId();
+    if (isIntegerType(typeId)) {
+        value.type = Value::Int;
+        value.i = constant.toLongLong();
+    } else if (typeId == QMetaType::Double) {
+        value.type = Value::Double;
+        value.d = constant.toDouble();
+    } else if (typeId == QMetaType::Bool) {
+        value.type = Value::Bool;
+        value.i = constant.toBool() ? 1 : 0;
+    } else if (typeId == QMetaType::QDate && constant.toDate().isValid()) {
+        value.type = Value::Date;
+        value.i = constant.toDate().toJulianDay();
+    } else if (typeId == QMetaType::QString) {
+        value.type = Value::Text;
+        value.s = constant.toString();
+        bool ok = false;
+        value.d = constant.toDouble(&ok);
+        value.numeric = ok ? 1 : 0;
+    } else {
+        value.type = Value::Variant;
+        value.v = constant;
+    }
+    return value;
+}
+
+QVariant xhypredicate::toVariant(const Value& value) {
+    switch (value.type) {
+    case Value::Int: return QVariant(static_cast<qlonglong>(value.i));
+    case Value::Double: return QVariant(value.d);
+    case Value::Bool: return QVariant(value.i != 0);
+    case Value::Date: return QVariant(QDate::fromJulianDay(value.i));
+    case Value::Text: return QVariant(value.s);
+    case Value::Variant: return value.v;
+    default: return QVariant();
+    }
+}
+
+// 与 QVariant::toString 一致（LIKE 及字符串比较使用）
+QString xhypredicate::toString(const Value& value) {
+    switch (value.type) {
+    case Value::Int: return QString::number(value.i);
+    case Value::Text: return value.s;
+    case Value::Date: return QDate::fromJulianDay(value.i).toString(Qt::ISODate);
+    case Value::Null: return QString();
+    default: return toVariant(value).toString();
+    }
+}
+
+bool xhypredicate::toNumber(const Value& value, double* out) {
+    switch (value.type) {
+    case Value::Int:
+    case Value::Bool:
+        *out = static_cast<double>(value.i);
+        return true;
+    case Value::Double:
+        *out = value.d;
+        return true;
+    case Value::Text: {
+        if (value.numeric >= 0) {
+            *out = value.d;
+            return value.numeric == 1;
+        }
+        bool ok = false;
+        *out = QVariant(value.s).toDouble(&ok); // 行值按需解析，规则与 QVariant 相同
+        return ok;
+    }
+    default:
+        return false;
+    }
+}
+
+// compareVariants 在预分类值上的实现：Int/Double/Bool/Text 之间先尝试按数值比较，两边都是日期时按日期，其余按字符串
+bool xhypredicate::compare(const Value& left, const Value& right, Op op) {
+    if (left.type == Value::Null || right.type == Value::Null) return false;
+    if (left.type == Value::Variant || right.type == Value::Variant) {
+        return compareVariants(toVariant(left), toVariant(right), op);
+    }
+    if (left.type == Value::Int && right.type == Value::Int) return ordered(left.i, right.i, op);
+    if (left.type != Value::Date && right.type != Value::Date) {
+        double l = 0, r = 0;
+        if (toNumber(right, &r) && toNumber(left, &l)) return approximately(l, r, op);
+        return textOrdered(toString(left), toString(right), op);
+    }
+    if (left.type == Value::Date && right.type == Value::Date) return ordered(left.i, right.i, op);
+    return textOrdered(toString(left), toString(right), op);
+}
+
+bool xhypredicate::compareVariants(const QVariant& left, const QVariant& right, Op op) {
+    // 任一方是 SQL NULL 时结果为假（UNKNOWN）
+    if (!left.isValid() || left.isNull() || !right.isValid() || right.isNull()) return false;
+
+    const int leftTypeId = left.typeId();
+    const int rightTypeId = right.typeId();
+    if (isIntegerType(leftTypeId) && isIntegerType(rightTypeId)) {
+        return ordered(left.toLongLong(), right.toLongLong(), op);
+    }
+    if (left.canConvert<double>() && right.canConvert<double>()) {
+        bool lok = false, rok = false;
+        const double l = left.toDouble(&lok);
+        const double r = right.toDouble(&rok);
+        if (lok && rok) return approximately(l, r, op);
+        // 无法转为数值时按字符串比较
+    } else if (leftTypeId == QMetaType::QDate && rightTypeId == QMetaType::QDate) {
+        return ordered(left.toDate(), right.toDate(), op);
+    } else if (leftTypeId == QMetaType::QDateTime && rightTypeId == QMetaType::QDateTime) {
+        return ordered(left.toDateTime(), right.toDateTime(), op);
+    }
+    return textOrdered(left.toString(), right.toString(), op);
+}
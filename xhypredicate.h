@@ -0,0 +1,100 @@
+#ifndef XHYPREDICATE_H
+#define XHYPREDICATE_H
+
+#include "ConditionNode.h"
+#include "xhyfield.h"
+#include "xhyrecord.h"
+#include <QRegularExpression>
+#include <QSet>
+#include <QSharedDataPointer>
+#include <QVector>
+#include <functional>
+
+QString sqlLikeToRegex(const QString& likePattern, QChar customEscapeChar = QChar::Null);
+
+// 编译后的 WHERE 条件：每条语句编译一次，逐行求值时不再比较运算符字符串或查找字段定义
+// 列解析为布局序号，常量预先分类，IN 列表按类型建哈希集合；结果与 xhytable::matchConditions 的规则完全一致
+class xhypredicate {
+public:
+    enum Op : quint8 { Eq, Ne, Lt, Le, Gt, Ge, NoOp };
+
+    // 条件中字段的解析结果；found 为 false 时按 error 抛出（在求值到该条件时）
+    struct Column {
+        bool found = false;
+        QString name;                        // 在记录布局中查找时使用的列名
+        xhyfield::datatype type = xhyfield::VARCHAR;
+        QString error;
+    };
+    using Resolver = std::function<Column(const QString& fieldName)>;
+
+    // TableRows：单表记录；JoinedRows：JOIN 合并后的记录，缺少的列及 NULL 值与任何值比较均为假
+    enum Mode { TableRows, JoinedRows };
+
+    xhypredicate(); // 空条件，匹配所有行
+    static xhypredicate compile(const ConditionNode& condition, const QSharedDataPointer<xhyrecordlayout>& layout,
+                                const Resolver& resolve, Mode mode = TableRows);
+
+    bool isEmpty() const { return m_nodes.size() == 1 && m_nodes.first().kind == True; }
+    bool matches(const xhyrecord& record) const { return evaluate(record, 0); }
+
+    // 把条件按顶层 AND 拆成子句（空条件没有子句），以及反过来用 AND 连接；用于 JOIN 的 WHERE 下推
+    static QList<ConditionNode> conjuncts(const ConditionNode& condition);
+    static ConditionNode conjunction(const QList<ConditionNode>& conditions);
+    static QStringList referencedFields(const ConditionNode& condition); // 条件中出现的字段名（原样）
+
+    static Op opFromString(const QString& op);
+    // 与 compareQVariants 相同的比较规则（整数精确、数值 1e-6 容差、其余按区分大小写的字符串）
+    static bool compareVariants(const QVariant& left, const QVariant& right, Op op);
+
+private:
+    enum Kind : quint8 { True, False, Fail, And, Or, Not, IsNull, IsNotNull, Compare, Between, In, Like };
+
+    // 行值或常量的预分类表示；Variant 为少见类型（DATETIME 等），走通用比较
+    struct Value {
+        enum Type : quint8 { Null, Int, Double, Bool, Date, Text, Variant };
+        Type type = Null;
+        qint64 i = 0;         // Int / Bool / Date(儒略日)
+        double d = 0;         // Double；Text 可转为数值时为解析结果
+        qint8 numeric = -1;   // Text：能否转为 double，-1 表示尚未解析（行值只在需要时解析）
+        QString s;
+        QVariant v;
+    };
+
+    struct Node {
+        Kind kind = True;
+        bool negated = false;         // NOT IN / NOT BETWEEN / NOT LIKE
+        QVector<int> children;        // And / Or / Not
+        QString error;                // Fail；Like 的模式错误
+        int ordinal = -1;             // 在编译时布局中的序号
+        bool nativeType = false;      // 编译时布局中该列按 type 的原生类型存放
+        QString name;
+        xhyfield::datatype type = xhyfield::VARCHAR;
+        xhyrecordlayout::StorageType storage = xhyrecordlayout::TextColumn;
+        Op op = NoOp;
+        Value value, value2;          // Compare / Between
+        QVector<Value> list;          // In
+        bool intsHashed = false;      // In：列表全部为整数，整数行值直接查 intSet
+        bool textsHashed = false;     // In：列表全部为非数值文本，文本行值直接查 textSet
+        QSet<qint64> intSet;
+        QSet<QString> textSet;
+        QRegularExpression pattern;   // Like
+    };
+
+    int add(const ConditionNode& condition, const Resolver& resolve);
+    bool evaluate(const xhyrecord& record, int index) const;
+    bool evaluateLeaf(const xhyrecord& record, const Node& node) const;
+    Value rowValue(const xhyrecord& record, const Node& node, bool* present) const;
+
+    static Value fromText(const QString& text, xhyfield::datatype type);
+    static Value fromVariant(const QVariant& value);
+    static QVariant toVariant(const Value& value);
+    static QString toString(const Value& value);
+    static bool toNumber(const Value& value, double* out);
+    static bool compare(const Value& left, const Value& right, Op op);
+
+    QVector<Node> m_nodes;
+    QSharedDataPointer<xhyrecordlayout> m_layout;
+    Mode m_mode = TableRows;
+};
+
+#endif // XHYPREDICATE_H
@@ -0,0 +1,28 @@
+#include "xhyprotocol.h"
+#include <QtEndian>
+
+QByteArray xhyprotocol::frame(FrameType type, const QByteArray& payload) {
+    QByteArray result(kHeaderSize, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(payload.size()), result.data());
+    result[4] = char(type);
+    result += payload;
+    return result;
+}
+
+xhyprotocol::Status xhyprotocol::takeFrame(QByteArray& buffer, FrameType* type, QByteArray* payload) {
+    if (buffer.size() < kHeaderSize) return Incomplete;
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData());
+    const quint8 code = quint8(buffer.at(4));
+    if (length > kMaxPayload) return Malformed;
+    switch (code) {
+    case Login: case Query: case Ready: case Rows: case Done: case Busy: case Error:
+        break;
+    default:
+        return Malformed;
+    }
+    if (buffer.size() - kHeaderSize < qint64(length)) return Incomplete;
+    *type = FrameType(code);
+    *payload = buffer.mid(kHeaderSize, int(length));
+    buffer.remove(0, kHeaderSize + int(length));
+    return Complete;
+}
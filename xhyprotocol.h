@@ -0,0 +1,49 @@
+#ifndef XHYPROTOCOL_H
+#define XHYPROTOCOL_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QIODevice>
+
+// 本地服务器（dbms-server）的帧格式：quint32 负载长度（大端）+ quint8 帧类型 + 负载
+// 负载用 QDataStream（kStreamVersion）按各帧类型注释中的顺序序列化
+// 一次 Query 中的每条语句依次得到零个或多个 Rows 帧和一个 Done 帧；Busy/Error 帧表示整个请求没有执行
+class xhyprotocol {
+public:
+    enum FrameType : quint8 {
+        Login = 0x01, // 客户端：QString 用户名, QString 密码；连接后必须先登录
+        Query = 0x02, // 客户端：QString SQL，可含多条以分号结尾的语句
+
+        Ready = 0x81, // 服务器：登录成功，QString 用户名
+        Rows  = 0x82, // 服务器：QStringList 列名, QList<QVariantList> 结果行（列值同 xhyexecutor::RowSink）；
+                      //         查询结果按 kRowsPerFrame 行一帧，执行期间每满一帧即发送
+        Done  = 0x83, // 服务器：一条语句结束，QString 语句, qint64 执行耗时（微秒）, bool 本会话的事务仍在进行,
+                      //         QStringList 其余输出行（消息、行数、非查询语句的结果）
+        Busy  = 0x84, // 服务器：准入控制拒绝，QString 原因；请求中的语句都未执行，可稍后重试
+        Error = 0x85, // 服务器：QString 错误信息（登录失败、未登录、帧格式错误等）
+    };
+
+    enum Status { Incomplete, Complete, Malformed };
+
+    static constexpr int kHeaderSize = 5;
+    static constexpr quint32 kMaxPayload = 64 * 1024 * 1024;
+    static constexpr int kRowsPerFrame = 256; // 每个 Rows 帧的结果行数
+    static constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_5_15;
+
+    static QByteArray frame(FrameType type, const QByteArray& payload);
+
+    // 按参数顺序序列化负载并组帧
+    template <typename... Args>
+    static QByteArray message(FrameType type, const Args&... args) {
+        QByteArray payload;
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(kStreamVersion);
+        (stream << ... << args);
+        return frame(type, payload);
+    }
+
+    // 从缓冲区头部取出一帧；数据不足时返回 Incomplete 且不修改缓冲区，长度超限或类型未知时返回 Malformed
+    static Status takeFrame(QByteArray& buffer, FrameType* type, QByteArray* payload);
+};
+
+#endif // XHYPROTOCOL_H
@@ -1,19 +1,259 @@
 #include "xhyrecord.h"
+#include <QDate>
+#include <algorithm>
+#include <limits>
 
-xhyrecord::xhyrecord() {}
+namespace {
+// 未绑定表布局的记录共用的空布局；第一次 insert 时才复制
+const QSharedDataPointer<xhyrecordlayout>& emptyLayout() {
+    static const QSharedDataPointer<xhyrecordlayout> layout(new xhyrecordlayout);
+    return layout;
+}
+}
+
+int xhyrecordlayout::append(const QString& name, StorageType type) {
+    m_index.insert(name, m_names.size());
+    m_names.append(name);
+    m_types.append(type);
+    return m_names.size() - 1;
+}
+
+xhyrecord::xhyrecord() : m_layout(emptyLayout()) {}
+
+xhyrecord::xhyrecord(const QSharedDataPointer<xhyrecordlayout>& layout)
+    : m_layout(layout.constData() ? layout : emptyLayout()) {
+    m_cells.resize(m_layout.constData()->size());
+}
 
 QString xhyrecord::value(const QString& field) const {
-    return m_data.value(field);
+    const int ordinal = m_layout.constData()->indexOf(field);
+    return ordinal < 0 ? QString() : valueAt(ordinal);
 }
 
 void xhyrecord::insert(const QString& field, const QString& value) {
-    m_data.insert(field, value);
+    int ordinal = m_layout.constData()->indexOf(field);
+    if (ordinal < 0) ordinal = m_layout->append(field, xhyrecordlayout::TextColumn); // 布局被共享时先复制
+    setValueAt(ordinal, value);
 }
 
 QMap<QString, QString> xhyrecord::allValues() const { // 新增实现
-    return m_data;
+    QMap<QString, QString> values;
+    for (int i = 0; i < m_cells.size(); ++i) {
+        if (m_cells.at(i).kind != Absent) values.insert(m_layout.constData()->name(i), valueAt(i));
+    }
+    return values;
 }
 
 void xhyrecord::clear() { // 新增实现
-    m_data.clear();
+    m_cells.clear();
+    m_text.clear();
+}
+
+bool xhyrecord::contains(const QString& field) const {
+    return containsAt(m_layout.constData()->indexOf(field));
+}
+
+QStringList xhyrecord::fieldNames() const {
+    QStringList names;
+    for (int i = 0; i < m_cells.size(); ++i) {
+        if (m_cells.at(i).kind != Absent) names.append(m_layout.constData()->name(i));
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+QString xhyrecord::valueAt(int ordinal) const {
+    if (ordinal < 0 || ordinal >= m_cells.size()) return QString();
+    const Cell& cell = m_cells.at(ordinal);
+    switch (cell.kind) {
+    case Int: return QString::number(cell.i);
+    case Double: return QString::number(cell.d);
+    case Date: return QDate::fromJulianDay(cell.i).toString(Qt::ISODate);
+    case Bool: return cell.i ? QStringLiteral("1") : QStringLiteral("0");
+    case Text: return m_text.at(cell.i);
+    default: return QString(); // Absent / Null
+    }
+}
+
+bool xhyrecord::isNullAt(int ordinal) const {
+    if (ordinal < 0 || ordinal >= m_cells.size()) return true;
+    return m_cells.at(ordinal).kind == Absent || m_cells.at(ordinal).kind == Null;
+}
+
+bool xhyrecord::containsAt(int ordinal) const {
+    return ordinal >= 0 && ordinal < m_cells.size() && m_cells.at(ordinal).kind != Absent;
+}
+
+bool xhyrecord::nativeValueAt(int ordinal, QVariant* out) const {
+    if (ordinal < 0 || ordinal >= m_cells.size()) {
+        *out = QVariant();
+        return true;
+    }
+    const Cell& cell = m_cells.at(ordinal);
+    switch (cell.kind) {
+    case Absent:
+    case Null:
+        *out = QVariant();
+        return true;
+    case Int:
+        // 与 convertToTypedValue 一致：能放进 int 时返回 int
+        if (cell.i >= std::numeric_limits<int>::min() && cell.i <= std::numeric_limits<int>::max()) {
+            *out = QVariant(static_cast<int>(cell.i));
+        } else {
+            *out = QVariant(static_cast<qlonglong>(cell.i));
+        }
+        return true;
+    case Double:
+        *out = QVariant(cell.d);
+        return true;
+    case Date:
+        *out = QVariant(QDate::fromJulianDay(cell.i));
+        return true;
+    case Bool:
+        *out = QVariant(cell.i != 0);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool xhyrecord::intAt(int ordinal, qint64* out) const {
+    if (ordinal < 0 || ordinal >= m_cells.size() || m_cells.at(ordinal).kind != Int) return false;
+    *out = m_cells.at(ordinal).i;
+    return true;
+}
+
+bool xhyrecord::doubleAt(int ordinal, double* out) const {
+    if (ordinal < 0 || ordinal >= m_cells.size() || m_cells.at(ordinal).kind != Double) return false;
+    *out = m_cells.at(ordinal).d;
+    return true;
+}
+
+void xhyrecord::setNullAt(int ordinal) {
+    cellFor(ordinal).kind = Null;
+}
+
+void xhyrecord::setIntAt(int ordinal, qint64 value) {
+    Cell& cell = cellFor(ordinal);
+    cell.kind = Int;
+    cell.i = value;
+}
+
+void xhyrecord::setDoubleAt(int ordinal, double value) {
+    // 文本表示只保留 QString::number 的默认精度，原生值也按它规整，保证与 value() 一致
+    Cell& cell = cellFor(ordinal);
+    cell.kind = Double;
+    cell.d = QString::number(value).toDouble();
+}
+
+void xhyrecord::setDateAt(int ordinal, qint64 julianDay) {
+    const QDate date = QDate::fromJulianDay(julianDay);
+    if (!date.isValid()) {
+        setNullAt(ordinal);
+    } else if (date.year() < 1 || date.year() > 9999) {
+        storeText(cellFor(ordinal), date.toString(Qt::ISODate));
+    } else {
+        Cell& cell = cellFor(ordinal);
+        cell.kind = Date;
+        cell.i = julianDay;
+    }
+}
+
+void xhyrecord::setBoolAt(int ordinal, bool value) {
+    Cell& cell = cellFor(ordinal);
+    cell.kind = Bool;
+    cell.i = value ? 1 : 0;
+}
+
+void xhyrecord::setValueAt(int ordinal, const QString& value) {
+    Cell& cell = cellFor(ordinal);
+    if (value.isNull()) {
+        cell.kind = Null;
+        return;
+    }
+    // 只有能从原生值原样还原出文本时才按原生类型存放，否则 value() 会与写入的文本不同
+    bool ok = false;
+    switch (m_layout.constData()->type(ordinal)) {
+    case xhyrecordlayout::IntColumn: {
+        const qint64 v = value.toLongLong(&ok);
+        if (ok && QString::number(v) == value) {
+            cell.kind = Int;
+            cell.i = v;
+            return;
+        }
+        break;
+    }
+    case xhyrecordlayout::DoubleColumn: {
+        const double v = value.toDouble(&ok);
+        if (ok && QString::number(v) == value) {
+            cell.kind = Double;
+            cell.d = v;
+            return;
+        }
+        break;
+    }
+    case xhyrecordlayout::DateColumn:
+        if (value.size() == 10) {
+            const QDate date = QDate::fromString(value, Qt::ISODate);
+            if (date.isValid() && date.toString(Qt::ISODate) == value) {
+                cell.kind = Date;
+                cell.i = date.toJulianDay();
+                return;
+            }
+        }
+        break;
+    case xhyrecordlayout::BoolColumn:
+        if (value == QLatin1String("1") || value == QLatin1String("0")) {
+            cell.kind = Bool;
+            cell.i = value == QLatin1String("1") ? 1 : 0;
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+    storeText(cell, value);
+}
+
+xhyrecord xhyrecord::rebound(const QSharedDataPointer<xhyrecordlayout>& layout) const {
+    if (sharesLayout(layout)) return *this;
+    xhyrecord record(layout);
+    record.m_rowId = m_rowId;
+    record.m_beginTs = m_beginTs;
+    for (int i = 0; i < m_cells.size(); ++i) {
+        if (m_cells.at(i).kind != Absent) record.insert(m_layout.constData()->name(i), valueAt(i));
+    }
+    return record;
+}
+
+bool xhyrecord::operator!=(const xhyrecord& other) const {
+    if (!sharesLayout(other)) return allValues() != other.allValues();
+    // 同一布局下相同文本总是得到相同的单元，逐个比较即可
+    const int count = qMax(m_cells.size(), other.m_cells.size());
+    for (int i = 0; i < count; ++i) {
+        const Cell a = i < m_cells.size() ? m_cells.at(i) : Cell();
+        const Cell b = i < other.m_cells.size() ? other.m_cells.at(i) : Cell();
+        if (a.kind != b.kind) return true;
+        if (a.kind == Text) {
+            if (m_text.at(a.i) != other.m_text.at(b.i)) return true;
+        } else if (a.kind != Absent && a.kind != Null && a.i != b.i) {
+            return true;
+        }
+    }
+    return false;
+}
+
+xhyrecord::Cell& xhyrecord::cellFor(int ordinal) {
+    if (ordinal >= m_cells.size()) m_cells.resize(qMax(ordinal + 1, m_layout.constData()->size()));
+    return m_cells[ordinal];
+}
+
+void xhyrecord::storeText(Cell& cell, const QString& value) {
+    if (cell.kind == Text) {
+        m_text[cell.i] = value;
+        return;
+    }
+    cell.kind = Text;
+    cell.i = m_text.size();
+    m_text.append(value);
 }
@@ -2,21 +2,99 @@
 #define XHYRECORD_H
 
 #include <QString>
+#include <QStringList>
 #include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QVariant>
+#include <QSharedData>
+#include <QSharedDataPointer>
 
+// 行布局：列名 -> 序号，以及每列的存储类型；同一张表的所有行共享一份
+class xhyrecordlayout : public QSharedData {
+public:
+    enum StorageType : quint8 { TextColumn, IntColumn, DoubleColumn, DateColumn, BoolColumn };
+
+    int size() const { return m_names.size(); }
+    int indexOf(const QString& name) const { return m_index.value(name, -1); }
+    const QString& name(int ordinal) const { return m_names.at(ordinal); }
+    StorageType type(int ordinal) const { return m_types.at(ordinal); }
+    const QStringList& names() const { return m_names; }
+    int append(const QString& name, StorageType type);
+
+private:
+    QStringList m_names;
+    QVector<StorageType> m_types;
+    QHash<QString, int> m_index;
+};
+
+// 一行记录：按布局序号存放的定长单元 + 文本池
+// 整数/浮点/日期(儒略日)/布尔按原生类型存放，其余值以及无法无损还原的文本存入文本池
+// value()/insert() 按列名访问，保持与旧的 QMap<QString,QString> 表示一致的语义
 class xhyrecord {
 public:
     xhyrecord();
+    explicit xhyrecord(const QSharedDataPointer<xhyrecordlayout>& layout);
+
     QString value(const QString& field) const;
     void insert(const QString& field, const QString& value);
     QMap<QString, QString> allValues() const; // 新增
     void clear();                             // 新增
+    quint64 rowId() const { return m_rowId; } // 记录文件中的行号，0 表示尚未分配
+    void setRowId(quint64 rowId) { m_rowId = rowId; }
+    // 多版本：创建本版本的事务的提交时间戳（xhymvcc）；全 1 为尚未提交，0 为本次启动前已存在。不写入数据文件
+    quint64 beginTs() const { return m_beginTs; }
+    void setBeginTs(quint64 timestamp) { m_beginTs = timestamp; }
+
+    bool contains(const QString& field) const;
+    QStringList fieldNames() const; // 已赋值的列名（按列名排序，与 allValues().keys() 相同）
+
+    // 按序号访问；序号来自 layout()
+    const xhyrecordlayout& layout() const { return *m_layout; }
+    bool sharesLayout(const xhyrecord& other) const { return m_layout.constData() == other.m_layout.constData(); }
+    bool sharesLayout(const QSharedDataPointer<xhyrecordlayout>& layout) const { return m_layout.constData() == layout.constData(); }
+    QString valueAt(int ordinal) const;
+    bool isNullAt(int ordinal) const; // 未赋值也视为 NULL
+    bool containsAt(int ordinal) const; // 已赋值（含 NULL），与 contains() 相同
+    // 原生类型单元直接转换为 QVariant（与 xhytable::convertToTypedValue 的结果一致）；文本单元返回 false
+    bool nativeValueAt(int ordinal, QVariant* out) const;
+    bool intAt(int ordinal, qint64* out) const;     // 仅整数单元
+    bool doubleAt(int ordinal, double* out) const;  // 仅浮点单元
+
+    // 解码时直接写入原生值，省去先格式化再解析
+    void setNullAt(int ordinal);
+    void setIntAt(int ordinal, qint64 value);
+    void setDoubleAt(int ordinal, double value); // 按 QString::number 的精度规整
+    void setDateAt(int ordinal, qint64 julianDay);
+    void setBoolAt(int ordinal, bool value);
+    void setValueAt(int ordinal, const QString& value); // 与 insert 相同的按列类型解析
+
+    // 按列名把本行转换到另一布局（同一布局时直接返回副本）
+    xhyrecord rebound(const QSharedDataPointer<xhyrecordlayout>& layout) const;
+
     //重载比较函数
-    bool operator!=(const xhyrecord& other) const {
-        return this->m_data != other.m_data;
-    }
+    bool operator!=(const xhyrecord& other) const;
+    bool operator==(const xhyrecord& other) const { return !(*this != other); }
+
 private:
-    QMap<QString, QString> m_data;
+    enum CellKind : quint8 { Absent = 0, Null, Int, Double, Date, Bool, Text };
+    struct Cell {
+        union {
+            qint64 i;
+            double d;
+        };
+        CellKind kind;
+        Cell() : i(0), kind(Absent) {}
+    };
+
+    Cell& cellFor(int ordinal);
+    void storeText(Cell& cell, const QString& value);
+
+    QSharedDataPointer<xhyrecordlayout> m_layout;
+    QVector<Cell> m_cells;
+    QStringList m_text; // 文本池，Text 单元的 i 为下标
+    quint64 m_rowId = 0;
+    quint64 m_beginTs = 0;
 };
 
 #endif // XHYRECORD_H
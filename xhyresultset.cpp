@@ -0,0 +1,31 @@
+#include "xhyresultset.h"
+#include <numeric>
+
+xhyresultset::xhyresultset(const QList<xhyrecord>& rows)
+    : m_snapshot(rows), m_rows(rows.size()) {
+    std::iota(m_rows.begin(), m_rows.end(), 0);
+}
+
+xhyresultset::xhyresultset(const QList<xhyrecord>& snapshot, const QVector<int>& rows)
+    : m_snapshot(snapshot), m_rows(rows) {}
+
+xhyresultset::xhyresultset(const QList<xhyrecord>& snapshot, const QList<xhyrecord>& versions, const QVector<int>& rows)
+    : m_snapshot(snapshot), m_versions(versions), m_rows(rows) {}
+
+void xhyresultset::truncate(int count) {
+    if (count >= 0 && count < m_rows.size()) m_rows.resize(count);
+}
+
+xhyresultset xhyresultset::reordered(const QVector<int>& positions) const {
+    QVector<int> rows;
+    rows.reserve(positions.size());
+    for (int position : positions) rows.append(m_rows.at(position));
+    return xhyresultset(m_snapshot, m_versions, rows);
+}
+
+QVector<xhyrecord> xhyresultset::materialize() const {
+    QVector<xhyrecord> records;
+    records.reserve(m_rows.size());
+    for (int i = 0; i < m_rows.size(); ++i) records.append(at(i));
+    return records;
+}
@@ -0,0 +1,41 @@
+#ifndef XHYRESULTSET_H
+#define XHYRESULTSET_H
+
+#include "xhyrecord.h"
+#include <QList>
+#include <QVector>
+
+// 查询结果集：读快照 + 行下标，不复制记录
+// 快照是表记录列表的隐式共享副本：之后表被修改时表一侧分离，结果集看到的仍是读取时的行，生命周期与结果集相同
+// 取值只在输出时进行（at(i).value(...)），排序、截取 LIMIT 只调整下标
+// 按读快照查询时，当前记录对快照不可见的行改用版本链中的旧版本：它们放在 versions 中，下标接在快照之后
+class xhyresultset {
+public:
+    xhyresultset() = default;
+    explicit xhyresultset(const QList<xhyrecord>& rows); // 全部行
+    xhyresultset(const QList<xhyrecord>& snapshot, const QVector<int>& rows);
+    // rows 中不小于 snapshot.size() 的下标指向 versions[row - snapshot.size()]
+    xhyresultset(const QList<xhyrecord>& snapshot, const QList<xhyrecord>& versions, const QVector<int>& rows);
+
+    int size() const { return m_rows.size(); }
+    bool isEmpty() const { return m_rows.isEmpty(); }
+    const xhyrecord& at(int i) const {
+        const int row = m_rows.at(i);
+        return row < m_snapshot.size() ? m_snapshot.at(row) : m_versions.at(row - m_snapshot.size());
+    }
+    int rowAt(int i) const { return m_rows.at(i); } // 在快照中的下标（旧版本接在快照之后）
+    const QVector<int>& rows() const { return m_rows; }
+    const QList<xhyrecord>& snapshot() const { return m_snapshot; }
+
+    void truncate(int count);
+    // 按 positions（本结果集中的位置）重新排列/筛选，例如排序的输出
+    xhyresultset reordered(const QVector<int>& positions) const;
+    QVector<xhyrecord> materialize() const; // 复制出记录，供仍按值使用记录的调用者
+
+private:
+    QList<xhyrecord> m_snapshot;
+    QList<xhyrecord> m_versions;
+    QVector<int> m_rows;
+};
+
+#endif // XHYRESULTSET_H
@@ -0,0 +1,337 @@
+#include "xhyserver.h"
+#include "sqlparser.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+xhyserver::xhyserver(xhydbmanager& dbManager, UserFileManager& account, const Options& options, QObject* parent)
+    : QObject(parent)
+    , m_dbManager(dbManager)
+    , m_account(account)
+    , m_options(options)
+{
+    m_pool.setMaxThreadCount(qMax(1, m_options.workers));
+    m_server.setMaxPendingConnections(m_options.maxSessions);
+    connect(&m_server, &QLocalServer::newConnection, this, &xhyserver::acceptConnections);
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(m_options.idleTransactionTimeout * 1000);
+    connect(&m_idleTimer, &QTimer::timeout, this, &xhyserver::expireIdleTransaction);
+}
+
+xhyserver::~xhyserver() {
+    m_server.close();
+    m_pool.waitForDone(); // 工作线程中的任务引用会话的执行器
+    for (Session* session : std::as_const(m_sessions)) {
+        session->socket->disconnect(this);
+        session->socket->abort();
+        delete session;
+    }
+    QWriteLocker locker(&m_engineLock);
+    if (m_transactionOwner.load() != 0 && m_dbManager.isInTransaction()) m_dbManager.rollbackTransaction();
+}
+
+bool xhyserver::listen(QString* error) {
+    QLocalServer::removeServer(m_options.name); // 上次异常退出留下的套接字文件
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server.listen(m_options.name)) {
+        if (error) *error = m_server.errorString();
+        return false;
+    }
+    qInfo() << "[SERVER] 监听" << m_server.fullServerName() << "，工作线程" << m_pool.maxThreadCount()
+            << "，会话上限" << m_options.maxSessions << "，排队上限" << m_options.maxQueued
+            << "，事务空闲超时" << m_options.idleTransactionTimeout << "秒";
+    return true;
+}
+
+void xhyserver::acceptConnections() {
+    while (QLocalSocket* socket = m_server.nextPendingConnection()) {
+        if (m_sessions.size() >= m_options.maxSessions) {
+            connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            socket->write(xhyprotocol::message(xhyprotocol::Error, QString("连接数已达上限 (%1)。").arg(m_options.maxSessions)));
+            socket->disconnectFromServer();
+            continue;
+        }
+        Session* session = new Session;
+        session->id = m_nextSessionId++;
+        session->socket = socket;
+        m_sessions.insert(session->id, session);
+        connect(socket, &QLocalSocket::readyRead, this, [this, session] { readFrames(session); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, session] { closeSession(session); });
+        qDebug() << "[SERVER] 会话" << session->id << "已连接";
+    }
+}
+
+void xhyserver::readFrames(Session* session) {
+    if (session->closing) return;
+    session->input += session->socket->readAll();
+    xhyprotocol::FrameType type;
+    QByteArray payload;
+    for (;;) {
+        const xhyprotocol::Status status = xhyprotocol::takeFrame(session->input, &type, &payload);
+        if (status == xhyprotocol::Incomplete) return;
+        if (status == xhyprotocol::Malformed) {
+            send(session, xhyprotocol::message(xhyprotocol::Error, QString("帧格式错误，连接关闭。")));
+            session->socket->disconnectFromServer();
+            return;
+        }
+        handleFrame(session, type, payload);
+        if (session->closing) return;
+    }
+}
+
+void xhyserver::handleFrame(Session* session, xhyprotocol::FrameType type, const QByteArray& payload) {
+    QDataStream stream(payload);
+    stream.setVersion(xhyprotocol::kStreamVersion);
+    if (type == xhyprotocol::Login) {
+        Job job;
+        job.kind = Job::Login;
+        stream >> job.text >> job.password;
+        if (session->executor) {
+            send(session, xhyprotocol::message(xhyprotocol::Error, QString("会话已登录为 '%1'。").arg(session->user)));
+        } else if (stream.status() != QDataStream::Ok) {
+            send(session, xhyprotocol::message(xhyprotocol::Error, QString("登录帧格式错误。")));
+        } else {
+            enqueue(session, {job});
+        }
+        return;
+    }
+    if (type != xhyprotocol::Query) {
+        send(session, xhyprotocol::message(xhyprotocol::Error, QString("客户端不能发送该类型的帧 (0x%1)。").arg(int(type), 2, 16, QChar('0'))));
+        return;
+    }
+
+    QString sql;
+    stream >> sql;
+    if (stream.status() != QDataStream::Ok) {
+        send(session, xhyprotocol::message(xhyprotocol::Error, QString("查询帧格式错误。")));
+        return;
+    }
+    if (!session->executor) { // 收到 Ready 之后才能发送查询
+        send(session, xhyprotocol::message(xhyprotocol::Error, QString("未登录。")));
+        return;
+    }
+    QList<Job> jobs;
+    for (const QString& command : SQLParser::parseMultiLineSQL(sql)) {
+        Job job;
+        job.text = command.trimmed();
+        job.sharedRead = xhyexecutor::isSharedRead(job.text);
+        jobs.append(job);
+    }
+    if (jobs.isEmpty()) {
+        send(session, xhyprotocol::message(xhyprotocol::Error, QString("请求中没有以分号结尾的完整语句。")));
+        return;
+    }
+    if (m_queued + jobs.size() > m_options.maxQueued) {
+        send(session, xhyprotocol::message(xhyprotocol::Busy,
+            QString("服务器繁忙：已有 %1 条语句排队（上限 %2）。").arg(m_queued).arg(m_options.maxQueued)));
+        return;
+    }
+    enqueue(session, jobs);
+}
+
+void xhyserver::closeSession(Session* session) {
+    if (session->closing) return;
+    session->closing = true;
+    m_queued -= session->pending.size();
+    session->pending.clear();
+    qDebug() << "[SERVER] 会话" << session->id << "已断开";
+    if (session->executor) {
+        Job abort;
+        abort.kind = Job::Abort;
+        session->pending.enqueue(abort);
+        ++m_queued;
+        if (!session->running) m_ready.append(session->id);
+        dispatch();
+    } else if (!session->running) {
+        destroySession(session);
+    }
+}
+
+void xhyserver::destroySession(Session* session) {
+    m_sessions.remove(session->id);
+    session->socket->disconnect(this); // 删除套接字之前不再回调到已删除的会话
+    session->socket->deleteLater();
+    delete session;
+}
+
+void xhyserver::enqueue(Session* session, const QList<Job>& jobs) {
+    const bool wasIdle = session->pending.isEmpty() && !session->running;
+    for (const Job& job : jobs) session->pending.enqueue(job);
+    m_queued += jobs.size();
+    if (wasIdle) m_ready.append(session->id);
+    dispatch();
+}
+
+void xhyserver::dispatch() {
+    const quint64 owner = m_transactionOwner.load();
+    for (int i = 0; i < m_ready.size() && m_inFlight < m_pool.maxThreadCount();) {
+        Session* session = m_sessions.value(m_ready.at(i));
+        if (!session || session->running || session->pending.isEmpty()) {
+            m_ready.removeAt(i);
+            continue;
+        }
+        // 事务被另一个会话持有时，写语句等到它结束；只读语句、登录与断开回滚不受影响
+        const Job& head = session->pending.head();
+        if (owner != 0 && owner != session->id && head.kind == Job::Statement && !head.sharedRead) {
+            ++i;
+            continue;
+        }
+        m_ready.removeAt(i);
+        const Job job = session->pending.dequeue();
+        --m_queued;
+        session->running = true;
+        ++m_inFlight;
+        const quint64 id = session->id;
+        xhyexecutor* executor = session->executor.get();
+        m_pool.start([this, id, executor, job] {
+            const Result result = run(id, executor, job);
+            QMetaObject::invokeMethod(this, [this, id, job, result] { finish(id, job, result); }, Qt::QueuedConnection);
+        });
+    }
+}
+
+xhyserver::Result xhyserver::run(quint64 sessionId, xhyexecutor* executor, const Job& job) {
+    Result result;
+    QStringList output;
+    qint64 micros = 0;
+    bool inTransaction = false;
+    QElapsedTimer timer;
+    switch (job.kind) {
+    case Job::Login: // UserFileManager 自带锁，登录不等待引擎上正在执行的语句
+        result.ok = m_account.validateUser(job.text, job.password);
+        result.reply = result.ok ? xhyprotocol::message(xhyprotocol::Ready, job.text)
+                                 : xhyprotocol::message(xhyprotocol::Error, QString("用户名或密码错误。"));
+        return result;
+    case Job::Abort: {
+        QWriteLocker locker(&m_engineLock);
+        if (m_transactionOwner.load() == sessionId) {
+            if (m_dbManager.isInTransaction()) m_dbManager.rollbackTransaction();
+            m_transactionOwner.store(0);
+            qInfo() << "[SERVER] 会话" << sessionId << "断开时事务未结束，已回滚";
+        }
+        return result;
+    }
+    case Job::Statement: {
+        // 结果行在执行期间按 kRowsPerFrame 一批组帧，每满一批就交给主线程发送，不在内存中攒到语句结束
+        QStringList columns;
+        QList<QVariantList> batch;
+        auto flushRows = [&] {
+            if (batch.isEmpty()) return;
+            const QByteArray frame = xhyprotocol::message(xhyprotocol::Rows, columns, batch);
+            batch.clear();
+            QMetaObject::invokeMethod(this, [this, sessionId, frame] { sendTo(sessionId, frame); }, Qt::QueuedConnection);
+        };
+        executor->setRowSink([&](const QStringList& names, const QVariantList& values) {
+            if (batch.isEmpty()) columns = names;
+            batch.append(values);
+            if (batch.size() >= xhyprotocol::kRowsPerFrame) flushRows();
+        });
+        if (job.sharedRead && m_transactionOwner.load() != sessionId) {
+            // 只读语句读已提交数据的快照，通常在读锁下与其它只读语句并发；库还没有准备好时在写锁下执行，
+            // 由执行器按需加载并报告错误。本会话持有事务时改走下面的写路径，读本事务的修改
+            if (!lockForSharedRead(executor->currentDatabase())) m_engineLock.lockForWrite();
+            timer.start();
+            executor->executeSharedRead(job.text); // 不抛出异常
+            micros = timer.nsecsElapsed() / 1000;
+            m_engineLock.unlock();
+        } else {
+            QWriteLocker locker(&m_engineLock);
+            const quint64 owner = m_transactionOwner.load();
+            if (owner != 0 && owner != sessionId) { // 分派后另一个会话先打开了事务
+                executor->setRowSink(nullptr);
+                result.deferred = true;
+                return result;
+            }
+            executor->restoreCurrentDatabase();
+            timer.start();
+            executor->execute_command(job.text);
+            micros = timer.nsecsElapsed() / 1000;
+            inTransaction = m_dbManager.isInTransaction();
+            m_transactionOwner.store(inTransaction ? sessionId : 0);
+        }
+        executor->setRowSink(nullptr);
+        flushRows(); // 在 Done 之前入队，同一线程投递的调用按顺序执行
+        output = executor->takeOutput(); // 输出缓冲属于本会话的执行器
+        break;
+    }
+    }
+    result.reply = xhyprotocol::message(xhyprotocol::Done, job.text, micros, inTransaction, output);
+    return result;
+}
+
+// 取得引擎读锁并确认当前库的表可以并发读（记录已加载、索引已建立），否则先在写锁下准备。
+// 准备失败或期间的写语句又使其失效时返回 false 且不持有锁
+bool xhyserver::lockForSharedRead(const QString& dbname) {
+    m_engineLock.lockForRead();
+    if (m_dbManager.readsPrepared(dbname)) return true;
+    m_engineLock.unlock();
+    {
+        QWriteLocker locker(&m_engineLock);
+        try {
+            m_dbManager.prepareReads(dbname);
+        } catch (const std::exception& e) {
+            qWarning() << "[SERVER] 准备数据库" << dbname << "的并发读失败:" << e.what();
+            return false;
+        }
+    }
+    m_engineLock.lockForRead();
+    if (m_dbManager.readsPrepared(dbname)) return true;
+    m_engineLock.unlock();
+    return false;
+}
+
+void xhyserver::finish(quint64 sessionId, const Job& job, const Result& result) {
+    --m_inFlight;
+    const quint64 owner = m_transactionOwner.load();
+    if (owner == 0) m_idleTimer.stop();
+    Session* session = m_sessions.value(sessionId);
+    if (!session) {
+        dispatch();
+        return;
+    }
+    session->running = false;
+    if (result.deferred) {
+        if (!session->closing) {
+            session->pending.prepend(job);
+            ++m_queued;
+        }
+    } else if (!session->closing) {
+        if (job.kind == Job::Login && result.ok) {
+            session->user = job.text;
+            session->executor.reset(new xhyexecutor(m_dbManager, &m_account, job.text));
+        }
+        send(session, result.reply);
+    }
+    // 持有者的语句都执行完后重新开始计时；其它会话的语句不影响持有者的空闲时间
+    if (owner == sessionId && !session->closing && session->pending.isEmpty() && m_options.idleTransactionTimeout > 0)
+        m_idleTimer.start();
+
+    if (session->closing && session->pending.isEmpty()) {
+        destroySession(session);
+    } else if (!session->pending.isEmpty()) {
+        m_ready.append(sessionId);
+    }
+    dispatch();
+}
+
+// 持有事务的会话空闲超时：与帧格式错误一样断开连接，断开时的 Abort 回滚事务并释放 m_transactionOwner
+void xhyserver::expireIdleTransaction() {
+    Session* session = m_sessions.value(m_transactionOwner.load());
+    if (!session || session->closing) return;
+    if (session->running || !session->pending.isEmpty()) return; // 计时后又收到语句，执行完时重新计时
+    qInfo() << "[SERVER] 会话" << session->id << "的事务空闲超过" << m_options.idleTransactionTimeout << "秒，断开并回滚";
+    send(session, xhyprotocol::message(xhyprotocol::Error,
+        QString("事务空闲超过 %1 秒未结束，已回滚，连接关闭。").arg(m_options.idleTransactionTimeout)));
+    session->socket->disconnectFromServer();
+}
+
+void xhyserver::sendTo(quint64 sessionId, const QByteArray& data) {
+    if (Session* session = m_sessions.value(sessionId)) send(session, data);
+}
+
+void xhyserver::send(Session* session, const QByteArray& data) {
+    if (session->closing || data.isEmpty()) return;
+    session->socket->write(data);
+}
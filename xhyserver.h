@@ -0,0 +1,104 @@
+#ifndef XHYSERVER_H
+#define XHYSERVER_H
+
+#include "xhydbmanager.h"
+#include "xhyexecutor.h"
+#include "xhyprotocol.h"
+#include "userfilemanager.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QQueue>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+
+// 本地多客户端服务器：在本地套接字（Linux 上为 Unix 套接字，Windows 上为命名管道）上接受连接，帧格式见 xhyprotocol
+// 每个连接是一个会话，有自己的执行器（当前数据库、登录用户）；语句在工作线程池上执行
+// 引擎（xhydbmanager）只有一个当前事务，写语句在引擎写锁下逐条执行；会话以 BEGIN 打开事务后独占写，
+// 其它会话的写语句留在队列中，直到该会话提交、回滚或断开（断开时回滚）；事务空闲超时的会话被断开
+// 只读语句（见 xhyexecutor::isSharedRead）在引擎读锁下彼此并发，读已提交数据的快照，不等待别的会话的事务
+// 准入控制：会话数与排队语句数有上限，超出时分别以 Error / Busy 帧拒绝
+class xhyserver : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString name = "dbms"; // 本地套接字名
+        int workers = 4;       // 工作线程数
+        int maxSessions = 64;
+        int maxQueued = 256;   // 所有会话排队中（未开始执行）的语句总数上限，超出的请求整体以 Busy 拒绝
+        int idleTransactionTimeout = 60; // 秒：持有事务的会话没有语句执行或排队超过该时间时断开并回滚，0 为不限
+    };
+
+    xhyserver(xhydbmanager& dbManager, UserFileManager& account, const Options& options, QObject* parent = nullptr);
+    ~xhyserver() override;
+
+    bool listen(QString* error);
+    QString fullServerName() const { return m_server.fullServerName(); }
+
+private:
+    struct Job {
+        enum Kind { Login, Statement, Abort }; // Abort：会话断开，回滚它持有的事务
+        Kind kind = Statement;
+        QString text;     // Statement：语句；Login：用户名
+        QString password; // Login
+        bool sharedRead = false; // Statement：只读语句，可与其它只读语句并发
+    };
+
+    struct Result {
+        bool deferred = false; // 另一个会话持有事务，未执行，放回队首
+        bool ok = false;       // Login：用户名与密码正确
+        QByteArray reply;      // 已组帧的响应（结果行在执行期间已分批发送）
+    };
+
+    struct Session {
+        quint64 id = 0;
+        QLocalSocket* socket = nullptr;
+        QByteArray input;
+        std::unique_ptr<xhyexecutor> executor; // 登录后创建
+        QString user;
+        QQueue<Job> pending;
+        bool running = false;
+        bool closing = false;
+    };
+
+    void acceptConnections();
+    void readFrames(Session* session);
+    void handleFrame(Session* session, xhyprotocol::FrameType type, const QByteArray& payload);
+    void closeSession(Session* session);
+    void destroySession(Session* session);
+    void enqueue(Session* session, const QList<Job>& jobs);
+    void dispatch();
+    Result run(quint64 sessionId, xhyexecutor* executor, const Job& job); // 工作线程
+    void finish(quint64 sessionId, const Job& job, const Result& result);
+    void sendTo(quint64 sessionId, const QByteArray& data); // 会话已断开时丢弃
+    void expireIdleTransaction();
+    bool lockForSharedRead(const QString& dbname); // 工作线程
+    void send(Session* session, const QByteArray& data);
+
+    xhydbmanager& m_dbManager;
+    UserFileManager& m_account;
+    Options m_options;
+    QLocalServer m_server;
+    QThreadPool m_pool;
+
+    QReadWriteLock m_engineLock;           // 只在执行语句（和断开回滚）期间持有：写语句独占，只读语句共享
+    std::atomic<quint64> m_transactionOwner{0}; // 持有未结束事务的会话，0 表示没有；在引擎写锁下修改
+    QTimer m_idleTimer; // 事务持有者的空闲计时，持有者的语句执行完且没有排队时开始
+
+    QHash<quint64, Session*> m_sessions;
+    QList<quint64> m_ready; // 有待执行任务的会话，轮转调度
+    quint64 m_nextSessionId = 1;
+    int m_queued = 0;       // 各会话 pending 中的任务总数
+    int m_inFlight = 0;     // 已交给线程池的任务数
+};
+
+#endif // XHYSERVER_H
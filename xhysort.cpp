@@ -0,0 +1,442 @@
+#include "xhysort.h"
+#include <QDataStream>
+#include <QDate>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// 与 convertToTypedValue 转换失败后的字符串比较相同：能转为数值的文本按数值排序
+xhysorter::Key textKey(const QString& text) {
+    xhysorter::Key key;
+    bool ok = false;
+    key.d = text.toDouble(&ok);
+    if (ok) {
+        key.kind = xhysorter::Key::Number;
+    } else {
+        key.kind = xhysorter::Key::Text;
+        key.s = text;
+    }
+    return key;
+}
+
+xhysorter::Key intKey(qint64 value) {
+    xhysorter::Key key;
+    key.kind = xhysorter::Key::Number;
+    key.exact = true;
+    key.i = value;
+    key.d = static_cast<double>(value);
+    return key;
+}
+
+void appendBigEndian(QByteArray& out, quint64 value) {
+    char bytes[8];
+    for (int k = 7; k >= 0; --k) {
+        bytes[k] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+    out.append(bytes, 8);
+}
+
+// 有符号整数翻转符号位后按无符号比较
+quint64 orderedInt(qint64 value) {
+    return static_cast<quint64>(value) ^ (quint64(1) << 63);
+}
+
+// IEEE 754：正数置符号位，负数整体取反，之后按无符号比较即为数值顺序
+quint64 orderedDouble(double value) {
+    if (value == 0) value = 0;                  // -0.0 与 0.0 相同
+    if (value != value) value = std::numeric_limits<double>::quiet_NaN(); // NaN 排在 +inf 之后
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return (bits & (quint64(1) << 63)) ? ~bits : bits | (quint64(1) << 63);
+}
+}
+
+xhysorter::Key xhysorter::keyOf(const QString& text, xhyfield::datatype type) {
+    if (text.isNull() || text.compare("NULL", Qt::CaseInsensitive) == 0) return Key();
+    bool ok = false;
+    switch (type) {
+    case xhyfield::INT:
+    case xhyfield::TINYINT:
+    case xhyfield::SMALLINT:
+    case xhyfield::BIGINT: {
+        const qint64 value = text.toLongLong(&ok);
+        if (ok) return intKey(value);
+        break;
+    }
+    case xhyfield::FLOAT:
+    case xhyfield::DOUBLE:
+    case xhyfield::DECIMAL: {
+        Key key;
+        key.d = text.toDouble(&ok);
+        if (ok) {
+            key.kind = Key::Number;
+            return key;
+        }
+        break;
+    }
+    case xhyfield::BOOL:
+        if (text.compare("true", Qt::CaseInsensitive) == 0 || text == "1") return intKey(1);
+        if (text.compare("false", Qt::CaseInsensitive) == 0 || text == "0") return intKey(0);
+        break;
+    case xhyfield::DATE: {
+        QDate date = QDate::fromString(text, "yyyy-MM-dd");
+        if (!date.isValid()) date = QDate::fromString(text, Qt::ISODate);
+        if (date.isValid()) {
+            Key key;
+            key.kind = Key::Time;
+            key.i = date.toJulianDay();
+            return key;
+        }
+        break;
+    }
+    case xhyfield::DATETIME:
+    case xhyfield::TIMESTAMP: {
+        QDateTime dt = QDateTime::fromString(text, "yyyy-MM-dd HH:mm:ss");
+        if (!dt.isValid()) dt = QDateTime::fromString(text, Qt::ISODate);
+        if (dt.isValid()) {
+            Key key;
+            key.kind = Key::Time;
+            key.i = dt.toMSecsSinceEpoch();
+            return key;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return textKey(text);
+}
+
+xhysorter::Key xhysorter::keyAt(const xhyrecord& record, int ordinal, xhyfield::datatype type) {
+    switch (type) {
+    case xhyfield::INT:
+    case xhyfield::TINYINT:
+    case xhyfield::SMALLINT:
+    case xhyfield::BIGINT: {
+        qint64 value = 0;
+        if (record.intAt(ordinal, &value)) return intKey(value);
+        break;
+    }
+    case xhyfield::FLOAT:
+    case xhyfield::DOUBLE:
+    case xhyfield::DECIMAL: {
+        Key key;
+        if (record.doubleAt(ordinal, &key.d)) {
+            key.kind = Key::Number;
+            return key;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return keyOf(record.valueAt(ordinal), type);
+}
+
+// 每个键以类别字节开头；数值为 8 字节 double 加 8 字节整数（整数超出 double 精度时靠后者区分），
+// 时间为 8 字节整数，文本为逐个 UTF-16 单元的大端 2 字节（0 单元写成 00 00 01），以 00 00 00 结尾
+void xhysorter::appendNormalized(QByteArray& out, const Key& key, bool descending) {
+    const int start = out.size();
+    out.append(static_cast<char>(key.kind));
+    switch (key.kind) {
+    case Key::Null:
+        break;
+    case Key::Number:
+        appendBigEndian(out, orderedDouble(key.exact ? static_cast<double>(key.i) : key.d));
+        appendBigEndian(out, orderedInt(key.exact ? key.i : 0));
+        break;
+    case Key::Time:
+        appendBigEndian(out, orderedInt(key.i));
+        break;
+    case Key::Text:
+        for (QChar ch : key.s) {
+            const ushort unit = ch.unicode();
+            out.append(static_cast<char>(unit >> 8));
+            out.append(static_cast<char>(unit & 0xff));
+            if (unit == 0) out.append('\x01');
+        }
+        out.append(3, '\0');
+        break;
+    }
+    if (descending) {
+        char* data = out.data();
+        for (int k = start; k < out.size(); ++k) data[k] = ~data[k];
+    }
+}
+
+struct xhysorter::Run {
+    int begin = 0;
+    int end = 0;
+    QByteArray keys;          // 不限行数：整段的键首尾相接
+    QVector<QByteArray> kept; // 有 limit：堆中各槽的键
+    QVector<Entry> entries;   // 本段排好序的结果
+};
+
+xhysorter::xhysorter(const QVector<Column>& columns, int limit) : m_columns(columns), m_limit(limit) {}
+
+int xhysorter::compareEntries(const char* a, int sizeA, int rowA, const char* b, int sizeB, int rowB) {
+    const int c = std::memcmp(a, b, static_cast<size_t>(qMin(sizeA, sizeB)));
+    if (c != 0) return c < 0 ? -1 : 1;
+    if (sizeA != sizeB) return sizeA < sizeB ? -1 : 1;
+    return rowA < rowB ? -1 : (rowA > rowB ? 1 : 0);
+}
+
+void xhysorter::setSpill(const QString& directory, qint64 memoryBudget) {
+    m_spillDirectory = directory;
+    m_memoryBudget = qMax<qint64>(1, memoryBudget);
+}
+
+void xhysorter::setParallelDegree(int degree) {
+    m_parallelDegree = qMax(0, degree);
+}
+
+QVector<xhyhashjoin::ColumnOrdinal> xhysorter::columnOrdinals() const {
+    QVector<xhyhashjoin::ColumnOrdinal> ordinals;
+    for (const Column& column : m_columns) ordinals.append(xhyhashjoin::ColumnOrdinal(column.name));
+    return ordinals;
+}
+
+void xhysorter::appendKey(const xhyrecord& record, QVector<xhyhashjoin::ColumnOrdinal>& ordinals, QByteArray& out) const {
+    for (int k = 0; k < m_columns.size(); ++k) {
+        appendNormalized(out, keyAt(record, ordinals[k].of(record), m_columns.at(k).type), m_columns.at(k).descending);
+    }
+}
+
+void xhysorter::sortRun(const xhyresultset& rows, Run& run) const {
+    QVector<xhyhashjoin::ColumnOrdinal> ordinals = columnOrdinals();
+    QVector<int> ends;
+    ends.reserve(run.end - run.begin);
+    for (int r = run.begin; r < run.end; ++r) {
+        appendKey(rows.at(r), ordinals, run.keys);
+        ends.append(run.keys.size());
+    }
+    // 键全部生成后缓冲区不再增长，这时才取指针
+    run.entries.reserve(ends.size());
+    int start = 0;
+    for (int i = 0; i < ends.size(); ++i) {
+        run.entries.append({run.keys.constData() + start, ends.at(i) - start, run.begin + i});
+        start = ends.at(i);
+    }
+    std::sort(run.entries.begin(), run.entries.end(), entryLess);
+}
+
+void xhysorter::topOfRun(const xhyresultset& rows, Run& run) const {
+    QVector<xhyhashjoin::ColumnOrdinal> ordinals = columnOrdinals();
+    QVector<int> keptRows; // 槽 -> 行下标
+    QVector<int> heap;     // 槽的最大堆，堆顶是排在最后的一行
+    auto slotLess = [&run, &keptRows](int a, int b) {
+        const QByteArray& ka = run.kept.at(a);
+        const QByteArray& kb = run.kept.at(b);
+        return compareEntries(ka.constData(), ka.size(), keptRows.at(a), kb.constData(), kb.size(), keptRows.at(b)) < 0;
+    };
+    QByteArray key;
+    for (int r = run.begin; r < run.end; ++r) {
+        key.clear();
+        appendKey(rows.at(r), ordinals, key);
+        if (run.kept.size() < m_limit) {
+            run.kept.append(key);
+            keptRows.append(r);
+            heap.append(run.kept.size() - 1);
+            std::push_heap(heap.begin(), heap.end(), slotLess);
+            continue;
+        }
+        // 堆已满：不比堆顶靠前的行直接丢弃，否则替换堆顶
+        const int worst = heap.first();
+        const QByteArray& worstKey = run.kept.at(worst);
+        if (compareEntries(key.constData(), key.size(), r, worstKey.constData(), worstKey.size(), keptRows.at(worst)) >= 0) continue;
+        std::pop_heap(heap.begin(), heap.end(), slotLess);
+        run.kept[worst] = key;
+        keptRows[worst] = r;
+        std::push_heap(heap.begin(), heap.end(), slotLess);
+    }
+    run.entries.reserve(run.kept.size());
+    for (int slot = 0; slot < run.kept.size(); ++slot) {
+        run.entries.append({run.kept.at(slot).constData(), static_cast<int>(run.kept.at(slot).size()), keptRows.at(slot)});
+    }
+    std::sort(run.entries.begin(), run.entries.end(), entryLess);
+}
+
+// 按均匀抽样的行估计全部排序键（连同每行的下标项）占用的字节数
+qint64 xhysorter::estimateKeyBytes(const xhyresultset& rows) const {
+    const int samples = static_cast<int>(qMin<qsizetype>(rows.size(), 1024));
+    if (samples == 0) return 0;
+    QVector<xhyhashjoin::ColumnOrdinal> ordinals = columnOrdinals();
+    QByteArray keys;
+    for (int i = 0; i < samples; ++i) appendKey(rows.at(static_cast<int>(qint64(rows.size()) * i / samples)), ordinals, keys);
+    const double perRow = double(keys.size()) / samples + sizeof(Entry) + sizeof(int);
+    return static_cast<qint64>(perRow * rows.size());
+}
+
+QVector<int> xhysorter::sort(const xhyresultset& rows) {
+    const int n = rows.size();
+    m_stats = Stats();
+    m_stats.rows = n;
+    m_stats.method = m_limit >= 0 ? TopN : InMemory;
+    if (n == 0 || m_limit == 0) return {};
+    if (m_limit < 0 && !m_spillDirectory.isEmpty() && estimateKeyBytes(rows) > m_memoryBudget) {
+        m_stats.method = External;
+        return externalSort(rows);
+    }
+    const int degree = m_parallelDegree > 0 ? m_parallelDegree : QThread::idealThreadCount();
+    const int parts = n >= kParallelRows ? qMax(1, degree) : 1;
+    m_stats.parallelRuns = parts;
+    QVector<Run> runs(parts);
+    for (int p = 0; p < parts; ++p) {
+        runs[p].begin = static_cast<int>(qint64(n) * p / parts);
+        runs[p].end = static_cast<int>(qint64(n) * (p + 1) / parts);
+    }
+    auto sortOne = [this, &rows](Run& run) {
+        if (m_limit > 0) {
+            topOfRun(rows, run);
+        } else {
+            sortRun(rows, run);
+        }
+    };
+    if (parts == 1) {
+        sortOne(runs[0]);
+    } else {
+        QtConcurrent::blockingMap(runs, sortOne);
+    }
+
+    // 各段结果首尾相接，每轮把相邻两段并行归并，直到只剩一段
+    QVector<Entry> merged;
+    QVector<int> bounds{0};
+    for (const Run& run : runs) {
+        merged += run.entries;
+        bounds.append(merged.size());
+    }
+    Entry* data = merged.data();
+    while (bounds.size() > 2) {
+        QVector<int> pairs; // 每对的第一段序号
+        for (int i = 0; i + 2 < bounds.size(); i += 2) pairs.append(i);
+        QtConcurrent::blockingMap(pairs, [data, &bounds](int i) {
+            std::inplace_merge(data + bounds.at(i), data + bounds.at(i + 1), data + bounds.at(i + 2), entryLess);
+        });
+        QVector<int> next;
+        for (int i = 0; i < bounds.size(); i += 2) next.append(bounds.at(i));
+        if (next.last() != bounds.last()) next.append(bounds.last());
+        bounds = next;
+    }
+
+    const int count = static_cast<int>(m_limit > 0 ? qMin<qsizetype>(m_limit, merged.size()) : merged.size());
+    QVector<int> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) result.append(merged.at(i).row);
+    return result;
+}
+
+// 每攒满内存预算就把这一段排好序写成一个顺串（行下标、键长、键字节），最后按各顺串的当前项多路归并
+QVector<int> xhysorter::externalSort(const xhyresultset& rows) {
+    if (!QDir().mkpath(m_spillDirectory)) {
+        throw std::runtime_error("无法创建排序临时目录: " + m_spillDirectory.toStdString());
+    }
+    std::vector<std::unique_ptr<QTemporaryFile>> files;
+    QVector<xhyhashjoin::ColumnOrdinal> ordinals = columnOrdinals();
+    QByteArray keys;
+    QVector<int> ends;
+    int runBegin = 0;
+    auto spill = [&]() {
+        QVector<Entry> entries;
+        entries.reserve(ends.size());
+        int start = 0;
+        for (int i = 0; i < ends.size(); ++i) {
+            entries.append({keys.constData() + start, ends.at(i) - start, runBegin + i});
+            start = ends.at(i);
+        }
+        std::sort(entries.begin(), entries.end(), entryLess);
+
+        std::unique_ptr<QTemporaryFile> file(new QTemporaryFile(QDir(m_spillDirectory).filePath("sort_XXXXXX.run")));
+        if (!file->open()) throw std::runtime_error("无法创建排序临时文件: " + file->errorString().toStdString());
+        QDataStream out(file.get());
+        for (const Entry& entry : entries) {
+            out << qint32(entry.row) << qint32(entry.size);
+            out.writeRawData(entry.key, entry.size);
+        }
+        if (out.status() != QDataStream::Ok || !file->flush()) {
+            throw std::runtime_error("写入排序临时文件失败: " + file->errorString().toStdString());
+        }
+        m_stats.spilledBytes += file->size();
+        ++m_stats.spilledRuns;
+        files.push_back(std::move(file));
+        runBegin += ends.size();
+        keys.clear();
+        ends.clear();
+    };
+    for (int r = 0; r < rows.size(); ++r) {
+        appendKey(rows.at(r), ordinals, keys);
+        ends.append(keys.size());
+        if (keys.size() + qint64(ends.size()) * qint64(sizeof(Entry) + sizeof(int)) >= m_memoryBudget) spill();
+    }
+    if (!ends.isEmpty()) spill();
+    keys = QByteArray();
+    ends = QVector<int>();
+    qDebug() << "[SORT] 外部排序" << rows.size() << "行，写出" << m_stats.spilledRuns << "个顺串，共" << m_stats.spilledBytes << "字节";
+
+    struct Cursor {
+        QDataStream in;
+        QByteArray key;
+        qint32 row = -1;
+    };
+    std::vector<std::unique_ptr<Cursor>> cursors;
+    auto advance = [](Cursor& cursor) {
+        if (cursor.in.atEnd()) return false;
+        qint32 size = 0;
+        cursor.in >> cursor.row >> size;
+        if (cursor.in.status() != QDataStream::Ok || size < 0) throw std::runtime_error("读取排序临时文件失败");
+        cursor.key.resize(size);
+        if (cursor.in.readRawData(cursor.key.data(), size) != size) throw std::runtime_error("读取排序临时文件失败");
+        return true;
+    };
+    // 最小堆：堆顶是各顺串当前项中最靠前的一个
+    auto after = [&cursors](int a, int b) {
+        const Cursor& ca = *cursors[a];
+        const Cursor& cb = *cursors[b];
+        return compareEntries(ca.key.constData(), ca.key.size(), ca.row, cb.key.constData(), cb.key.size(), cb.row) > 0;
+    };
+    std::priority_queue<int, std::vector<int>, decltype(after)> heads(after);
+    for (const auto& file : files) {
+        if (!file->seek(0)) throw std::runtime_error("读取排序临时文件失败: " + file->errorString().toStdString());
+        std::unique_ptr<Cursor> cursor(new Cursor);
+        cursor->in.setDevice(file.get());
+        cursors.push_back(std::move(cursor));
+        if (advance(*cursors.back())) heads.push(static_cast<int>(cursors.size()) - 1);
+    }
+
+    QVector<int> result;
+    result.reserve(rows.size());
+    while (!heads.empty()) {
+        const int run = heads.top();
+        heads.pop();
+        result.append(cursors[run]->row);
+        if (advance(*cursors[run])) heads.push(run);
+    }
+    return result; // 临时文件随 QTemporaryFile 析构删除
+}
+
+QString xhysorter::explain() const {
+    const QString parallel = m_stats.parallelRuns > 1 ? QString("，%1 段并行").arg(m_stats.parallelRuns) : QString();
+    switch (m_stats.method) {
+    case TopN:
+        return QString("排序: 堆排序取前 %1 行（输入 %2 行%3）").arg(m_limit).arg(m_stats.rows).arg(parallel);
+    case External:
+        return QString("排序: 外部归并排序 %1 行，内存预算 %2 MB，写出 %3 个顺串共 %4 MB")
+            .arg(m_stats.rows)
+            .arg(m_memoryBudget / double(1 << 20), 0, 'f', 1)
+            .arg(m_stats.spilledRuns)
+            .arg(m_stats.spilledBytes / double(1 << 20), 0, 'f', 1);
+    default:
+        return QString("排序: 内存排序 %1 行%2").arg(m_stats.rows).arg(parallel);
+    }
+}
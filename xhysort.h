@@ -0,0 +1,97 @@
+#ifndef XHYSORT_H
+#define XHYSORT_H
+
+#include "xhyfield.h"
+#include "xhyhashjoin.h"
+#include "xhyrecord.h"
+#include "xhyresultset.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// ORDER BY 排序：排序列在构造时解析一次，每行按字段类型转换成一段规范化字节键（逐列拼接），比较只做 memcmp
+// 给出 limit 时只保留前 limit 行：用大小为 limit 的堆（堆顶是当前最差的一行），其余行比较一次后丢弃
+// 行数达到 kParallelRows 时按线程数分段，各段并行生成键并排序（或取前 limit 行），再两两归并
+// 不限行数且键估计超过内存预算时改为外部归并排序：每攒满预算就把排好序的（键, 行下标）写成临时文件中的一个顺串，
+// 最后多路归并；记录本身仍在内存中（表数据常驻），落盘的只是排序键
+// 键相同的行保持原顺序，结果与稳定排序后截取前 limit 行相同
+class xhysorter {
+public:
+    // 排序键：NULL 最小，其次数值（整数精确比较），再次日期/时间，最后不能转为数值的文本
+    // 与 compareQVariants 一致：文本能转为数值时按数值比较
+    struct Key {
+        enum Kind : quint8 { Null, Number, Time, Text };
+        Kind kind = Null;
+        bool exact = false; // Number：整数，按 i 比较
+        qint64 i = 0;       // Number 的整数值；Time 的儒略日或毫秒数
+        double d = 0;
+        QString s;
+    };
+    static Key keyOf(const QString& text, xhyfield::datatype type);
+    static Key keyAt(const xhyrecord& record, int ordinal, xhyfield::datatype type); // 原生整数/浮点单元不经过文本
+
+    // 把 key 追加为规范化字节：按字节比较的结果与键的顺序相同；descending 时逐字节取反
+    static void appendNormalized(QByteArray& out, const Key& key, bool descending);
+
+    struct Column {
+        QString name; // 记录中的列名
+        xhyfield::datatype type = xhyfield::VARCHAR;
+        bool descending = false;
+    };
+
+    static const int kParallelRows = 1 << 16;
+    static const qint64 kDefaultMemoryBudget = qint64(128) << 20; // 排序键占用的内存上限（字节）
+
+    enum Method { InMemory, TopN, External };
+    // 最近一次 sort 的执行统计（EXPLAIN ANALYZE）
+    struct Stats {
+        Method method = InMemory;
+        int rows = 0;
+        int parallelRuns = 1;     // 内存排序/取前 N 行时的并行段数
+        int spilledRuns = 0;      // 外部排序写出的顺串个数
+        qint64 spilledBytes = 0;  // 写入临时文件的字节数
+    };
+
+    // limit < 0 表示不限
+    explicit xhysorter(const QVector<Column>& columns, int limit = -1);
+
+    // 外部排序的临时文件目录（不存在时创建）和内存预算；目录为空时不落盘
+    void setSpill(const QString& directory, qint64 memoryBudget = kDefaultMemoryBudget);
+    // 并行排序的段数上限：0 为 CPU 核数，1 为串行
+    void setParallelDegree(int degree);
+
+    // 返回排好序的位置（rows 中的序号，最多 limit 个）；临时文件无法读写时抛出 std::runtime_error
+    QVector<int> sort(const xhyresultset& rows);
+    QVector<int> sort(const QVector<xhyrecord>& rows) { return sort(xhyresultset(rows)); }
+    int limit() const { return m_limit; }
+    const Stats& stats() const { return m_stats; }
+    QString explain() const; // 统计的文字说明
+
+private:
+    struct Entry {
+        const char* key = nullptr;
+        int size = 0;
+        int row = -1;
+    };
+    struct Run; // 一段行的排序结果
+
+    static int compareEntries(const char* a, int sizeA, int rowA, const char* b, int sizeB, int rowB);
+    static bool entryLess(const Entry& a, const Entry& b) {
+        return compareEntries(a.key, a.size, a.row, b.key, b.size, b.row) < 0;
+    }
+    void sortRun(const xhyresultset& rows, Run& run) const;
+    void topOfRun(const xhyresultset& rows, Run& run) const;
+    void appendKey(const xhyrecord& record, QVector<xhyhashjoin::ColumnOrdinal>& ordinals, QByteArray& out) const;
+    QVector<xhyhashjoin::ColumnOrdinal> columnOrdinals() const;
+    qint64 estimateKeyBytes(const xhyresultset& rows) const;
+    QVector<int> externalSort(const xhyresultset& rows);
+
+    QVector<Column> m_columns;
+    int m_limit = -1;
+    QString m_spillDirectory;
+    qint64 m_memoryBudget = kDefaultMemoryBudget;
+    int m_parallelDegree = 0;
+    Stats m_stats;
+};
+
+#endif // XHYSORT_H
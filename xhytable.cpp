@@ -7,57 +7,17 @@
 #include <limits> // <--- 确保此行存在
 #include <QRegularExpression>
 #include "xhydatabase.h"
+#include <cmath>
+#include <algorithm>
 #include <stdexcept> // 用于 std::runtime_error
-#include <QJSEngine>
+#include <QMutex>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <atomic>
 #include <QRegularExpression>
 
 // zyh的where里的like
-namespace { // 匿名命名空间，用于此文件内的辅助函数
-QStringList helper_parseSqlValues(const QString& input_raw) {
-    QStringList values;
-    QString current_value;
-    bool in_string_literal = false;
-    QChar quote_char = QChar::Null;
-    QString input = input_raw.trimmed();
-
-    for (int i = 0; i < input.length(); ++i) {
-        QChar ch = input[i];
-        if (in_string_literal) {
-            if (ch == quote_char) {
-                // 处理SQL中的两个连续引号表示一个引号的情况
-                if (i + 1 < input.length() && input[i + 1] == quote_char) {
-                    current_value += quote_char;
-                    i++; // 跳过第二个引号
-                } else {
-                    in_string_literal = false; // 字符串结束
-                    // current_value += ch; // 包含结束引号 (如果 parseLiteralValue 需要)
-                    // 或者不加，如果 parseLiteralValue 期望的是内部内容
-                }
-            } else {
-                current_value += ch;
-            }
-        } else {
-            if (ch == '\'' || ch == '"') {
-                in_string_literal = true;
-                quote_char = ch;
-                // current_value += ch; // 包含开始引号 (如果 parseLiteralValue 需要)
-            } else if (ch == ',') {
-                values.append(current_value.trimmed());
-                current_value.clear();
-            } else {
-                current_value += ch;
-            }
-        }
-    }
-    if (!current_value.trimmed().isEmpty() || !values.isEmpty() || !input_raw.trimmed().isEmpty()) {
-        values.append(current_value.trimmed()); // 添加最后一个值
-    }
-    // 清理可能因仅有逗号或末尾逗号产生的空字符串
-    values.removeAll(QString(""));
-    return values;
-}
-}
-QString sqlLikeToRegex(const QString& likePattern, QChar customEscapeChar = QChar::Null) {
+QString sqlLikeToRegex(const QString& likePattern, QChar customEscapeChar) {
     QString regexPattern;
     regexPattern += '^'; // 锚定字符串的开始
 
@@ -132,16 +92,68 @@ bool parseDecimalParams(const QStringList& constraints, int& precision, int& sca
 }
 xhytable::xhytable(const QString& name, xhydatabase* parentDb)
     : m_name(name), m_inTransaction(false), m_parentDb(parentDb) {
-    // 初始化，如果需要
+    rebuildRowLayout();
+}
+
+xhyrecordlayout::StorageType xhytable::storageTypeFor(xhyfield::datatype type) {
+    switch (type) {
+    case xhyfield::TINYINT:
+    case xhyfield::SMALLINT:
+    case xhyfield::INT:
+    case xhyfield::BIGINT:
+        return xhyrecordlayout::IntColumn;
+    case xhyfield::FLOAT:
+    case xhyfield::DOUBLE:
+    case xhyfield::DECIMAL:
+        return xhyrecordlayout::DoubleColumn;
+    case xhyfield::DATE:
+        return xhyrecordlayout::DateColumn;
+    case xhyfield::BOOL:
+        return xhyrecordlayout::BoolColumn;
+    default:
+        return xhyrecordlayout::TextColumn;
+    }
+}
+
+void xhytable::rebuildRowLayout() {
+    QSharedDataPointer<xhyrecordlayout> layout(new xhyrecordlayout);
+    for (const xhyfield& field : m_fields) layout->append(field.name(), storageTypeFor(field.type()));
+    m_rowLayout = layout;
+    compileCheckConstraints(); // CHECK 表达式按字段序号解析，随字段变化重新解析
+    rebuildColumns();
 }
 
 
 
 const QList<xhyrecord>& xhytable::records() const {
-    return m_inTransaction ? m_tempRecords : m_records;
+    ensureRowsLoaded();
+    return m_records;
+}
+
+void xhytable::setRowLoader(std::function<void(xhytable&)> loader) {
+    m_rowLoader = std::move(loader);
+    m_rowsLoaded = !m_rowLoader;
+}
+
+void xhytable::ensureRowsLoaded() const {
+    if (m_rowsLoaded) return;
+    // 记录属于表的逻辑状态，按需加载不改变 const 语义
+    xhytable* self = const_cast<xhytable*>(this);
+    self->m_rowsLoaded = true; // 先置位，loader 内部的 addrecord 不会再次触发加载
+    std::function<void(xhytable&)> loader;
+    loader.swap(self->m_rowLoader);
+    try {
+        loader(*self);
+    } catch (...) { // 记录文件损坏：保持未加载，下次访问重新报告错误
+        self->m_rowLoader.swap(loader);
+        self->m_rowsLoaded = false;
+        throw;
+    }
 }
 
 void xhytable::addfield(const xhyfield& field) {
+    beginSchemaChange();
+    ensureRowsLoaded(); // 已有记录按旧字段布局解码
     if (has_field(field.name())) {
         qWarning() << "字段已存在：" << field.name();
         return; // 或者抛出异常
@@ -230,6 +242,8 @@ void xhytable::addfield(const xhyfield& field) {
         }
     }
     m_fields.append(newField);
+    rebuildRowLayout();
+    markSchemaDirty();
 }
 
 // xhytable.cpp
@@ -375,200 +389,39 @@ QVariant xhytable::convertStringToType(const QString& str, xhyfield::datatype ty
     }
 }
 
-//解析check语句
-bool xhytable::evaluateCheckExpression(const QString& expr, const QVariantMap& fieldValues) const {
-    QJSEngine engine;
-    qDebug() << "[表::CHECK表达式求值] 开始处理表达式: '" << expr << "' 使用字段值: " << fieldValues;
-
-    // 1. 安全防护
-    if (expr.contains("function", Qt::CaseInsensitive) || expr.contains("eval", Qt::CaseInsensitive) || expr.contains("script", Qt::CaseInsensitive)) {
-        qWarning() << "  拒绝执行可能危险的CHECK表达式（包含禁用词）:" << expr;
-        return false;
-    }
-
-    // 2. 注入字段值到JS引擎
-    for (auto it = fieldValues.constBegin(); it != fieldValues.constEnd(); ++it) {
-        const QString& fieldName = it.key();
-        const QVariant& qVariantValue = it.value();
-
-        if (qVariantValue.isNull() || qVariantValue.userType() == QMetaType::UnknownType ||
-            (qVariantValue.typeId() == QMetaType::QString && qVariantValue.toString().compare("NULL", Qt::CaseInsensitive) == 0) ) {
-            engine.globalObject().setProperty(fieldName, QJSValue::NullValue);
-            // qDebug() << "  注入字段 '" << fieldName << "' 为 JS null";
-            continue;
-        }
-
-        // 根据QVariant内部存储的C++类型注入
-        switch (qVariantValue.userType()) {
-        case QMetaType::Bool:       engine.globalObject().setProperty(fieldName, qVariantValue.toBool()); break;
-        case QMetaType::Int:        engine.globalObject().setProperty(fieldName, qVariantValue.toInt()); break;
-        case QMetaType::LongLong:   engine.globalObject().setProperty(fieldName, static_cast<double>(qVariantValue.toLongLong())); break;
-        case QMetaType::UInt:       engine.globalObject().setProperty(fieldName, qVariantValue.toUInt()); break;
-        case QMetaType::ULongLong:  engine.globalObject().setProperty(fieldName, static_cast<double>(qVariantValue.toULongLong())); break;
-        case QMetaType::Float:      engine.globalObject().setProperty(fieldName, static_cast<double>(qVariantValue.toFloat())); break;
-        case QMetaType::Double:     engine.globalObject().setProperty(fieldName, qVariantValue.toDouble()); break;
-        case QMetaType::QDate:      engine.globalObject().setProperty(fieldName, qVariantValue.toDate().toString(Qt::ISODate)); break;
-        case QMetaType::QDateTime:  engine.globalObject().setProperty(fieldName, qVariantValue.toDateTime().toString(Qt::ISODateWithMs)); break;
-        case QMetaType::QString:
-        default:                    engine.globalObject().setProperty(fieldName, qVariantValue.toString()); break;
-        }
-    }
-
-    // 3. SQL→JS语法转换
-    QString jsExpr = expr;
-    qDebug() << "  [表::CHECK表达式求值] 原始SQL CHECK表达式 (来自m_checkConstraints): " << jsExpr;
-
-    // 规范化字段名大小写
-    for (const xhyfield& fieldDef : m_fields) {
-        QString fieldNameInTableDef = fieldDef.name();
-        QRegularExpression fieldRegex(QString(R"(\b%1\b)").arg(QRegularExpression::escape(fieldNameInTableDef)),
-                                      QRegularExpression::CaseInsensitiveOption);
-        jsExpr.replace(fieldRegex, fieldNameInTableDef);
-    }
-    qDebug() << "  [表::CHECK表达式求值] 规范化字段名大小写后的JS表达式: " << jsExpr;
-
-    // 基本逻辑和比较操作符转换
-    jsExpr.replace(QRegularExpression(R"(\bAND\b)", QRegularExpression::CaseInsensitiveOption), "&&");
-    jsExpr.replace(QRegularExpression(R"(\bOR\b)", QRegularExpression::CaseInsensitiveOption), "||");
-    jsExpr.replace(QRegularExpression(R"(\bNOT\b(?!\s+(?:IN|LIKE|BETWEEN|NULL)))", QRegularExpression::CaseInsensitiveOption), "!"); // 修正NOT以避免干扰IS NOT NULL
-    jsExpr.replace(QRegularExpression(R"((?<![!=<>])=(?!=))"), "==");
-    jsExpr.replace("<>", "!=");
-
-    QRegularExpression isNotNullRe(R"(\b([\w`\[\]\.]+)\s+IS\s+NOT\s+NULL\b)", QRegularExpression::CaseInsensitiveOption);
-    jsExpr.replace(isNotNullRe, "(\\1 !== null && typeof \\1 !== 'undefined')"); // 使用 \\1 代表第一个捕获组
-
-    QRegularExpression isNullRe(R"(\b([\w`\[\]\.]+)\s+IS\s+NULL\b)", QRegularExpression::CaseInsensitiveOption);
-    jsExpr.replace(isNullRe, "(\\1 === null || typeof \\1 === 'undefined')"); // 使用 \\1 代表第一个捕获组
-
-    qDebug() << "  [表::CHECK表达式求值] 处理 IS NULL/NOT NULL后的JS表达式: " << jsExpr;
-    // 处理 LIKE 和 NOT LIKE
-    QRegularExpression likeRe(R"(([\w`\[\]\.]+)\s+(NOT\s+)?LIKE\s+'((?:[^']|'')*)')", QRegularExpression::CaseInsensitiveOption);
-    int pos = 0;
-    QString tempJsExprForLike = jsExpr;
-    jsExpr.clear();
-    int lastPos = 0;
-    while ((pos = tempJsExprForLike.indexOf(likeRe, lastPos)) != -1) {
-        QRegularExpressionMatch match = likeRe.match(tempJsExprForLike, pos);
-        jsExpr += tempJsExprForLike.mid(lastPos, pos - lastPos);
-        QString field = match.captured(1);
-        bool isNotLike = !match.captured(2).isEmpty();
-        QString patternStr = match.captured(3).replace("''", "'");
-        QString jsRegexPattern =sqlLikeToRegex(patternStr); // 使用辅助函数
-        QString escapedJsRegexPattern = jsRegexPattern.replace("\\", "\\\\").replace("'", "\\'");
-        jsExpr += QString("%3new RegExp('^%1$', 'i').test(%2)") // 添加 ^ 和 $ 以匹配整个字符串
-                      .arg(escapedJsRegexPattern, field, (isNotLike ? "!" : ""));
-        lastPos = pos + match.capturedLength();
-    }
-    jsExpr += tempJsExprForLike.mid(lastPos);
-    qDebug() << "  [表::CHECK表达式求值] 处理 LIKE 后的JS表达式: " << jsExpr;
-
-    // 处理 IN 和 NOT IN
-    QRegularExpression inRe(R"(([\w`\[\]\.]+)\s+(NOT\s+)?IN\s*\(\s*((?:'[^']*'(?:\s*,\s*'[^']*')*|[\d\s,trufalsetTRUEFALSE\.\-\+Ee]+)?)\s*\))", QRegularExpression::CaseInsensitiveOption);
-    pos = 0;
-    QString tempJsExprForIn = jsExpr;
-    jsExpr.clear();
-    lastPos = 0;
-    while((pos = tempJsExprForIn.indexOf(inRe, lastPos)) != -1) {
-        QRegularExpressionMatch match = inRe.match(tempJsExprForIn, pos);
-        jsExpr += tempJsExprForIn.mid(lastPos, pos - lastPos);
-        QString field = match.captured(1);
-        bool isNotIn = !match.captured(2).isEmpty();
-        QString valuesPart = match.captured(3).trimmed();
-        QStringList jsValues;
-        if (!valuesPart.isEmpty()) {
-            QStringList sqlLiterals = helper_parseSqlValues(valuesPart); // 使用为此优化的辅助函数
-            for (const QString& sqlLiteralOriginal : sqlLiterals) {
-                QString sqlLiteral = sqlLiteralOriginal;
-                // 将SQL字面量转换为JS字面量
-                if (sqlLiteral.compare("true", Qt::CaseInsensitive) == 0 || sqlLiteral.compare("false", Qt::CaseInsensitive) == 0) {
-                    jsValues << sqlLiteral.toLower();
-                } else if ((sqlLiteral.startsWith('\'') && sqlLiteral.endsWith('\'')) || (sqlLiteral.startsWith('"') && sqlLiteral.endsWith('"'))) {
-                    // 如果 helper_parseSqlValues_for_check 返回的是包含引号的字符串 " 'value' "
-                    // 那么JS数组中也应该是 "'value'"
-                    // 如果 helper_parseSqlValues_for_check 返回的是去除引号的字符串 "value"
-                    // 那么JS数组中应该是 "'value'"
-                    // 假设 helper_parseSqlValues_for_check 返回的是SQL字面量字符串本身（即 'value' 或 "value"）
-                    jsValues << sqlLiteral;
-                } else { // 数字或其他不需要引号的JS字面量
-                    bool okNum;
-                    sqlLiteral.toDouble(&okNum);
-                    if(okNum) jsValues << sqlLiteral; // 数字直接用
-                    else jsValues << "'" + QString(sqlLiteral).replace(QLatin1Char('\''), QLatin1String("\\'")) + "'"; // 其他无引号的视为字符串
-                }
-            }
-        }
-        jsExpr += QString("%3[%1].includes(%2)")
-                      .arg(jsValues.join(", "), field, (isNotIn ? "!" : ""));
-        lastPos = pos + match.capturedLength();
-    }
-    jsExpr += tempJsExprForIn.mid(lastPos);
-    qDebug() << "  [表::CHECK表达式求值] 处理 IN 后的JS表达式: " << jsExpr;
-
-    // 4. 执行表达式
-    QString fullJsToEvaluate = QString(
-                                   "(function() {"
-                                   "  try {"
-                                   "    let result = (%1);"
-                                   "    if (result === null || typeof result === 'undefined') {"
-                                   "      return true; /* SQL UNKNOWN means CHECK constraint passes */"
-                                   "    }"
-                                   "    return !!result; /* Otherwise, must be true */"
-                                   "  } catch (e) {"
-                                   "    /* console.warn is not available here, error will be caught by C++ */"
-                                   "    return false; /* JS error means CHECK constraint fails */"
-                                   "  }"
-                                   "})()"
-                                   ).arg(jsExpr);
-
-    // qDebug() << "  [表::CHECK表达式求值] 待执行的完整JS函数体:\n" << fullJsToEvaluate; // 调试时可以取消注释
-    QJSValue result = engine.evaluate(fullJsToEvaluate);
-
-    if (result.isError()) {
-        qWarning() << "  CHECK约束 QJSEngine 执行错误 (engine.evaluate() returned error):" << result.toString()
-            << "\n    原始SQL表达式:" << expr
-            << "\n    转换后JS表达式主体:" << jsExpr;
+bool xhytable::evaluateCheckConstraint(const QString& constraintName, const QVector<QVariant>& values) const {
+    const auto it = m_checkPrograms.constFind(constraintName);
+    if (it == m_checkPrograms.constEnd()) return true;
+    if (!it->isValid()) { // 无法解析（如引用了已不存在的列）的约束拒绝所有记录
+        qWarning() << "CHECK 约束" << constraintName << "无法解析:" << it->error() << "表达式:" << m_checkConstraints.value(constraintName);
         return false;
     }
+    return it->passes(values);
+}
 
-    bool finalOutcome = result.toBool();
-    if(!finalOutcome && !result.isError()){ // 如果JS逻辑的catch块返回了false
-        qDebug() << "  [表::CHECK表达式求值] JS表达式 (" << jsExpr << ") 在catch块中返回false或计算结果为false.";
+void xhytable::compileCheckConstraints() {
+    m_checkPrograms.clear();
+    for (auto it = m_checkConstraints.constBegin(); it != m_checkConstraints.constEnd(); ++it) {
+        m_checkPrograms.insert(it.key(), xhycheck::compile(it.value(), m_fields));
     }
-    qDebug() << "  [表::CHECK表达式求值] SQL表达式 '" << expr << "' 的最终计算结果: " << (finalOutcome ? "通过" : "失败");
-    return finalOutcome;
 }
+
 // 确保其声明和定义匹配。这里我提供一个与之前讨论匹配的签名。
 void xhytable::checkUpdateConstraints(const xhyrecord& originalRecord, const QMap<QString, QString>& finalProposedUpdates) const {
     qDebug() << "[表::检查更新约束] 开始对表 '"<< m_name << "' 的更新值进行 CHECK 约束检查。";
-    QVariantMap updatedRecordData;
-
-    QMap<QString, QString> originalValues = originalRecord.allValues();
+    if (m_checkConstraints.isEmpty()) return;
+    QVector<QVariant> updatedValues;
+    updatedValues.reserve(m_fields.size());
     for (const xhyfield& fieldDef : m_fields) {
         const QString& fieldName = fieldDef.name();
-        if (finalProposedUpdates.contains(fieldName)) {
-            updatedRecordData[fieldName] = convertToTypedValue(finalProposedUpdates.value(fieldName), fieldDef.type());
-        } else {
-            updatedRecordData[fieldName] = convertToTypedValue(originalValues.value(fieldName), fieldDef.type());
-        }
+        const QString value = finalProposedUpdates.contains(fieldName) ? finalProposedUpdates.value(fieldName) : originalRecord.value(fieldName);
+        updatedValues.append(convertToTypedValue(value, fieldDef.type()));
     }
-    for (const QString& key : finalProposedUpdates.keys()) {
-        if (!updatedRecordData.contains(key)) {
-            const xhyfield* fieldDef = get_field(key); // 【修复】使用 ->
-            if (fieldDef) {
-                updatedRecordData[key] = convertToTypedValue(finalProposedUpdates.value(key), fieldDef->type());
-            } else {
-                qWarning() << "  [表::检查更新约束] 警告: 字段 '" << key << "' 在表定义中未找到，但在更新值中存在。作为字符串处理。";
-                updatedRecordData[key] = finalProposedUpdates.value(key);
-            }
-        }
-    }
-    qDebug() << "  [表::检查更新约束] 用于 CHECK 表达式的更新后记录数据: " << updatedRecordData;
 
     for (auto it = m_checkConstraints.constBegin(); it != m_checkConstraints.constEnd(); ++it) {
         const QString& constraintName = it.key();
         const QString& checkExpr = it.value();
-        qDebug() << "    检查约束 '" << constraintName << "', 表达式: '" << checkExpr << "'";
-        if (!evaluateCheckExpression(checkExpr, updatedRecordData)) {
+        if (!evaluateCheckConstraint(constraintName, updatedValues)) {
             QString errorMsg = QString("更新失败: 记录更新后将违反 CHECK 约束 '%1' (表达式: %2).")
                                    .arg(constraintName, checkExpr);
             qWarning() << "  " << errorMsg;
@@ -581,34 +434,18 @@ void xhytable::checkUpdateConstraints(const xhyrecord& originalRecord, const QMa
 
 void xhytable::checkInsertConstraints(const QMap<QString, QString>& fieldValues) const {
     qDebug() << "[表::检查插入约束] 开始对表 '"<< m_name << "' 的插入值进行 CHECK 约束检查: " << fieldValues;
-    QVariantMap fullRecordData;
-
-    for (const xhyfield& fieldDef : m_fields) { // 【修复】直接遍历 m_fields
+    if (m_checkConstraints.isEmpty()) return;
+    QVector<QVariant> fullValues;
+    fullValues.reserve(m_fields.size());
+    for (const xhyfield& fieldDef : m_fields) {
         const QString& fieldName = fieldDef.name();
-        if (fieldValues.contains(fieldName)) {
-            fullRecordData[fieldName] = convertToTypedValue(fieldValues.value(fieldName), fieldDef.type());
-        } else {
-            fullRecordData[fieldName] = QVariant();
-        }
+        fullValues.append(fieldValues.contains(fieldName) ? convertToTypedValue(fieldValues.value(fieldName), fieldDef.type()) : QVariant());
     }
-    for (const QString& key : fieldValues.keys()) {
-        if (!fullRecordData.contains(key)) {
-            const xhyfield* fieldDef = get_field(key);
-            if (fieldDef) {
-                fullRecordData[key] = convertToTypedValue(fieldValues.value(key), fieldDef->type());
-            } else {
-                qWarning() << "  [表::检查插入约束] 警告: 字段 '" << key << "' 在表定义中未找到，但在输入值中存在。作为字符串处理。";
-                fullRecordData[key] = fieldValues.value(key);
-            }
-        }
-    }
-    qDebug() << "  [表::检查插入约束] 用于 CHECK 表达式的记录数据: " << fullRecordData;
 
     for (auto it = m_checkConstraints.constBegin(); it != m_checkConstraints.constEnd(); ++it) {
         const QString& constraintName = it.key();
         const QString& checkExpr = it.value();
-        qDebug() << "    检查约束 '" << constraintName << "', 表达式: '" << checkExpr << "'";
-        if (!evaluateCheckExpression(checkExpr, fullRecordData)) {
+        if (!evaluateCheckConstraint(constraintName, fullValues)) {
             QString errorMsg = QString("插入失败: 记录违反了 CHECK 约束 '%1' (表达式: %2).")
                                    .arg(constraintName, checkExpr);
             qWarning() << "  " << errorMsg;
@@ -641,8 +478,15 @@ void xhytable::add_field(const xhyfield& field) {
 }
 
 void xhytable::remove_field(const QString& field_name) {
+    beginSchemaChange();
+    ensureRowsLoaded();
     m_fields.removeIf([&](const xhyfield& f){ return f.name().compare(field_name, Qt::CaseInsensitive) == 0; });
+    rebuildRowLayout();
+    m_indexes.removeIf([&](const xhybtree& index) { // 索引随被删除的列一起删除
+        return index.definition().columns().contains(field_name, Qt::CaseInsensitive);
+    });
     m_primaryKeys.removeAll(field_name);
+    markSchemaDirty();
 }
 
 const xhyfield* xhytable::get_field(const QString& field_name) const {
@@ -655,22 +499,42 @@ const xhyfield* xhytable::get_field(const QString& field_name) const {
 }
 
 void xhytable::rename(const QString& new_name) {
+    beginSchemaChange();
+    ensureRowsLoaded(); // 提交时按新名整体写出，随后删除旧的 .trd
     m_name = new_name;
+    for (xhybtree& index : m_indexes) {
+        const xhyindex& def = index.definition();
+        index.setDefinition(xhyindex(def.name(), new_name, def.columns(), def.isUnique()));
+    }
+    markSchemaDirty();
 }
 
 void xhytable::addrecord(const xhyrecord& record) {
-    m_records.append(record);
+    m_keyIndexesBuilt = false; // 加载路径不逐行维护，下次校验时整体重建
+    m_records.append(record.rebound(m_rowLayout));
+    if (record.rowId() == 0) {
+        m_records.last().setRowId(m_nextRowId++);
+    } else if (record.rowId() >= m_nextRowId) {
+        m_nextRowId = record.rowId() + 1;
+    }
+    columnsRowInserted(m_records.size() - 1);
 }
 
 
 bool xhytable::createtable(const xhytable& table) {
     m_name = table.name();
     m_fields = table.fields();
+    m_rowLayout = table.m_rowLayout;
     m_records = table.getCommittedRecords(); // 使用 getter 获取源表的 m_records
     m_primaryKeys = table.primaryKeys();
     m_foreignKeys = table.m_foreignKeys; // 假设可以直接访问或有 getter
     m_uniqueConstraints = table.m_uniqueConstraints;
     m_checkConstraints = table.m_checkConstraints;
+    m_checkPrograms = table.m_checkPrograms;
+    m_nextRowId = table.m_nextRowId;
+    m_options = table.m_options;
+    m_indexes = table.m_indexes;
+    for (xhybtree& index : m_indexes) index.invalidate(); // 源表可能在事务中，按复制来的记录重建
 
     // ---- 开始修复 ----
     m_notNullFields = table.notNullFields(); // 确保 m_notNullFields 被复制
@@ -678,7 +542,13 @@ bool xhytable::createtable(const xhytable& table) {
     // ---- 结束修复 ----
 
     m_inTransaction = false;
-    m_tempRecords.clear();
+    m_undoLog.clear();
+    // 记录连同版本信息一起复制：事务中复制来的未提交行仍按行号在提交时盖时间戳
+    m_versions = table.m_versions;
+    m_txnRowIds = table.m_txnRowIds;
+    m_lastCommitTs = table.m_lastCommitTs;
+    markSchemaDirty();
+    markDataDirty();
     // 同样重要的是，新表实例的父数据库指针 (m_parentDb) 需要被正确设置。
     // 这通常由 xhydatabase 在添加表时处理。
     // 如果这里创建的表实例是最终存储在 xhydatabase 中的实例，
@@ -687,10 +557,12 @@ bool xhytable::createtable(const xhytable& table) {
     // 此处假设 'this' 对象的 m_parentDb 已经是正确的或在别处设置。
 
     rebuildIndexes();
+    rebuildColumns();
     return true;
 }
 
 void xhytable::add_primary_key(const QStringList& keys) {
+    beginSchemaChange();
     if (keys.isEmpty()) {
         qWarning() << "[add_primary_key] 表 '" << m_name << "'：尝试添加空的主键列表。";
         // 也可以考虑抛出异常
@@ -736,6 +608,7 @@ void xhytable::add_primary_key(const QStringList& keys) {
             // 为了简单起见，这里仅输出警告。但这意味着可能创建出一个无效的表定义。
         }
     }
+    markSchemaDirty();
     qDebug() << "[add_primary_key] 表 '" << m_name << "' 的主键列更新为：" << m_primaryKeys;
     qDebug() << "[add_primary_key] 表 '" << m_name << "' 的非空字段集合更新为：" << m_notNullFields;
 }
@@ -745,6 +618,7 @@ void xhytable::add_foreign_key(const QStringList& childColumns,
                                const QString& constraintNameIn,
                                ForeignKeyDefinition::ReferentialAction onDeleteAction,
                                ForeignKeyDefinition::ReferentialAction onUpdateAction) {
+    beginSchemaChange();
     if (childColumns.isEmpty() || referencedColumns.isEmpty() || childColumns.size() != referencedColumns.size()) {
         throw std::runtime_error("添加外键失败：列列表不能为空且长度必须匹配。");
     }
@@ -780,6 +654,7 @@ void xhytable::add_foreign_key(const QStringList& childColumns,
     newForeignKey.onUpdateAction = onUpdateAction; // 保存 ON UPDATE 动作
 
     m_foreignKeys.append(newForeignKey);
+    markSchemaDirty();
     qDebug() << "外键 '" << newForeignKey.constraintName << "' (" << childColumns.join(", ")
              << " REFERENCES " << referencedTable << "(" << referencedColumns.join(", ") << "))"
              << " ON DELETE " << (onDeleteAction == ForeignKeyDefinition::CASCADE ? "CASCADE" : "NO ACTION") // 示例输出
@@ -789,6 +664,7 @@ void xhytable::add_foreign_key(const QStringList& childColumns,
 
 
 void xhytable::add_unique_constraint(const QStringList& fields, const QString& constraintNameIn) {
+    beginSchemaChange();
     if (fields.isEmpty()) {
         throw std::runtime_error("添加唯一约束失败：字段列表不能为空。");
     }
@@ -807,15 +683,19 @@ void xhytable::add_unique_constraint(const QStringList& fields, const QString& c
         throw std::runtime_error("唯一约束 '" + constraintName.toStdString() + "' 已存在。");
     }
     m_uniqueConstraints[constraintName] = fields;
+    markSchemaDirty();
     qDebug() << "唯一约束 '" << constraintName << "' ON (" << fields.join(", ") << ") 已添加到表 " << m_name;
 }
 
 
 
 void xhytable::add_check_constraint(const QString& condition, const QString& constraintName) {
+    beginSchemaChange();
     QString actualConstraintName = constraintName.isEmpty() ? ("CK_" + m_name + "_cond" + QString::number(m_checkConstraints.size()+1) ) : constraintName;
     if(!m_checkConstraints.contains(actualConstraintName)){
         m_checkConstraints[actualConstraintName] = condition;
+        m_checkPrograms.insert(actualConstraintName, xhycheck::compile(condition, m_fields));
+        markSchemaDirty();
     } else {
         qWarning() << "检查约束 " << actualConstraintName << " 已存在。";
     }
@@ -823,32 +703,291 @@ void xhytable::add_check_constraint(const QString& condition, const QString& con
 
 void xhytable::beginTransaction() {
     if (!m_inTransaction) {
-        m_tempRecords = m_records;
+        m_undoLog.clear();
         m_inTransaction = true;
     }
 }
 
-void xhytable::commit() {
+void xhytable::commit(quint64 commitTimestamp) {
     if (m_inTransaction) {
-        m_records = m_tempRecords;
-        m_tempRecords.clear();
+        // 本事务写入的新版本盖上提交时间戳，被它们取代的旧版本同时结束
+        QHash<quint64, int> positions;
+        for (quint64 rowId : std::as_const(m_txnRowIds)) {
+            const int position = rowPosition(m_records, rowId, &positions);
+            if (position >= 0 && m_records.at(position).beginTs() == xhymvcc::kUncommitted) {
+                m_records[position].setBeginTs(commitTimestamp);
+            }
+            auto chain = m_versions.find(rowId);
+            if (chain == m_versions.end()) continue;
+            for (RowVersion& version : chain->versions) {
+                if (version.endTs == xhymvcc::kUncommitted) version.endTs = commitTimestamp;
+            }
+        }
+        if (!m_txnRowIds.isEmpty()) m_lastCommitTs = qMax(m_lastCommitTs, commitTimestamp);
+        m_txnRowIds.clear();
+        m_undoLog.clear();
         m_inTransaction = false;
     }
 }
 
 void xhytable::rollback() {
     if (m_inTransaction) {
-        m_tempRecords.clear();
+        rollbackTo(0);
+        m_txnRowIds.clear();
         m_inTransaction = false;
     }
 }
 
+// 逆序回放撤销日志，索引随行增量维护；每撤销一项同时丢弃对应的一条待写日志变更
+void xhytable::rollbackTo(int undoLogSize) {
+    undoLogSize = qMax(0, undoLogSize);
+    if (m_undoLog.size() <= undoLogSize) return;
+    while (m_undoLog.size() > undoLogSize) {
+        const UndoEntry entry = m_undoLog.takeLast();
+        switch (entry.kind) {
+        case RowChange::Insert: {
+            const quint64 rowId = m_records.at(entry.position).rowId();
+            indexRowRemoved(m_records.at(entry.position));
+            m_records.removeAt(entry.position);
+            columnsRowRemoved(entry.position);
+            m_changedRowIds.remove(rowId);
+            m_insertedRowIds.remove(rowId);
+            m_deletedRowIds.insert(rowId);
+            break;
+        }
+        case RowChange::Update:
+            indexRowRemoved(m_records.at(entry.position));
+            m_records.replace(entry.position, entry.before);
+            columnsRowReplaced(entry.position);
+            indexRowInserted(entry.before);
+            m_changedRowIds.insert(entry.before.rowId());
+            break;
+        case RowChange::Delete:
+            m_records.insert(entry.position, entry.before);
+            columnsRowInserted(entry.position);
+            indexRowInserted(entry.before);
+            m_deletedRowIds.remove(entry.before.rowId());
+            m_changedRowIds.insert(entry.before.rowId());
+            m_insertedRowIds.insert(entry.before.rowId()); // 可能已从页文件中删除
+            break;
+        }
+        if (entry.kind != RowChange::Insert) {
+            auto chain = m_versions.find(entry.before.rowId());
+            if (chain != m_versions.end()) {
+                if (entry.versionKept && !chain->versions.isEmpty()) chain->versions.removeLast();
+                if (entry.kind == RowChange::Delete) chain->deleted = false;
+                if (chain->versions.isEmpty()) m_versions.erase(chain);
+            }
+        }
+        if (!m_pendingChanges.isEmpty()) m_pendingChanges.removeLast();
+    }
+    markDataDirty();
+    qDebug() << "[表::回滚] 表" << m_name << "撤销到第" << undoLogSize << "项修改。";
+}
+
+// 记录一次行修改，返回新版本的开始时间戳：事务中记入撤销日志，新版本在提交前不可见；
+// 不在事务中时立即以新的提交时间戳生效。被取代或删除的已提交版本放入版本链，不在事务中且没有读快照时不保留
+quint64 xhytable::recordRowWrite(RowChange::Kind kind, int position, quint64 rowId, const xhyrecord& before) {
+    QSharedPointer<xhymvcc> mvcc = m_parentDb ? m_parentDb->mvcc() : QSharedPointer<xhymvcc>();
+    quint64 timestamp = xhymvcc::kUncommitted;
+    if (!m_inTransaction) {
+        timestamp = mvcc ? mvcc->reserveCommit() : 0;
+        m_lastCommitTs = qMax(m_lastCommitTs, timestamp);
+    }
+    UndoEntry entry;
+    entry.kind = kind;
+    entry.position = position;
+    entry.before = before;
+    if (kind != RowChange::Insert && before.beginTs() != xhymvcc::kUncommitted
+        && (m_inTransaction || (mvcc && mvcc->activeSnapshots() > 0))) {
+        m_versions[rowId].versions.append(RowVersion{before, timestamp});
+        entry.versionKept = true;
+    }
+    if (kind == RowChange::Delete) {
+        auto chain = m_versions.find(rowId);
+        if (chain != m_versions.end()) chain->deleted = true;
+    }
+    if (m_inTransaction) {
+        m_txnRowIds.insert(rowId);
+        m_undoLog.append(entry);
+    } else if (mvcc) {
+        mvcc->publish(timestamp);
+    }
+    return timestamp;
+}
+
+const xhyrecord* xhytable::visibleVersion(const VersionChain& chain, quint64 timestamp) {
+    for (int i = chain.versions.size() - 1; i >= 0; --i) {
+        const RowVersion& version = chain.versions.at(i);
+        if (version.record.beginTs() <= timestamp && timestamp < version.endTs) return &version.record;
+    }
+    return nullptr;
+}
+
+xhytable::SnapshotVersions xhytable::snapshotVersions(quint64 timestamp) const {
+    SnapshotVersions result;
+    QVector<QPair<quint64, int>> deleted;
+    for (auto it = m_versions.constBegin(); it != m_versions.constEnd(); ++it) {
+        const xhyrecord* version = visibleVersion(it.value(), timestamp);
+        if (!version) continue;
+        const int index = result.versions.size();
+        result.versions.append(*version);
+        if (it->deleted) deleted.append(qMakePair(it.key(), index));
+        else result.versionOf.insert(it.key(), index);
+    }
+    std::sort(deleted.begin(), deleted.end());
+    for (const auto& row : deleted) result.deletedRows.append(row.second);
+    return result;
+}
+
+bool xhytable::isCurrentAt(const xhysnapshot& snapshot) const {
+    // 旧版本的结束时间戳不超过取代它的版本的开始时间戳，最近一次提交不晚于快照时它们都已不可见
+    return !snapshot.isValid() || (m_txnRowIds.isEmpty() && m_lastCommitTs <= snapshot.timestamp());
+}
+
+QList<xhyrecord> xhytable::visibleRecords(const xhysnapshot& snapshot) const {
+    const QList<xhyrecord>& current = records();
+    if (isCurrentAt(snapshot)) return current;
+    const quint64 timestamp = snapshot.timestamp();
+    const SnapshotVersions versions = snapshotVersions(timestamp);
+    QList<xhyrecord> visible;
+    visible.reserve(current.size());
+    for (const xhyrecord& record : current) {
+        if (record.beginTs() <= timestamp) {
+            visible.append(record);
+        } else {
+            const int index = versions.versionOf.value(record.rowId(), -1);
+            if (index >= 0) visible.append(versions.versions.at(index));
+        }
+    }
+    for (int index : versions.deletedRows) visible.append(versions.versions.at(index));
+    return visible;
+}
+
+void xhytable::collectVersions(quint64 horizon) {
+    for (auto it = m_versions.begin(); it != m_versions.end();) {
+        it->versions.removeIf([horizon](const RowVersion& version) {
+            return version.endTs != xhymvcc::kUncommitted && version.endTs <= horizon;
+        });
+        if (it->versions.isEmpty()) it = m_versions.erase(it);
+        else ++it;
+    }
+}
+
+int xhytable::versionCount() const {
+    int count = 0;
+    for (const VersionChain& chain : m_versions) count += chain.versions.size();
+    return count;
+}
+
+void xhytable::beginSchemaChange() {
+    if (m_inTransaction && m_parentDb) m_parentDb->snapshotBeforeSchemaChange();
+}
+
+QList<RowChange> xhytable::takePendingChanges() {
+    QList<RowChange> changes;
+    changes.swap(m_pendingChanges);
+    return changes;
+}
+
+// 按日志顺序重做一批已提交的变更（直接作用于 m_records，不做约束检查），返回失败的条数
+// 按行号定位，数据文件已部分包含该变更时重做仍然正确；行号 -> 下标的散列表只建一次，
+// 删除的行先标记，最后一次性移除，下标在重做期间保持不变。行号为 0 的旧日志才按整行内容查找
+int xhytable::redoChanges(const QList<RowChange>& changes) {
+    ensureRowsLoaded();
+    QHash<quint64, int> positions;
+    positions.reserve(m_records.size() + changes.size());
+    for (int i = 0; i < m_records.size(); ++i) positions.insert(m_records.at(i).rowId(), i);
+    QVector<bool> removed(m_records.size(), false);
+    int removedCount = 0;
+
+    auto findRecord = [this, &positions, &removed](const RowChange& change, const QMap<QString, QString>& image) -> int {
+        if (change.rowId != 0) return positions.value(change.rowId, -1);
+        for (int i = 0; i < m_records.size(); ++i) {
+            if (!removed.at(i) && m_records.at(i).allValues() == image) return i;
+        }
+        return -1;
+    };
+    auto makeRecord = [this](const RowChange& change, const QMap<QString, QString>& image) {
+        xhyrecord record(m_rowLayout);
+        for (auto it = image.constBegin(); it != image.constEnd(); ++it) {
+            record.insert(it.key(), it.value());
+        }
+        record.setRowId(change.rowId);
+        return record;
+    };
+
+    int failed = 0;
+    for (const RowChange& change : changes) {
+        switch (change.kind) {
+        case RowChange::Insert: {
+            int idx = change.rowId != 0 ? findRecord(change, change.after) : -1;
+            if (idx >= 0) {
+                indexRowRemoved(m_records.at(idx));
+                m_records.replace(idx, makeRecord(change, change.after));
+                columnsRowReplaced(idx);
+            } else {
+                addrecord(makeRecord(change, change.after));
+                idx = m_records.size() - 1;
+                removed.append(false);
+                positions.insert(m_records.at(idx).rowId(), idx);
+            }
+            indexRowInserted(m_records.at(idx));
+            m_changedRowIds.insert(m_records.at(idx).rowId());
+            m_insertedRowIds.insert(m_records.at(idx).rowId());
+            break;
+        }
+        case RowChange::Update: {
+            const int idx = findRecord(change, change.before);
+            if (idx < 0) { ++failed; continue; }
+            xhyrecord updated = makeRecord(change, change.after);
+            if (change.rowId == 0) updated.setRowId(m_records.at(idx).rowId());
+            indexRowRemoved(m_records.at(idx));
+            m_records.replace(idx, updated);
+            columnsRowReplaced(idx);
+            indexRowInserted(updated);
+            m_changedRowIds.insert(updated.rowId());
+            break;
+        }
+        case RowChange::Delete: {
+            const int idx = findRecord(change, change.before);
+            if (idx < 0) { // 按行号找不到说明已删除
+                if (change.rowId == 0) ++failed;
+                continue;
+            }
+            const quint64 rowId = m_records.at(idx).rowId();
+            m_deletedRowIds.insert(rowId);
+            m_changedRowIds.remove(rowId);
+            m_insertedRowIds.remove(rowId);
+            indexRowRemoved(m_records.at(idx));
+            positions.remove(rowId);
+            removed[idx] = true;
+            ++removedCount;
+            break;
+        }
+        }
+        markDataDirty();
+    }
+
+    if (removedCount > 0) {
+        QList<xhyrecord> kept;
+        kept.reserve(m_records.size() - removedCount);
+        for (int i = 0; i < m_records.size(); ++i) {
+            if (!removed.at(i)) kept.append(m_records.at(i));
+        }
+        m_records.swap(kept);
+        rebuildColumns();
+    }
+    return failed;
+}
+
 namespace DefaultValueKeywords {
 const QString SQL_NULL = "##SQL_NULL##"; // 特殊标记代表 SQL NULL
 const QString CURRENT_TIMESTAMP_KW = "##CURRENT_TIMESTAMP##"; // 特殊标记代表 CURRENT_TIMESTAMP
 const QString CURRENT_DATE_KW = "##CURRENT_DATE##";
 }
 bool xhytable::insertData(const QMap<QString, QString>& fieldValuesFromUser) {
+    ensureRowsLoaded();
     qDebug() << "[表::插入数据] 尝试向表 '" << m_name << "' 插入数据，用户提供的值: " << fieldValuesFromUser;
     QMap<QString, QString> valuesToInsert = fieldValuesFromUser; // 创建一个可修改的副本
 
@@ -910,20 +1049,25 @@ bool xhytable::insertData(const QMap<QString, QString>& fieldValuesFromUser) {
         validateRecord(valuesToInsert, nullptr); // nullptr 表示这是 INSERT 操作
 
         // 创建记录对象并用处理后的值填充所有定义的字段
-        xhyrecord new_record_obj;
+        xhyrecord new_record_obj(m_rowLayout);
         for (const xhyfield& fieldDef : m_fields) {
             // 确保记录对象包含表定义的每个字段，即使其值为SQL NULL
             new_record_obj.insert(fieldDef.name(), valuesToInsert.value(fieldDef.name()));
         }
-
-        // 将新记录添加到正确的列表 (事务中是 m_tempRecords，否则是 m_records)
-        QList<xhyrecord>* targetRecordsList = m_inTransaction ? &m_tempRecords : &m_records;
-        if (m_inTransaction && targetRecordsList->isEmpty() && !m_records.isEmpty() && targetRecordsList != &m_records) {
-            // 如果在事务中，并且这是事务中的第一个DML操作，确保 m_tempRecords 是 m_records 的副本
-            *targetRecordsList = m_records;
-            qDebug() << "[表::插入数据] 事务开始，m_tempRecords 已从 m_records 初始化。";
-        }
-        targetRecordsList->append(new_record_obj);
+        new_record_obj.setRowId(m_nextRowId++);
+
+        new_record_obj.setBeginTs(recordRowWrite(RowChange::Insert, m_records.size(), new_record_obj.rowId()));
+        m_records.append(new_record_obj);
+        columnsRowInserted(m_records.size() - 1);
+        indexRowInserted(new_record_obj);
+        markDataDirty();
+        m_changedRowIds.insert(new_record_obj.rowId());
+        m_insertedRowIds.insert(new_record_obj.rowId());
+        RowChange change;
+        change.kind = RowChange::Insert;
+        change.rowId = new_record_obj.rowId();
+        change.after = new_record_obj.allValues();
+        m_pendingChanges.append(change);
 
         qDebug() << "[表::插入数据] 成功插入数据到表 '" << m_name << "'";
         return true;
@@ -935,14 +1079,10 @@ bool xhytable::insertData(const QMap<QString, QString>& fieldValuesFromUser) {
 
 
 int xhytable::updateData(const QMap<QString, QString>& updates_with_expressions, const ConditionNode& conditions) {
+    ensureRowsLoaded();
     qDebug() << "[表::更新数据] 尝试更新表 '" << m_name << "', SET 子句: " << updates_with_expressions;
     int totalAffectedRows = 0;
-    QList<xhyrecord>* targetRecordsList = m_inTransaction ? &m_tempRecords : &m_records;
-
-    if (m_inTransaction && targetRecordsList->isEmpty() && !m_records.isEmpty() && targetRecordsList != &m_records) {
-        *targetRecordsList = m_records;
-        qDebug() << "[表::更新数据] 事务开始，m_tempRecords 已从 m_records 初始化。";
-    }
+    QList<xhyrecord>* targetRecordsList = &m_records;
 
     QList<QPair<int, xhyrecord>> pending_parent_table_updates;
     struct CascadeUpdateTriggerInfo {
@@ -952,10 +1092,15 @@ int xhytable::updateData(const QMap<QString, QString>& updates_with_expressions,
     QList<CascadeUpdateTriggerInfo> cascade_update_triggers;
 
     // --- 阶段 1: 收集父表自身的更新 和 潜在的级联触发信息 ---
-    for (int i = 0; i < targetRecordsList->size(); ++i) {
+    QVector<int> indexedRows; // 有可用索引时只检查候选行
+    const bool byIndex = indexCandidates(conditions, indexedRows);
+    const int scanCount = byIndex ? indexedRows.size() : targetRecordsList->size();
+    const xhypredicate predicate = compilePredicate(conditions);
+    for (int k = 0; k < scanCount; ++k) {
+        const int i = byIndex ? indexedRows.at(k) : k;
         const xhyrecord& originalRecord = targetRecordsList->at(i);
 
-        if (matchConditions(originalRecord, conditions)) {
+        if (predicate.matches(originalRecord)) {
             qDebug() << "  [表::更新数据] 第 " << i << " 行记录符合WHERE条件。PK提示: '"
                      << originalRecord.value(m_primaryKeys.isEmpty() ? (m_fields.isEmpty() ? "" : m_fields.first().name()) : m_primaryKeys.first()) << "'";
 
@@ -1035,7 +1180,7 @@ int xhytable::updateData(const QMap<QString, QString>& updates_with_expressions,
             // 它不应该因为子表的外键而失败，因为子表的级联还没有发生。
             validateRecord(proposedNewValuesFromSet, &originalRecord, false); // 第三个参数 false 表示这不是级联验证
 
-            xhyrecord updatedRecordObject;
+            xhyrecord updatedRecordObject(m_rowLayout);
             for(const xhyfield& fieldDef : m_fields) {
                 updatedRecordObject.insert(fieldDef.name(), proposedNewValuesFromSet.value(fieldDef.name()));
             }
@@ -1065,14 +1210,28 @@ int xhytable::updateData(const QMap<QString, QString>& updates_with_expressions,
         }
     }
 
-    // --- 阶段 2: 应用父表自身的更新到 targetRecordsList (m_tempRecords 或 m_records) ---
+    // --- 阶段 2: 应用父表自身的更新（事务中把原记录记入撤销日志） ---
     int parentRowsUpdatedThisCall = 0;
     for (const auto& update_pair : pending_parent_table_updates) {
-        targetRecordsList->replace(update_pair.first, update_pair.second);
+        xhyrecord updated = update_pair.second;
+        updated.setRowId(targetRecordsList->at(update_pair.first).rowId());
+        RowChange change;
+        change.kind = RowChange::Update;
+        change.rowId = updated.rowId();
+        change.before = targetRecordsList->at(update_pair.first).allValues();
+        change.after = updated.allValues();
+        m_pendingChanges.append(change);
+        m_changedRowIds.insert(updated.rowId());
+        updated.setBeginTs(recordRowWrite(RowChange::Update, update_pair.first, updated.rowId(), targetRecordsList->at(update_pair.first)));
+        indexRowRemoved(targetRecordsList->at(update_pair.first));
+        targetRecordsList->replace(update_pair.first, updated);
+        columnsRowReplaced(update_pair.first);
+        indexRowInserted(updated);
         parentRowsUpdatedThisCall++;
     }
     if (parentRowsUpdatedThisCall > 0) {
-        qDebug() << "[表::更新数据] 表 '" << m_name << "' 中直接更新了 " << parentRowsUpdatedThisCall << " 行记录 (在临时列表)。";
+        markDataDirty();
+        qDebug() << "[表::更新数据] 表 '" << m_name << "' 中直接更新了 " << parentRowsUpdatedThisCall << " 行记录。";
     }
     totalAffectedRows += parentRowsUpdatedThisCall;
 
@@ -1204,20 +1363,21 @@ int xhytable::updateData(const QMap<QString, QString>& updates_with_expressions,
 
 // xhytable.cpp
 int xhytable::deleteData(const ConditionNode& conditions) {
+    ensureRowsLoaded();
     int affectedRows = 0;
-    QList<xhyrecord>* targetRecordsList = m_inTransaction ? &m_tempRecords : &m_records;
-
-    if (m_inTransaction && targetRecordsList->isEmpty() && !m_records.isEmpty() && targetRecordsList != &m_records) { // 修正条件
-        *targetRecordsList = m_records;
-        qDebug() << "[表::删除数据] 事务开始，m_tempRecords 已从 m_records 初始化。";
-    }
+    QList<xhyrecord>* targetRecordsList = &m_records;
 
     QList<int> indicesToRemove;
     QList<xhyrecord> recordsToDeleteForCascadeCheck; // 存储将要删除的记录的副本
 
-    for (int i = 0; i < targetRecordsList->size(); ++i) {
+    QVector<int> indexedRows; // 有可用索引时只检查候选行
+    const bool byIndex = indexCandidates(conditions, indexedRows);
+    const int scanCount = byIndex ? indexedRows.size() : targetRecordsList->size();
+    const xhypredicate predicate = compilePredicate(conditions);
+    for (int k = 0; k < scanCount; ++k) {
+        const int i = byIndex ? indexedRows.at(k) : k;
         const xhyrecord& currentRecord = targetRecordsList->at(i);
-        if (matchConditions(currentRecord, conditions)) {
+        if (predicate.matches(currentRecord)) {
             recordsToDeleteForCascadeCheck.append(currentRecord); // 先收集，用于后续处理
             indicesToRemove.append(i);
         }
@@ -1328,33 +1488,135 @@ int xhytable::deleteData(const ConditionNode& conditions) {
     // 按索引倒序删除，避免因删除导致后续索引失效
     std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<int>());
     for (int index : indicesToRemove) {
+        RowChange change;
+        change.kind = RowChange::Delete;
+        change.rowId = targetRecordsList->at(index).rowId();
+        change.before = targetRecordsList->at(index).allValues();
+        m_pendingChanges.append(change);
+        m_changedRowIds.remove(change.rowId);
+        m_insertedRowIds.remove(change.rowId);
+        m_deletedRowIds.insert(change.rowId);
+        recordRowWrite(RowChange::Delete, index, change.rowId, targetRecordsList->at(index));
+        indexRowRemoved(targetRecordsList->at(index));
         targetRecordsList->removeAt(index);
+        columnsRowRemoved(index);
         affectedRows++;
     }
 
     if (affectedRows > 0) {
+        markDataDirty();
         qDebug() << "[表::删除数据] 表 '" << m_name << "' 中直接删除了 " << affectedRows << " 行。";
     }
     return affectedRows;
 }
 
 
-bool xhytable::selectData(const ConditionNode & conditions, QVector<xhyrecord>& results) const {
+namespace {
+// 扫描 0..n-1，match(i) 返回结果下标，-1 为不满足；结果按 i 的顺序，limit >= 0 时取够即停（可能多出，由调用者截断）
+// 达到 kParallelScanRows 行时各线程按块领取：块按序号递增领取，已领取的块总是前缀，有 limit 时匹配行数够了就不再领取新块
+template <typename Match>
+QVector<int> scanRows(int n, int limit, int parallelDegree, const Match& match) {
+    QVector<int> rows;
+    const int degree = parallelDegree > 0 ? parallelDegree : QThread::idealThreadCount();
+    const int morselCount = (n + xhytable::kScanMorselRows - 1) / xhytable::kScanMorselRows;
+    const int workers = qMin(degree, morselCount);
+    if (n >= xhytable::kParallelScanRows && workers > 1) {
+        QVector<QVector<int>> morselRows(morselCount);
+        QVector<int> workerIds(workers);
+        for (int w = 0; w < workers; ++w) workerIds[w] = w;
+        std::atomic<int> nextMorsel{0};
+        std::atomic<int> matched{0};
+        std::atomic<bool> failed{false};
+        QString error;
+        QMutex errorMutex;
+        QtConcurrent::blockingMap(workerIds, [&](int) {
+            try {
+                while (!failed && (limit < 0 || matched < limit)) {
+                    const int morsel = nextMorsel++;
+                    if (morsel >= morselCount) break;
+                    QVector<int>& out = morselRows[morsel];
+                    const int end = qMin(n, (morsel + 1) * xhytable::kScanMorselRows);
+                    for (int i = morsel * xhytable::kScanMorselRows; i < end; ++i) {
+                        const int row = match(i);
+                        if (row >= 0) out.append(row);
+                    }
+                    matched += out.size();
+                }
+            } catch (const std::runtime_error& e) {
+                QMutexLocker locker(&errorMutex);
+                if (!failed) error = QString::fromStdString(e.what());
+                failed = true;
+            }
+        });
+        if (failed) throw std::runtime_error(error.toStdString());
+        rows.reserve(limit >= 0 ? qMin(limit, matched.load()) : matched.load());
+        for (const QVector<int>& out : morselRows) rows += out;
+    } else {
+        for (int i = 0; i < n; ++i) {
+            const int row = match(i);
+            if (row >= 0) {
+                rows.append(row);
+                if (rows.size() == limit) break;
+            }
+        }
+    }
+    return rows;
+}
+}
+
+bool xhytable::selectData(const ConditionNode & conditions, QVector<xhyrecord>& results, int limit) const {
     results.clear();
-    const QList<xhyrecord>& sourceRecords = m_inTransaction ? m_tempRecords : m_records;
+    xhyresultset rows;
+    if (!selectRows(conditions, rows, limit)) return false;
+    results = rows.materialize();
+    return true;
+}
+
+bool xhytable::selectRows(const ConditionNode& conditions, xhyresultset& result, int limit, const xhysnapshot& snapshot,
+                          int parallelDegree) const {
+    ensureRowsLoaded();
+    // 结果集持有记录列表的隐式共享副本；没有快照时包含本事务的未提交修改
+    const QList<xhyrecord>& sourceRecords = m_records;
+    result = xhyresultset(sourceRecords, QVector<int>());
+    if (limit == 0) return true;
+    QVector<int> rows;
     try {
-        for(const auto& record : sourceRecords) {
-            if(matchConditions(record, conditions)) {
-                results.append(record);
+        const xhypredicate predicate = compilePredicate(conditions);
+        const int n = static_cast<int>(sourceRecords.size());
+        if (!isCurrentAt(snapshot)) {
+            // 快照之后有过修改：逐行取快照可见的版本，不走索引（索引反映的是当前记录）
+            const quint64 timestamp = snapshot.timestamp();
+            const SnapshotVersions versions = snapshotVersions(timestamp);
+            rows = scanRows(n, limit, parallelDegree, [&](int i) {
+                const xhyrecord& record = sourceRecords.at(i);
+                if (record.beginTs() <= timestamp) return predicate.matches(record) ? i : -1;
+                const int index = versions.versionOf.value(record.rowId(), -1);
+                return index >= 0 && predicate.matches(versions.versions.at(index)) ? n + index : -1;
+            });
+            for (int index : versions.deletedRows) {
+                if (limit >= 0 && rows.size() >= limit) break;
+                if (predicate.matches(versions.versions.at(index))) rows.append(n + index);
+            }
+            result = xhyresultset(sourceRecords, versions.versions, rows);
+            result.truncate(limit);
+            return true;
+        }
+        QVector<int> indexedRows;
+        if (indexCandidates(conditions, indexedRows)) {
+            for (int i : indexedRows) {
+                if (predicate.matches(sourceRecords.at(i))) rows.append(i);
+                if (rows.size() == limit) break;
             }
+            result = xhyresultset(sourceRecords, rows);
+            return true;
         }
+        rows = scanRows(n, limit, parallelDegree, [&](int i) { return predicate.matches(sourceRecords.at(i)) ? i : -1; });
     } catch (const std::runtime_error& e) {
         qWarning() << "查询表 '" << m_name << "' 数据时出错: " << e.what();
-
-
-
         return false;
     }
+    result = xhyresultset(sourceRecords, rows);
+    result.truncate(limit);
     return true;
 }
 
@@ -1366,7 +1628,7 @@ void xhytable::validateRecord(const QMap<QString, QString>& valuesToValidate,
              << (isBeingValidatedDueToCascade ? ", 由级联触发)" : ")");
 
 
-    const QList<xhyrecord>& recordsToCheckAgainst = m_inTransaction ? m_tempRecords : m_records;
+    ensureRowsLoaded();
 
     // 步骤 1: 字段级固有约束检查 (NOT NULL, 数据类型, ENUM)
     for (const xhyfield& fieldDef : m_fields) {
@@ -1409,11 +1671,13 @@ void xhytable::validateRecord(const QMap<QString, QString>& valuesToValidate,
         }
     }
 
+    // 约束键通过哈希索引探测；更新时排除被更新的行自身
+    const quint64 selfRowId = original_record_for_update ? original_record_for_update->rowId() : 0;
+
     // 步骤 2: 主键唯一性检查
     if (!m_primaryKeys.isEmpty()) {
-        QMap<QString, QString> pkValuesInCurrentOp;
+        QStringList pkValuesInCurrentOp;
         bool pkHasNull = false;
-        bool pkFieldsWereModified = false;
 
         for (const QString& pkFieldName : m_primaryKeys) {
             // 确保从 valuesToValidate 获取值，因为它包含了最新的提议值
@@ -1427,37 +1691,13 @@ void xhytable::validateRecord(const QMap<QString, QString>& valuesToValidate,
             if (pkFieldValue.isNull() || pkFieldValue.compare("NULL", Qt::CaseInsensitive) == 0) {
                 pkHasNull = true; break;
             }
-            pkValuesInCurrentOp[pkFieldName] = pkFieldValue;
-
-            if (original_record_for_update != nullptr) {
-                if (original_record_for_update->value(pkFieldName).compare(pkValuesInCurrentOp.value(pkFieldName), Qt::CaseSensitive) != 0) {
-                    pkFieldsWereModified = true;
-                }
-            }
+            pkValuesInCurrentOp << pkFieldValue;
         }
         if (pkHasNull) throw std::runtime_error("主键字段 (" + m_primaryKeys.join(", ").toStdString() + ") 不能包含NULL值。");
 
-        int matchCount = 0;
-        for (const xhyrecord& existingRecord : recordsToCheckAgainst) {
-            // 如果是更新操作，并且当前检查的 existingRecord 就是正在被更新的原始记录，则跳过与自身的比较，
-            // 除非主键字段本身被修改了（这种情况下，新主键值不能与任何其他记录冲突）。
-            if (original_record_for_update != nullptr && (&existingRecord == original_record_for_update) && !pkFieldsWereModified) {
-                continue;
-            }
-
-            bool currentExistingMatchesProposedPk = true;
-            for (const QString& pkFieldName : m_primaryKeys) {
-                if (existingRecord.value(pkFieldName).compare(pkValuesInCurrentOp.value(pkFieldName), Qt::CaseSensitive) != 0) {
-                    currentExistingMatchesProposedPk = false;
-                    break;
-                }
-            }
-            if (currentExistingMatchesProposedPk) {
-                // 无论插入还是更新（且主键改变），只要找到一个匹配就是冲突
-                QStringList pkValsForError;
-                for(const QString& pkName : m_primaryKeys) pkValsForError << pkValuesInCurrentOp.value(pkName);
-                throw std::runtime_error("主键冲突: 值 (" + pkValsForError.join(",").toStdString() + ") 已存在。");
-            }
+        if (primaryKeyIndex()->contains(xhykeyindex::keyOf(pkValuesInCurrentOp), selfRowId)) {
+            // 无论插入还是更新，只要其他行已有相同主键就是冲突
+            throw std::runtime_error("主键冲突: 值 (" + pkValuesInCurrentOp.join(",").toStdString() + ") 已存在。");
         }
     }
 
@@ -1466,9 +1706,8 @@ void xhytable::validateRecord(const QMap<QString, QString>& valuesToValidate,
     for (auto it_uq_constr = m_uniqueConstraints.constBegin(); it_uq_constr != m_uniqueConstraints.constEnd(); ++it_uq_constr) {
         const QString& constraintName = it_uq_constr.key();
         const QList<QString>& uniqueFields = it_uq_constr.value();
-        QMap<QString, QString> currentUniqueValues;
+        QStringList currentUniqueValues;
         bool uniqueKeyHasNull = false;
-        bool uniqueKeyFieldsWereModified = false;
 
         for (const QString& uqFieldName : uniqueFields) {
             QString uqFieldValue;
@@ -1481,37 +1720,14 @@ void xhytable::validateRecord(const QMap<QString, QString>& valuesToValidate,
             if (uqFieldValue.isNull() || uqFieldValue.compare("NULL", Qt::CaseInsensitive) == 0) {
                 uniqueKeyHasNull = true; break;
             }
-            currentUniqueValues[uqFieldName] = uqFieldValue;
-            if (original_record_for_update != nullptr) {
-                if (original_record_for_update->value(uqFieldName).compare(currentUniqueValues.value(uqFieldName), Qt::CaseSensitive) != 0) {
-                    uniqueKeyFieldsWereModified = true;
-                }
-            }
+            currentUniqueValues << uqFieldValue;
         }
         if (uniqueKeyHasNull) continue; // SQL标准：唯一约束允许列中包含多个NULL（除非唯一键是主键）
 
-        for (const xhyrecord& existingRecord : recordsToCheckAgainst) {
-            if (original_record_for_update != nullptr && (&existingRecord == original_record_for_update) && !uniqueKeyFieldsWereModified) {
-                continue;
-            }
-            bool currentExistingMatchesProposedUQ = true;
-            bool existingUqKeyInDbHasNull = false;
-            for (const QString& uqFieldName : uniqueFields) {
-                if (existingRecord.value(uqFieldName).isNull() ||
-                    existingRecord.value(uqFieldName).compare("NULL", Qt::CaseInsensitive) == 0) {
-                    existingUqKeyInDbHasNull = true; break;
-                }
-                if (existingRecord.value(uqFieldName).compare(currentUniqueValues.value(uqFieldName), Qt::CaseSensitive) != 0) {
-                    currentExistingMatchesProposedUQ = false; break;
-                }
-            }
-            if (existingUqKeyInDbHasNull) continue;
-            if (currentExistingMatchesProposedUQ) {
-                QStringList uqValsForError;
-                for(const QString& uqName : uniqueFields) uqValsForError << currentUniqueValues.value(uqName);
-                throw std::runtime_error("唯一约束 '" + constraintName.toStdString() + "' 冲突: 值 (" +
-                                         uqValsForError.join(",").toStdString() + ") 已存在。");
-            }
+        // 已有记录中含 NULL 的行不在索引中，不参与比较
+        if (uniqueKeyIndex(constraintName)->contains(xhykeyindex::keyOf(currentUniqueValues), selfRowId)) {
+            throw std::runtime_error("唯一约束 '" + constraintName.toStdString() + "' 冲突: 值 (" +
+                                     currentUniqueValues.join(",").toStdString() + ") 已存在。");
         }
     }
 
@@ -1546,8 +1762,22 @@ void xhytable::validateRecord(const QMap<QString, QString>& valuesToValidate,
             }
 
             bool foundMatchingParentKey = false;
-            // **关键修改**: 查询父表的当前事务状态记录 (m_tempRecords if in transaction)
-            const QList<xhyrecord>& parentRecords = referencedTable->records(); // 使用 records() 而不是 getCommittedRecords()
+            // 引用列恰好是父表的主键或 UNIQUE 约束时按哈希索引查找
+            // 子表值含空串时仍逐行比较：父表 NULL 的文本也是空串，而 UNIQUE 索引不收录 NULL 行
+            const xhykeyindex* parentKeyIndex = nullptr;
+            bool childFkHasEmpty = false;
+            for (const QString& value : childFkValues) childFkHasEmpty = childFkHasEmpty || value.isEmpty();
+            if (!childFkHasEmpty) parentKeyIndex = referencedTable->keyIndexCovering(fkDef.columnMappings.values());
+            if (parentKeyIndex) {
+                QStringList parentKeyValues;
+                for (const QString& parentColumnName : parentKeyIndex->columns()) {
+                    parentKeyValues << childFkValues.value(fkDef.columnMappings.key(parentColumnName));
+                }
+                foundMatchingParentKey = parentKeyIndex->contains(xhykeyindex::keyOf(parentKeyValues));
+            }
+
+            // **关键修改**: 查询父表的当前记录（含本事务的未提交修改）
+            const QList<xhyrecord>& parentRecords = parentKeyIndex ? QList<xhyrecord>() : referencedTable->records(); // 使用 records() 而不是 getCommittedRecords()
 
             for (const xhyrecord& parentRecord : parentRecords) {
                 bool allParentColsMatch = true;
@@ -1580,32 +1810,23 @@ void xhytable::validateRecord(const QMap<QString, QString>& valuesToValidate,
     }
 
     // 步骤 5: 所有 CHECK 约束检查
-    QVariantMap recordDataForCheck;
-    for(const xhyfield& fieldDef : m_fields) {
-        const QString& fieldName = fieldDef.name();
-        QString valueStr;
-        if (valuesToValidate.contains(fieldName)) {
-            valueStr = valuesToValidate.value(fieldName);
-        } else if (original_record_for_update) {
-            valueStr = original_record_for_update->value(fieldName);
-        } else {
-            valueStr = QString();
-        }
-        recordDataForCheck[fieldName] = convertToTypedValue(valueStr, fieldDef.type());
-    }
-    for(const QString& key_in_values : valuesToValidate.keys()){
-        if(!recordDataForCheck.contains(key_in_values)){
-            const xhyfield* fieldDef = get_field(key_in_values);
-            if(fieldDef) recordDataForCheck[key_in_values] = convertToTypedValue(valuesToValidate.value(key_in_values), fieldDef->type());
-            else recordDataForCheck[key_in_values] = valuesToValidate.value(key_in_values);
-        }
-    }
-
     if (!m_checkConstraints.isEmpty()) {
+        QVector<QVariant> valuesForCheck;
+        valuesForCheck.reserve(m_fields.size());
+        for(const xhyfield& fieldDef : m_fields) {
+            const QString& fieldName = fieldDef.name();
+            QString valueStr;
+            if (valuesToValidate.contains(fieldName)) {
+                valueStr = valuesToValidate.value(fieldName);
+            } else if (original_record_for_update) {
+                valueStr = original_record_for_update->value(fieldName);
+            }
+            valuesForCheck.append(convertToTypedValue(valueStr, fieldDef.type()));
+        }
         for (auto it_check = m_checkConstraints.constBegin(); it_check != m_checkConstraints.constEnd(); ++it_check) {
             const QString& constraintName = it_check.key();
             const QString& checkExpr = it_check.value();
-            if (!evaluateCheckExpression(checkExpr, recordDataForCheck)) {
+            if (!evaluateCheckConstraint(constraintName, valuesForCheck)) {
                 QString opType = original_record_for_update ? "更新" : "插入";
                 QString errorMsg = QString("%1操作失败: 记录违反了 CHECK 约束 '%2' (表达式: %3).")
                                        .arg(opType, constraintName, checkExpr);
@@ -1840,7 +2061,7 @@ bool xhytable::checkConstraint(const xhyfield& field, const QString& value) cons
     return true;
 }
 
-void xhytable::rebuildIndexes() { /* 占位符 */ }
+void xhytable::rebuildIndexes() { invalidateRowIndexes(); } // 下次使用时按记录重建
 QVariant xhytable::convertToTypedValue(const QString& strValue, xhyfield::datatype type) const {
     if (strValue.isNull() || strValue.compare("NULL", Qt::CaseInsensitive) == 0) {
         qDebug() << "[convertToTypedValue] Input '" << strValue << "' is NULL, returning invalid QVariant.";
@@ -1917,223 +2138,746 @@ QVariant xhytable::convertToTypedValue(const QString& strValue, xhyfield::dataty
 
 bool xhytable::compareQVariants(const QVariant& left, const QVariant& right, const QString& op) const {
     // IS NULL 和 IS NOT NULL 通常在 matchConditions 中由调用者直接处理，因为它们是单操作数
-    // 但为了健壮性，如果它们被传到这里：
-    if (op == "IS NULL") {
-        bool isLeftNull = !left.isValid() || left.isNull();
-        qDebug() << "[compareQVariants] Op: IS NULL, Left: " << left << " (isNull:" << isLeftNull << ") -> " << isLeftNull;
-        return isLeftNull;
-    }
-    if (op == "IS NOT NULL") {
-        bool isLeftNotNull = left.isValid() && !left.isNull();
-        qDebug() << "[compareQVariants] Op: IS NOT NULL, Left: " << left << " (isNotNull:" << isLeftNotNull << ") -> " << isLeftNotNull;
-        return isLeftNotNull;
-    }
-
-    // 对于二元操作符，如果任一方是SQL NULL，则结果通常是false (UNKNOWN)
-    if (!left.isValid() || left.isNull() || !right.isValid() || right.isNull()) {
-        qDebug() << "[compareQVariants] One or both operands are NULL. Left valid:" << left.isValid() << "isNull:" << left.isNull()
-        << "Right valid:" << right.isValid() << "isNull:" << right.isNull() << "Op:" << op << "-> returning false";
+    if (op == "IS NULL") return !left.isValid() || left.isNull();
+    if (op == "IS NOT NULL") return left.isValid() && !left.isNull();
+    const xhypredicate::Op compareOp = xhypredicate::opFromString(op);
+    if (compareOp == xhypredicate::NoOp) {
+        qWarning() << "[compareQVariants] Unhandled comparison or operator '" << op << "' not supported.";
         return false;
     }
+    return xhypredicate::compareVariants(left, right, compareOp);
+}
 
-    // 使用 typeId() 获取 QVariant 的内部类型 ID
-    int leftTypeId = left.typeId();
-    int rightTypeId = right.typeId();
-
-    qDebug() << "[compareQVariants] Left: " << left.toString() << " (TypeID:" << leftTypeId << ", Name:" << left.typeName() << ")"
-             << " Op: '" << op << "' "
-             << "Right: " << right.toString() << " (TypeID:" << rightTypeId << ", Name:" << right.typeName() << ")";
-
-    // 优先处理原生数字类型之间的精确比较
-    if ((leftTypeId == QMetaType::Int || leftTypeId == QMetaType::LongLong || leftTypeId == QMetaType::ULongLong) &&
-        (rightTypeId == QMetaType::Int || rightTypeId == QMetaType::LongLong || rightTypeId == QMetaType::ULongLong)) {
-        qlonglong l_ll = left.toLongLong();
-        qlonglong r_ll = right.toLongLong();
-        qDebug() << "  Integer Comparison Path: l_ll=" << l_ll << ", r_ll=" << r_ll;
-        if (op == "=") return l_ll == r_ll;
-        if (op == "!=" || op == "<>") return l_ll != r_ll;
-        if (op == ">") return l_ll > r_ll;
-        if (op == "<") return l_ll < r_ll;
-        if (op == ">=") return l_ll >= r_ll;
-        if (op == "<=") return l_ll <= r_ll;
-    }
-    // 浮点数或可转换为浮点数的类型之间的比较
-    else if (left.canConvert<double>() && right.canConvert<double>()) {
-        bool lok, rok;
-        double l_double = left.toDouble(&lok);
-        double r_double = right.toDouble(&rok);
-        qDebug() << "  Numeric Convertible Path: l_double=" << l_double << "(ok:" << lok << ")"
-                 << ", r_double=" << r_double << "(ok:" << rok << ")";
-        if (lok && rok) { // 确保双方都成功转换为double
-            // 检查是否实际上是整数的比较（避免不必要的浮点精度问题）
-            // 这种情况应该被上面的分支覆盖，但作为双重检查
-            bool leftIsActuallyInt = (leftTypeId == QMetaType::Int || leftTypeId == QMetaType::LongLong || leftTypeId == QMetaType::ULongLong);
-            bool rightIsActuallyInt = (rightTypeId == QMetaType::Int || rightTypeId == QMetaType::LongLong || rightTypeId == QMetaType::ULongLong);
-
-            if(leftIsActuallyInt && rightIsActuallyInt && qAbs(l_double - left.toLongLong()) < 0.0000001 && qAbs(r_double - right.toLongLong()) < 0.0000001){
-                qlonglong l_ll_f = left.toLongLong();
-                qlonglong r_ll_f = right.toLongLong();
-                qDebug() << "    Integer Sub-Path (from float convert): l_ll=" << l_ll_f << ", r_ll=" << r_ll_f;
-                if (op == "=") return l_ll_f == r_ll_f;
-                if (op == "!=" || op == "<>") return l_ll_f != r_ll_f;
-                // ... 其他操作符 ...
-                if (op == ">") return l_ll_f > r_ll_f;
-                if (op == "<") return l_ll_f < r_ll_f;
-                if (op == ">=") return l_ll_f >= r_ll_f;
-                if (op == "<=") return l_ll_f <= r_ll_f;
-            } else { // 至少一个是真正的浮点数，或从字符串转来的数字
-                qDebug() << "    Floating Point Comparison Sub-Path: l_double=" << l_double << ", r_double=" << r_double;
-                const double epsilon = 0.000001;
-                if (op == "=") return qAbs(l_double - r_double) < epsilon;
-                if (op == "!=" || op == "<>") return qAbs(l_double - r_double) >= epsilon;
-                if (op == ">") return l_double > r_double && qAbs(l_double - r_double) >= epsilon;
-                if (op == "<") return l_double < r_double && qAbs(l_double - r_double) >= epsilon;
-                if (op == ">=") return l_double > r_double || qAbs(l_double - r_double) < epsilon;
-                if (op == "<=") return l_double < r_double || qAbs(l_double - r_double) < epsilon;
-            }
+
+bool xhytable::matchConditions(const xhyrecord& record, const ConditionNode& condition) const {
+    return compilePredicate(condition).matches(record);
+}
+
+// 字段按 get_field（不区分大小写）确定类型，行值按条件中的原样列名在布局中定位，与逐行解释时一致
+xhypredicate xhytable::compilePredicate(const ConditionNode& condition) const {
+    return xhypredicate::compile(condition, m_rowLayout, [this](const QString& fieldName) {
+        xhypredicate::Column column;
+        column.name = fieldName;
+        const xhyfield* fieldDef = get_field(fieldName);
+        column.found = fieldDef != nullptr;
+        if (fieldDef) {
+            column.type = fieldDef->type();
         } else {
-            qWarning() << "  Numeric conversion failed: left_ok=" << lok << ", right_ok=" << rok << ". Falling to string comparison.";
-            // 如果数字转换失败，退回到字符串比较
-        }
-    }
-    // 日期比较
-    else if (leftTypeId == QMetaType::QDate && rightTypeId == QMetaType::QDate) {
-        QDate l_date = left.toDate(); QDate r_date = right.toDate();
-        qDebug() << "  Date Comparison Path: left_date=" << l_date.toString("yyyy-MM-dd") << ", right_date=" << r_date.toString("yyyy-MM-dd");
-        if (op == "=") return l_date == r_date; if (op == "!=" || op == "<>") return l_date != r_date;
-        if (op == ">") return l_date > r_date;  if (op == "<") return l_date < r_date;
-        if (op == ">=") return l_date >= r_date; if (op == "<=") return l_date <= r_date;
-    }
-    // 日期时间比较
-    else if (leftTypeId == QMetaType::QDateTime && rightTypeId == QMetaType::QDateTime) {
-        QDateTime l_dt = left.toDateTime(); QDateTime r_dt = right.toDateTime();
-        qDebug() << "  DateTime Comparison Path: left_dt=" << l_dt.toString(Qt::ISODate) << ", right_dt=" << r_dt.toString(Qt::ISODate);
-        if (op == "=") return l_dt == r_dt; if (op == "!=" || op == "<>") return l_dt != r_dt;
-        if (op == ">") return l_dt > r_dt;  if (op == "<") return l_dt < r_dt;
-        if (op == ">=") return l_dt >= r_dt; if (op == "<=") return l_dt <= r_dt;
-    }
-    // 布尔比较
-    else if (leftTypeId == QMetaType::Bool && rightTypeId == QMetaType::Bool) {
-        bool l_bool = left.toBool(); bool r_bool = right.toBool();
-        qDebug() << "  Bool Comparison Path: left_bool=" << l_bool << ", right_bool=" << r_bool;
-        if (op == "=") return l_bool == r_bool;
-        if (op == "!=" || op == "<>") return l_bool != r_bool;
-        // 布尔值不支持 >, < 等
-        qDebug() << "    Unsupported operator '" << op << "' for bool comparison.";
-        return false;
-    }
+            column.error = QString("在表 '%1' 中未找到字段: %2").arg(m_name, fieldName);
+        }
+        return column;
+    });
+}
 
-    // 如果以上类型都不匹配，或者数字转换失败，最后尝试字符串比较
-    // （注意：如果上面数字转换失败，lok或rok为false，会直接跳到这里）
-    // 如果一个明确是数字类型，另一个是字符串，标准SQL通常会尝试将字符串转为数字，
-    // 或者如果无法转换则类型不匹配。这里的实现是，如果不能按数字比较，就按字符串比较。
-    // 这可能需要根据您期望的隐式转换规则调整。
+void xhytable::setOption(const QString& key, const QString& value) {
+    beginSchemaChange();
+    m_options.insert(key.toLower(), value);
+    rebuildColumns();
+    markSchemaDirty();
+}
 
-    QString sLeft = left.toString();
-    QString sRight = right.toString();
-    qDebug() << "  String Comparison Path (Fallback or Explicit String Types): sLeft='" << sLeft << "', sRight='" << sRight << "'";
+void xhytable::rebuildColumns() {
+    if (isColumnar()) m_columnStore.rebuild(m_records, m_rowLayout);
+    else m_columnStore.clear();
+}
 
-    Qt::CaseSensitivity cs = Qt::CaseSensitive; // 标准SQL字符串比较通常区分大小写
-    // Qt::CaseSensitivity cs = Qt::CaseInsensitive; // 如果您的字段设计为不区分大小写
+// 列向量与 m_records 逐行同步；对不上时（例如加载路径直接设置了表选项）整体重建一次
+void xhytable::columnsRowInserted(int position) {
+    if (!isColumnar()) return;
+    if (!m_columnStore.isCurrent(m_rowLayout, m_records.size() - 1)) rebuildColumns();
+    else m_columnStore.insert(position, m_records.at(position));
+}
 
-    if (op == "=") return sLeft.compare(sRight, cs) == 0;
-    if (op == "!=" || op == "<>") return sLeft.compare(sRight, cs) != 0;
-    if (op == ">") return sLeft.compare(sRight, cs) > 0;
-    if (op == "<") return sLeft.compare(sRight, cs) < 0;
-    if (op == ">=") return sLeft.compare(sRight, cs) >= 0;
-    if (op == "<=") return sLeft.compare(sRight, cs) <= 0;
+void xhytable::columnsRowReplaced(int position) {
+    if (!isColumnar()) return;
+    if (!m_columnStore.isCurrent(m_rowLayout, m_records.size())) rebuildColumns();
+    else m_columnStore.replace(position, m_records.at(position));
+}
 
-    qWarning() << "[compareQVariants] Unhandled comparison or operator '" << op << "' not supported for these types. "
-               << "Left Type:" << left.typeName() << ", Right Type:" << right.typeName();
-    return false;
+void xhytable::columnsRowRemoved(int position) {
+    if (!isColumnar()) return;
+    if (!m_columnStore.isCurrent(m_rowLayout, m_records.size() + 1)) rebuildColumns();
+    else m_columnStore.remove(position);
 }
 
+bool xhytable::selectRowIndexes(const ConditionNode& conditions, QVector<int>& rows, int limit) const {
+    if (!isColumnar() || m_inTransaction) return false;
+    ensureRowsLoaded();
+    if (!m_columnStore.isCurrent(m_rowLayout, m_records.size())) return false; // 没有记录、未建立过列向量
+    QVector<quint8> mask;
+    try {
+        mask = evaluateColumnar(conditions);
+    } catch (const std::runtime_error& e) {
+        qWarning() << "按列查询表 '" << m_name << "' 时出错，改为逐行查询: " << e.what();
+        return false;
+    }
+    rows.clear();
+    for (int i = 0; i < mask.size() && rows.size() != limit; ++i) {
+        if (mask.at(i)) rows.append(i);
+    }
+    return true;
+}
 
-// matchConditions 函数保持您提供的版本（已移除 isNegated 相关逻辑）
-bool xhytable::matchConditions(const xhyrecord& record, const ConditionNode& condition) const {
-    bool result;
+// 按列求值条件树，返回每行是否满足；只有整数/浮点列上的比较按列向量计算，其余条件按编译后的谓词逐行求值
+QVector<quint8> xhytable::evaluateColumnar(const ConditionNode& condition) const {
+    const int n = m_records.size();
     switch (condition.type) {
     case ConditionNode::EMPTY:
-        return true;
-    case ConditionNode::LOGIC_OP:
-        if (condition.children.isEmpty()) {
-            return condition.logicOp.compare("AND", Qt::CaseInsensitive) == 0;
+        return QVector<quint8>(n, 1);
+    case ConditionNode::LOGIC_OP: {
+        const bool isAnd = condition.logicOp.compare("AND", Qt::CaseInsensitive) == 0;
+        if (!isAnd && condition.logicOp.compare("OR", Qt::CaseInsensitive) != 0 && !condition.children.isEmpty()) {
+            throw std::runtime_error("未知逻辑运算符: " + condition.logicOp.toStdString());
         }
-        if (condition.logicOp.compare("AND", Qt::CaseInsensitive) == 0) {
-            result = true;
-            for (const auto& child : condition.children) {
-                if (!matchConditions(record, child)) { result = false; break; }
-            }
-        } else if (condition.logicOp.compare("OR", Qt::CaseInsensitive) == 0) {
-            result = false;
-            for (const auto& child : condition.children) {
-                if (matchConditions(record, child)) { result = true; break; }
+        QVector<quint8> result(n, isAnd ? 1 : 0);
+        for (const auto& child : condition.children) {
+            const QVector<quint8> childMask = evaluateColumnar(child);
+            for (int i = 0; i < n; ++i) {
+                result[i] = isAnd ? (result[i] && childMask[i]) : (result[i] || childMask[i]);
             }
-        } else {
-            throw std::runtime_error("未知逻辑运算符: " + condition.logicOp.toStdString());
         }
-        break;
-    case ConditionNode::NEGATION_OP:
+        return result;
+    }
+    case ConditionNode::NEGATION_OP: {
         if (condition.children.isEmpty()) throw std::runtime_error("NOT 操作符后缺少条件");
-        result = !matchConditions(record, condition.children.first());
+        QVector<quint8> result = evaluateColumnar(condition.children.first());
+        for (quint8& v : result) v = !v;
+        return result;
+    }
+    case ConditionNode::COMPARISON_OP:
         break;
-    case ConditionNode::COMPARISON_OP: {
-        const ComparisonDetails& cd = condition.comparison;
-        if (!has_field(cd.fieldName)) {
-            throw std::runtime_error("在表 '" + m_name.toStdString() + "' 中未找到字段: " + cd.fieldName.toStdString());
+    default:
+        throw std::runtime_error("未知的条件节点类型");
+    }
+
+    const ComparisonDetails& cd = condition.comparison;
+    const xhyfield* fieldDef = get_field(cd.fieldName);
+    if (!fieldDef) {
+        throw std::runtime_error("在表 '" + m_name.toStdString() + "' 中未找到字段: " + cd.fieldName.toStdString());
+    }
+    QVector<quint8> result(n, 0);
+    const xhypredicate rowPredicate = compilePredicate(condition);
+    auto rowByRow = [&](int i) { result[i] = rowPredicate.matches(m_records.at(i)) ? 1 : 0; };
+
+    const QString& op = cd.operation;
+    const bool isNullOp = op.compare("IS NULL", Qt::CaseInsensitive) == 0;
+    const bool isNotNullOp = op.compare("IS NOT NULL", Qt::CaseInsensitive) == 0;
+    const bool isBinaryOp = op == "=" || op == "!=" || op == "<>" || op == ">" || op == "<" || op == ">=" || op == "<=";
+    const int ordinal = m_rowLayout->indexOf(cd.fieldName);
+    const xhyrecordlayout::StorageType storage = storageTypeFor(fieldDef->type());
+    if (ordinal < 0 || m_rowLayout->type(ordinal) != storage
+        || (storage != xhyrecordlayout::IntColumn && storage != xhyrecordlayout::DoubleColumn)
+        || !(isNullOp || isNotNullOp || isBinaryOp)) {
+        for (int i = 0; i < n; ++i) rowByRow(i);
+        return result;
+    }
+
+    // 右操作数只解析一次；比较规则与 compareQVariants 相同
+    const QVariant& right = cd.value;
+    const bool rightNull = !right.isValid() || right.isNull();
+    const int rightType = right.typeId();
+    const bool intMode = storage == xhyrecordlayout::IntColumn
+                         && (rightType == QMetaType::Int || rightType == QMetaType::LongLong || rightType == QMetaType::ULongLong);
+    bool floatOk = false;
+    const double rightDouble = (!intMode && right.canConvert<double>()) ? right.toDouble(&floatOk) : 0.0;
+    const qlonglong rightInt = intMode ? right.toLongLong() : 0;
+    if (isBinaryOp && !rightNull && !intMode && !floatOk) {
+        for (int i = 0; i < n; ++i) rowByRow(i);
+        return result;
+    }
+
+    const xhycolumnstore::Column& column = m_columnStore.column(ordinal);
+    const double epsilon = 0.000001;
+    for (int i = 0; i < n; ++i) {
+        const quint8 flags = column.flags.at(i);
+        if (flags & xhycolumnstore::Column::IsNull) {
+            result[i] = isNullOp ? 1 : 0;
+            continue;
+        }
+        if (!(flags & xhycolumnstore::Column::IsNative)) {
+            rowByRow(i); // 文本单元（例如未通过类型解析的值）按原逻辑处理
+            continue;
         }
-        xhyfield::datatype schemaType = getFieldType(cd.fieldName);
-        QVariant actualValue = convertToTypedValue(record.value(cd.fieldName), schemaType); // 使用增强的转换函数
+        if (isNullOp || isNotNullOp) {
+            result[i] = isNotNullOp ? 1 : 0;
+            continue;
+        }
+        if (rightNull) continue;
+        bool match = false;
+        if (intMode) {
+            const qlonglong l = column.ints.at(i);
+            if (op == "=") match = l == rightInt;
+            else if (op == "!=" || op == "<>") match = l != rightInt;
+            else if (op == ">") match = l > rightInt;
+            else if (op == "<") match = l < rightInt;
+            else if (op == ">=") match = l >= rightInt;
+            else match = l <= rightInt;
+        } else {
+            const double l = column.numbers.at(i);
+            const bool equal = qAbs(l - rightDouble) < epsilon;
+            if (op == "=") match = equal;
+            else if (op == "!=" || op == "<>") match = !equal;
+            else if (op == ">") match = l > rightDouble && !equal;
+            else if (op == "<") match = l < rightDouble && !equal;
+            else if (op == ">=") match = l > rightDouble || equal;
+            else match = l < rightDouble || equal;
+        }
+        result[i] = match ? 1 : 0;
+    }
+    return result;
+}
 
-        qDebug() << "[matchConditions] Field:" << cd.fieldName << "Op:" << cd.operation << "RecValRaw:" << record.value(cd.fieldName)
-                 << "ActualValTyped:" << actualValue << "CompVal:" << cd.value;
+QVariant xhytable::aggregateColumn(const QString& function, const QString& column, const QVector<int>& rows) const {
+    if (function == "COUNT" && (column == "*" || column.isEmpty())) {
+        return rows.size();
+    }
+    if (column.isEmpty() && function != "COUNT") {
+        return QVariant();
+    }
+    ensureRowsLoaded();
+    const int ordinal = m_rowLayout->indexOf(column);
+    if (ordinal < 0) { // 与逐行计算一致：不存在的列全部视为 NULL
+        return function == "COUNT" ? QVariant(0) : QVariant();
+    }
+    const xhycolumnstore::Column& col = m_columnStore.column(ordinal);
+    const quint8* flags = col.flags.constData();
+    const double* numbers = col.numbers.constData();
+
+    if (function == "COUNT") {
+        int count = 0;
+        for (int row : rows) {
+            if (flags[row] & xhycolumnstore::Column::HasText) ++count;
+        }
+        return count;
+    }
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    int count = 0;
+    for (int row : rows) {
+        if (!(flags[row] & xhycolumnstore::Column::IsNumber)) continue;
+        const double v = numbers[row];
+        sum += v;
+        min = qMin(min, v);
+        max = qMax(max, v);
+        ++count;
+    }
+    if (count == 0) return QVariant();
+    if (function == "SUM") return QVariant(sum);
+    if (function == "AVG") return QVariant(std::round(sum / count * 100) / 100); // 四舍五入到两位小数
+    if (function == "MIN") return QVariant(min);
+    if (function == "MAX") return QVariant(max);
+    return QVariant();
+}
 
+namespace {
+// 索引扫描区间：从 from 开始按序扫描，首列不再满足 within 时停止
+struct IndexRange {
+    xhybtree::KeyPart from;
+    bool fromInclusive = true;
+    std::function<bool(const xhybtree::KeyPart&)> within;
+};
+
+// 比较条件在操作数上的区间；IN 的每个值是一个点区间
+struct OperandInterval {
+    QVariant lower, upper;
+    bool hasLower = false, hasUpper = false;
+    bool lowerStrict = false, upperStrict = false;
+};
+
+const double kIndexSlack = 2e-6;                      // compareQVariants 的浮点容差为 1e-6，区间放宽后由 matchConditions 精确判断
+const double kExactIntegerLimit = 4503599627370496.0; // 2^52，超出后整数与 double 的比较不再精确
+
+IndexRange kindRange(xhybtree::KeyPart::Kind kind) {
+    IndexRange range;
+    range.from.kind = kind;
+    range.from.i = std::numeric_limits<qint64>::min();
+    range.from.d = -std::numeric_limits<double>::infinity();
+    range.within = [kind](const xhybtree::KeyPart& part) { return part.kind == kind; };
+    return range;
+}
 
-        if (cd.operation.compare("IS NULL", Qt::CaseInsensitive) == 0) {
-            result = !actualValue.isValid() || actualValue.isNull();
-        } else if (cd.operation.compare("IS NOT NULL", Qt::CaseInsensitive) == 0) {
-            result = actualValue.isValid() && !actualValue.isNull();
-        } else if (cd.operation.compare("IN", Qt::CaseInsensitive) == 0 || cd.operation.compare("NOT IN", Qt::CaseInsensitive) == 0) {
-            bool found = false;
-            if (!cd.valueList.isEmpty()) {
-                for (const QVariant& listItem : cd.valueList) {
-                    qDebug() << "  IN check: actual=" << actualValue << "vs list_item=" << listItem;
-                    if (compareQVariants(actualValue, listItem, "=")) { // IN 使用等号比较
-                        found = true; break;
-                    }
-                }
-            }
-            result = (cd.operation.compare("IN", Qt::CaseInsensitive) == 0) ? found : !found;
-        } else if (cd.operation.compare("BETWEEN", Qt::CaseInsensitive) == 0 || cd.operation.compare("NOT BETWEEN", Qt::CaseInsensitive) == 0) {
-            bool isBetween = compareQVariants(actualValue, cd.value, ">=") && compareQVariants(actualValue, cd.value2, "<=");
-            result = (cd.operation.compare("BETWEEN", Qt::CaseInsensitive) == 0) ? isBetween : !isBetween;
-        } // zyh修改了以下这一段like，然后就能在where里模式匹配了
-        else if (cd.operation.compare("LIKE", Qt::CaseInsensitive) == 0 || cd.operation.compare("NOT LIKE", Qt::CaseInsensitive) == 0) {
-            QString actualString = actualValue.toString();
-            // 确保 cd.value 是字符串或者可以无歧义地转为字符串模式
-            if (cd.value.typeId() != QMetaType::QString && !cd.value.canConvert<QString>()) {
-                throw std::runtime_error("LIKE 操作符的模式必须是字符串或可转换为字符串。");
+IndexRange integerRange(xhybtree::KeyPart::Kind kind, qint64 lo, qint64 hi) {
+    IndexRange range;
+    range.from.kind = kind;
+    range.from.i = lo;
+    range.within = [kind, hi](const xhybtree::KeyPart& part) { return part.kind == kind && part.i <= hi; };
+    return range;
+}
+
+// compareQVariants 只在两边都是整数类型时按整数精确比较
+bool integerOperand(const QVariant& value, qint64* out) {
+    if (value.typeId() == QMetaType::Int || value.typeId() == QMetaType::LongLong) {
+        *out = value.toLongLong();
+        return true;
+    }
+    if (value.typeId() == QMetaType::ULongLong && value.toULongLong() <= quint64(std::numeric_limits<qint64>::max())) {
+        *out = value.toLongLong();
+        return true;
+    }
+    return false;
+}
+
+bool numericOperand(const QVariant& value, double* out) {
+    if (!value.isValid() || value.isNull() || !value.canConvert<double>()) return false;
+    bool ok = false;
+    *out = value.toDouble(&ok);
+    return ok && std::isfinite(*out);
+}
+
+// 整数单元上的界；upper 为 true 时求上界
+bool integerBound(const QVariant& value, bool upper, bool strict, qint64* out) {
+    qint64 exact = 0;
+    if (integerOperand(value, &exact)) {
+        if (!strict) {
+            *out = exact;
+            return true;
+        }
+        if (exact == (upper ? std::numeric_limits<qint64>::min() : std::numeric_limits<qint64>::max())) return false;
+        *out = upper ? exact - 1 : exact + 1;
+        return true;
+    }
+    double d = 0;
+    if (!numericOperand(value, &d) || std::fabs(d) >= kExactIntegerLimit) return false;
+    *out = static_cast<qint64>(upper ? std::floor(d + kIndexSlack) : std::ceil(d - kIndexSlack));
+    return true;
+}
+
+// 日期单元与 QDate 按日期比较，与文本按 ISO 字符串比较；只有规范的 yyyy-MM-dd 文本两种次序才一致
+bool dateOperand(const QVariant& value, qint64* julianDay) {
+    QDate date;
+    if (value.typeId() == QMetaType::QDate) {
+        date = value.toDate();
+    } else if (value.typeId() == QMetaType::QString) {
+        const QString text = value.toString();
+        date = QDate::fromString(text, Qt::ISODate);
+        if (!date.isValid() || date.toString(Qt::ISODate) != text) return false;
+    }
+    if (!date.isValid() || date.year() < 1 || date.year() > 9999) return false;
+    *julianDay = date.toJulianDay();
+    return true;
+}
+
+// 文本列：数字文本会与数字单元按数值比较，次序与字符串不同，不走索引
+bool textOperand(const QVariant& value, QString* out) {
+    if (value.typeId() != QMetaType::QString) return false;
+    bool numeric = false;
+    value.toDouble(&numeric);
+    if (numeric) return false;
+    *out = value.toString();
+    return true;
+}
+
+// LIKE 'abc%'：取第一个通配符之前的前缀；LIKE 不区分大小写，前缀中的 ASCII 字母展开为大小写组合
+// k/s 在 Unicode 大小写折叠下还对应 K（开尔文符号）、ſ，非 ASCII 字母的规则更复杂，前缀在这些字符处截断
+QStringList likePrefixes(const QString& pattern) {
+    QString prefix;
+    int letters = 0;
+    for (const QChar c : pattern) {
+        if (c == QLatin1Char('%') || c == QLatin1Char('_') || c == QLatin1Char('\\')) break;
+        if (c.toLower() != c.toUpper()) {
+            const QChar lower = c.toLower();
+            if (c.unicode() >= 128 || lower == QLatin1Char('k') || lower == QLatin1Char('s') || letters == 4) break;
+            ++letters;
+        }
+        prefix += c;
+    }
+    if (prefix.isEmpty()) return QStringList();
+    QStringList variants{QString()};
+    for (const QChar c : prefix) {
+        QStringList next;
+        for (const QString& variant : variants) {
+            if (c.toLower() == c.toUpper()) {
+                next << variant + c;
+            } else {
+                next << variant + c.toUpper() << variant + c.toLower();
             }
-            QString likePatternStr = cd.value.toString(); // 这是原始的 SQL LIKE 模式，例如 'a%' 或 '_r%'
-            qDebug() << "  LIKE check: actualString='" << actualString << "' likePatternStr='" << likePatternStr << "'";
+        }
+        variants = next;
+    }
+    return variants;
+}
+}
+
+bool xhytable::addIndex(const xhyindex& definition) {
+    beginSchemaChange();
+    for (const xhybtree& index : m_indexes) {
+        if (index.definition().name().compare(definition.name(), Qt::CaseInsensitive) == 0) {
+            qWarning() << "表 '" << m_name << "' 上已存在索引 '" << definition.name() << "'";
+            return false;
+        }
+    }
+    xhybtree index(definition);
+    index.build(records());
+    m_indexes.append(index);
+    markSchemaDirty();
+    return true;
+}
+
+bool xhytable::dropIndex(const QString& indexName) {
+    beginSchemaChange();
+    const int removed = m_indexes.removeIf([&](const xhybtree& index) {
+        return index.definition().name().compare(indexName, Qt::CaseInsensitive) == 0;
+    });
+    if (removed > 0) markSchemaDirty();
+    return removed > 0;
+}
+
+void xhytable::attachIndex(const xhybtree& index) {
+    m_indexes.removeIf([&](const xhybtree& existing) {
+        return existing.definition().name().compare(index.definition().name(), Qt::CaseInsensitive) == 0;
+    });
+    m_indexes.append(index);
+}
+
+const xhybtree* xhytable::indexOnColumn(const QString& column) const {
+    for (xhybtree& index : m_indexes) {
+        const QStringList columns = index.definition().columns();
+        if (columns.isEmpty() || columns.first().compare(column, Qt::CaseInsensitive) != 0) continue;
+        if (!index.isBuilt()) index.build(records());
+        return &index;
+    }
+    return nullptr;
+}
+
+void xhytable::indexRowInserted(const xhyrecord& record) {
+    for (xhybtree& index : m_indexes) index.insert(record);
+    if (m_keyIndexesBuilt) {
+        for (xhykeyindex& index : m_keyIndexes) index.insert(record);
+    }
+}
+
+void xhytable::indexRowRemoved(const xhyrecord& record) {
+    for (xhybtree& index : m_indexes) index.remove(record);
+    if (m_keyIndexesBuilt) {
+        for (xhykeyindex& index : m_keyIndexes) index.remove(record);
+    }
+}
+
+void xhytable::invalidateRowIndexes() {
+    for (xhybtree& index : m_indexes) index.invalidate();
+    m_keyIndexesBuilt = false;
+}
+
+void xhytable::prepareReads() {
+    ensureRowsLoaded();
+    for (xhybtree& index : m_indexes) {
+        if (!index.isBuilt()) index.build(m_records);
+    }
+    ensureKeyIndexes();
+}
+
+bool xhytable::readsPrepared() const {
+    if (!m_rowsLoaded) return false;
+    for (const xhybtree& index : m_indexes) {
+        if (!index.isBuilt()) return false;
+    }
+    return keyIndexesMatch(wantedKeyIndexes());
+}
+
+QList<xhykeyindex> xhytable::wantedKeyIndexes() const {
+    QList<xhykeyindex> wanted;
+    if (!m_primaryKeys.isEmpty()) wanted.append(xhykeyindex(QString(), m_primaryKeys, false));
+    for (auto it = m_uniqueConstraints.constBegin(); it != m_uniqueConstraints.constEnd(); ++it) {
+        wanted.append(xhykeyindex(it.key(), it.value(), true));
+    }
+    return wanted;
+}
+
+bool xhytable::keyIndexesMatch(const QList<xhykeyindex>& wanted) const {
+    bool same = m_keyIndexesBuilt && wanted.size() == m_keyIndexes.size();
+    for (int i = 0; same && i < wanted.size(); ++i) {
+        same = wanted.at(i).name() == m_keyIndexes.at(i).name() && wanted.at(i).columns() == m_keyIndexes.at(i).columns()
+               && wanted.at(i).skipsNulls() == m_keyIndexes.at(i).skipsNulls();
+    }
+    return same;
+}
+
+// 按当前的主键和 UNIQUE 定义建立哈希索引；定义变化（ALTER TABLE 等）后自动重建
+void xhytable::ensureKeyIndexes() const {
+    QList<xhykeyindex> wanted = wantedKeyIndexes();
+    if (keyIndexesMatch(wanted)) return;
 
-            // 使用新的辅助函数将 SQL LIKE 模式转换为正确的正则表达式模式
-            QString regexPatternStr = sqlLikeToRegex(likePatternStr);
-            qDebug() << "    Converted regex pattern: '" << regexPatternStr << "'";
+    const QList<xhyrecord>& rows = records(); // 可能触发加载，需在置位之前
+    for (xhykeyindex& index : wanted) index.build(rows);
+    m_keyIndexes = wanted;
+    m_keyIndexesBuilt = true;
+    qDebug() << "[KEY_INDEX] 表" << m_name << "建立" << wanted.size() << "个键索引，共" << rows.size() << "行";
+}
 
-            QRegularExpression pattern(regexPatternStr, QRegularExpression::CaseInsensitiveOption);
-            bool matches = pattern.match(actualString).hasMatch(); // match() 会检查整个字符串是否匹配锚定的正则表达式
+const xhykeyindex* xhytable::primaryKeyIndex() const {
+    if (m_primaryKeys.isEmpty()) return nullptr;
+    ensureKeyIndexes();
+    return &m_keyIndexes.first();
+}
 
-            result = (cd.operation.compare("LIKE", Qt::CaseInsensitive) == 0) ? matches : !matches;
-        } else { // 其他二元比较操作符: =, !=, >, <, >=, <=
-            result = compareQVariants(actualValue, cd.value, cd.operation);
+const xhykeyindex* xhytable::uniqueKeyIndex(const QString& constraintName) const {
+    ensureKeyIndexes();
+    for (const xhykeyindex& index : m_keyIndexes) {
+        if (index.skipsNulls() && index.name() == constraintName) return &index;
+    }
+    return nullptr;
+}
+
+// 列集合（不计顺序，列名与记录字段名一致）恰好是主键或某个 UNIQUE 约束时返回其索引
+const xhykeyindex* xhytable::keyIndexCovering(const QStringList& columns) const {
+    if (columns.isEmpty()) return nullptr;
+    ensureKeyIndexes();
+    for (const xhykeyindex& index : m_keyIndexes) {
+        if (index.columns().size() != columns.size()) continue;
+        bool covers = true;
+        for (const QString& column : columns) covers = covers && index.columns().contains(column);
+        if (covers) return &index;
+    }
+    return nullptr;
+}
+
+bool xhytable::indexCandidates(const ConditionNode& conditions, QVector<int>& rows, QString* plan) const {
+    if (m_indexes.isEmpty()) return false;
+    ensureRowsLoaded();
+    QVector<quint64> rowIds;
+    QStringList used;
+    if (!indexRowIds(conditions, rowIds, &used)) return false;
+
+    const QList<xhyrecord>& source = records();
+    if (rowIds.size() * 2 > source.size()) { // 候选行过半时逐行扫描更快
+        if (plan) {
+            *plan = QString("%1 得到候选 %2 行 / 共 %3 行，选择性不足，改为全表扫描")
+                        .arg(used.join(" + ")).arg(rowIds.size()).arg(source.size());
         }
-        qDebug() << "[matchConditions] ComparisonOp result for field " << cd.fieldName << ": " << result;
-        break;
+        return false;
+    }
+    rows.clear();
+    rows.reserve(rowIds.size());
+    QHash<quint64, int> positions;
+    for (quint64 rowId : rowIds) {
+        const int pos = rowPosition(source, rowId, &positions);
+        if (pos >= 0) rows.append(pos);
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    if (plan) *plan = QString("%1，候选 %2 行 / 共 %3 行").arg(used.join(" + ")).arg(rows.size()).arg(source.size());
+    return true;
+}
+
+bool xhytable::hasEqualityIndex(const QString& column) const {
+    if (m_primaryKeys.size() == 1 && m_primaryKeys.first().compare(column, Qt::CaseInsensitive) == 0) return true;
+    for (const xhybtree& index : m_indexes) {
+        const QStringList columns = index.definition().columns();
+        if (!columns.isEmpty() && columns.first().compare(column, Qt::CaseInsensitive) == 0) return true;
+    }
+    return false;
+}
+
+// 主键走哈希索引（键与逐行比较文本一致）；B+ 树按该列的存储规则把 value 转成键，同一文本总是得到同一个键
+bool xhytable::lookupEqual(const QString& column, const QString& value, QVector<int>& rows) const {
+    rows.clear();
+    const xhyfield* field = get_field(column);
+    if (!field) return false;
+    if (value.isNull()) return hasEqualityIndex(column); // NULL 不与任何值相等
+    QList<quint64> rowIds;
+    if (m_primaryKeys.size() == 1 && m_primaryKeys.first().compare(column, Qt::CaseInsensitive) == 0) {
+        rowIds = primaryKeyIndex()->rowIds(xhykeyindex::keyOf(QStringList{value}));
+    } else if (const xhybtree* index = indexOnColumn(column)) {
+        const int ordinal = m_rowLayout.constData()->indexOf(field->name());
+        xhyrecord probe(m_rowLayout);
+        probe.setValueAt(ordinal, value);
+        const xhybtree::KeyPart part = xhybtree::keyPartOf(probe, ordinal);
+        index->scan(part, true, [&](const xhybtree::Entry& entry) {
+            if (entry.key.isEmpty() || entry.key.first().compare(part) != 0) return false;
+            rowIds.append(entry.rowId);
+            return true;
+        });
+    } else {
+        return false;
+    }
+    const QList<xhyrecord>& source = records();
+    QHash<quint64, int> positions;
+    for (quint64 rowId : rowIds) {
+        const int pos = rowPosition(source, rowId, &positions);
+        if (pos >= 0) rows.append(pos);
+    }
+    std::sort(rows.begin(), rows.end());
+    return true;
+}
+
+const xhyrecord* xhytable::committedRecord(quint64 rowId) const {
+    const QList<xhyrecord>& rows = getCommittedRecords();
+    QHash<quint64, int> positions;
+    const int pos = rowPosition(rows, rowId, &positions);
+    return pos >= 0 ? &rows.at(pos) : nullptr;
+}
+
+// 记录通常按行号递增排列，先二分查找；顺序被打乱时退回调用者的行号 -> 下标散列表（每次查询最多建立一次）
+// 散列表属于调用者而不是表，并发的读查询互不影响
+int xhytable::rowPosition(const QList<xhyrecord>& rows, quint64 rowId, QHash<quint64, int>* positions) {
+    auto it = std::lower_bound(rows.cbegin(), rows.cend(), rowId,
+                               [](const xhyrecord& record, quint64 id) { return record.rowId() < id; });
+    if (it != rows.cend() && it->rowId() == rowId) return static_cast<int>(it - rows.cbegin());
+    if (positions->isEmpty() && !rows.isEmpty()) {
+        positions->reserve(rows.size());
+        for (int i = 0; i < rows.size(); ++i) positions->insert(rows.at(i).rowId(), i);
+    }
+    return positions->value(rowId, -1);
+}
+
+// AND 取候选最少的可用子条件，OR 要求每个子条件都能走索引
+bool xhytable::indexRowIds(const ConditionNode& condition, QVector<quint64>& rowIds, QStringList* plan) const {
+    switch (condition.type) {
+    case ConditionNode::COMPARISON_OP:
+        return indexRowIdsForComparison(condition.comparison, rowIds, plan);
+    case ConditionNode::LOGIC_OP: {
+        if (condition.children.isEmpty()) return false;
+        if (condition.logicOp.compare("AND", Qt::CaseInsensitive) == 0) {
+            bool found = false;
+            QStringList bestPlan;
+            for (const ConditionNode& child : condition.children) {
+                QVector<quint64> childIds;
+                QStringList childPlan;
+                if (indexRowIds(child, childIds, &childPlan) && (!found || childIds.size() < rowIds.size())) {
+                    rowIds = childIds;
+                    bestPlan = childPlan;
+                    found = true;
+                }
+            }
+            if (found && plan) *plan += bestPlan;
+            return found;
+        }
+        if (condition.logicOp.compare("OR", Qt::CaseInsensitive) == 0) {
+            QVector<quint64> allIds;
+            QStringList allPlans;
+            for (const ConditionNode& child : condition.children) {
+                QVector<quint64> childIds;
+                if (!indexRowIds(child, childIds, &allPlans)) return false;
+                allIds += childIds;
+            }
+            rowIds += allIds;
+            if (plan) *plan += allPlans;
+            return true;
+        }
+        return false;
     }
     default:
-        throw std::runtime_error("未知的条件节点类型");
+        return false;
     }
-    return result;
 }
 
+bool xhytable::indexRowIdsForComparison(const ComparisonDetails& comparison, QVector<quint64>& rowIds, QStringList* plan) const {
+    const xhyfield* field = get_field(comparison.fieldName);
+    if (!field) return false;
+    bool hasIndex = false;
+    for (const xhybtree& index : m_indexes) {
+        const QStringList columns = index.definition().columns();
+        if (!columns.isEmpty() && columns.first().compare(field->name(), Qt::CaseInsensitive) == 0) hasIndex = true;
+    }
+    if (!hasIndex) return false;
+
+    const QString op = comparison.operation.trimmed().toUpper();
+    QList<IndexRange> ranges;
+    QList<OperandInterval> intervals;
+    if (op == "=" || op == "<" || op == "<=" || op == ">" || op == ">=") {
+        OperandInterval interval;
+        interval.hasLower = op != "<" && op != "<=";
+        interval.hasUpper = op != ">" && op != ">=";
+        interval.lower = interval.upper = comparison.value;
+        interval.lowerStrict = op == ">";
+        interval.upperStrict = op == "<";
+        intervals.append(interval);
+    } else if (op == "BETWEEN") {
+        OperandInterval interval;
+        interval.hasLower = interval.hasUpper = true;
+        interval.lower = comparison.value;
+        interval.upper = comparison.value2;
+        intervals.append(interval);
+    } else if (op == "IN") {
+        for (const QVariant& item : comparison.valueList) {
+            OperandInterval interval;
+            interval.hasLower = interval.hasUpper = true;
+            interval.lower = interval.upper = item;
+            intervals.append(interval);
+        }
+    } else if (op != "LIKE") {
+        return false;
+    }
+
+    const xhyrecordlayout::StorageType storage = storageTypeFor(field->type());
+    const bool textSemantics = field->type() == xhyfield::CHAR || field->type() == xhyfield::VARCHAR
+                               || field->type() == xhyfield::TEXT || field->type() == xhyfield::ENUM;
+    if (op == "LIKE") {
+        const QStringList prefixes = textSemantics ? likePrefixes(comparison.value.toString()) : QStringList();
+        if (prefixes.isEmpty()) return false;
+        for (const QString& prefix : prefixes) {
+            IndexRange range;
+            range.from.kind = xhybtree::KeyPart::Text;
+            range.from.s = prefix;
+            range.within = [prefix](const xhybtree::KeyPart& part) {
+                return part.kind == xhybtree::KeyPart::Text && part.s.startsWith(prefix);
+            };
+            ranges.append(range);
+        }
+    }
+
+    for (const OperandInterval& interval : intervals) {
+        if (storage == xhyrecordlayout::IntColumn || storage == xhyrecordlayout::DoubleColumn) {
+            qint64 lo = std::numeric_limits<qint64>::min(), hi = std::numeric_limits<qint64>::max();
+            if (interval.hasLower && !integerBound(interval.lower, false, interval.lowerStrict, &lo)) return false;
+            if (interval.hasUpper && !integerBound(interval.upper, true, interval.upperStrict, &hi)) return false;
+            double dlo = -std::numeric_limits<double>::infinity(), dhi = std::numeric_limits<double>::infinity();
+            if (interval.hasLower && numericOperand(interval.lower, &dlo)) dlo -= kIndexSlack;
+            if (interval.hasUpper && numericOperand(interval.upper, &dhi)) dhi += kIndexSlack;
+            if (lo <= hi) ranges.append(integerRange(xhybtree::KeyPart::Int, lo, hi));
+            if (dlo <= dhi) {
+                IndexRange range;
+                range.from.kind = xhybtree::KeyPart::Double;
+                range.from.d = dlo;
+                range.within = [dhi](const xhybtree::KeyPart& part) { return part.kind == xhybtree::KeyPart::Double && part.d <= dhi; };
+                ranges.append(range);
+            }
+        } else if (storage == xhyrecordlayout::DateColumn) {
+            qint64 lo = std::numeric_limits<qint64>::min(), hi = std::numeric_limits<qint64>::max();
+            if (interval.hasLower) {
+                if (!dateOperand(interval.lower, &lo)) return false;
+                if (interval.lowerStrict) ++lo;
+            }
+            if (interval.hasUpper) {
+                if (!dateOperand(interval.upper, &hi)) return false;
+                if (interval.upperStrict) --hi;
+            }
+            if (lo <= hi) ranges.append(integerRange(xhybtree::KeyPart::Date, lo, hi));
+        } else if (textSemantics) {
+            QString lower, upper;
+            if (interval.hasLower && !textOperand(interval.lower, &lower)) return false;
+            if (interval.hasUpper && !textOperand(interval.upper, &upper)) return false;
+            IndexRange range;
+            range.from.kind = xhybtree::KeyPart::Text;
+            range.from.s = lower;
+            range.fromInclusive = !interval.hasLower || !interval.lowerStrict;
+            const bool hasUpper = interval.hasUpper, upperStrict = interval.upperStrict;
+            range.within = [upper, hasUpper, upperStrict](const xhybtree::KeyPart& part) {
+                if (part.kind != xhybtree::KeyPart::Text) return false;
+                if (!hasUpper) return true;
+                const int c = part.s.compare(upper);
+                return upperStrict ? c < 0 : c <= 0;
+            };
+            ranges.append(range);
+        } else {
+            return false; // 布尔、日期时间等列按原逻辑逐行比较
+        }
+    }
+    // 数值/日期列中无法按列类型存放的文本单元按字符串比较，次序不可预知，全部作为候选
+    if (!intervals.isEmpty() && !textSemantics) ranges.append(kindRange(xhybtree::KeyPart::Text));
+
+    const xhybtree* index = indexOnColumn(field->name());
+    for (const IndexRange& range : ranges) {
+        index->scan(range.from, range.fromInclusive, [&](const xhybtree::Entry& entry) {
+            if (!range.within(entry.key.first())) return false;
+            rowIds.append(entry.rowId);
+            return true;
+        });
+    }
+    if (plan) {
+        plan->append(QString("索引 '%1' (%2 %3, 高度 %4)")
+                         .arg(index->definition().name(), field->name(), op).arg(index->height()));
+    }
+    return true;
+}
@@ -3,12 +3,20 @@
 
 #include "xhyfield.h"
 #include "xhyrecord.h"
+#include "xhycolumnstore.h"
+#include "xhybtree.h"
+#include "xhykeyindex.h"
+#include "xhypredicate.h"
+#include "xhycheck.h"
+#include "xhyresultset.h"
+#include "xhymvcc.h"
 #include "ConditionNode.h"
 #include <QString>
 #include <QList>
 #include <QMap>
 #include <QSet>
 #include <QVariant>
+#include <functional>
 
 // 前向声明，避免循环依赖
 class xhydatabase;
@@ -36,6 +44,18 @@ struct ForeignKeyDefinition {
         return constraintName.compare(other.constraintName, Qt::CaseInsensitive) == 0;
     }
 };
+// 行级变更（前像/后像），提交时写入预写日志，启动时用于重做
+struct RowChange {
+    enum Kind : quint8 {
+        Insert = 1,
+        Update = 2,
+        Delete = 3
+    };
+    Kind kind = Insert;
+    quint64 rowId = 0;             // 行号，重做时按行号定位，保证幂等
+    QMap<QString, QString> before; // UPDATE/DELETE 时的原记录
+    QMap<QString, QString> after;  // INSERT/UPDATE 时的新记录
+};
 class xhytable {
 
 public:
@@ -44,8 +64,19 @@ public:
 
     const QString& name() const { return m_name; }
     const QList<xhyfield>& fields() const { return m_fields; }
-    const QList<xhyrecord>& records() const; // 根据是否在事务中返回 m_tempRecords 或 m_records
-    const QList<xhyrecord>& getCommittedRecords() const { return m_records; }
+    // 本表记录共享的行布局（按字段顺序），字段变化时重建
+    const QSharedDataPointer<xhyrecordlayout>& rowLayout() const { return m_rowLayout; }
+    const QList<xhyrecord>& records() const;
+    // 写数据文件用；事务中的修改原地进行，事务期间不做检查点，提交或回滚后即为已提交状态
+    const QList<xhyrecord>& getCommittedRecords() const { ensureRowsLoaded(); return m_records; }
+
+    // 延迟加载：启动时只加载表定义，记录在第一次被访问时才由 loader 解码
+    void setRowLoader(std::function<void(xhytable&)> loader); // 传入空函数表示记录已在内存中
+    bool rowsLoaded() const { return m_rowsLoaded; }
+    void ensureRowsLoaded() const;
+    // 并发读之前由写方调用：加载记录、建立尚未建立的二级索引与键索引；之后 const 的查询接口不再修改表
+    void prepareReads();
+    bool readsPrepared() const;
 
     void addfield(const xhyfield& field);
     bool has_field(const QString& field_name) const;
@@ -59,6 +90,31 @@ public:
     const QMap<QString, QString>& defaultValues() const { return m_defaultValues; }
     const QMap<QString, QString>& checkConstraints() const { return m_checkConstraints; }
 
+    // 表选项（CREATE TABLE ... WITH (key=value, ...)），随 .tdf 保存
+    const QMap<QString, QString>& options() const { return m_options; }
+    void setOption(const QString& key, const QString& value);
+    // storage=column：除记录外另存每列的类型化向量，随每次写入同步更新（见 xhycolumnstore）
+    bool isColumnar() const { return m_options.value("storage").compare("column", Qt::CaseInsensitive) == 0; }
+
+    // 列存表：按列向量过滤，rows 为满足条件的行在 getCommittedRecords() 中的下标
+    // 非列存表或事务进行中返回 false，由调用者改用 selectData；limit >= 0 时只取前 limit 行
+    bool selectRowIndexes(const ConditionNode& conditions, QVector<int>& rows, int limit = -1) const;
+    // 列存表：对 rows 中的行按列计算 COUNT/SUM/AVG/MIN/MAX，结果与逐行计算一致
+    QVariant aggregateColumn(const QString& function, const QString& column, const QVector<int>& rows) const;
+
+    // 二级索引（CREATE INDEX）：随行的增删改维护，事务回滚时随表快照恢复
+    const QList<xhybtree>& indexes() const { return m_indexes; }
+    bool addIndex(const xhyindex& definition); // 按当前记录建立
+    bool dropIndex(const QString& indexName);
+    void attachIndex(const xhybtree& index);   // 从 .ix 加载，不标记脏
+    // 用索引求出可能满足条件的行（records() 中的下标，升序）；没有可用索引时返回 false
+    // 结果是超集，调用者仍需逐行 matchConditions；plan 返回使用的索引及扫描方式
+    bool indexCandidates(const ConditionNode& conditions, QVector<int>& rows, QString* plan = nullptr) const;
+    // 等值连接用：column 是某个 B+ 树索引的首列或单列主键时返回 true
+    bool hasEqualityIndex(const QString& column) const;
+    // records() 中 column 的文本等于 value 的行下标（升序）；没有可用索引时返回 false
+    bool lookupEqual(const QString& column, const QString& value, QVector<int>& rows) const;
+
 
     void add_field(const xhyfield& field); // 等同于 addfield
     void remove_field(const QString& field_name);
@@ -77,23 +133,67 @@ public:
     void add_unique_constraint(const QStringList& fields, const QString& constraintName = "");
     void add_check_constraint(const QString& condition, const QString& constraintName = "");
 
+    // 事务：开始时不复制记录，增删改原地进行并把每行的前像记入撤销日志；回滚时按日志逆序恢复
+    // 事务中写入的版本开始时间戳为 xhymvcc::kUncommitted，提交时统一盖上 commitTimestamp
     void beginTransaction();
-    void commit();
+    void commit(quint64 commitTimestamp = 0);
     void rollback();
     bool isInTransaction() const { return m_inTransaction; }
+    int undoLogSize() const { return m_undoLog.size(); } // 保存点记录的位置
+    void rollbackTo(int undoLogSize);                    // 逆序撤销该位置之后的修改，事务继续
+
+    // 多版本：被更新或删除的已提交版本按行号保存在版本链中，供开始得更早的读快照使用
+    bool isCurrentAt(const xhysnapshot& snapshot) const; // 当前记录就是快照可见的记录（快照之后没有提交过、也没有未提交的修改）
+    QList<xhyrecord> visibleRecords(const xhysnapshot& snapshot) const; // isCurrentAt 时与 records() 共享，否则按版本重组
+    void collectVersions(quint64 horizon); // 回收结束时间戳不超过 horizon 的旧版本
+    int versionCount() const;
+
+    // 脏标记：提交时只持久化发生变化的表；结构变化时才重写 .tdf
+    bool isDataDirty() const { return m_dataDirty; }
+    bool isSchemaDirty() const { return m_schemaDirty; }
+    bool isDirty() const { return m_dataDirty || m_schemaDirty; }
+    quint64 version() const { return m_version; }
+    void markDataDirty() { m_dataDirty = true; ++m_version; }
+    void markSchemaDirty() { m_schemaDirty = true; ++m_version; }
+    void clearDirty() { m_dataDirty = false; m_schemaDirty = false; m_changedRowIds.clear(); m_insertedRowIds.clear(); m_deletedRowIds.clear(); }
+
+    // 分页记录文件：自上次写出后新增/修改及删除的行号，检查点只重写这些行所在的页
+    // insertedRowIds 是 changedRowIds 中新插入（页文件中可能还没有）的行
+    const QSet<quint64>& changedRowIds() const { return m_changedRowIds; }
+    const QSet<quint64>& insertedRowIds() const { return m_insertedRowIds; }
+    const QSet<quint64>& deletedRowIds() const { return m_deletedRowIds; }
+    const xhyrecord* committedRecord(quint64 rowId) const; // 按行号取已提交的记录，不存在时返回空指针
+    quint64 nextRowId() const { return m_nextRowId; }
+    void setNextRowId(quint64 rowId) { m_nextRowId = qMax(m_nextRowId, rowId); }
+
+    // 预写日志：取走本表尚未写入日志的行变更；启动时按日志重做
+    QList<RowChange> takePendingChanges();
+    int redoChanges(const QList<RowChange>& changes); // 同一张表按日志顺序的变更，返回失败的条数
+    quint64 walLsn() const { return m_walLsn; }
+    void setWalLsn(quint64 lsn) { m_walLsn = lsn; }
 
     // 数据操作 (CRUD)
     bool insertData(const QMap<QString, QString>& fieldValuesFromUser);
     int updateData(const QMap<QString, QString>& updates_with_expressions, const ConditionNode& conditions);
     int deleteData(const ConditionNode& conditions);
-    bool selectData(const ConditionNode& conditions, QVector<xhyrecord>& results) const;
+    bool selectData(const ConditionNode& conditions, QVector<xhyrecord>& results, int limit = -1) const; // limit >= 0 时取够即停
+    // 与 selectData 相同，但只返回满足条件的行下标和当前记录的读快照，不复制记录
+    // snapshot 有效时只读该快照可见的版本：快照之后的提交和未提交的修改不可见，被改掉的行取版本链中的旧版本，
+    // 快照之后被删除的行排在最后；不复制表，只复制用到的旧版本
+    // 全表扫描达到 kParallelScanRows 行时，各线程按块（kScanMorselRows 行）领取记录求值条件，结果按块顺序拼接，与串行扫描相同
+    // parallelDegree 为扫描线程数（会话的 SET PARALLEL_DEGREE）：0 为 CPU 核数，1 为串行
+    bool selectRows(const ConditionNode& conditions, xhyresultset& result, int limit = -1,
+                    const xhysnapshot& snapshot = xhysnapshot(), int parallelDegree = 0) const;
+    static const int kParallelScanRows = 1 << 15;
+    static const int kScanMorselRows = 1 << 13;
 
     // 验证方法
     //约束检查
     void checkInsertConstraints(const QMap<QString, QString>& fieldValues) const;
     void checkUpdateConstraints(const xhyrecord& originalRecord, const QMap<QString, QString>& finalProposedUpdates) const ;
     bool checkDeleteConstraints(const ConditionNode & conditions) const;
-    bool evaluateCheckExpression(const QString& expr, const QVariantMap& fieldValues) const;//check 语句解析
+    // 按预先解析的 CHECK 表达式求值；values 按字段序号排列（convertToTypedValue 的结果）
+    bool evaluateCheckConstraint(const QString& constraintName, const QVector<QVariant>& values) const;
     QVariant convertStringToType(const QString& str, xhyfield::datatype type) const ;//类型转换
 
     // 新增：设置父数据库的方法
@@ -105,11 +205,13 @@ public:
     bool validateType(xhyfield::datatype type, const QString& value, const QStringList& constraints) const;
     bool checkConstraint(const xhyfield& field, const QString& value) const; // CHECK 约束 (目前是占位符)
 
-    void rebuildIndexes(); // (占位符)
+    void rebuildIndexes(); // 记录整体替换后调用
 
     QVariant convertToTypedValue(const QString& strValue, xhyfield::datatype type) const;
     bool compareQVariants(const QVariant& left, const QVariant& right, const QString& op) const;
-    bool matchConditions(const xhyrecord& record, const ConditionNode& condition) const;
+    bool matchConditions(const xhyrecord& record, const ConditionNode& condition) const; // 单次求值；逐行扫描请先 compilePredicate
+    xhypredicate compilePredicate(const ConditionNode& condition) const;
+    static xhyrecordlayout::StorageType storageTypeFor(xhyfield::datatype type);
 
 
 
@@ -118,19 +220,92 @@ public:
 
     QString m_name;
     QList<xhyfield> m_fields;
-    QList<xhyrecord> m_records; // 已提交状态
+    QList<xhyrecord> m_records; // 当前状态，事务中的未提交修改也在这里
     QStringList m_primaryKeys;
     QList<ForeignKeyDefinition> m_foreignKeys;  // FK 定义
     QMap<QString, QList<QString>> m_uniqueConstraints; // <ConstraintName, ListOfFields>
     QSet<QString> m_notNullFields;
     QMap<QString, QString> m_defaultValues; // <FieldName, DefaultValue>
     QMap<QString, QString> m_checkConstraints;
+    QMap<QString, xhycheck> m_checkPrograms; // 约束名 -> 解析后的表达式；字段变化时重新解析
+
+    // 撤销日志的一项：INSERT 记新行的下标，UPDATE/DELETE 记下标和原记录；逆序回放时下标与当时一致
+    struct UndoEntry {
+        RowChange::Kind kind = RowChange::Insert;
+        int position = -1;
+        xhyrecord before;
+        bool versionKept = false; // before 是已提交版本，已放入版本链
+    };
+    // 已被取代的版本：[record.beginTs(), endTs) 内开始的快照可见；endTs 为 kUncommitted 时取代它的事务尚未提交
+    struct RowVersion {
+        xhyrecord record;
+        quint64 endTs = xhymvcc::kUncommitted;
+    };
+    struct VersionChain {
+        QVector<RowVersion> versions; // 按时间从旧到新
+        bool deleted = false;         // 当前记录中已没有这一行
+    };
+    // 按快照重组时的旧版本：versionOf 为仍在当前记录中的行，deletedRows 为已删除的行（按行号排序）
+    struct SnapshotVersions {
+        QList<xhyrecord> versions;
+        QHash<quint64, int> versionOf;
+        QVector<int> deletedRows;
+    };
 
     bool m_inTransaction;
-    QList<xhyrecord> m_tempRecords; // 事务期间的临时记录
+    QVector<UndoEntry> m_undoLog; // 当前事务的行修改，提交时清空
+    QHash<quint64, VersionChain> m_versions; // 行号 -> 旧版本
+    QSet<quint64> m_txnRowIds;    // 当前事务写过的行号，提交时按它盖时间戳
+    quint64 m_lastCommitTs = 0;   // 本表最近一次提交的时间戳
 
     xhydatabase* m_parentDb; // 指向所属数据库的指针
 
+    bool m_dataDirty = false;   // 记录自上次持久化后是否被修改
+    bool m_schemaDirty = false; // 表结构/约束自上次持久化后是否被修改
+    quint64 m_version = 0;      // 每次修改递增
+    QList<RowChange> m_pendingChanges; // 尚未写入 WAL 的变更，与撤销日志一一对应地回滚
+    quint64 m_walLsn = 0;       // .trd 文件已包含的最大 WAL 序号
+    quint64 m_nextRowId = 1;
+    bool m_rowsLoaded = true;
+    std::function<void(xhytable&)> m_rowLoader;
+    QSet<quint64> m_changedRowIds;
+    QSet<quint64> m_insertedRowIds;
+    QSet<quint64> m_deletedRowIds;
+    QSharedDataPointer<xhyrecordlayout> m_rowLayout;
+    QMap<QString, QString> m_options;
+    xhycolumnstore m_columnStore; // 列存表的列向量，下标与 m_records 一致
+    mutable QList<xhybtree> m_indexes;  // 未建立的索引在第一次使用时按记录建立
+    mutable QList<xhykeyindex> m_keyIndexes;     // 主键与 UNIQUE 约束的哈希索引，第一次校验时建立
+    mutable bool m_keyIndexesBuilt = false;
+
+    const xhybtree* indexOnColumn(const QString& column) const;
+    bool indexRowIds(const ConditionNode& condition, QVector<quint64>& rowIds, QStringList* plan) const;
+    bool indexRowIdsForComparison(const ComparisonDetails& comparison, QVector<quint64>& rowIds, QStringList* plan) const;
+    static int rowPosition(const QList<xhyrecord>& rows, quint64 rowId, QHash<quint64, int>* positions);
+    void indexRowInserted(const xhyrecord& record);
+    void indexRowRemoved(const xhyrecord& record);
+    quint64 recordRowWrite(RowChange::Kind kind, int position, quint64 rowId, const xhyrecord& before = xhyrecord());
+    SnapshotVersions snapshotVersions(quint64 timestamp) const;
+    static const xhyrecord* visibleVersion(const VersionChain& chain, quint64 timestamp);
+    void beginSchemaChange(); // 事务中第一次改表结构前，让数据库保存表列表快照
+    void invalidateRowIndexes(); // 记录整体替换后，索引下次使用时重建
+
+    QList<xhykeyindex> wantedKeyIndexes() const;
+    bool keyIndexesMatch(const QList<xhykeyindex>& wanted) const;
+    void ensureKeyIndexes() const;
+    const xhykeyindex* primaryKeyIndex() const;
+    const xhykeyindex* uniqueKeyIndex(const QString& constraintName) const;
+    const xhykeyindex* keyIndexCovering(const QStringList& columns) const;
+
+    QVector<quint8> evaluateColumnar(const ConditionNode& condition) const;
+
+    void rebuildRowLayout();
+    void compileCheckConstraints();
+    void rebuildColumns();
+    void columnsRowInserted(int position); // m_records 在 position 处插入后调用
+    void columnsRowReplaced(int position);
+    void columnsRowRemoved(int position);  // m_records 删除 position 处的行后调用
+
 };
 
 #endif // XHYTABLE_H
@@ -0,0 +1,271 @@
+#include "xhywal.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QSaveFile>
+#include <QThread>
+#include <QtEndian>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+const int kFrameHeaderSize = 8; // quint32 长度 + quint32 校验和
+
+bool decodePayload(const QByteArray& payload, quint64& lsn, quint8& type, QString& tableName, RowChange& change) {
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_15);
+    in >> lsn >> type >> tableName >> change.rowId >> change.before >> change.after;
+    change.kind = static_cast<RowChange::Kind>(type);
+    return in.status() == QDataStream::Ok;
+}
+}
+
+xhywal::xhywal(const QString& filePath) : m_filePath(filePath) {}
+
+xhywal::~xhywal() {
+    close();
+}
+
+bool xhywal::syncFile(QFileDevice& file) {
+    if (!file.flush()) return false;
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()))) != 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+quint16 xhywal::checksum(const char* data, int len) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return qChecksum(QByteArrayView(data, len));
+#else
+    return qChecksum(data, uint(len));
+#endif
+}
+
+QByteArray xhywal::encodeFrame(quint64 lsn, RecordType type, const QString& tableName, const RowChange& change) {
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << lsn << static_cast<quint8>(type) << tableName << change.rowId << change.before << change.after;
+
+    QByteArray frame(kFrameHeaderSize, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size()), frame.data());
+    qToBigEndian<quint32>(checksum(payload.constData(), payload.size()), frame.data() + 4);
+    frame.append(payload);
+    return frame;
+}
+
+// 从头扫描日志：收集完整提交的变更组，返回最后一个完整提交之后的偏移
+bool xhywal::scan(QList<Entry>* entries, qint64* validEnd) {
+    *validEnd = 0;
+    QFile in(m_filePath);
+    if (!in.exists()) return true;
+    if (!in.open(QIODevice::ReadOnly)) {
+        qWarning() << "[WAL] 无法读取日志文件:" << m_filePath << in.errorString();
+        return false;
+    }
+    const QByteArray data = in.readAll();
+    in.close();
+
+    QList<Entry> group;
+    quint64 maxLsn = 0;
+    qint64 pos = 0;
+    while (pos + kFrameHeaderSize <= data.size()) {
+        quint32 len = qFromBigEndian<quint32>(data.constData() + pos);
+        quint32 crc = qFromBigEndian<quint32>(data.constData() + pos + 4);
+        if (pos + kFrameHeaderSize + static_cast<qint64>(len) > data.size()) break;
+        QByteArray payload = data.mid(pos + kFrameHeaderSize, len);
+        if (checksum(payload.constData(), payload.size()) != crc) break;
+
+        Entry e;
+        quint8 type = 0;
+        if (!decodePayload(payload, e.lsn, type, e.tableName, e.change)) break;
+        pos += kFrameHeaderSize + len;
+
+        if (type == RecCommit) {
+            if (entries) entries->append(group);
+            group.clear();
+            *validEnd = pos;
+            maxLsn = e.lsn;
+        } else {
+            group.append(e);
+        }
+    }
+    if (!group.isEmpty()) {
+        qWarning() << "[WAL] 日志尾部有" << group.size() << "条未提交完整的变更，已忽略。";
+    }
+    m_nextLsn = maxLsn + 1;
+    m_bufferedLsn = maxLsn;
+    m_durableLsn = maxLsn;
+    return true;
+}
+
+bool xhywal::open() {
+    QMutexLocker lock(&m_mutex);
+    qint64 validEnd = 0;
+    if (!scan(nullptr, &validEnd)) return false;
+
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "[WAL] 无法打开日志文件:" << m_filePath << m_file.errorString();
+        return false;
+    }
+    if (m_file.size() > validEnd) {
+        qWarning() << "[WAL] 截断日志尾部不完整的数据:" << (m_file.size() - validEnd) << "字节";
+        m_file.resize(validEnd);
+    }
+    m_fileSize = validEnd;
+    return true;
+}
+
+void xhywal::close() {
+    QMutexLocker lock(&m_mutex);
+    while (m_syncInProgress) m_syncDone.wait(&m_mutex);
+    if (m_file.isOpen()) m_file.close();
+}
+
+QList<xhywal::Entry> xhywal::readCommitted() {
+    QMutexLocker lock(&m_mutex);
+    QList<Entry> entries;
+    qint64 validEnd = 0;
+    scan(&entries, &validEnd);
+    return entries;
+}
+
+quint64 xhywal::appendCommit(const QList<QPair<QString, RowChange>>& changes, qint64* bytesAppended) {
+    if (bytesAppended) *bytesAppended = 0;
+    if (changes.isEmpty()) return 0;
+
+    QMutexLocker lock(&m_mutex);
+    QByteArray frames;
+    for (const auto& c : changes) {
+        frames += encodeFrame(m_nextLsn++, static_cast<RecordType>(c.second.kind), c.first, c.second);
+    }
+    quint64 commitLsn = m_nextLsn++;
+    frames += encodeFrame(commitLsn, RecCommit, QString(), RowChange());
+
+    m_pending += frames;
+    m_bufferedLsn = commitLsn;
+    if (bytesAppended) *bytesAppended = frames.size();
+    return commitLsn;
+}
+
+bool xhywal::sync(quint64 lsn) {
+    if (lsn == 0) return true;
+    QMutexLocker lock(&m_mutex);
+    while (m_durableLsn < lsn) {
+        if (m_syncInProgress) {
+            // 其他线程正在写盘，等它完成后再看自己的记录是否已被带上
+            m_syncDone.wait(&m_mutex);
+            continue;
+        }
+        m_syncInProgress = true;
+        if (m_groupCommitWindowUs > 0) {
+            lock.unlock();
+            QThread::usleep(m_groupCommitWindowUs);
+            lock.relock();
+        }
+        QByteArray batch;
+        batch.swap(m_pending);
+        const quint64 target = m_bufferedLsn;
+        lock.unlock();
+
+        bool ok = true;
+        if (!batch.isEmpty()) {
+            ok = m_file.seek(m_fileSize) && m_file.write(batch) == batch.size() && syncFile(m_file);
+        }
+
+        lock.relock();
+        m_syncInProgress = false;
+        if (ok) {
+            m_durableLsn = target;
+            m_fileSize += batch.size();
+            ++m_syncCount;
+        } else {
+            qWarning() << "[WAL] 写入或同步日志失败:" << m_filePath << m_file.errorString();
+            m_file.resize(m_fileSize);
+            m_pending.prepend(batch);
+        }
+        m_syncDone.wakeAll();
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool xhywal::truncateUpTo(quint64 lsn) {
+    QMutexLocker lock(&m_mutex);
+    while (m_syncInProgress) m_syncDone.wait(&m_mutex);
+    m_syncInProgress = true; // 占用写盘权，期间提交只进入缓冲
+    lock.unlock();
+
+    bool ok = false;
+    QByteArray kept;
+    QByteArray lastCommit; // 被丢弃的最后一条 COMMIT 记录，只有 LSN，重放时不产生变更
+    if (m_file.isOpen() && m_file.seek(0)) {
+        const QByteArray data = m_file.read(m_fileSize);
+        qint64 pos = 0;
+        while (pos + kFrameHeaderSize <= data.size()) {
+            quint32 len = qFromBigEndian<quint32>(data.constData() + pos);
+            qint64 frameSize = kFrameHeaderSize + static_cast<qint64>(len);
+            if (pos + frameSize > data.size()) break;
+            quint64 frameLsn = qFromBigEndian<quint64>(data.constData() + pos + kFrameHeaderSize);
+            if (frameLsn > lsn) {
+                kept.append(data.constData() + pos, frameSize);
+            } else if (static_cast<quint8>(data.at(pos + kFrameHeaderSize + 8)) == RecCommit) {
+                lastCommit = data.mid(pos, frameSize);
+            }
+            pos += frameSize;
+        }
+        kept.prepend(lastCommit);
+        m_file.close();
+
+        QSaveFile out(m_filePath);
+        if (out.open(QIODevice::WriteOnly)) {
+            out.write(kept);
+            ok = syncFile(out) && out.commit();
+        }
+        if (!ok) qWarning() << "[WAL] 检查点后截断日志失败:" << m_filePath;
+        if (!m_file.open(QIODevice::ReadWrite)) {
+            qWarning() << "[WAL] 截断后重新打开日志失败:" << m_filePath << m_file.errorString();
+        }
+    }
+
+    lock.relock();
+    m_fileSize = m_file.size();
+    m_syncInProgress = false;
+    m_syncDone.wakeAll();
+    if (ok) qDebug() << "[WAL] 已丢弃 LSN <=" << lsn << "的日志，剩余" << kept.size() << "字节。";
+    return ok;
+}
+
+void xhywal::advanceLsn(quint64 lsn) {
+    QMutexLocker lock(&m_mutex);
+    if (lsn < m_nextLsn || !m_pending.isEmpty()) return;
+    m_nextLsn = lsn + 1;
+    m_bufferedLsn = lsn;
+    m_durableLsn = lsn;
+}
+
+quint64 xhywal::lastLsn() const {
+    QMutexLocker lock(&m_mutex);
+    return m_bufferedLsn;
+}
+
+qint64 xhywal::size() const {
+    QMutexLocker lock(&m_mutex);
+    return m_fileSize + m_pending.size();
+}
+
+quint64 xhywal::syncCount() const {
+    QMutexLocker lock(&m_mutex);
+    return m_syncCount;
+}
+
+void xhywal::setGroupCommitWindow(int usec) {
+    QMutexLocker lock(&m_mutex);
+    m_groupCommitWindowUs = qMax(0, usec);
+}
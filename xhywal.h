@@ -0,0 +1,72 @@
+#ifndef XHYWAL_H
+#define XHYWAL_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include "xhytable.h"
+
+// 每个数据库一个预写日志（重做日志），文件为 [数据库名].log
+// 帧格式: quint32 负载长度 | quint32 校验和 | 负载(lsn, 类型, 表名, 行号, 前像, 后像)
+// 一次提交的所有变更之后跟一条 COMMIT 记录，重放时只应用完整提交的变更组
+class xhywal {
+public:
+    enum RecordType : quint8 {
+        RecInsert = RowChange::Insert,
+        RecUpdate = RowChange::Update,
+        RecDelete = RowChange::Delete,
+        RecCommit = 4
+    };
+
+    struct Entry {
+        quint64 lsn = 0;
+        QString tableName;
+        RowChange change;
+    };
+
+    explicit xhywal(const QString& filePath);
+    ~xhywal();
+
+    bool open();                      // 打开日志并截掉尾部不完整的帧
+    void close();
+    QList<Entry> readCommitted();     // 读取所有已完整提交的变更（按 LSN 顺序）
+
+    // 追加一次提交的变更到内存缓冲，返回 COMMIT 记录的 LSN；changes 为空时返回 0
+    quint64 appendCommit(const QList<QPair<QString, RowChange>>& changes, qint64* bytesAppended = nullptr);
+    // 组提交：保证 lsn 之前的记录已落盘；并发的提交共享一次 fsync
+    bool sync(quint64 lsn);
+    // 丢弃 lsn 及之前的记录（检查点之后调用）；保留其中最后一条 COMMIT 记录，重启后 LSN 从它之后继续
+    bool truncateUpTo(quint64 lsn);
+    // 打开后、追加之前调用：LSN 至少从 lsn + 1 开始（数据文件头中的 LSN 可能大于日志中剩下的）
+    void advanceLsn(quint64 lsn);
+
+    quint64 lastLsn() const;
+    qint64 size() const;
+    quint64 syncCount() const;
+    void setGroupCommitWindow(int usec); // 组提交等待窗口（微秒），0 表示不等待
+
+    static bool syncFile(QFileDevice& file); // flush + fsync
+    static quint16 checksum(const char* data, int len); // 帧与数据页共用的 CRC-16，Qt 5 与 Qt 6 结果相同
+
+private:
+    static QByteArray encodeFrame(quint64 lsn, RecordType type, const QString& tableName, const RowChange& change);
+    bool scan(QList<Entry>* entries, qint64* validEnd);
+
+    QString m_filePath;
+    QFile m_file;
+    mutable QMutex m_mutex;
+    QWaitCondition m_syncDone;
+    QByteArray m_pending;          // 尚未写入文件的帧
+    quint64 m_nextLsn = 1;
+    quint64 m_bufferedLsn = 0;     // 已进入缓冲的最大 LSN
+    quint64 m_durableLsn = 0;      // 已 fsync 的最大 LSN
+    bool m_syncInProgress = false; // 是否有线程正在作为组提交的领导者写盘
+    int m_groupCommitWindowUs = 0;
+    qint64 m_fileSize = 0;
+    quint64 m_syncCount = 0;
+};
+
+#endif // XHYWAL_H